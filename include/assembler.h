@@ -12,11 +12,12 @@
  * in the `pass_one()` and `pass_two()` functions to implement the
  * two pass translation process.  This module makes use of the
  * `symbol-table` module to build and maintain a dictionary of
- * labels and addresses encountered in pass 1, and a linked list of
+ * labels and addresses encountered in pass 1, and a list of
  * `operation-list` entries that is constructed in pass 1, and processed
  * and completed to assemble the machine instructions and final binary
  * file in pass two.
  */
+#include "cache.h"
 #include "operation-list.h"
 #include "symbol-table.h"
 #include "tokenizer.h"
@@ -27,6 +28,38 @@
 #ifndef LC3VMASSEMBLER_H
 #define LC3VMASSEMBLER_H
 
+/// number of operation list entries handed to a worker at a time
+/// by the parallel pass two
+#define PASS_TWO_CHUNK 4096
+
+/// version of the assembler, change it whenever the output of the same
+/// source changes so that cached outputs are not reused
+#define LC3ASM_VERSION "lc3asm 1.1"
+
+/// assembly flags, the options of an assembly, the output flags change
+/// the binary file of a source, so they are part of its cache key
+#define LC3ASM_OPTIMIZE 0x1
+#define LC3ASM_DEPFILE 0x2
+#define LC3ASM_DEADCODE 0x4
+#define LC3ASM_ANALYZE 0x8
+#define LC3ASM_DIAGFILE 0x10
+#define LC3ASM_OUTPUT_FLAGS (LC3ASM_OPTIMIZE | LC3ASM_DEADCODE)
+
+/// the entry of a line that was skipped after its error was recorded in
+/// the diagnostic sink
+#define LC3ASM_NO_ENTRY ((unsigned)-1)
+
+/// word size is 2 bytes for LC-3
+#define WORD_SIZE 2
+
+/// the .INCBIN variant of the byte order of the words in the binary file,
+/// which are written in the byte order of the host
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define INCBIN_HOST_ORDER 1
+#else
+#define INCBIN_HOST_ORDER 0
+#endif
+
 /// flags are used in testing and in the operation-list so make them visible
 enum flags
 {
@@ -41,33 +74,53 @@ enum flags
 extern "C" {
 #endif
 
-void lc3asm(const char* asmfile, const char* binfile, bool verbose);
+void lc3asm(const char* asmfile, const char* binfile, bool verbose, unsigned flags, unsigned num_threads, cache* ch);
+void lc3asm_stream(const char* asmfile, const char* binfile, bool verbose);
+bool lc3asm_file(const char* asmfile, const char* binfile, bool verbose, unsigned flags, unsigned num_threads,
+  cache* ch);
+bool lc3asm_stream_file(const char* asmfile, const char* binfile, bool verbose);
+bool lc3asm_batch(char* const* asmfiles, unsigned num_files, unsigned flags, unsigned num_threads, cache* ch);
+size_t pass_stream(tokenizer* tk, symbol_table* st, FILE* out, unsigned* max_pending);
 operation_list* pass_one(tokenizer* tk, symbol_table* st);
+unsigned source_file(operation_list* opl, unsigned file, tokens* tks);
+unsigned pass_one_line(operation_list* opl, unsigned file, tokens* tks, symbol_table* st, uint16_t* address);
+void assign_addresses(operation_list* opl, symbol_table* st, unsigned begin);
 void pass_two(operation_list* opl, symbol_table* st);
+void pass_two_range(operation_list* opl, symbol_table* st, unsigned begin, unsigned end);
+void pass_two_parallel(operation_list* opl, symbol_table* st, unsigned num_threads);
+void display_bin_file(const char* binfile);
 void write_bin_file(const char* binfile, operation_list* opl, bool verbose);
+size_t write_entry(FILE* out, operation_list* opl, unsigned idx);
+size_t image_size(operation_list* opl);
+size_t write_image(operation_list* opl, uint16_t* image);
 char* bin_file_name(const char* asmfile);
+char* dep_file_name(const char* binfile);
+char* diag_file_name(const char* binfile);
+void write_dep_file(const char* depfile, const char* binfile, const char* asmfile, operation_list* opl);
 
 bool match(const char* symbol1, const char* symbol2);
+bool match_nocase(const char* symbol1, const char* symbol2);
 char* check_for_symbol(tokens* tks);
-void calculate_symbol_offset(operand* opr, uint16_t opaddress, symbol_table* st);
-void asm_inst(opl_entry* entry);
-uint16_t asm_add(opl_entry* entry);
-uint16_t asm_and(opl_entry* entry);
-uint16_t asm_br(opl_entry* entry);
-uint16_t asm_fill(opl_entry* entry);
-uint16_t asm_jmp(opl_entry* entry);
-uint16_t asm_jsr(opl_entry* entry);
-uint16_t asm_ld(opl_entry* entry);
-uint16_t asm_ldi(opl_entry* entry);
-uint16_t asm_ldr(opl_entry* entry);
-uint16_t asm_lea(opl_entry* entry);
-uint16_t asm_not(opl_entry* entry);
-uint16_t asm_rti(opl_entry* entry);
-uint16_t asm_st(opl_entry* entry);
-uint16_t asm_sti(opl_entry* entry);
-uint16_t asm_str(opl_entry* entry);
-uint16_t asm_stringz(opl_entry* entry);
-uint16_t asm_trap(opl_entry* entry);
+bool calculate_symbol_offset(operand* opr, uint16_t opaddress, symbol_table* st);
+void asm_inst(operation_list* opl, unsigned idx);
+void asm_malformed(operation_list* opl, unsigned idx, const char* where, const char* what);
+uint16_t asm_add(operation_list* opl, unsigned idx);
+uint16_t asm_and(operation_list* opl, unsigned idx);
+uint16_t asm_br(operation_list* opl, unsigned idx);
+uint16_t asm_fill(operation_list* opl, unsigned idx);
+uint16_t asm_jmp(operation_list* opl, unsigned idx);
+uint16_t asm_jsr(operation_list* opl, unsigned idx);
+uint16_t asm_ld(operation_list* opl, unsigned idx);
+uint16_t asm_ldi(operation_list* opl, unsigned idx);
+uint16_t asm_ldr(operation_list* opl, unsigned idx);
+uint16_t asm_lea(operation_list* opl, unsigned idx);
+uint16_t asm_not(operation_list* opl, unsigned idx);
+uint16_t asm_rti(operation_list* opl, unsigned idx);
+uint16_t asm_st(operation_list* opl, unsigned idx);
+uint16_t asm_sti(operation_list* opl, unsigned idx);
+uint16_t asm_str(operation_list* opl, unsigned idx);
+uint16_t asm_stringz(operation_list* opl, unsigned idx);
+uint16_t asm_trap(operation_list* opl, unsigned idx);
 
 #ifdef TEST
 } // end extern C for C++ test runner
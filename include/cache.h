@@ -0,0 +1,70 @@
+/** @file cache.h
+ * @brief LC-3 Assembler output cache
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * A content addressed cache of assembler outputs.  The same sources are
+ * assembled over and over, so the outputs of an assembly are kept in a
+ * cache directory under a key that is a hash of the source bytes, the
+ * assembler version and the flags that change the output.  When a source
+ * is assembled again its outputs are copied from the cache, without
+ * tokenizing or running either pass.
+ *
+ * Each entry is three files in the cache directory named after the key,
+ * KEY.lc3 the binary image, KEY.sym the symbol table report and KEY.lst
+ * the assembly listing, the last two are only needed by verbose output.
+ * A hit reports nothing, so the outputs of a source with warnings, like
+ * the operations relax.h relaxed, are not stored.
+ */
+#include "operation-list.h"
+#include "symbol-table.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef CACHE_H
+#define CACHE_H
+
+/// environment variable naming the cache directory when none is given
+#define CACHE_ENV "LC3ASM_CACHE"
+
+/// extensions of the files of an entry
+#define CACHE_IMAGE ".lc3"
+#define CACHE_SYMBOLS ".sym"
+#define CACHE_LISTING ".lst"
+
+/// length of a key, 16 hex digits of a 64 bit hash and the '\0'
+#define CACHE_KEY_SIZE 17
+
+/// An open cache directory and the hits and misses of this process.
+typedef struct cache
+{
+  char* dir;
+  unsigned hits;
+  unsigned misses;
+} cache;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+cache* cache_construct(const char* dir);
+void cache_destruct(cache* ch);
+uint64_t cache_hash(const void* data, size_t length, uint64_t seed);
+bool cache_cacheable(const char* source, size_t length);
+void cache_key(const char* source, size_t length, unsigned flags, char* key);
+bool cache_fetch(cache* ch, const char* key, const char* binfile, bool listing);
+void cache_display(cache* ch, const char* key, const char* ext);
+void cache_store(cache* ch, const char* key, const char* binfile, symbol_table* st, operation_list* opl);
+void cache_display_stats(cache* ch);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // CACHE_H
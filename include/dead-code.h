@@ -0,0 +1,77 @@
+/** @file dead-code.h
+ * @brief LC-3 Assembler dead code and unreferenced data elimination
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The optional `-G` pass, run after pass one and before the `-O` passes,
+ * relaxation and pass two.  A library of routines and messages, like the
+ * sources of an operating system, is assembled into images that only use
+ * some of them, the rest are dropped from the image:
+ *
+ *           .ORIG  x3000
+ *           LEA    R0, HELLO
+ *           TRAP   x22
+ *           TRAP   x25
+ *   HELLO   .STRINGZ "hello"
+ *   CLEAR   AND    R0, R0, #0     ; never reached, removed
+ *           RET                   ; removed
+ *   BYE     .STRINGZ "bye"        ; never referenced, removed
+ *           .END
+ *
+ * The program is walked from its entry points, the first word of each
+ * .ORIG section, which is the entry of a program, a labelled routine
+ * loaded at a fixed address, or a TRAP vector table.  An instruction
+ * reaches the instruction after it unless it is a BRnzp, JMP, RET or RTI,
+ * and the label or numeric offset it uses.  A word of data reaches the
+ * labels in its .FILLs, so the routines of a TRAP vector table, and the
+ * entries of a jump table, are reached through the table.  Data is kept a
+ * whole run at a time, the .FILL, .BLKW, .STRINGZ and .INCBIN entries
+ * between two instructions, since a table that is reached by its first
+ * label is read at offsets from it.
+ *
+ * The entries that are not reached are removed like a peephole removes an
+ * instruction, with a size of 0, and the addresses are assigned again.
+ * Code that is only reached through an address the assembler can not see,
+ * like a routine at a fixed address that another image jumps to, must
+ * start a section of its own or be named by a .FILL to be kept.  As for
+ * the peephole optimizer, no word between an operation with a numeric PC
+ * offset and its target is removed.
+ */
+#include "operation-list.h"
+#include "symbol-table.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+/// What dead code elimination removed.
+typedef struct dead_stats
+{
+  // the instructions that can not be reached, each of them was one word
+  unsigned num_instructions;
+
+  // the words of data that are never referenced
+  unsigned num_data_words;
+
+  // the runs of consecutive entries that were removed
+  unsigned num_blocks;
+} dead_stats;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+dead_stats dead_code(operation_list* opl, symbol_table* st);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // DEAD_CODE_H
@@ -0,0 +1,147 @@
+/** @file diagnostic.h
+ * @brief assembler error diagnostics
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * All of the errors found while assembling are reported through
+ * `diag_fatal()`.  Normally a fatal error is printed on standard error
+ * and the assembler exits.  When the assembler is used as a library it
+ * must not exit, so the library sets an error trap first.  While a trap is
+ * set, a fatal error in that thread is recorded as a diagnostic in the trap
+ * and control jumps back to where the trap was set, which then cleans up
+ * and returns the diagnostic to its caller.
+ *
+ * Most errors only spoil the line they are on, like an unknown opcode, a
+ * duplicate label, an undefined symbol or a malformed operation, and are
+ * reported through `diag_error()` instead.  While a diagnostic sink is
+ * set, such an error is recorded in the sink and the assembly goes on, the
+ * line is skipped or assembled as a 0 word, so one run finds every error
+ * of a file.  The sink reports them all at the end, as text on standard
+ * error, one per line
+ *
+ *   progs/bad.asm:12:17: error: [undefined-symbol] <assembler::...> Error ...
+ *
+ * and as a JSON array, one object per error with its file, line, column,
+ * code, severity and message, for the tools that read them.  Without a
+ * sink `diag_error()` stops the assembly like `diag_fatal()`.
+ *
+ * Some things the assembler does on its own are worth telling the user
+ * about without failing the assembly, like an operation relaxation
+ * rewrote.  They are reported through `diag_warning()` with a warning
+ * code, recorded in the sink like an error but not counted as one, and
+ * printed right away when there is no sink.
+ */
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef DIAGNOSTIC_H
+#define DIAGNOSTIC_H
+
+#ifdef __GNUC__
+#define DIAG_NORETURN __attribute__((noreturn))
+#else
+#define DIAG_NORETURN
+#endif
+
+/// The kinds of errors, so tools can tell them apart without parsing the
+/// messages.  The names of the codes are given by `diag_code_name()`, and
+/// the codes from DIAG_RELAXED on are warnings, see `diag_is_warning()`.
+typedef enum diag_code
+{
+  DIAG_FATAL = 0, // an error that stops the assembly
+  DIAG_UNKNOWN_OPCODE,
+  DIAG_DUPLICATE_LABEL,
+  DIAG_TOO_MANY_OPERANDS,
+  DIAG_BAD_INCBIN,
+  DIAG_UNDEFINED_SYMBOL,
+  DIAG_OFFSET_RANGE,
+  DIAG_MALFORMED,
+  DIAG_BAD_MACRO,
+  DIAG_BAD_INCLUDE,
+  DIAG_SECTION_OVERLAP,
+  DIAG_RELAXED, // a warning, an operation was relaxed
+  DIAG_NUM_CODES
+} diag_code;
+
+/// A diagnostic message about an error in an assembly source, and the
+/// file and line it was found on.  The file is NULL and the line 0 when
+/// the error is not about a particular line, and the column is 0 when the
+/// error is not about a particular token of the line.
+typedef struct diagnostic
+{
+  char* file;
+  unsigned line;
+  char* message;
+  unsigned column;
+  diag_code code;
+} diagnostic;
+
+/// A diagnostic sink, the errors an assembly recorded and went on after.
+/// The threads of a parallel pass two all record into the sink of the
+/// assembly, so it is locked.
+typedef struct diag_sink
+{
+  diagnostic* diags;
+  unsigned num_diags;
+  unsigned capacity;
+
+  // the diagnostics that are errors, the others are warnings, the
+  // assembly failed if there are any
+  unsigned num_errors;
+  pthread_mutex_t lock;
+
+  // the file the errors are written to as JSON when they are reported, or
+  // NULL
+  const char* json_file;
+} diag_sink;
+
+/// An error trap.  setjmp() is called on the jump buffer right after the
+/// trap is set, and a fatal error longjmp()s back to it with the error
+/// recorded in diag.  Traps can be nested, the most recently set trap of
+/// a thread catches the errors.
+typedef struct diag_trap
+{
+  jmp_buf jump;
+  diagnostic diag;
+  struct diag_trap* previous;
+} diag_trap;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+void diag_set_trap(diag_trap* trap);
+void diag_clear_trap(diag_trap* trap);
+void diag_locate(const char* file, unsigned line);
+diagnostic diag_format(const char* file, unsigned line, const char* format, ...);
+DIAG_NORETURN void diag_fatal(const char* file, unsigned line, const char* format, ...);
+void diag_error(const char* file, unsigned line, unsigned column, diag_code code, const char* format, ...);
+void diag_warning(const char* file, unsigned line, unsigned column, diag_code code, const char* format, ...);
+unsigned diag_column(const char* line, const char* token);
+const char* diag_code_name(diag_code code);
+bool diag_is_warning(diag_code code);
+void diag_print(FILE* out, const diagnostic* diag);
+void diag_destruct(diagnostic* diag);
+void diag_sink_construct(diag_sink* sink, const char* json_file);
+void diag_sink_destruct(diag_sink* sink);
+void diag_sink_clear(diag_sink* sink);
+void diag_sink_add(diag_sink* sink, diagnostic diag);
+diag_sink* diag_set_sink(diag_sink* sink);
+diag_sink* diag_get_sink(void);
+void diag_sink_sort(diag_sink* sink);
+void diag_sink_report(diag_sink* sink);
+void diag_write_json(diag_sink* sink, FILE* out);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // DIAGNOSTIC_H
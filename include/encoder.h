@@ -0,0 +1,63 @@
+/** @file encoder.h
+ * @brief batched machine instruction encoder
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Once the SYMBOL operands of the operation list have been resolved
+ * in pass two, encoding a machine instruction is just masking, shifting
+ * and or'ing together small integer operand values.  Every operation is
+ * classified into one of a few encoding formats when it is parsed, and
+ * all operations of a format are encoded with the same masks and shifts.
+ * The encoder then encodes runs of entries straight from the hot field
+ * arrays of the operation list, 16 entries at a time using AVX2 vector
+ * instructions on 16 bit lanes when the cpu supports them, or with a
+ * scalar loop when it does not.  Compile with -DNO_SIMD to only build the
+ * scalar loop.
+ */
+#include "operation-list.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+/// The encoding formats.  Every format encodes its instructions as
+/// base | ((value0 & mask0) << shift0) | ((value1 & mask1) << shift1)
+/// | (value2 & mask2), where the base word holds the opcode and any fixed
+/// bits of the entry, and the masks and shifts are constants of the format.
+/// There can be at most 16 formats, so a format can index a vector table.
+typedef enum enc_format
+{
+  ENC_UNCLASSIFIED = 0, // not classified yet, or malformed and left to asm_inst()
+  ENC_NONE,             // RET, RTI, .ORIG, .END and .BLKW, only the base word
+  ENC_R_R_IMM5,         // ADD, AND: DR, SR1, SR2/imm5
+  ENC_R_R_OFF6,         // LDR, STR: DR/SR, BaseR, offset6
+  ENC_R_R,              // NOT: DR, SR
+  ENC_R_OFF9,           // LD, LDI, LEA, ST, STI: DR/SR, PCoffset9
+  ENC_OFF9,             // BR: PCoffset9
+  ENC_OFF11,            // JSR: PCoffset11
+  ENC_BASER,            // JMP, JSRR: BaseR
+  ENC_TRAP8,            // TRAP: trapvect8
+  ENC_WORD,             // .FILL, .STRINGZ, .INCBIN: the whole operand value
+  ENC_NUM_FORMATS
+} enc_format;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+void enc_classify(operation_list* opl, unsigned idx);
+void enc_batch(operation_list* opl, unsigned begin, unsigned end, bool simd);
+bool enc_simd_available();
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // ENCODER_H
@@ -0,0 +1,186 @@
+/** @file flow-graph.h
+ * @brief LC-3 Assembler control flow analysis
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The optional `-A` analysis, run on the operation list after pass two.
+ * The instructions are split into basic blocks, after each BR, JMP, RET,
+ * RTI, JSR and TRAP and before each label or branch target, and the
+ * blocks are joined by the branches and the instructions that fall into
+ * the next block.  A JSR is a call, it goes on to the instruction after
+ * it, and the routine it calls is counted as part of the JSR.  A TRAP x25
+ * halts, other TRAPs return to the instruction after them.
+ *
+ * A routine starts at the first instruction of a section, or at the label
+ * of a JSR, and is made of the blocks its entry reaches.  A .FILL of a
+ * label assembles to the offset of the label, not its address, so a label
+ * named by a .FILL, like a handler in a TRAP vector table, does not start
+ * a routine, a handler in its own section does.  For each
+ * routine the analysis reports its instructions, its loops and how deep
+ * they are nested, and the instructions and cycles of its worst case
+ * path, the path that takes the most cycles from its entry to a RET, RTI,
+ * JMP or HALT.  The cycles of an instruction are those of `opc_cycles()`,
+ * and a taken branch takes one more.
+ *
+ * A loop is found from the branches back to a block that is still being
+ * walked, its header, and is bounded by the most times its header runs
+ * each time the loop is entered.  The bound of a loop that counts a
+ * register down is inferred:
+ *
+ *           LD     R1, SIX        ; or AND R1, R1, #0 and ADD R1, R1, #6
+ *   AGAIN   ADD    R3, R3, R2
+ *           ADD    R1, R1, #-1
+ *           BRp    AGAIN          ; runs 6 times
+ *
+ * when the counter is only written by the decrement in the loop and the
+ * loop is only entered from the instruction before its header.  Any other
+ * loop, like a loop that polls a device register, is bounded by a comment
+ * with @bound and the number of times, on the line of its header or of
+ * the branch back to it:
+ *
+ *   POLL    LDI    R1, DSR        ; @bound 100
+ *           BRzp   POLL
+ *
+ * A routine with a loop that is not bounded has no worst case.
+ */
+#include "operation-list.h"
+#include "symbol-table.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef FLOW_GRAPH_H
+#define FLOW_GRAPH_H
+
+/// no block, loop or routine
+#define FG_NONE ((unsigned)-1)
+
+/// the text in the comment of a line that gives the bound of its loop
+#define FG_BOUND_ANNOTATION "@bound"
+
+/// The instructions and cycles of a path, or of a part of one.
+typedef struct fg_cost
+{
+  uint64_t instructions;
+  uint64_t cycles;
+
+  // true if the path goes around a loop that is not bounded
+  bool unbounded;
+} fg_cost;
+
+/// A basic block, instructions that always run one after the other.
+typedef struct fg_block
+{
+  // the entries of the first and last instruction of the block
+  unsigned first;
+  unsigned last;
+
+  // the instructions and cycles of the block, not counting a routine it
+  // calls
+  fg_cost cost;
+
+  // the blocks the block can go on to, and the cycles each of them adds,
+  // a taken branch takes one more cycle
+  unsigned succ[2];
+  unsigned succ_cycles[2];
+  unsigned num_succ;
+
+  // the routine the JSR at the end of the block calls, or FG_NONE
+  unsigned callee;
+
+  // the innermost loop the block is in, or FG_NONE
+  unsigned loop;
+} fg_block;
+
+/// How the bound of a loop is known.
+typedef enum fg_bound
+{
+  FG_UNBOUNDED,
+  FG_INFERRED,
+  FG_ANNOTATED
+} fg_bound;
+
+/// A loop, the blocks that can go back to its header.
+typedef struct fg_loop
+{
+  unsigned header;
+  unsigned* blocks;
+  unsigned num_blocks;
+
+  // the blocks that branch back to the header
+  unsigned* latches;
+  unsigned num_latches;
+
+  // the loop it is nested in, or FG_NONE, and how deep it is nested,
+  // 1 for a loop that is not in another one
+  unsigned parent;
+  unsigned depth;
+
+  // the most times the header runs each time the loop is entered
+  unsigned bound;
+  fg_bound bound_kind;
+
+  // the worst case of the loop, once it is known
+  fg_cost cost;
+  uint8_t state;
+} fg_loop;
+
+/// A routine, its entry and what the analysis found in it.
+typedef struct fg_routine
+{
+  unsigned entry;
+  unsigned num_blocks;
+  unsigned num_instructions;
+  unsigned num_loops;
+  unsigned max_depth;
+
+  // the worst case path of the routine, once it is known
+  fg_cost cost;
+  uint8_t state;
+} fg_routine;
+
+/// The control flow graph of an assembled operation list.
+typedef struct flow_graph
+{
+  operation_list* opl;
+  symbol_table* st;
+
+  fg_block* blocks;
+  unsigned num_blocks;
+
+  // the block of each entry, FG_NONE for entries that are not
+  // instructions
+  unsigned* block_of;
+
+  // the predecessors of each block, those of block b are
+  // preds[pred_begin[b]] up to preds[pred_begin[b + 1]]
+  unsigned* preds;
+  unsigned* pred_begin;
+
+  fg_loop* loops;
+  unsigned num_loops;
+
+  fg_routine* routines;
+  unsigned num_routines;
+} flow_graph;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+flow_graph* fg_construct(operation_list* opl, symbol_table* st);
+void fg_destruct(flow_graph* fg);
+fg_cost fg_routine_cost(flow_graph* fg, unsigned routine);
+fg_cost fg_loop_cost(flow_graph* fg, unsigned loop);
+void fg_display(flow_graph* fg);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // FLOW_GRAPH_H
@@ -0,0 +1,71 @@
+/** @file include-cache.h
+ * @brief LC-3 Assembler cache of included files
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The files named by .INCLUDE are read and tokenized once per process, and
+ * kept in this cache, see macro.h for the .INCLUDE directive.  A file that
+ * is included by many sources, or many times by the files of a batch that
+ * are assembled concurrently, is only read and tokenized by the first
+ * assembly that includes it, the others copy the lines it tokenized.
+ *
+ * A file is cached under its real path, with the size and modification
+ * time it had when it was read.  A long running process, like the
+ * assembler server, checks those each time the file is included, and reads
+ * the file again if it changed.  The new version replaces the old one in
+ * the cache, but an assembly running in another thread may still be
+ * copying the old lines, and the names of the files of its lines point at
+ * the old path, so each assembly holds the versions it loaded until it
+ * releases them with `ic_release()`, and a replaced version is freed by the
+ * last release.
+ */
+#include "tokenizer.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <time.h>
+
+#ifndef INCLUDE_CACHE_H
+#define INCLUDE_CACHE_H
+
+/// A file read and tokenized once, for all of the .INCLUDEs of it.
+typedef struct ic_file
+{
+  // the real path of the file, the key of the cache, and what the file
+  // was when it was read
+  char* path;
+  off_t size;
+  struct timespec mtime;
+
+  // the tokenized lines of the file, each one has the path as its file
+  tokens** lines;
+  unsigned num_lines;
+
+  // the number of assemblies holding this version, and whether a newer
+  // version replaced it in the cache
+  unsigned refs;
+  bool replaced;
+} ic_file;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+ic_file* ic_load(const char* path);
+tokens* ic_copy_line(const ic_file* file, unsigned line);
+void ic_release(ic_file* file);
+unsigned ic_num_reads();
+unsigned ic_num_cached();
+void ic_clear();
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // INCLUDE_CACHE_H
@@ -0,0 +1,111 @@
+/** @file incremental.h
+ * @brief LC-3 Assembler incremental reassembly engine
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * An incremental assembler for editor integration.  The engine keeps the
+ * symbol table and operation list of a source alive between edits.  An
+ * edit replaces a range of lines with new text, and only the new lines are
+ * tokenized and run through pass one.  The entries after the edit are
+ * moved to their new addresses, and only the entries whose symbol offsets
+ * changed are resolved and encoded again, so an edit of one line of a
+ * large program takes microseconds instead of a full assembly.
+ *
+ * Errors are kept per line, so the engine always has the diagnostics of
+ * the current text, and a line with an error is assembled again when an
+ * edit elsewhere could fix it, like defining the label it refers to.
+ *
+ * An edit that puts a label out of reach of an operation, or a program
+ * that already has relaxed operations, is relaxed again from scratch after
+ * the edit, see relax.h, so the image is always the one a full assembly
+ * would make.  That costs a pass over the whole program, but only for
+ * programs that need relaxing.
+ *
+ * Each line is tokenized by itself, so the engine does not see the lines
+ * of a macro together, and it does not expand macros or include files,
+ * see macro.h.  `inc_supported()` tells if a source can be assembled by
+ * the engine, a source with a .MACRO, .INCLUDE or .INCBIN needs a full
+ * assembly instead.
+ */
+#include "diagnostic.h"
+#include "operation-list.h"
+#include "symbol-table.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+/// entry index of a line that has no operation list entry, a blank line,
+/// a comment or a line with a pass one error
+#define INC_NO_ENTRY 0xffffffffU
+
+/// One line of the source being edited.
+typedef struct inc_line
+{
+  // the text of the line, without the newline
+  char* text;
+  unsigned length;
+
+  // the operation list entry of the line, and the slot of the operation
+  // list file table that points at the text of the line, both INC_NO_ENTRY
+  // if the line has no entry
+  unsigned entry;
+  unsigned file;
+
+  // the error on this line, the message is NULL if there is none
+  diagnostic diag;
+} inc_line;
+
+/// The state of an incremental assembly, the lines of the source and the
+/// tables assembled from them.
+typedef struct inc_engine
+{
+  char* name;
+
+  // the lines of the source
+  inc_line* lines;
+  unsigned num_lines;
+  unsigned capacity;
+  unsigned num_errors;
+
+  // the tables of the assembly, kept between edits
+  symbol_table* st;
+  operation_list* opl;
+
+  // file table slots freed by deleted lines, reused by new lines
+  unsigned* free_files;
+  unsigned num_free_files;
+
+  // work done by the last edit, lines tokenized and entries encoded
+  unsigned num_parsed;
+  unsigned num_encoded;
+
+  // the number of operations the last relaxation rewrote, and if an
+  // entry was found out of range of its label since then
+  unsigned num_relaxed;
+  bool relax_pending;
+} inc_engine;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+bool inc_supported(const char* source, size_t length);
+inc_engine* inc_construct(const char* name, const char* source, size_t length);
+void inc_destruct(inc_engine* eng);
+void inc_edit(inc_engine* eng, unsigned first_line, unsigned num_removed, const char* text, size_t length);
+unsigned inc_diagnostics(inc_engine* eng, const diagnostic** diags, unsigned max);
+size_t inc_image(inc_engine* eng, uint16_t* image);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // INCREMENTAL_H
@@ -0,0 +1,34 @@
+/** @file lc3asm-cli.h
+ * @brief LC-3 Assembler command line
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The parts of the command line that lc3asm and its drop in replacement
+ * lc3asm-client share, the usage message of their common arguments and
+ * the assembly of a batch of files, so both programs assemble a batch
+ * exactly the same way.
+ */
+#include "assembler.h"
+#include <stdbool.h>
+
+#ifndef LC3ASM_CLI_H
+#define LC3ASM_CLI_H
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+void cli_usage(bool client);
+int cli_assemble_batch(char* const* infiles, unsigned num_files, bool verbose, unsigned flags, bool stream,
+  unsigned num_threads, cache* ch);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // LC3ASM_CLI_H
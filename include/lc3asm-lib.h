@@ -0,0 +1,122 @@
+/** @file lc3asm-lib.h
+ * @brief LC-3 Assembler library interface
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * An interface to embed the assembler in other programs.  The library
+ * assembles source text held in memory into the words of a binary image
+ * in memory, without reading or writing any files, and reports errors as
+ * diagnostics in the result instead of exiting.  A batch of files can also
+ * be assembled concurrently, each file into its own result and binary file.
+ * The library is built as liblc3asm.a and liblc3asm.so.
+ *
+ * An assembly keeps all of its state in an assembler context, the tables,
+ * the diagnostic sink, and the tokenizer and macro processor of the source,
+ * and none of it in globals, errors never exit and the only state kept
+ * per thread is the error trap and sink the assembly sets while it runs.
+ * So any number of threads can assemble at the same time, each with a
+ * context of its own:
+ *
+ *   lc3asm_context* ctx = lc3asm_context_construct();
+ *   for (each source)
+ *   {
+ *     lc3asm_result* result = lc3asm_context_assemble(ctx, name, source, length);
+ *     ...
+ *     lc3asm_result_destruct(result);
+ *   }
+ *   lc3asm_context_destruct(ctx);
+ *
+ * A context is reset before each assembly, its tables are cleared but keep
+ * their capacity, so a context that is reused does not allocate them again.
+ */
+#include "diagnostic.h"
+#include "macro.h"
+#include "operation-list.h"
+#include "symbol-table.h"
+#include "tokenizer.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef LC3ASM_LIB_H
+#define LC3ASM_LIB_H
+
+/// A label of the assembled program and its address.
+typedef struct lc3asm_symbol
+{
+  char* symbol;
+  uint16_t address;
+} lc3asm_symbol;
+
+/// The result of assembling a source, all of it is owned by the result
+/// and freed by `lc3asm_result_destruct()`.
+typedef struct lc3asm_result
+{
+  /// true if the source assembled without errors
+  bool ok;
+
+  /// The words of the binary image, the section address and size followed
+  /// by the assembled code, exactly the words the assembler writes to a
+  /// .lc3 file.  NULL if there were errors.
+  uint16_t* image;
+  unsigned image_size;
+
+  /// The labels defined by the source, sorted by address
+  lc3asm_symbol* symbols;
+  unsigned num_symbols;
+
+  /// The errors found in the source, and its warnings, which a source
+  /// that is ok can also have, see `diag_is_warning()`
+  diagnostic* diagnostics;
+  unsigned num_diagnostics;
+
+  /// The files the source read, the real paths of the files it included
+  /// and the paths of the binary files of its .INCBINs, so a tool can
+  /// assemble it again when one of them changes
+  char** files;
+  unsigned num_files;
+} lc3asm_result;
+
+/// An assembler context, everything an assembly uses, kept for the next
+/// assembly with it.  A context is only used by one thread at a time.
+typedef struct lc3asm_context
+{
+  symbol_table* st;
+  operation_list* opl;
+  diag_sink sink;
+
+  // the tokenizer and macro processor of the source being assembled, and
+  // its line being processed, NULL between assemblies
+  tokenizer* tk;
+  macro_processor* mp;
+  tokens* tks;
+
+  // the assemblies done with the context
+  unsigned num_assemblies;
+} lc3asm_context;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+lc3asm_result* lc3asm_assemble(const char* name, const char* source, size_t length);
+lc3asm_context* lc3asm_context_construct();
+void lc3asm_context_reset(lc3asm_context* ctx);
+void lc3asm_context_destruct(lc3asm_context* ctx);
+lc3asm_result* lc3asm_context_assemble(lc3asm_context* ctx, const char* name, const char* source, size_t length);
+void lc3asm_result_add_diagnostic(lc3asm_result* result, diagnostic diag);
+char* lc3asm_read_source(const char* asmfile, size_t* length);
+lc3asm_result** lc3asm_assemble_files(const char* const* asmfiles, const char* const* binfiles, unsigned num_files,
+  unsigned num_threads);
+void lc3asm_result_destruct(lc3asm_result* result);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // LC3ASM_LIB_H
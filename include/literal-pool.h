@@ -0,0 +1,67 @@
+/** @file literal-pool.h
+ * @brief LC-3 Assembler literal pool
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Part of the optional `-O` pass, run after the peephole optimizer and
+ * before relaxation and pass two.  A program declares a constant it loads
+ * as a labelled .FILL, and generated code declares the same constant many
+ * times:
+ *
+ *   SIX     .FILL  x0006
+ *   ...
+ *   SIX2    .FILL  x0006
+ *
+ * A literal is a labelled .FILL of a number whose label is only used as
+ * the label of LD and LDI operations, so the word is only ever read.
+ * Every literal with the same value as a literal before it, that all of
+ * its loads can still reach, is merged into that earlier literal, its
+ * pool slot: the loads are pointed at the label of the slot, and the
+ * literal is removed like a peephole removes an instruction, with a size
+ * of 0.  Removing words only brings the other words of the program closer
+ * together, so a load that reaches its slot before the literals are
+ * removed reaches it after.
+ *
+ * A .FILL is not a literal if its label is used any other way, by LEA or
+ * ST or as the value of a .FILL, since then its address is taken and the
+ * word can be written or read through a pointer.  Data next to a word
+ * whose address is taken is left alone as well, a table that is reached
+ * through LEA of its first label and LDR is read at offsets from that
+ * label.  As for the peephole optimizer, no word between an operation
+ * with a numeric PC offset and its target is removed.
+ */
+#include "operation-list.h"
+#include "symbol-table.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef LITERAL_POOL_H
+#define LITERAL_POOL_H
+
+/// What the literal pool merged.
+typedef struct pool_stats
+{
+  // the literals merged into a slot, each of them was one word
+  unsigned num_merged;
+
+  // the slots that literals were merged into
+  unsigned num_slots;
+} pool_stats;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+pool_stats pool_literals(operation_list* opl, symbol_table* st);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // LITERAL_POOL_H
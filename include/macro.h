@@ -0,0 +1,146 @@
+/** @file macro.h
+ * @brief LC-3 Assembler macro preprocessor
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The macro preprocessor sits between the tokenizer and pass one.  It
+ * hands pass one the lines of the tokenizer, except that it keeps the
+ * lines between .MACRO and .ENDM as the body of a macro, and replaces a
+ * line that uses a macro with the lines of its body:
+ *
+ *           .MACRO PUSH REG
+ *           ADD    R6, R6, #-1
+ *           STR    REG, R6, #0
+ *           .ENDM
+ *
+ *   SAVE    PUSH   R1
+ *
+ * A body is kept as the tokens the tokenizer already made of it, with
+ * each token that names a parameter replaced by the index of the
+ * parameter, so a use of the macro only copies the tokens and puts in the
+ * arguments, and never tokenizes the text of the body again.  A label on
+ * the line that uses a macro goes on the first line of its body.  The
+ * characters \@ in a token of the body become a number that is different
+ * for each use, so a macro can have labels of its own, like LOOP\@.
+ * Macros can use macros that are defined before they are used, up to
+ * MACRO_MAX_DEPTH deep.
+ *
+ * The lines of a body have the line number of the line that used the
+ * macro, so an error in an expanded line is reported at the use.
+ *
+ * The preprocessor also replaces an .INCLUDE "file" line with the lines of
+ * the file, which can define and use macros and include files themselves.
+ * A file is only included once by each assembly, a later .INCLUDE of it
+ * is skipped, so files that share definitions can each include them.  The
+ * lines come from the include cache, see include-cache.h, so a file is
+ * only read and tokenized once by the whole process.  The lines of an
+ * included file keep their own line numbers and the path of their file,
+ * so errors in them are reported in the included file.
+ *
+ * An error in a macro directive, a use of a macro or an .INCLUDE only
+ * spoils its line, it is reported with `diag_error()` and the line is
+ * skipped, and a .MACRO that can not be defined skips its body, so the
+ * rest of the source is still assembled to find its other errors.
+ */
+#include "include-cache.h"
+#include "tokenizer.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef MACRO_H
+#define MACRO_H
+
+/// a line has at most 5 tokens, .MACRO and the name leave room for 3
+/// parameters
+#define MACRO_MAX_PARAMS 3
+
+/// the most macros that can be expanded inside each other, more means a
+/// macro uses itself
+#define MACRO_MAX_DEPTH 16
+
+/// A token of the body of a macro, the text of the token or the
+/// parameter it is replaced with.
+typedef struct mac_token
+{
+  // the text of the token, NULL if it is a parameter
+  char* text;
+  unsigned param;
+
+  // true if the text has a \@ to replace with the number of the use
+  bool unique;
+} mac_token;
+
+/// A line of the body of a macro, tokenized when the macro was defined.
+typedef struct mac_line
+{
+  int num_tokens;
+  mac_token token[5];
+} mac_line;
+
+/// A macro defined with .MACRO, its parameters and its body.
+typedef struct macro
+{
+  char* name;
+  unsigned num_params;
+  char* params[MACRO_MAX_PARAMS];
+  mac_line* lines;
+  unsigned num_lines;
+} macro;
+
+/// The macro preprocessor of a tokenizer, the macros defined so far, and
+/// the expanded lines still to hand to pass one.
+typedef struct macro_processor
+{
+  tokenizer* tk;
+
+  macro* macros;
+  unsigned num_macros;
+  unsigned capacity;
+
+  // the expanded lines waiting to be returned, a stack with the next line
+  // on top, so a macro used in a body is expanded in its place, and how
+  // deep in expansions each line is
+  tokens** pending;
+  unsigned* depth;
+  unsigned num_pending;
+  unsigned pending_capacity;
+
+  // the file of the tokenizer and the real paths of the files included so
+  // far, to include each file once
+  char** included;
+  unsigned num_included;
+
+  // the versions of the included files in the include cache, held until
+  // the preprocessor is destructed, since its lines point at their paths
+  ic_file** files;
+  unsigned num_files;
+
+  // the line that is defining or using a macro while it is preprocessed,
+  // so it is freed if an error stops the assembly
+  tokens* line;
+
+  // the number of times a macro was used
+  unsigned num_expansions;
+} macro_processor;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+macro_processor* mac_construct(tokenizer* tk);
+void mac_destruct(macro_processor* mp);
+tokens* mac_next_line(macro_processor* mp);
+macro* mac_lookup(macro_processor* mp, const char* name);
+void mac_include_path(const char* asmfile, const char* name, char* path, size_t size);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // MACRO_H
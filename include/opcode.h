@@ -23,7 +23,7 @@
 #define OPCODE_H
 
 /// Opcode enumerated type.  There are only 15/16 valid opcodes
-/// and 5 pseudo opcodes in LC-3.  The opcodes have the
+/// and 5 pseudo opcodes in LC-3, and .INCBIN of our own.  The opcodes have the
 /// correct machine instruction 4bit value for each
 /// one in this enum.  The pseudo opcodes are numbered starting
 /// at 0x20.  The enum value for the real opcodes directly
@@ -51,7 +51,8 @@ typedef enum opctype
   END,
   BLKW,
   FILL,
-  STRINGZ
+  STRINGZ,
+  INCBIN // .INCBIN little endian, .INCBINBE big endian
 } opctype;
 
 /// The opcode holds information about the operation
@@ -71,6 +72,8 @@ typedef struct opcode
   // opcode is ADD, AND, or JSR/JSRR we may use this field:
   // 0 means JSR with a PCOffset11
   // 1 means JSRR return using BaseR
+  // For .INCBIN the variant is the byte order of the words of the file,
+  // 0 little endian and 1 big endian
   uint16_t variant;
 
   // keep the actual opcode string token if needed;
@@ -87,6 +90,7 @@ opcode* opc_construct();
 void opc_destruct(opcode* opc);
 opcode* extract_opcode(tokens* tks);
 const char* opc_str(opcode* opc);
+unsigned opc_cycles(opctype opc);
 bool is_keyword(const char* token);
 
 #ifdef TEST
@@ -1,5 +1,5 @@
 /** @file operation-list.h
- * @brief linked list of parsed assembly operations
+ * @brief list of parsed assembly operations
  *
  * @author Student Name
  * @note   cwid: 123456
@@ -14,8 +14,12 @@
  * calculate their offsets, and then determine the size of each operation
  * to finish the assembly process.
  *
- * Implemented as a basic linked list of opl_entry structures.  There will be one
- * opl_entry per each line in the input assembly file that contains an opcode/psedo opcode.
+ * Implemented as a growable, index addressed array of entries.  There will be one
+ * entry per each line in the input assembly file that contains an opcode/psedo opcode.
+ * The cold information about the source line is kept in an array of opl_entry
+ * structures, while the hot fields used to assemble and write the machine
+ * instructions are kept in a struct of arrays, so that pass two and the binary
+ * writer stream through cache dense arrays.
  */
 #include "opcode.h"
 #include "operand.h"
@@ -26,12 +30,22 @@
 #ifndef OPERATION_LIST_H
 #define OPERATION_LIST_H
 
-/// opl_entry holds operation list entries that are maintained
-/// as a linked list.
+/// opl_entry holds the cold fields of an operation list entry, the
+/// information about the original line that is only needed to
+/// display the list or to report an error.  Entries are kept in one
+/// contiguous array in the operation_list and addressed by index.
 typedef struct opl_entry
 {
-  // The whole original line of this entry before translation
-  char* line;
+#ifndef NO_SOURCE_LINES
+  // Where the whole original line of this entry is in its assembly file,
+  // the index of the file in the list file table and the byte offset and
+  // length of the line.  The line text is only read back from the file by
+  // opl_line() when it is needed for a diagnostic.  Compile with
+  // -DNO_SOURCE_LINES to drop the reference from every entry.
+  unsigned file;
+  unsigned length;
+  long offset;
+#endif
 
   // the actual line number in the input assembly file that this line was read from
   unsigned linenum;
@@ -46,42 +60,97 @@ typedef struct opl_entry
   // Operands, there can be from 0 to 3 operands depending on opcode
   int num_opr;
   operand* opr[3];
+} opl_entry;
+
+/// opl_hot holds the hot fields of every operation list entry, everything
+/// that pass two and the binary file writer need to assemble and output
+/// the machine instructions.  Each field is its own contiguous array indexed
+/// by entry number, so a pass that streams over the entries only touches the
+/// fields it actually uses.
+typedef struct opl_hot
+{
+  // opcode type, BR nzp flags and JSR/JMP variant of the opcode
+  uint8_t* opc;
+  uint8_t* flags;
+  uint8_t* variant;
+
+  // the number of operands and the type and value of each operand.  SYMBOL
+  // operand values are the resolved offsets once pass two has run
+  uint8_t* num_opr;
+  uint8_t* oprtype[3];
+  uint16_t* value[3];
 
   // The address assigned to this operation in 1st pass
-  uint16_t address;
+  uint16_t* address;
 
   // The size of this line in machine words, usually 1 except for some
   // pseudoops that allocate a block or a string of multiple words
-  uint16_t size;
+  uint16_t* size;
+
+  // The encoding format of the operation and the base word of its machine
+  // instruction, its opcode and fixed bits, see the encoder module.  A format
+  // of 0 means the entry has not been classified yet
+  uint8_t* format;
+  uint16_t* base;
 
   // The final compiled machine instruction, the target of the work of the
   // assembler in pass 2 for each line.  For pseudo ops where size is more than 1,
   // we would have multiple machine instructions, but only first one is kept here
-  uint16_t inst;
+  uint16_t* inst;
+} opl_hot;
 
-  // The next operation entry in the operation linked list
-  struct opl_entry* next;
-} opl_entry;
-
-/// The operation_list keeps track of the linked list of opl_entry
-/// items while constructed from pass 1, and supports iterating over the list.
+/// opl_file is an assembly file that entries were read from.  The source
+/// of a file assembled from memory is kept, but not copied, so that lines
+/// can be read back without any file I/O.
+typedef struct opl_file
+{
+  char* name;
+  const char* source;
+  size_t length;
+} opl_file;
+
+/// opl_binary is a binary file included with .INCBIN.  The file is mapped
+/// into memory, not read, and its words are written to the binary file
+/// straight from the mapping, so the data is never tokenized or copied
+/// into the entries.
+typedef struct opl_binary
+{
+  char* name;
+  const uint8_t* bytes;
+  size_t length;
+} opl_binary;
+
+/// The operation_list keeps the cold entries and the hot field arrays
+/// of the operations constructed in pass 1.  Both grow together as
+/// entries are appended, and entry idx is at index idx of all of them.
 typedef struct operation_list
 {
   /// current number of entries being held in the operation list
   unsigned num_entries;
 
+  /// number of entries the list can hold before it needs to grow
+  unsigned capacity;
+
   // The size of the program in 16-bit words that is held in this
   // list.
   unsigned size;
 
-  // front of the operation_list
-  opl_entry* front;
+  // the cold per line entries, pointers into this array are invalidated
+  // when the list grows
+  opl_entry* entries;
+
+  // the hot per entry field arrays
+  opl_hot hot;
 
-  // back of the operation_list
-  opl_entry* back;
+  // the names of the assembly files that entries were read from, entries
+  // refer to their file by index into this table
+  unsigned num_files;
+  opl_file* files;
 
-  // current iteration location when iterating the operation_list
-  opl_entry* current;
+  // the binary files of the .INCBIN entries, an entry refers to its file
+  // by the index in this table kept in the value of its file name operand
+  unsigned num_binaries;
+  opl_binary* binaries;
 } operation_list;
 
 // If we are creating tests, make all declarations extern C so can
@@ -92,11 +161,24 @@ extern "C" {
 
 operation_list* opl_construct();
 void opl_destruct(operation_list* opl);
-opl_entry* opl_append(operation_list* opl, const char* line, unsigned linenum, const char* label, opcode* opc, uint16_t address);
-void opl_append_operand(opl_entry* entry, operand* opr);
-opl_entry* opl_begin(operation_list* opl);
-opl_entry* opl_next(operation_list* opl);
+void opl_clear(operation_list* opl);
+unsigned opl_add_file(operation_list* opl, const char* asmfile);
+unsigned opl_add_source(operation_list* opl, const char* name, const char* source, size_t length);
+void opl_set_source(operation_list* opl, unsigned file, const char* source, size_t length);
+const char* opl_file_name(operation_list* opl, unsigned idx);
+int opl_add_binary(operation_list* opl, const char* path);
+const uint8_t* opl_binary_bytes(operation_list* opl, unsigned idx);
+uint16_t opl_binary_word(operation_list* opl, unsigned idx, unsigned word);
+void opl_binary_words(operation_list* opl, unsigned idx, uint16_t* words);
+unsigned opl_append(operation_list* opl, unsigned file, tokens* tks, const char* label, opcode* opc, uint16_t address);
+void opl_append_operand(operation_list* opl, unsigned idx, operand* opr);
+void opl_remove_last(operation_list* opl);
+void opl_splice(operation_list* opl, unsigned begin, unsigned num_removed, unsigned first_new);
+opl_entry* opl_begin(operation_list* opl, unsigned* cursor);
+opl_entry* opl_next(operation_list* opl, unsigned* cursor);
 void opl_display(operation_list* opl);
+void opl_fdisplay(FILE* out, operation_list* opl);
+const char* opl_line(operation_list* opl, unsigned idx, char* buffer, size_t size);
 
 #ifdef TEST
 } // end extern C for C++ test runner
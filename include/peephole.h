@@ -0,0 +1,88 @@
+/** @file peephole.h
+ * @brief LC-3 Assembler peephole optimizer
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The optional `-O` pass, run after pass one and before relaxation and
+ * pass two.  It looks at each instruction of the operation list together
+ * with the instructions next to it, and removes the instructions that can
+ * not change what the program does:
+ *
+ *   branch-next    BR LABEL, where LABEL is the next instruction, the PC
+ *                  ends up at the next instruction either way
+ *   set-cc         ADD Rx, Rx, #0 after an instruction that wrote Rx, and
+ *                  so already set the condition codes from it
+ *   dead-clear     AND Rx, Ry, #0 when the next instruction writes Rx and
+ *                  the condition codes without reading Rx
+ *
+ * A removed instruction keeps its entry in the operation list with a size
+ * of 0, so it is still shown in the listing but has no words in the
+ * binary file.  The addresses after it move down, and its label, if it had
+ * one, moves to the instruction after it.  A labelled instruction can be
+ * reached by a branch as well as by falling into it, so set-cc never
+ * removes a labelled instruction.  The labels are moved in the symbol
+ * table, but a numeric PC offset, like BR #3, is relative to where the
+ * operation is, so no instruction between an operation with a numeric
+ * offset and its target is ever removed.  Code that is reached through an
+ * absolute address the assembler can not see, a .FILL x3005 that is
+ * jumped through, is not supported with `-O`.
+ *
+ * Removing an instruction can make another one removable, a branch can
+ * become a branch to the next instruction, so the rules are applied again
+ * until a pass removes nothing.
+ */
+#include "operation-list.h"
+#include "symbol-table.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+/// the number of words of LC-3 memory, the addresses a numeric offset
+/// can pin
+#define NUM_ADDRESSES 0x10000
+
+/// The peephole rules, see peephole.h.
+typedef enum peep_rule
+{
+  PEEP_BRANCH_NEXT,
+  PEEP_SET_CC,
+  PEEP_DEAD_CLEAR,
+  PEEP_NUM_RULES
+} peep_rule;
+
+/// What the peephole optimizer removed, for each of its rules.
+typedef struct peep_stats
+{
+  // instructions removed by each rule, each of them was one word
+  unsigned num_removed[PEEP_NUM_RULES];
+
+  // the clock cycles of the removed instructions, saved each time the
+  // code they were in runs
+  unsigned cycles_saved[PEEP_NUM_RULES];
+
+  // passes over the operation list until nothing more was removed
+  unsigned num_passes;
+} peep_stats;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+peep_stats peephole(operation_list* opl, symbol_table* st);
+const char* peep_rule_name(peep_rule rule);
+bool peep_is_removed(opl_hot* hot, unsigned idx);
+uint8_t* peep_pin_numeric_offsets(operation_list* opl);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // PEEPHOLE_H
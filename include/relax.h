@@ -0,0 +1,82 @@
+/** @file relax.h
+ * @brief LC-3 Assembler branch relaxation
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The PC relative operations can only reach a label within the bits of
+ * their offset, -256 to 255 words for the 9 bit offsets of BR, LD, LDI,
+ * LEA and ST, and -1024 to 1023 words for the 11 bit offset of JSR.
+ * Relaxation runs after pass one, and finds the SYMBOL operands whose
+ * offsets do not fit.  Each of those operations is rewritten into a longer
+ * sequence that reaches the label through a literal word holding its
+ * address, placed right after the operation:
+ *
+ *   BRnzp LABEL      LD R7, #1 / JMP R7 / .FILL LABEL
+ *   BRcc LABEL       BR(not cc) #3 / LD R7, #1 / JMP R7 / .FILL LABEL
+ *   JSR LABEL        LD R7, #2 / JSRR R7 / BRnzp #1 / .FILL LABEL
+ *   LD DR, LABEL     LDI DR, #1 / BRnzp #1 / .FILL LABEL
+ *   LDI DR, LABEL    LDI DR, #2 / LDR DR, DR, #0 / BRnzp #1 / .FILL LABEL
+ *   LEA DR, LABEL    LD DR, #1 / BRnzp #1 / .FILL LABEL
+ *   ST SR, LABEL     STI SR, #1 / BRnzp #1 / .FILL LABEL
+ *
+ * A relaxed branch jumps through R7, like JSR already does, and arrives
+ * with the condition codes of the address it loaded, so a far branch in a
+ * subroutine loses its return address.  Relaxation is never silent, each
+ * relaxed operation is reported as a relaxed-offset warning at its label,
+ * and a section that grows over the start of another section is a
+ * section-overlap error.  STI would need a free register, so it is not
+ * relaxed, and pass two reports a STI that can not reach its label.
+ *
+ * Growing an operation moves every operation after it, which can push
+ * more offsets out of range, so relaxation repeats until no operation
+ * needs relaxing.  Operations are only ever grown, so the addresses
+ * converge.  A relaxed operation keeps its single operation list entry,
+ * with the size of its whole sequence, and the words of the sequence are
+ * made from the address of its label by `relax_words()` when the binary is
+ * written.
+ */
+#include "operation-list.h"
+#include "symbol-table.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef RELAX_H
+#define RELAX_H
+
+/// the most words a relaxed operation becomes
+#define RELAX_MAX_WORDS 4
+
+/// What a relaxation did, to report how much code it added.
+typedef struct relax_stats
+{
+  // operations that were rewritten, and the words that added to the program
+  unsigned num_relaxed;
+  unsigned words_added;
+
+  // passes over the operation list until the addresses converged
+  unsigned num_passes;
+} relax_stats;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+relax_stats relax(operation_list* opl, symbol_table* st);
+uint16_t relax_needed(operation_list* opl, symbol_table* st, unsigned idx);
+unsigned relax_reset(operation_list* opl, symbol_table* st);
+unsigned relax_offset_bits(opl_hot* hot, unsigned idx, unsigned opr);
+bool relax_fits(uint16_t offset, unsigned bits);
+bool relax_is_relaxed(opl_hot* hot, unsigned idx);
+unsigned relax_words(operation_list* opl, unsigned idx, uint16_t* words);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // RELAX_H
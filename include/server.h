@@ -0,0 +1,78 @@
+/** @file server.h
+ * @brief LC-3 Assembler server
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * An assembler server that listens on a local Unix socket, so that
+ * assembling many small programs does not pay for starting a new process
+ * and building new tables each time.  Clients send framed assemble
+ * requests, naming a file or giving the source inline, and the server
+ * answers each with the binary image, symbols and diagnostics.
+ *
+ * All fields of a frame are in host byte order, since the server and its
+ * clients are always on the same machine.  A request is
+ *
+ *   uint32 magic (SRV_REQUEST_MAGIC), uint32 kind, uint32 name length,
+ *   uint32 body length, the name bytes, the body bytes
+ *
+ * where the name is the name of the source used in diagnostics, and the
+ * body is the path of the file to assemble for a SRV_PATH request or the
+ * source text for a SRV_SOURCE request.  A response is
+ *
+ *   uint32 magic (SRV_RESPONSE_MAGIC), uint32 ok, uint32 image words,
+ *   uint32 number of symbols, uint32 number of diagnostics,
+ *   the uint16 image words,
+ *   for each symbol: uint32 address, uint32 length, the symbol bytes,
+ *   for each diagnostic: uint32 line, uint32 column, uint32 code,
+ *     uint32 file length (SRV_NO_FILE if there is no file), the file bytes,
+ *     uint32 message length, the message bytes
+ *
+ * A connection can carry any number of requests one after the other.
+ */
+#include "lc3asm-lib.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef SERVER_H
+#define SERVER_H
+
+/// socket the server listens on when none is given, and the environment
+/// variable that overrides it
+#define SRV_SOCKET_DEFAULT "/tmp/lc3asm.sock"
+#define SRV_SOCKET_ENV "LC3ASM_SOCKET"
+
+/// first word of every request and response frame, "LC3Q" and "LC3R"
+#define SRV_REQUEST_MAGIC 0x5133434cU
+#define SRV_RESPONSE_MAGIC 0x5233434cU
+
+/// file length of a diagnostic that is not about a file
+#define SRV_NO_FILE 0xffffffffU
+
+/// The kinds of requests a client can send.
+typedef enum srv_request_kind
+{
+  SRV_PATH = 1,
+  SRV_SOURCE = 2,
+  SRV_SHUTDOWN = 3
+} srv_request_kind;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+const char* srv_socket_path(const char* socket_path);
+void srv_serve(const char* socket_path, bool verbose);
+lc3asm_result* srv_request(const char* socket_path, srv_request_kind kind, const char* name, const char* body,
+  size_t length);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // SERVER_H
@@ -60,9 +60,12 @@ extern "C" {
 
 symbol_table* st_construct(unsigned table_size);
 void st_destruct(symbol_table* st);
+void st_clear(symbol_table* st);
 st_entry* st_insert(symbol_table* st, const char* symbol, uint16_t address);
 st_entry* st_lookup(symbol_table* st, const char* symbol);
+void st_remove(symbol_table* st, const char* symbol);
 void st_display(symbol_table* st);
+void st_fdisplay(FILE* out, symbol_table* st);
 unsigned st_hash(symbol_table* st, const char* symbol);
 
 #ifdef TEST
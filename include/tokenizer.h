@@ -31,6 +31,16 @@ typedef struct tokens
 {
   char* line;
   unsigned linenum;
+
+  // byte offset and length of the line in the assembly file, so the
+  // line can be reread later if it is needed for a diagnostic
+  long offset;
+  unsigned length;
+
+  // the path of the included file the line is from, or NULL if it is from
+  // the file of the tokenizer, see include-cache.h
+  const char* file;
+
   int num_tokens;
   char* token[5];
 } tokens;
@@ -60,10 +70,12 @@ extern "C" {
 #endif
 
 tokenizer* tk_construct(const char* asmfile);
+tokenizer* tk_construct_buffer(const char* name, const char* source, size_t length);
 void tk_destruct(tokenizer* tk);
 void tokens_destruct(tokens* tks);
 tokens* tk_next_line(tokenizer* tk);
 char* strtokquote(char* input, char* delimit);
+char* strtokquote_r(char* input, char* delimit, char** save);
 
 #ifdef TEST
 } // end extern C for C++ test runner
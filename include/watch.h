@@ -0,0 +1,101 @@
+/** @file watch.h
+ * @brief LC-3 Assembler watch mode
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Watch mode assembles its files once, and then waits for inotify to
+ * report that one of them changed and assembles it again, instead of
+ * polling the files.  Editors save a file in bursts of writes, or by
+ * writing a new file and renaming it over the old one, so the directories
+ * of the files are watched, and a rebuild only starts once the files have
+ * been quiet for WATCH_DEBOUNCE_MS.
+ *
+ * Each file keeps an incremental assembly between builds.  A changed file
+ * is compared with the text of the last build, and only the lines that
+ * changed are edited in its incremental assembly.  A file with macros,
+ * .INCLUDEs or .INCBINs can not be assembled incrementally, see
+ * `inc_supported()`, so it is assembled in full with the warm context of
+ * the watcher, and the files it included are watched along with it.
+ */
+#include "incremental.h"
+#include "lc3asm-lib.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef WATCH_H
+#define WATCH_H
+
+/// changes are collected until the files are quiet for this many
+/// milliseconds, then the changed files are assembled
+#define WATCH_DEBOUNCE_MS 50
+
+/// A file a watched file included, and the directory watch that reports
+/// changes to it.
+typedef struct watch_dep
+{
+  char* path;
+  int wd;
+  const char* name;
+} watch_dep;
+
+/// A watched file, the text of its last build and its warm incremental
+/// assembly.
+typedef struct watch_file
+{
+  char* asmfile;
+  char* binfile;
+
+  // the directory watch that reports changes to the file, and the name of
+  // the file in that directory
+  int wd;
+  const char* name;
+
+  // the text the file had when it was last assembled, and its assembly,
+  // NULL if it was assembled in full
+  char* source;
+  size_t length;
+  inc_engine* eng;
+
+  // the files the last full assembly of the file included
+  watch_dep* deps;
+  unsigned num_deps;
+
+  // true when a change to the file has been reported since its last build
+  bool changed;
+} watch_file;
+
+/// The inotify instance and the files being watched.
+typedef struct watcher
+{
+  int fd;
+  watch_file* files;
+  unsigned num_files;
+  bool verbose;
+
+  // the context of the files that are assembled in full
+  lc3asm_context* ctx;
+
+  // the number of times a file was assembled, including the first builds
+  unsigned num_builds;
+} watcher;
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+watcher* watch_construct(char* const* asmfiles, unsigned num_files, const char* outfile, bool verbose);
+void watch_destruct(watcher* w);
+unsigned watch_wait(watcher* w, int timeout_ms);
+void watch_run(watcher* w);
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // WATCH_H
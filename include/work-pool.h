@@ -0,0 +1,43 @@
+/** @file work-pool.h
+ * @brief work stealing pool of threads for parallel loops
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * A small pool of worker threads to run the iterations of a loop
+ * in parallel.  The range of loop indexes is cut into chunks, and
+ * each worker is initially given an equal share of the chunks.  Workers
+ * claim chunks from their own share, and when their share is used up they
+ * steal unclaimed chunks from the shares of the other workers, so a worker
+ * that gets a slow share does not hold up the whole loop.  Every index
+ * in the range is processed exactly once.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+/// The work function run by the pool, it is called with the user argument
+/// and a [begin, end) range of loop indexes to process.  Work functions
+/// for the same loop run concurrently, so they must only write to data that
+/// belongs to the indexes they were given.
+typedef void (*wp_work)(void* arg, unsigned begin, unsigned end);
+
+// If we are creating tests, make all declarations extern C so can
+// work with catch2 C++ framework
+#ifdef TEST
+extern "C" {
+#endif
+
+void wp_parallel_for(unsigned num_threads, unsigned count, unsigned chunk_size, wp_work work, void* arg);
+unsigned wp_num_cpus();
+
+#ifdef TEST
+} // end extern C for C++ test runner
+#endif
+
+#endif // WORK_POOL_H
@@ -0,0 +1,88 @@
+verbose: 1
+input  file <progs/cin.asm>
+output file <output/cin.lc3>
+Pass 1 Symbol Table Results
+Symbol             ADDRESS (indx)
+---------------------------------
+SaveR1..............0x04BC (0271)
+SaveR2..............0x04BD (0272)
+SaveR3..............0x04BE (0273)
+KBSR................0x04C1 (0357)
+START...............0x04A0 (0879)
+Prompt..............0x04C4 (2340)
+DDR.................0x04C0 (2395)
+L1..................0x04A4 (2405)
+L2..................0x04AA (2406)
+L3..................0x04B2 (2407)
+L4..................0x04B5 (2408)
+DSR.................0x04BF (2860)
+Loop................0x04A8 (4137)
+Newline.............0x04C3 (4173)
+KBDR................0x04C2 (4903)
+Input...............0x04AF (4999)
+
+
+Pass 2 Assembly Results
+LABEL               OPCODE    OPERANDS                                 ADDR: INST           BINARY
+--------------------------------------------------------------------------------------------------
+                    .ORIG     0x04A0                                   04A0: 0000 0000000000000000
+START               ST        R1, SaveR1                               04A0: 321B 0011001000011011
+                    ST        R2, SaveR2                               04A1: 341B 0011010000011011
+                    ST        R3, SaveR3                               04A2: 361B 0011011000011011
+                    LD        R2, Newline                              04A3: 241F 0010010000011111
+L1                  LDI       R3, DSR                                  04A4: A61A 1010011000011010
+                    BRzp      L1                                       04A5: 07FE 0000011111111110
+                    STI       R2, DDR                                  04A6: B419 1011010000011001
+                    LEA       R1, Prompt                               04A7: E21C 1110001000011100
+Loop                LDR       R0, R1, #0                               04A8: 6040 0110000001000000
+                    BRz       Input                                    04A9: 0405 0000010000000101
+L2                  LDI       R3, DSR                                  04AA: A614 1010011000010100
+                    BRzp      L2                                       04AB: 07FE 0000011111111110
+                    STI       R0, DDR                                  04AC: B013 1011000000010011
+                    ADD       R1, R1, #1                               04AD: 1261 0001001001100001
+                    BRnzp     Loop                                     04AE: 0FF9 0000111111111001
+Input               LDI       R3, KBSR                                 04AF: A611 1010011000010001
+                    BRzp      Loop                                     04B0: 07F7 0000011111110111
+                    LDI       R0, KBDR                                 04B1: A010 1010000000010000
+L3                  LDI       R3, DSR                                  04B2: A60C 1010011000001100
+                    BRzp      L3                                       04B3: 07FE 0000011111111110
+                    STI       R0, DDR                                  04B4: B00B 1011000000001011
+L4                  LDI       R3, DSR                                  04B5: A609 1010011000001001
+                    BRzp      L4                                       04B6: 07FE 0000011111111110
+                    STI       R2, DDR                                  04B7: B408 1011010000001000
+                    LD        R1, SaveR1                               04B8: 2203 0010001000000011
+                    LD        R2, SaveR2                               04B9: 2403 0010010000000011
+                    LD        R3, SaveR3                               04BA: 2603 0010011000000011
+                    RTI                                                04BB: 8000 1000000000000000
+SaveR1              .BLKW     1                                        04BC: 0000 0000000000000000
+SaveR2              .BLKW     1                                        04BD: 0000 0000000000000000
+SaveR3              .BLKW     1                                        04BE: 0000 0000000000000000
+DSR                 .FILL     xFE04                                    04BF: FE04 1111111000000100
+DDR                 .FILL     xFE06                                    04C0: FE06 1111111000000110
+KBSR                .FILL     xFE00                                    04C1: FE00 1111111000000000
+KBDR                .FILL     xFE02                                    04C2: FE02 1111111000000010
+Newline             .FILL     x000A                                    04C3: 000A 0000000000001010
+Prompt              .STRINGZ  "Input a character>"                     04C4: 0049 0000000001001001
+                    .         .                                        04C5: 006E 0000000001101110
+                    .         .                                        04C6: 0070 0000000001110000
+                    .         .                                        04C7: 0075 0000000001110101
+                    .         .                                        04C8: 0074 0000000001110100
+                    .         .                                        04C9: 0020 0000000000100000
+                    .         .                                        04CA: 0061 0000000001100001
+                    .         .                                        04CB: 0020 0000000000100000
+                    .         .                                        04CC: 0063 0000000001100011
+                    .         .                                        04CD: 0068 0000000001101000
+                    .         .                                        04CE: 0061 0000000001100001
+                    .         .                                        04CF: 0072 0000000001110010
+                    .         .                                        04D0: 0061 0000000001100001
+                    .         .                                        04D1: 0063 0000000001100011
+                    .         .                                        04D2: 0074 0000000001110100
+                    .         .                                        04D3: 0065 0000000001100101
+                    .         .                                        04D4: 0072 0000000001110010
+                    .         .                                        04D5: 003E 0000000000111110
+                    .         .                                        04D6: 0000 0000000000000000
+                    .END                                               04D7: 0000 0000000000000000
+Assembly complete
+    bin file: <output/cin.lc3>
+    words written: <0X0039>
+    section: <0X0001> address: <0x04A0> size: <0X0037>
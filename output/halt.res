@@ -0,0 +1,64 @@
+verbose: 1
+input  file <progs/halt.asm>
+output file <output/halt.lc3>
+Pass 1 Symbol Table Results
+Symbol             ADDRESS (indx)
+---------------------------------
+SaveR0..............0x0530 (0270)
+SaveR1..............0x0531 (0271)
+ASCIINewline........0x052F (0277)
+MCR.................0x0547 (0991)
+Message.............0x0532 (2928)
+MASK................0x0548 (3850)
+
+
+Pass 2 Assembly Results
+LABEL               OPCODE    OPERANDS                                 ADDR: INST           BINARY
+--------------------------------------------------------------------------------------------------
+                    .ORIG     0x0520                                   0520: 0000 0000000000000000
+                    ST        R1, SaveR1                               0520: 3210 0011001000010000
+                    ST        R0, SaveR0                               0521: 300E 0011000000001110
+                    LD        R0, ASCIINewline                         0522: 200C 0010000000001100
+                    TRAP      x21                                      0523: F021 1111000000100001
+                    LEA       R0, Message                              0524: E00D 1110000000001101
+                    TRAP      x22                                      0525: F022 1111000000100010
+                    LD        R0, ASCIINewline                         0526: 2008 0010000000001000
+                    TRAP      x21                                      0527: F021 1111000000100001
+                    LDI       R1, MCR                                  0528: A21E 1010001000011110
+                    LD        R0, MASK                                 0529: 201E 0010000000011110
+                    AND       R0, R1, R0                               052A: 5040 0101000001000000
+                    STI       R0, MCR                                  052B: B01B 1011000000011011
+                    LD        R1, SaveR1                               052C: 2204 0010001000000100
+                    LD        R0, SaveR0                               052D: 2002 0010000000000010
+                    RTI                                                052E: 8000 1000000000000000
+ASCIINewline        .FILL     x000A                                    052F: 000A 0000000000001010
+SaveR0              .BLKW     1                                        0530: 0000 0000000000000000
+SaveR1              .BLKW     1                                        0531: 0000 0000000000000000
+Message             .STRINGZ  "Halting the machine."                   0532: 0048 0000000001001000
+                    .         .                                        0533: 0061 0000000001100001
+                    .         .                                        0534: 006C 0000000001101100
+                    .         .                                        0535: 0074 0000000001110100
+                    .         .                                        0536: 0069 0000000001101001
+                    .         .                                        0537: 006E 0000000001101110
+                    .         .                                        0538: 0067 0000000001100111
+                    .         .                                        0539: 0020 0000000000100000
+                    .         .                                        053A: 0074 0000000001110100
+                    .         .                                        053B: 0068 0000000001101000
+                    .         .                                        053C: 0065 0000000001100101
+                    .         .                                        053D: 0020 0000000000100000
+                    .         .                                        053E: 006D 0000000001101101
+                    .         .                                        053F: 0061 0000000001100001
+                    .         .                                        0540: 0063 0000000001100011
+                    .         .                                        0541: 0068 0000000001101000
+                    .         .                                        0542: 0069 0000000001101001
+                    .         .                                        0543: 006E 0000000001101110
+                    .         .                                        0544: 0065 0000000001100101
+                    .         .                                        0545: 002E 0000000000101110
+                    .         .                                        0546: 0000 0000000000000000
+MCR                 .FILL     xFFFE                                    0547: FFFE 1111111111111110
+MASK                .FILL     x7FFF                                    0548: 7FFF 0111111111111111
+                    .END                                               0549: 0000 0000000000000000
+Assembly complete
+    bin file: <output/halt.lc3>
+    words written: <0X002B>
+    section: <0X0001> address: <0x0520> size: <0X0029>
@@ -0,0 +1,48 @@
+verbose: 1
+input  file <progs/multiply-by-six.asm>
+output file <output/multiply-by-six.lc3>
+Pass 1 Symbol Table Results
+Symbol             ADDRESS (indx)
+---------------------------------
+MSG.................0x305D (1476)
+SIX.................0x305C (1938)
+AGAIN...............0x3053 (2278)
+NUMBER..............0x3057 (3147)
+
+
+Pass 2 Assembly Results
+LABEL               OPCODE    OPERANDS                                 ADDR: INST           BINARY
+--------------------------------------------------------------------------------------------------
+                    .ORIG     0x3050                                   3050: 0000 0000000000000000
+                    LD        R1, SIX                                  3050: 220B 0010001000001011
+                    LD        R2, NUMBER                               3051: 2405 0010010000000101
+                    AND       R3, R3, #0                               3052: 56E0 0101011011100000
+AGAIN               ADD       R3, R3, R2                               3053: 16C2 0001011011000010
+                    ADD       R1, R1, #-1                              3054: 127F 0001001001111111
+                    BRp       AGAIN                                    3055: 03FD 0000001111111101
+                    TRAP      0x25                                     3056: F025 1111000000100101
+NUMBER              .BLKW     5                                        3057: 0000 0000000000000000
+                    .         .                                        3058: 0000 0000000000000000
+                    .         .                                        3059: 0000 0000000000000000
+                    .         .                                        305A: 0000 0000000000000000
+                    .         .                                        305B: 0000 0000000000000000
+SIX                 .FILL     0x0006                                   305C: 0006 0000000000000110
+MSG                 .STRINGZ  "Error Message"                          305D: 0045 0000000001000101
+                    .         .                                        305E: 0072 0000000001110010
+                    .         .                                        305F: 0072 0000000001110010
+                    .         .                                        3060: 006F 0000000001101111
+                    .         .                                        3061: 0072 0000000001110010
+                    .         .                                        3062: 0020 0000000000100000
+                    .         .                                        3063: 004D 0000000001001101
+                    .         .                                        3064: 0065 0000000001100101
+                    .         .                                        3065: 0073 0000000001110011
+                    .         .                                        3066: 0073 0000000001110011
+                    .         .                                        3067: 0061 0000000001100001
+                    .         .                                        3068: 0067 0000000001100111
+                    .         .                                        3069: 0065 0000000001100101
+                    .         .                                        306A: 0000 0000000000000000
+                    .END                                               306B: 0000 0000000000000000
+Assembly complete
+    bin file: <output/multiply-by-six.lc3>
+    words written: <0X001D>
+    section: <0X0001> address: <0x3050> size: <0X001B>
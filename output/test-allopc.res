@@ -0,0 +1,62 @@
+verbose: 1
+input  file <progs/test-allopc.asm>
+output file <output/test-allopc.lc3>
+Pass 1 Symbol Table Results
+Symbol             ADDRESS (indx)
+---------------------------------
+SUBS................0x3059 (0857)
+START...............0x3050 (0879)
+LOADS...............0x305B (1362)
+MSG.................0x3066 (1476)
+SIX.................0x3065 (1938)
+ARITH...............0x305E (2265)
+AGAIN...............0x3053 (2278)
+NUMBER..............0x3060 (3147)
+ALL.................0x3057 (4765)
+
+
+Pass 2 Assembly Results
+LABEL               OPCODE    OPERANDS                                 ADDR: INST           BINARY
+--------------------------------------------------------------------------------------------------
+                    .ORIG     0x3050                                   3050: 0000 0000000000000000
+START               LD        R1, SIX                                  3050: 2214 0010001000010100
+                    LD        R2, NUMBER                               3051: 240E 0010010000001110
+                    AND       R3, R3, #0                               3052: 56E0 0101011011100000
+AGAIN               ADD       R3, R3, R2                               3053: 16C2 0001011011000010
+                    ADD       R1, R1, #-1                              3054: 127F 0001001001111111
+                    BRp       AGAIN                                    3055: 03FD 0000001111111101
+                    BRzp      START                                    3056: 07F9 0000011111111001
+ALL                 JMP       R4                                       3057: C100 1100000100000000
+                    RET                                                3058: C1C0 1100000111000000
+SUBS                JSR       START                                    3059: 4FF6 0100111111110110
+                    JSRR      R3                                       305A: 40C0 0100000011000000
+LOADS               LDI       R5, NUMBER                               305B: AA04 1010101000000100
+                    LDR       R6, R4, 0x22                             305C: 6D22 0110110100100010
+                    LEA       R2, AGAIN                                305D: E5F5 1110010111110101
+ARITH               NOT       R4, R5                                   305E: 997F 1001100101111111
+                    TRAP      0x25                                     305F: F025 1111000000100101
+NUMBER              .BLKW     5                                        3060: 0000 0000000000000000
+                    .         .                                        3061: 0000 0000000000000000
+                    .         .                                        3062: 0000 0000000000000000
+                    .         .                                        3063: 0000 0000000000000000
+                    .         .                                        3064: 0000 0000000000000000
+SIX                 .FILL     0x0006                                   3065: 0006 0000000000000110
+MSG                 .STRINGZ  "Error Message"                          3066: 0045 0000000001000101
+                    .         .                                        3067: 0072 0000000001110010
+                    .         .                                        3068: 0072 0000000001110010
+                    .         .                                        3069: 006F 0000000001101111
+                    .         .                                        306A: 0072 0000000001110010
+                    .         .                                        306B: 0020 0000000000100000
+                    .         .                                        306C: 004D 0000000001001101
+                    .         .                                        306D: 0065 0000000001100101
+                    .         .                                        306E: 0073 0000000001110011
+                    .         .                                        306F: 0073 0000000001110011
+                    .         .                                        3070: 0061 0000000001100001
+                    .         .                                        3071: 0067 0000000001100111
+                    .         .                                        3072: 0065 0000000001100101
+                    .         .                                        3073: 0000 0000000000000000
+                    .END                                               3074: 0000 0000000000000000
+Assembly complete
+    bin file: <output/test-allopc.lc3>
+    words written: <0X0026>
+    section: <0X0001> address: <0x3050> size: <0X0024>
@@ -0,0 +1,273 @@
+verbose: 1
+input  file <progs/trap-vector.asm>
+output file <output/trap-vector.lc3>
+Pass 1 Symbol Table Results
+Symbol             ADDRESS (indx)
+---------------------------------
+
+
+Pass 2 Assembly Results
+LABEL               OPCODE    OPERANDS                                 ADDR: INST           BINARY
+--------------------------------------------------------------------------------------------------
+                    .ORIG     0x0000                                   0000: 0000 0000000000000000
+                    .BLKW     x20                                      0000: 0000 0000000000000000
+                    .         .                                        0001: 0000 0000000000000000
+                    .         .                                        0002: 0000 0000000000000000
+                    .         .                                        0003: 0000 0000000000000000
+                    .         .                                        0004: 0000 0000000000000000
+                    .         .                                        0005: 0000 0000000000000000
+                    .         .                                        0006: 0000 0000000000000000
+                    .         .                                        0007: 0000 0000000000000000
+                    .         .                                        0008: 0000 0000000000000000
+                    .         .                                        0009: 0000 0000000000000000
+                    .         .                                        000A: 0000 0000000000000000
+                    .         .                                        000B: 0000 0000000000000000
+                    .         .                                        000C: 0000 0000000000000000
+                    .         .                                        000D: 0000 0000000000000000
+                    .         .                                        000E: 0000 0000000000000000
+                    .         .                                        000F: 0000 0000000000000000
+                    .         .                                        0010: 0000 0000000000000000
+                    .         .                                        0011: 0000 0000000000000000
+                    .         .                                        0012: 0000 0000000000000000
+                    .         .                                        0013: 0000 0000000000000000
+                    .         .                                        0014: 0000 0000000000000000
+                    .         .                                        0015: 0000 0000000000000000
+                    .         .                                        0016: 0000 0000000000000000
+                    .         .                                        0017: 0000 0000000000000000
+                    .         .                                        0018: 0000 0000000000000000
+                    .         .                                        0019: 0000 0000000000000000
+                    .         .                                        001A: 0000 0000000000000000
+                    .         .                                        001B: 0000 0000000000000000
+                    .         .                                        001C: 0000 0000000000000000
+                    .         .                                        001D: 0000 0000000000000000
+                    .         .                                        001E: 0000 0000000000000000
+                    .         .                                        001F: 0000 0000000000000000
+                    .FILL     0x03E0                                   0020: 03E0 0000001111100000
+                    .FILL     0x0420                                   0021: 0420 0000010000100000
+                    .FILL     0x0460                                   0022: 0460 0000010001100000
+                    .FILL     0x04A0                                   0023: 04A0 0000010010100000
+                    .FILL     0x04E0                                   0024: 04E0 0000010011100000
+                    .FILL     0x0520                                   0025: 0520 0000010100100000
+                    .BLKW     xDA                                      0026: 0000 0000000000000000
+                    .         .                                        0027: 0000 0000000000000000
+                    .         .                                        0028: 0000 0000000000000000
+                    .         .                                        0029: 0000 0000000000000000
+                    .         .                                        002A: 0000 0000000000000000
+                    .         .                                        002B: 0000 0000000000000000
+                    .         .                                        002C: 0000 0000000000000000
+                    .         .                                        002D: 0000 0000000000000000
+                    .         .                                        002E: 0000 0000000000000000
+                    .         .                                        002F: 0000 0000000000000000
+                    .         .                                        0030: 0000 0000000000000000
+                    .         .                                        0031: 0000 0000000000000000
+                    .         .                                        0032: 0000 0000000000000000
+                    .         .                                        0033: 0000 0000000000000000
+                    .         .                                        0034: 0000 0000000000000000
+                    .         .                                        0035: 0000 0000000000000000
+                    .         .                                        0036: 0000 0000000000000000
+                    .         .                                        0037: 0000 0000000000000000
+                    .         .                                        0038: 0000 0000000000000000
+                    .         .                                        0039: 0000 0000000000000000
+                    .         .                                        003A: 0000 0000000000000000
+                    .         .                                        003B: 0000 0000000000000000
+                    .         .                                        003C: 0000 0000000000000000
+                    .         .                                        003D: 0000 0000000000000000
+                    .         .                                        003E: 0000 0000000000000000
+                    .         .                                        003F: 0000 0000000000000000
+                    .         .                                        0040: 0000 0000000000000000
+                    .         .                                        0041: 0000 0000000000000000
+                    .         .                                        0042: 0000 0000000000000000
+                    .         .                                        0043: 0000 0000000000000000
+                    .         .                                        0044: 0000 0000000000000000
+                    .         .                                        0045: 0000 0000000000000000
+                    .         .                                        0046: 0000 0000000000000000
+                    .         .                                        0047: 0000 0000000000000000
+                    .         .                                        0048: 0000 0000000000000000
+                    .         .                                        0049: 0000 0000000000000000
+                    .         .                                        004A: 0000 0000000000000000
+                    .         .                                        004B: 0000 0000000000000000
+                    .         .                                        004C: 0000 0000000000000000
+                    .         .                                        004D: 0000 0000000000000000
+                    .         .                                        004E: 0000 0000000000000000
+                    .         .                                        004F: 0000 0000000000000000
+                    .         .                                        0050: 0000 0000000000000000
+                    .         .                                        0051: 0000 0000000000000000
+                    .         .                                        0052: 0000 0000000000000000
+                    .         .                                        0053: 0000 0000000000000000
+                    .         .                                        0054: 0000 0000000000000000
+                    .         .                                        0055: 0000 0000000000000000
+                    .         .                                        0056: 0000 0000000000000000
+                    .         .                                        0057: 0000 0000000000000000
+                    .         .                                        0058: 0000 0000000000000000
+                    .         .                                        0059: 0000 0000000000000000
+                    .         .                                        005A: 0000 0000000000000000
+                    .         .                                        005B: 0000 0000000000000000
+                    .         .                                        005C: 0000 0000000000000000
+                    .         .                                        005D: 0000 0000000000000000
+                    .         .                                        005E: 0000 0000000000000000
+                    .         .                                        005F: 0000 0000000000000000
+                    .         .                                        0060: 0000 0000000000000000
+                    .         .                                        0061: 0000 0000000000000000
+                    .         .                                        0062: 0000 0000000000000000
+                    .         .                                        0063: 0000 0000000000000000
+                    .         .                                        0064: 0000 0000000000000000
+                    .         .                                        0065: 0000 0000000000000000
+                    .         .                                        0066: 0000 0000000000000000
+                    .         .                                        0067: 0000 0000000000000000
+                    .         .                                        0068: 0000 0000000000000000
+                    .         .                                        0069: 0000 0000000000000000
+                    .         .                                        006A: 0000 0000000000000000
+                    .         .                                        006B: 0000 0000000000000000
+                    .         .                                        006C: 0000 0000000000000000
+                    .         .                                        006D: 0000 0000000000000000
+                    .         .                                        006E: 0000 0000000000000000
+                    .         .                                        006F: 0000 0000000000000000
+                    .         .                                        0070: 0000 0000000000000000
+                    .         .                                        0071: 0000 0000000000000000
+                    .         .                                        0072: 0000 0000000000000000
+                    .         .                                        0073: 0000 0000000000000000
+                    .         .                                        0074: 0000 0000000000000000
+                    .         .                                        0075: 0000 0000000000000000
+                    .         .                                        0076: 0000 0000000000000000
+                    .         .                                        0077: 0000 0000000000000000
+                    .         .                                        0078: 0000 0000000000000000
+                    .         .                                        0079: 0000 0000000000000000
+                    .         .                                        007A: 0000 0000000000000000
+                    .         .                                        007B: 0000 0000000000000000
+                    .         .                                        007C: 0000 0000000000000000
+                    .         .                                        007D: 0000 0000000000000000
+                    .         .                                        007E: 0000 0000000000000000
+                    .         .                                        007F: 0000 0000000000000000
+                    .         .                                        0080: 0000 0000000000000000
+                    .         .                                        0081: 0000 0000000000000000
+                    .         .                                        0082: 0000 0000000000000000
+                    .         .                                        0083: 0000 0000000000000000
+                    .         .                                        0084: 0000 0000000000000000
+                    .         .                                        0085: 0000 0000000000000000
+                    .         .                                        0086: 0000 0000000000000000
+                    .         .                                        0087: 0000 0000000000000000
+                    .         .                                        0088: 0000 0000000000000000
+                    .         .                                        0089: 0000 0000000000000000
+                    .         .                                        008A: 0000 0000000000000000
+                    .         .                                        008B: 0000 0000000000000000
+                    .         .                                        008C: 0000 0000000000000000
+                    .         .                                        008D: 0000 0000000000000000
+                    .         .                                        008E: 0000 0000000000000000
+                    .         .                                        008F: 0000 0000000000000000
+                    .         .                                        0090: 0000 0000000000000000
+                    .         .                                        0091: 0000 0000000000000000
+                    .         .                                        0092: 0000 0000000000000000
+                    .         .                                        0093: 0000 0000000000000000
+                    .         .                                        0094: 0000 0000000000000000
+                    .         .                                        0095: 0000 0000000000000000
+                    .         .                                        0096: 0000 0000000000000000
+                    .         .                                        0097: 0000 0000000000000000
+                    .         .                                        0098: 0000 0000000000000000
+                    .         .                                        0099: 0000 0000000000000000
+                    .         .                                        009A: 0000 0000000000000000
+                    .         .                                        009B: 0000 0000000000000000
+                    .         .                                        009C: 0000 0000000000000000
+                    .         .                                        009D: 0000 0000000000000000
+                    .         .                                        009E: 0000 0000000000000000
+                    .         .                                        009F: 0000 0000000000000000
+                    .         .                                        00A0: 0000 0000000000000000
+                    .         .                                        00A1: 0000 0000000000000000
+                    .         .                                        00A2: 0000 0000000000000000
+                    .         .                                        00A3: 0000 0000000000000000
+                    .         .                                        00A4: 0000 0000000000000000
+                    .         .                                        00A5: 0000 0000000000000000
+                    .         .                                        00A6: 0000 0000000000000000
+                    .         .                                        00A7: 0000 0000000000000000
+                    .         .                                        00A8: 0000 0000000000000000
+                    .         .                                        00A9: 0000 0000000000000000
+                    .         .                                        00AA: 0000 0000000000000000
+                    .         .                                        00AB: 0000 0000000000000000
+                    .         .                                        00AC: 0000 0000000000000000
+                    .         .                                        00AD: 0000 0000000000000000
+                    .         .                                        00AE: 0000 0000000000000000
+                    .         .                                        00AF: 0000 0000000000000000
+                    .         .                                        00B0: 0000 0000000000000000
+                    .         .                                        00B1: 0000 0000000000000000
+                    .         .                                        00B2: 0000 0000000000000000
+                    .         .                                        00B3: 0000 0000000000000000
+                    .         .                                        00B4: 0000 0000000000000000
+                    .         .                                        00B5: 0000 0000000000000000
+                    .         .                                        00B6: 0000 0000000000000000
+                    .         .                                        00B7: 0000 0000000000000000
+                    .         .                                        00B8: 0000 0000000000000000
+                    .         .                                        00B9: 0000 0000000000000000
+                    .         .                                        00BA: 0000 0000000000000000
+                    .         .                                        00BB: 0000 0000000000000000
+                    .         .                                        00BC: 0000 0000000000000000
+                    .         .                                        00BD: 0000 0000000000000000
+                    .         .                                        00BE: 0000 0000000000000000
+                    .         .                                        00BF: 0000 0000000000000000
+                    .         .                                        00C0: 0000 0000000000000000
+                    .         .                                        00C1: 0000 0000000000000000
+                    .         .                                        00C2: 0000 0000000000000000
+                    .         .                                        00C3: 0000 0000000000000000
+                    .         .                                        00C4: 0000 0000000000000000
+                    .         .                                        00C5: 0000 0000000000000000
+                    .         .                                        00C6: 0000 0000000000000000
+                    .         .                                        00C7: 0000 0000000000000000
+                    .         .                                        00C8: 0000 0000000000000000
+                    .         .                                        00C9: 0000 0000000000000000
+                    .         .                                        00CA: 0000 0000000000000000
+                    .         .                                        00CB: 0000 0000000000000000
+                    .         .                                        00CC: 0000 0000000000000000
+                    .         .                                        00CD: 0000 0000000000000000
+                    .         .                                        00CE: 0000 0000000000000000
+                    .         .                                        00CF: 0000 0000000000000000
+                    .         .                                        00D0: 0000 0000000000000000
+                    .         .                                        00D1: 0000 0000000000000000
+                    .         .                                        00D2: 0000 0000000000000000
+                    .         .                                        00D3: 0000 0000000000000000
+                    .         .                                        00D4: 0000 0000000000000000
+                    .         .                                        00D5: 0000 0000000000000000
+                    .         .                                        00D6: 0000 0000000000000000
+                    .         .                                        00D7: 0000 0000000000000000
+                    .         .                                        00D8: 0000 0000000000000000
+                    .         .                                        00D9: 0000 0000000000000000
+                    .         .                                        00DA: 0000 0000000000000000
+                    .         .                                        00DB: 0000 0000000000000000
+                    .         .                                        00DC: 0000 0000000000000000
+                    .         .                                        00DD: 0000 0000000000000000
+                    .         .                                        00DE: 0000 0000000000000000
+                    .         .                                        00DF: 0000 0000000000000000
+                    .         .                                        00E0: 0000 0000000000000000
+                    .         .                                        00E1: 0000 0000000000000000
+                    .         .                                        00E2: 0000 0000000000000000
+                    .         .                                        00E3: 0000 0000000000000000
+                    .         .                                        00E4: 0000 0000000000000000
+                    .         .                                        00E5: 0000 0000000000000000
+                    .         .                                        00E6: 0000 0000000000000000
+                    .         .                                        00E7: 0000 0000000000000000
+                    .         .                                        00E8: 0000 0000000000000000
+                    .         .                                        00E9: 0000 0000000000000000
+                    .         .                                        00EA: 0000 0000000000000000
+                    .         .                                        00EB: 0000 0000000000000000
+                    .         .                                        00EC: 0000 0000000000000000
+                    .         .                                        00ED: 0000 0000000000000000
+                    .         .                                        00EE: 0000 0000000000000000
+                    .         .                                        00EF: 0000 0000000000000000
+                    .         .                                        00F0: 0000 0000000000000000
+                    .         .                                        00F1: 0000 0000000000000000
+                    .         .                                        00F2: 0000 0000000000000000
+                    .         .                                        00F3: 0000 0000000000000000
+                    .         .                                        00F4: 0000 0000000000000000
+                    .         .                                        00F5: 0000 0000000000000000
+                    .         .                                        00F6: 0000 0000000000000000
+                    .         .                                        00F7: 0000 0000000000000000
+                    .         .                                        00F8: 0000 0000000000000000
+                    .         .                                        00F9: 0000 0000000000000000
+                    .         .                                        00FA: 0000 0000000000000000
+                    .         .                                        00FB: 0000 0000000000000000
+                    .         .                                        00FC: 0000 0000000000000000
+                    .         .                                        00FD: 0000 0000000000000000
+                    .         .                                        00FE: 0000 0000000000000000
+                    .         .                                        00FF: 0000 0000000000000000
+                    .END                                               0100: 0000 0000000000000000
+Assembly complete
+    bin file: <output/trap-vector.lc3>
+    words written: <0X0102>
+    section: <0X0001> address: <0x0000> size: <0X0100>
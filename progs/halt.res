@@ -58,7 +58,6 @@ Message             .STRINGZ  "Halting the machine."                   0532: 004
 MCR                 .FILL     xFFFE                                    0547: FFFE 1111111111111110
 MASK                .FILL     x7FFF                                    0548: 7FFF 0111111111111111
                     .END                                               0549: 0000 0000000000000000
-                    .END                                               0549: 0000 0000000000000000
 Assembly complete
     bin file: <output/halt.lc3>
     words written: <0X002B>
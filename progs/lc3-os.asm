@@ -0,0 +1,151 @@
+; The LC-3 operating system image
+;
+; The trap vector table and the OUT, IN and HALT service routines,
+; assembled as one program with a section for each .ORIG/.END block,
+; so the whole image is assembled and loaded in one step.  Labels are
+; global to the file, so the labels the routines share are prefixed with
+; the name of their routine.
+;
+; Define the trap vector service table
+;
+; Patt & Patel Figure 9.10
+; 
+; 0020: x03E0 x20 GETC
+; 0021: x0420 x21 OUT
+; 0022: x0460 x22 PUTS
+; 0023: x04A0 x23 IN 
+; 0024: x04E0 x24 PUTSP
+; 0025: x0520 x25 HALT
+	.ORIG	0x0000			; Trap vector service table starts at top of memory 0x0000
+	.BLKW	x20			; addresses 0x0000 - 0x0019 are not used
+	.FILL	0x03E0			; x20 GETC
+	.FILL	0x0420			; x21 OUT
+	.FILL	0x0460			; x22 PUTS
+	.FILL	0x04A0			; x23 IN 
+	.FILL	0x04E0			; x24 PUTSP
+	.FILL	0x0520			; x25 HALT
+	.BLKW	xDA			; Ensure 0x26 - 0xFF are also 0 on load, in case garbage there on machine start
+	.END
+
+; Service Routine for console output
+;
+; Patt & Patel Figure 9.12
+; x21 OUT
+; x0420 Trap Service Vector
+;
+; Write a character in R0[7:0] to console display
+	.ORIG	0x0420
+	ST	R1, OutSaveR1		; R1 will be used to poll the DSR
+					; hardware
+; Write the character
+TryWrite LDI	R1, OutDSR			; Get status 
+	BRzp	TryWrite		; Bit 15 on says display is ready
+WriteIt	STI	R0, OutDDR			; Write character
+
+; return from trap 
+Return	LD	R1, OutSaveR1		; Restore registers 
+		RTI 			; Return from trap 
+;
+OutDSR	.FILL	xFE04			; Address of display status register
+OutDDR	.FILL	xFE06			; Address of display data register
+OutSaveR1	.BLKW	1
+	.END
+
+; Service Routine for Keyboard Input
+;
+; Patt & Patel Figure 9.12
+; x23 IN
+; x04A0 Trap Service Vector
+;
+; Print a prompt on the screen and read a single character
+; from keyboard.  The character is echoed onto the console
+; monitor, and it ASCII code is copied into RO.  The high
+; 8 bits of R0 are cleared.
+        .ORIG   0x04A0
+START   ST      R1, InSaveR1              ; Save the values in the registers
+        ST      R2, SaveR2              ; that are used so that they
+        ST      R3, SaveR3              ; can be restored before RET 
+;
+        LD      R2, Newline
+L1      LDI     R3, InDSR                 ; Check DDR -- is it free?
+        BRzp    L1
+        STI     R2, InDDR                 ; Move cursor to new clean line
+;
+        LEA     R1, Prompt              ; Prompt is starting address
+                                        ; of prompt string 
+Loop    LDR     R0, R1, #0              ; Get next prompt character
+        BRz     Input                   ; Check for end of prompt string 
+L2      LDI     R3, InDSR
+        BRzp    L2
+        STI     R0, InDDR                 ; Write next character of
+                                        ; prompt string 
+        ADD     R1, R1, #1              ; Increment prompt pointer
+        BRnzp   Loop 
+;
+Input   LDI     R3, KBSR                ; Has a character been typed?
+        BRzp    Loop
+        LDI     R0, KBDR                ; Load it into R0 
+L3      LDI     R3, InDSR 
+        BRzp    L3 
+        STI     R0, InDDR                 ; Echo input character 
+                                        ; to the monitor 
+;
+L4      LDI     R3, InDSR
+        BRzp    L4 
+        STI     R2, InDDR                 ; Move cursor to new clean line 
+        LD      R1, InSaveR1              ; Service routine done, restore 
+        LD      R2, SaveR2              ; original values in registers.
+        LD      R3, SaveR3
+        RTI                             ; Return from Trap
+;
+InSaveR1  .BLKW   1
+SaveR2  .BLKW   1
+SaveR3  .BLKW   1
+InDSR     .FILL   xFE04
+InDDR     .FILL   xFE06
+KBSR    .FILL   xFE00
+KBDR    .FILL   xFE02
+Newline .FILL   x000A                   ; ASCII code for newline 
+Prompt  .STRINGZ "Input a character>"
+        .END
+
+; Service Routine to halt machine
+;
+; Patt & Patel Figure 9.12
+; x25 HALT
+; x0520 Trap Service Vector
+;
+; Halt execution and print a message on the console
+	.ORIG	0x0520
+	ST	R1, HaltSaveR1		; R1 a temp for MC register
+	ST	R0, SaveR0		; R0 is used as working space
+
+; print message that mchine is halting
+	LD	R0, ASCIINewline
+	TRAP 	x21
+	LEA	R0, Message 
+	TRAP	x22
+	LD	R0, ASCIINewline
+	TRAP 	x21
+
+; clear bit 15 at xFFFE to stop the machine
+	LDI	R1, MCR			; Load MC register into R1
+	LD	R0, MASK		; R0 = x7FFF
+	AND 	R0, R1, R0		; Mask to clear the top bit 
+	STI	R0, MCR			; Store R0 into MC register
+
+; return from HALT routine.
+; (how can this routine return if machine is halted above?)
+	LD	R1, HaltSaveR1		; Restore registers
+	LD	R0, SaveR0
+	RTI 
+
+;
+; Some constants
+ASCIINewline .FILL x000A
+SaveR0	.BLKW	1
+HaltSaveR1	.BLKW	1
+Message	.STRINGZ "Halting the machine."
+MCR	.FILL	xFFFE			; Address of MCR
+MASK	.FILL	x7FFF			; Mask to clear the top bit
+	.END
@@ -0,0 +1,415 @@
+verbose: 1
+input  file <progs/lc3-os.asm>
+output file <output/lc3-os.lc3>
+Pass 1 Symbol Table Results
+Symbol             ADDRESS (indx)
+---------------------------------
+SaveR0..............0x0530 (0270)
+SaveR2..............0x04BD (0272)
+SaveR3..............0x04BE (0273)
+ASCIINewline........0x052F (0277)
+OutSaveR1...........0x0428 (0330)
+KBSR................0x04C1 (0357)
+InSaveR1............0x04BC (0576)
+START...............0x04A0 (0879)
+MCR.................0x0547 (0991)
+InDDR...............0x04C0 (1250)
+HaltSaveR1..........0x0531 (1543)
+InDSR...............0x04BF (1715)
+Return..............0x0424 (1886)
+Prompt..............0x04C4 (2340)
+L1..................0x04A4 (2405)
+L2..................0x04AA (2406)
+L3..................0x04B2 (2407)
+L4..................0x04B5 (2408)
+Message.............0x0532 (2928)
+OutDDR..............0x0427 (3437)
+TryWrite............0x0421 (3712)
+MASK................0x0548 (3850)
+OutDSR..............0x0426 (3902)
+WriteIt.............0x0423 (3978)
+Loop................0x04A8 (4137)
+Newline.............0x04C3 (4173)
+KBDR................0x04C2 (4903)
+Input...............0x04AF (4999)
+
+
+Pass 2 Assembly Results
+LABEL               OPCODE    OPERANDS                                 ADDR: INST           BINARY
+--------------------------------------------------------------------------------------------------
+                    .ORIG     0x0000                                   0000: 0000 0000000000000000
+                    .BLKW     x20                                      0000: 0000 0000000000000000
+                    .         .                                        0001: 0000 0000000000000000
+                    .         .                                        0002: 0000 0000000000000000
+                    .         .                                        0003: 0000 0000000000000000
+                    .         .                                        0004: 0000 0000000000000000
+                    .         .                                        0005: 0000 0000000000000000
+                    .         .                                        0006: 0000 0000000000000000
+                    .         .                                        0007: 0000 0000000000000000
+                    .         .                                        0008: 0000 0000000000000000
+                    .         .                                        0009: 0000 0000000000000000
+                    .         .                                        000A: 0000 0000000000000000
+                    .         .                                        000B: 0000 0000000000000000
+                    .         .                                        000C: 0000 0000000000000000
+                    .         .                                        000D: 0000 0000000000000000
+                    .         .                                        000E: 0000 0000000000000000
+                    .         .                                        000F: 0000 0000000000000000
+                    .         .                                        0010: 0000 0000000000000000
+                    .         .                                        0011: 0000 0000000000000000
+                    .         .                                        0012: 0000 0000000000000000
+                    .         .                                        0013: 0000 0000000000000000
+                    .         .                                        0014: 0000 0000000000000000
+                    .         .                                        0015: 0000 0000000000000000
+                    .         .                                        0016: 0000 0000000000000000
+                    .         .                                        0017: 0000 0000000000000000
+                    .         .                                        0018: 0000 0000000000000000
+                    .         .                                        0019: 0000 0000000000000000
+                    .         .                                        001A: 0000 0000000000000000
+                    .         .                                        001B: 0000 0000000000000000
+                    .         .                                        001C: 0000 0000000000000000
+                    .         .                                        001D: 0000 0000000000000000
+                    .         .                                        001E: 0000 0000000000000000
+                    .         .                                        001F: 0000 0000000000000000
+                    .FILL     0x03E0                                   0020: 03E0 0000001111100000
+                    .FILL     0x0420                                   0021: 0420 0000010000100000
+                    .FILL     0x0460                                   0022: 0460 0000010001100000
+                    .FILL     0x04A0                                   0023: 04A0 0000010010100000
+                    .FILL     0x04E0                                   0024: 04E0 0000010011100000
+                    .FILL     0x0520                                   0025: 0520 0000010100100000
+                    .BLKW     xDA                                      0026: 0000 0000000000000000
+                    .         .                                        0027: 0000 0000000000000000
+                    .         .                                        0028: 0000 0000000000000000
+                    .         .                                        0029: 0000 0000000000000000
+                    .         .                                        002A: 0000 0000000000000000
+                    .         .                                        002B: 0000 0000000000000000
+                    .         .                                        002C: 0000 0000000000000000
+                    .         .                                        002D: 0000 0000000000000000
+                    .         .                                        002E: 0000 0000000000000000
+                    .         .                                        002F: 0000 0000000000000000
+                    .         .                                        0030: 0000 0000000000000000
+                    .         .                                        0031: 0000 0000000000000000
+                    .         .                                        0032: 0000 0000000000000000
+                    .         .                                        0033: 0000 0000000000000000
+                    .         .                                        0034: 0000 0000000000000000
+                    .         .                                        0035: 0000 0000000000000000
+                    .         .                                        0036: 0000 0000000000000000
+                    .         .                                        0037: 0000 0000000000000000
+                    .         .                                        0038: 0000 0000000000000000
+                    .         .                                        0039: 0000 0000000000000000
+                    .         .                                        003A: 0000 0000000000000000
+                    .         .                                        003B: 0000 0000000000000000
+                    .         .                                        003C: 0000 0000000000000000
+                    .         .                                        003D: 0000 0000000000000000
+                    .         .                                        003E: 0000 0000000000000000
+                    .         .                                        003F: 0000 0000000000000000
+                    .         .                                        0040: 0000 0000000000000000
+                    .         .                                        0041: 0000 0000000000000000
+                    .         .                                        0042: 0000 0000000000000000
+                    .         .                                        0043: 0000 0000000000000000
+                    .         .                                        0044: 0000 0000000000000000
+                    .         .                                        0045: 0000 0000000000000000
+                    .         .                                        0046: 0000 0000000000000000
+                    .         .                                        0047: 0000 0000000000000000
+                    .         .                                        0048: 0000 0000000000000000
+                    .         .                                        0049: 0000 0000000000000000
+                    .         .                                        004A: 0000 0000000000000000
+                    .         .                                        004B: 0000 0000000000000000
+                    .         .                                        004C: 0000 0000000000000000
+                    .         .                                        004D: 0000 0000000000000000
+                    .         .                                        004E: 0000 0000000000000000
+                    .         .                                        004F: 0000 0000000000000000
+                    .         .                                        0050: 0000 0000000000000000
+                    .         .                                        0051: 0000 0000000000000000
+                    .         .                                        0052: 0000 0000000000000000
+                    .         .                                        0053: 0000 0000000000000000
+                    .         .                                        0054: 0000 0000000000000000
+                    .         .                                        0055: 0000 0000000000000000
+                    .         .                                        0056: 0000 0000000000000000
+                    .         .                                        0057: 0000 0000000000000000
+                    .         .                                        0058: 0000 0000000000000000
+                    .         .                                        0059: 0000 0000000000000000
+                    .         .                                        005A: 0000 0000000000000000
+                    .         .                                        005B: 0000 0000000000000000
+                    .         .                                        005C: 0000 0000000000000000
+                    .         .                                        005D: 0000 0000000000000000
+                    .         .                                        005E: 0000 0000000000000000
+                    .         .                                        005F: 0000 0000000000000000
+                    .         .                                        0060: 0000 0000000000000000
+                    .         .                                        0061: 0000 0000000000000000
+                    .         .                                        0062: 0000 0000000000000000
+                    .         .                                        0063: 0000 0000000000000000
+                    .         .                                        0064: 0000 0000000000000000
+                    .         .                                        0065: 0000 0000000000000000
+                    .         .                                        0066: 0000 0000000000000000
+                    .         .                                        0067: 0000 0000000000000000
+                    .         .                                        0068: 0000 0000000000000000
+                    .         .                                        0069: 0000 0000000000000000
+                    .         .                                        006A: 0000 0000000000000000
+                    .         .                                        006B: 0000 0000000000000000
+                    .         .                                        006C: 0000 0000000000000000
+                    .         .                                        006D: 0000 0000000000000000
+                    .         .                                        006E: 0000 0000000000000000
+                    .         .                                        006F: 0000 0000000000000000
+                    .         .                                        0070: 0000 0000000000000000
+                    .         .                                        0071: 0000 0000000000000000
+                    .         .                                        0072: 0000 0000000000000000
+                    .         .                                        0073: 0000 0000000000000000
+                    .         .                                        0074: 0000 0000000000000000
+                    .         .                                        0075: 0000 0000000000000000
+                    .         .                                        0076: 0000 0000000000000000
+                    .         .                                        0077: 0000 0000000000000000
+                    .         .                                        0078: 0000 0000000000000000
+                    .         .                                        0079: 0000 0000000000000000
+                    .         .                                        007A: 0000 0000000000000000
+                    .         .                                        007B: 0000 0000000000000000
+                    .         .                                        007C: 0000 0000000000000000
+                    .         .                                        007D: 0000 0000000000000000
+                    .         .                                        007E: 0000 0000000000000000
+                    .         .                                        007F: 0000 0000000000000000
+                    .         .                                        0080: 0000 0000000000000000
+                    .         .                                        0081: 0000 0000000000000000
+                    .         .                                        0082: 0000 0000000000000000
+                    .         .                                        0083: 0000 0000000000000000
+                    .         .                                        0084: 0000 0000000000000000
+                    .         .                                        0085: 0000 0000000000000000
+                    .         .                                        0086: 0000 0000000000000000
+                    .         .                                        0087: 0000 0000000000000000
+                    .         .                                        0088: 0000 0000000000000000
+                    .         .                                        0089: 0000 0000000000000000
+                    .         .                                        008A: 0000 0000000000000000
+                    .         .                                        008B: 0000 0000000000000000
+                    .         .                                        008C: 0000 0000000000000000
+                    .         .                                        008D: 0000 0000000000000000
+                    .         .                                        008E: 0000 0000000000000000
+                    .         .                                        008F: 0000 0000000000000000
+                    .         .                                        0090: 0000 0000000000000000
+                    .         .                                        0091: 0000 0000000000000000
+                    .         .                                        0092: 0000 0000000000000000
+                    .         .                                        0093: 0000 0000000000000000
+                    .         .                                        0094: 0000 0000000000000000
+                    .         .                                        0095: 0000 0000000000000000
+                    .         .                                        0096: 0000 0000000000000000
+                    .         .                                        0097: 0000 0000000000000000
+                    .         .                                        0098: 0000 0000000000000000
+                    .         .                                        0099: 0000 0000000000000000
+                    .         .                                        009A: 0000 0000000000000000
+                    .         .                                        009B: 0000 0000000000000000
+                    .         .                                        009C: 0000 0000000000000000
+                    .         .                                        009D: 0000 0000000000000000
+                    .         .                                        009E: 0000 0000000000000000
+                    .         .                                        009F: 0000 0000000000000000
+                    .         .                                        00A0: 0000 0000000000000000
+                    .         .                                        00A1: 0000 0000000000000000
+                    .         .                                        00A2: 0000 0000000000000000
+                    .         .                                        00A3: 0000 0000000000000000
+                    .         .                                        00A4: 0000 0000000000000000
+                    .         .                                        00A5: 0000 0000000000000000
+                    .         .                                        00A6: 0000 0000000000000000
+                    .         .                                        00A7: 0000 0000000000000000
+                    .         .                                        00A8: 0000 0000000000000000
+                    .         .                                        00A9: 0000 0000000000000000
+                    .         .                                        00AA: 0000 0000000000000000
+                    .         .                                        00AB: 0000 0000000000000000
+                    .         .                                        00AC: 0000 0000000000000000
+                    .         .                                        00AD: 0000 0000000000000000
+                    .         .                                        00AE: 0000 0000000000000000
+                    .         .                                        00AF: 0000 0000000000000000
+                    .         .                                        00B0: 0000 0000000000000000
+                    .         .                                        00B1: 0000 0000000000000000
+                    .         .                                        00B2: 0000 0000000000000000
+                    .         .                                        00B3: 0000 0000000000000000
+                    .         .                                        00B4: 0000 0000000000000000
+                    .         .                                        00B5: 0000 0000000000000000
+                    .         .                                        00B6: 0000 0000000000000000
+                    .         .                                        00B7: 0000 0000000000000000
+                    .         .                                        00B8: 0000 0000000000000000
+                    .         .                                        00B9: 0000 0000000000000000
+                    .         .                                        00BA: 0000 0000000000000000
+                    .         .                                        00BB: 0000 0000000000000000
+                    .         .                                        00BC: 0000 0000000000000000
+                    .         .                                        00BD: 0000 0000000000000000
+                    .         .                                        00BE: 0000 0000000000000000
+                    .         .                                        00BF: 0000 0000000000000000
+                    .         .                                        00C0: 0000 0000000000000000
+                    .         .                                        00C1: 0000 0000000000000000
+                    .         .                                        00C2: 0000 0000000000000000
+                    .         .                                        00C3: 0000 0000000000000000
+                    .         .                                        00C4: 0000 0000000000000000
+                    .         .                                        00C5: 0000 0000000000000000
+                    .         .                                        00C6: 0000 0000000000000000
+                    .         .                                        00C7: 0000 0000000000000000
+                    .         .                                        00C8: 0000 0000000000000000
+                    .         .                                        00C9: 0000 0000000000000000
+                    .         .                                        00CA: 0000 0000000000000000
+                    .         .                                        00CB: 0000 0000000000000000
+                    .         .                                        00CC: 0000 0000000000000000
+                    .         .                                        00CD: 0000 0000000000000000
+                    .         .                                        00CE: 0000 0000000000000000
+                    .         .                                        00CF: 0000 0000000000000000
+                    .         .                                        00D0: 0000 0000000000000000
+                    .         .                                        00D1: 0000 0000000000000000
+                    .         .                                        00D2: 0000 0000000000000000
+                    .         .                                        00D3: 0000 0000000000000000
+                    .         .                                        00D4: 0000 0000000000000000
+                    .         .                                        00D5: 0000 0000000000000000
+                    .         .                                        00D6: 0000 0000000000000000
+                    .         .                                        00D7: 0000 0000000000000000
+                    .         .                                        00D8: 0000 0000000000000000
+                    .         .                                        00D9: 0000 0000000000000000
+                    .         .                                        00DA: 0000 0000000000000000
+                    .         .                                        00DB: 0000 0000000000000000
+                    .         .                                        00DC: 0000 0000000000000000
+                    .         .                                        00DD: 0000 0000000000000000
+                    .         .                                        00DE: 0000 0000000000000000
+                    .         .                                        00DF: 0000 0000000000000000
+                    .         .                                        00E0: 0000 0000000000000000
+                    .         .                                        00E1: 0000 0000000000000000
+                    .         .                                        00E2: 0000 0000000000000000
+                    .         .                                        00E3: 0000 0000000000000000
+                    .         .                                        00E4: 0000 0000000000000000
+                    .         .                                        00E5: 0000 0000000000000000
+                    .         .                                        00E6: 0000 0000000000000000
+                    .         .                                        00E7: 0000 0000000000000000
+                    .         .                                        00E8: 0000 0000000000000000
+                    .         .                                        00E9: 0000 0000000000000000
+                    .         .                                        00EA: 0000 0000000000000000
+                    .         .                                        00EB: 0000 0000000000000000
+                    .         .                                        00EC: 0000 0000000000000000
+                    .         .                                        00ED: 0000 0000000000000000
+                    .         .                                        00EE: 0000 0000000000000000
+                    .         .                                        00EF: 0000 0000000000000000
+                    .         .                                        00F0: 0000 0000000000000000
+                    .         .                                        00F1: 0000 0000000000000000
+                    .         .                                        00F2: 0000 0000000000000000
+                    .         .                                        00F3: 0000 0000000000000000
+                    .         .                                        00F4: 0000 0000000000000000
+                    .         .                                        00F5: 0000 0000000000000000
+                    .         .                                        00F6: 0000 0000000000000000
+                    .         .                                        00F7: 0000 0000000000000000
+                    .         .                                        00F8: 0000 0000000000000000
+                    .         .                                        00F9: 0000 0000000000000000
+                    .         .                                        00FA: 0000 0000000000000000
+                    .         .                                        00FB: 0000 0000000000000000
+                    .         .                                        00FC: 0000 0000000000000000
+                    .         .                                        00FD: 0000 0000000000000000
+                    .         .                                        00FE: 0000 0000000000000000
+                    .         .                                        00FF: 0000 0000000000000000
+                    .END                                               0100: 0000 0000000000000000
+                    .ORIG     0x0420                                   0420: 0000 0000000000000000
+                    ST        R1, OutSaveR1                            0420: 3207 0011001000000111
+TryWrite            LDI       R1, OutDSR                               0421: A204 1010001000000100
+                    BRzp      TryWrite                                 0422: 07FE 0000011111111110
+WriteIt             STI       R0, OutDDR                               0423: B003 1011000000000011
+Return              LD        R1, OutSaveR1                            0424: 2203 0010001000000011
+                    RTI                                                0425: 8000 1000000000000000
+OutDSR              .FILL     xFE04                                    0426: FE04 1111111000000100
+OutDDR              .FILL     xFE06                                    0427: FE06 1111111000000110
+OutSaveR1           .BLKW     1                                        0428: 0000 0000000000000000
+                    .END                                               0429: 0000 0000000000000000
+                    .ORIG     0x04A0                                   04A0: 0000 0000000000000000
+START               ST        R1, InSaveR1                             04A0: 321B 0011001000011011
+                    ST        R2, SaveR2                               04A1: 341B 0011010000011011
+                    ST        R3, SaveR3                               04A2: 361B 0011011000011011
+                    LD        R2, Newline                              04A3: 241F 0010010000011111
+L1                  LDI       R3, InDSR                                04A4: A61A 1010011000011010
+                    BRzp      L1                                       04A5: 07FE 0000011111111110
+                    STI       R2, InDDR                                04A6: B419 1011010000011001
+                    LEA       R1, Prompt                               04A7: E21C 1110001000011100
+Loop                LDR       R0, R1, #0                               04A8: 6040 0110000001000000
+                    BRz       Input                                    04A9: 0405 0000010000000101
+L2                  LDI       R3, InDSR                                04AA: A614 1010011000010100
+                    BRzp      L2                                       04AB: 07FE 0000011111111110
+                    STI       R0, InDDR                                04AC: B013 1011000000010011
+                    ADD       R1, R1, #1                               04AD: 1261 0001001001100001
+                    BRnzp     Loop                                     04AE: 0FF9 0000111111111001
+Input               LDI       R3, KBSR                                 04AF: A611 1010011000010001
+                    BRzp      Loop                                     04B0: 07F7 0000011111110111
+                    LDI       R0, KBDR                                 04B1: A010 1010000000010000
+L3                  LDI       R3, InDSR                                04B2: A60C 1010011000001100
+                    BRzp      L3                                       04B3: 07FE 0000011111111110
+                    STI       R0, InDDR                                04B4: B00B 1011000000001011
+L4                  LDI       R3, InDSR                                04B5: A609 1010011000001001
+                    BRzp      L4                                       04B6: 07FE 0000011111111110
+                    STI       R2, InDDR                                04B7: B408 1011010000001000
+                    LD        R1, InSaveR1                             04B8: 2203 0010001000000011
+                    LD        R2, SaveR2                               04B9: 2403 0010010000000011
+                    LD        R3, SaveR3                               04BA: 2603 0010011000000011
+                    RTI                                                04BB: 8000 1000000000000000
+InSaveR1            .BLKW     1                                        04BC: 0000 0000000000000000
+SaveR2              .BLKW     1                                        04BD: 0000 0000000000000000
+SaveR3              .BLKW     1                                        04BE: 0000 0000000000000000
+InDSR               .FILL     xFE04                                    04BF: FE04 1111111000000100
+InDDR               .FILL     xFE06                                    04C0: FE06 1111111000000110
+KBSR                .FILL     xFE00                                    04C1: FE00 1111111000000000
+KBDR                .FILL     xFE02                                    04C2: FE02 1111111000000010
+Newline             .FILL     x000A                                    04C3: 000A 0000000000001010
+Prompt              .STRINGZ  "Input a character>"                     04C4: 0049 0000000001001001
+                    .         .                                        04C5: 006E 0000000001101110
+                    .         .                                        04C6: 0070 0000000001110000
+                    .         .                                        04C7: 0075 0000000001110101
+                    .         .                                        04C8: 0074 0000000001110100
+                    .         .                                        04C9: 0020 0000000000100000
+                    .         .                                        04CA: 0061 0000000001100001
+                    .         .                                        04CB: 0020 0000000000100000
+                    .         .                                        04CC: 0063 0000000001100011
+                    .         .                                        04CD: 0068 0000000001101000
+                    .         .                                        04CE: 0061 0000000001100001
+                    .         .                                        04CF: 0072 0000000001110010
+                    .         .                                        04D0: 0061 0000000001100001
+                    .         .                                        04D1: 0063 0000000001100011
+                    .         .                                        04D2: 0074 0000000001110100
+                    .         .                                        04D3: 0065 0000000001100101
+                    .         .                                        04D4: 0072 0000000001110010
+                    .         .                                        04D5: 003E 0000000000111110
+                    .         .                                        04D6: 0000 0000000000000000
+                    .END                                               04D7: 0000 0000000000000000
+                    .ORIG     0x0520                                   0520: 0000 0000000000000000
+                    ST        R1, HaltSaveR1                           0520: 3210 0011001000010000
+                    ST        R0, SaveR0                               0521: 300E 0011000000001110
+                    LD        R0, ASCIINewline                         0522: 200C 0010000000001100
+                    TRAP      x21                                      0523: F021 1111000000100001
+                    LEA       R0, Message                              0524: E00D 1110000000001101
+                    TRAP      x22                                      0525: F022 1111000000100010
+                    LD        R0, ASCIINewline                         0526: 2008 0010000000001000
+                    TRAP      x21                                      0527: F021 1111000000100001
+                    LDI       R1, MCR                                  0528: A21E 1010001000011110
+                    LD        R0, MASK                                 0529: 201E 0010000000011110
+                    AND       R0, R1, R0                               052A: 5040 0101000001000000
+                    STI       R0, MCR                                  052B: B01B 1011000000011011
+                    LD        R1, HaltSaveR1                           052C: 2204 0010001000000100
+                    LD        R0, SaveR0                               052D: 2002 0010000000000010
+                    RTI                                                052E: 8000 1000000000000000
+ASCIINewline        .FILL     x000A                                    052F: 000A 0000000000001010
+SaveR0              .BLKW     1                                        0530: 0000 0000000000000000
+HaltSaveR1          .BLKW     1                                        0531: 0000 0000000000000000
+Message             .STRINGZ  "Halting the machine."                   0532: 0048 0000000001001000
+                    .         .                                        0533: 0061 0000000001100001
+                    .         .                                        0534: 006C 0000000001101100
+                    .         .                                        0535: 0074 0000000001110100
+                    .         .                                        0536: 0069 0000000001101001
+                    .         .                                        0537: 006E 0000000001101110
+                    .         .                                        0538: 0067 0000000001100111
+                    .         .                                        0539: 0020 0000000000100000
+                    .         .                                        053A: 0074 0000000001110100
+                    .         .                                        053B: 0068 0000000001101000
+                    .         .                                        053C: 0065 0000000001100101
+                    .         .                                        053D: 0020 0000000000100000
+                    .         .                                        053E: 006D 0000000001101101
+                    .         .                                        053F: 0061 0000000001100001
+                    .         .                                        0540: 0063 0000000001100011
+                    .         .                                        0541: 0068 0000000001101000
+                    .         .                                        0542: 0069 0000000001101001
+                    .         .                                        0543: 006E 0000000001101110
+                    .         .                                        0544: 0065 0000000001100101
+                    .         .                                        0545: 002E 0000000000101110
+                    .         .                                        0546: 0000 0000000000000000
+MCR                 .FILL     xFFFE                                    0547: FFFE 1111111111111110
+MASK                .FILL     x7FFF                                    0548: 7FFF 0111111111111111
+                    .END                                               0549: 0000 0000000000000000
+Assembly complete
+    bin file: <output/lc3-os.lc3>
+    words written: <0X0171>
+    section: <0X0001> address: <0x0000> size: <0X0100>
+    section: <0X0002> address: <0x0420> size: <0X0009>
+    section: <0X0003> address: <0x04A0> size: <0X0037>
+    section: <0X0004> address: <0x0520> size: <0X0029>
@@ -267,7 +267,6 @@ LABEL               OPCODE    OPERANDS                                 ADDR: INS
                     .         .                                        00FE: 0000 0000000000000000
                     .         .                                        00FF: 0000 0000000000000000
                     .END                                               0100: 0000 0000000000000000
-                    .END                                               0100: 0000 0000000000000000
 Assembly complete
     bin file: <output/trap-vector.lc3>
     words written: <0X0102>
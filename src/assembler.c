@@ -12,21 +12,125 @@
  * in the `pass_one()` and `pass_two()` functions to implement the
  * two pass translation process.  This module makes use of the
  * `symbol-table` module to build and maintain a dictionary of
- * labels and addresses encountered in pass 1, and a linked list of
+ * labels and addresses encountered in pass 1, and a list of
  * `operation-list` entries that is constructed in pass 1, and processed
  * and completed to assemble the machine instructions and final binary
  * file in pass two.
  */
+#define _XOPEN_SOURCE 700
 #include "assembler.h"
+#include "dead-code.h"
+#include "diagnostic.h"
+#include "encoder.h"
+#include "flow-graph.h"
+#include "lc3asm-lib.h"
+#include "literal-pool.h"
 #include "opcode.h"
 #include "operand.h"
 #include "operation-list.h"
+#include "macro.h"
+#include "peephole.h"
+#include "relax.h"
 #include "symbol-table.h"
 #include "tokenizer.h"
+#include "work-pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+/// What the assembly of a file has to free when an error stops it.  It is
+/// kept off the stack, so it is still valid after a fatal error jumps back
+/// to the trap of `lc3asm_file()` or `lc3asm_stream_file()`.
+typedef struct file_assembly
+{
+  // the errors of the file, and the JSON file they are written to, or NULL
+  diag_sink sink;
+  char* diagfile;
+
+  // the binary file name made from the input file name, or NULL
+  char* binfile_name;
+
+  // the binary file being streamed and its name, the partly written file
+  // is removed if an error stops the assembly
+  const char* binfile;
+  FILE* out;
+
+  tokenizer* tk;
+  symbol_table* st;
+  operation_list* opl;
+} file_assembly;
+
+/** @brief begin file assembly
+ *
+ * Start the assembly of a file, its errors are collected in the sink of
+ * the assembly until `end_file_assembly()`.
+ *
+ * @returns file_assembly* The newly allocated assembly.
+ */
+static file_assembly* begin_file_assembly()
+{
+  file_assembly* fa = (file_assembly*)calloc(1, sizeof(file_assembly));
+  if (fa == NULL)
+  {
+    diag_fatal(NULL, 0, "<assembler::begin_file_assembly> error allocating assembly");
+  }
+  diag_sink_construct(&fa->sink, NULL);
+  return fa;
+}
+
+/** @brief end file assembly
+ *
+ * Report every error of the assembly of a file, including the one in the
+ * trap that stopped it, if any, and free the assembly.
+ *
+ * @param fa The assembly.
+ * @param trap The trap of the assembly, already cleared.
+ * @param previous_sink The sink to set again.
+ *
+ * @returns bool true if the file assembled without errors.
+ */
+static bool end_file_assembly(file_assembly* fa, diag_trap* trap, diag_sink* previous_sink)
+{
+  if (trap->diag.message != NULL)
+  {
+    diag_sink_add(&fa->sink, trap->diag);
+  }
+  bool ok = fa->sink.num_errors == 0;
+  if (fa->sink.num_diags > 0)
+  {
+    fflush(stdout);
+  }
+  diag_sink_report(&fa->sink);
+  diag_set_sink(previous_sink);
+
+  if (fa->out != NULL)
+  {
+    fclose(fa->out);
+    remove(fa->binfile);
+  }
+  if (fa->tk != NULL)
+  {
+    tk_destruct(fa->tk);
+  }
+  if (fa->st != NULL)
+  {
+    st_destruct(fa->st);
+  }
+  if (fa->opl != NULL)
+  {
+    opl_destruct(fa->opl);
+  }
+  diag_sink_destruct(&fa->sink);
+  free(fa->diagfile);
+  free(fa->binfile_name);
+  free(fa);
+  return ok;
+}
 
 /** @brief LC-3 Assembler
  *
@@ -45,21 +149,132 @@
  * @param binfile The name of the resulting binary/executable file that
  *   should be written after a successful 2 pass translation.
  * @param verbose If true we display results of symbol table creation in
- *   pass one, and linked list opcode/operand translation in pass two
+ *   pass one, and operation list opcode/operand translation in pass two
  *   on standard output during the assembly process.
+ * @param flags The assembly flags, LC3ASM_OPTIMIZE runs the peephole
+ *   optimizer and the literal pool between pass one and pass two, see
+ *   peephole.h and literal-pool.h, and
+ *   LC3ASM_DEPFILE writes a make dependency file next to the binary file,
+ *   see `write_dep_file()`, LC3ASM_DEADCODE removes the code and data
+ *   the program can not reach before them, see dead-code.h, and
+ *   LC3ASM_ANALYZE reports the routines, loops and worst cases of the
+ *   program after pass two, see flow-graph.h, and LC3ASM_DIAGFILE also
+ *   writes the errors as JSON next to the binary file, see
+ *   `diag_file_name()`.  The errors of the source are collected in a
+ *   diagnostic sink, and all of them are reported after pass two, see
+ *   diagnostic.h, before the assembler exits, see `lc3asm_file()`.
+ * @param num_threads The number of threads to assemble with in pass two,
+ *   1 for a serial pass two, 0 for one thread per cpu.
+ * @param ch The output cache, or NULL.  If the same source has been
+ *   assembled before its outputs are copied from the cache instead, and
+ *   otherwise the outputs of this assembly are added to the cache.
+ */
+void lc3asm(const char* asmfile, const char* binfile, bool verbose, unsigned flags, unsigned num_threads, cache* ch)
+{
+  if (!lc3asm_file(asmfile, binfile, verbose, flags, num_threads, ch))
+  {
+    exit(1);
+  }
+}
+
+/** @brief assemble file
+ *
+ * The passes of `lc3asm_file()`, the errors are recorded in the sink of
+ * the assembly, and everything it allocates is kept in the assembly, so
+ * it is freed even when a fatal error stops it.
  */
-void lc3asm(const char* asmfile, const char* binfile, bool verbose)
+static void assemble_file(file_assembly* fa, const char* asmfile, const char* binfile, bool verbose, unsigned flags,
+  unsigned num_threads, cache* ch)
 {
+  // determine output file name, and look for the outputs in the cache,
+  // a source that can not be read is left for the tokenizer to report
+  if (!binfile)
+  {
+    binfile = fa->binfile_name = bin_file_name(asmfile);
+  }
+  if (flags & LC3ASM_DIAGFILE)
+  {
+    fa->sink.json_file = fa->diagfile = diag_file_name(binfile);
+  }
+
+  char key[CACHE_KEY_SIZE];
+  size_t length;
+  // the analysis needs the operation list, so it is never copied from the
+  // cache
+  char* source = ch && !(flags & LC3ASM_ANALYZE) ? lc3asm_read_source(asmfile, &length) : NULL;
+  bool cacheable = source != NULL && cache_cacheable(source, length);
+  if (cacheable)
+  {
+    cache_key(source, length, flags & LC3ASM_OUTPUT_FLAGS, key);
+  }
+  free(source);
+  if (cacheable && cache_fetch(ch, key, binfile, verbose))
+  {
+    if (verbose)
+    {
+      printf("Pass 1 Symbol Table Results\n");
+      cache_display(ch, key, CACHE_SYMBOLS);
+      printf("\n\nPass 2 Assembly Results\n");
+      cache_display(ch, key, CACHE_LISTING);
+      display_bin_file(binfile);
+    }
+    // a cached source includes no files, it only depends on itself
+    if (flags & LC3ASM_DEPFILE)
+    {
+      char* depfile = dep_file_name(binfile);
+      write_dep_file(depfile, binfile, asmfile, NULL);
+      free(depfile);
+    }
+    return;
+  }
+
   // create symbol table and tokenizer needed in pass 1 and
   // pass 2
-  tokenizer* tk = tk_construct(asmfile);
-  symbol_table* st = st_construct(0);
+  tokenizer* tk = fa->tk = tk_construct(asmfile);
+  symbol_table* st = fa->st = st_construct(0);
   operation_list* opl;
 
   // perform pass 1 which fills in the symbol table and returns
   // the list of partially processed operation lines from the pass
   // to be used in pass two
-  opl = pass_one(tk, st);
+  opl = fa->opl = pass_one(tk, st);
+
+  // remove the routines and data nothing reaches, before the optimizer
+  // looks at them, the passes that change the program only run on a
+  // program without errors
+  if ((flags & LC3ASM_DEADCODE) && fa->sink.num_errors == 0)
+  {
+    dead_stats dead = dead_code(opl, st);
+    printf("Dead code removed <%u> unreachable instructions and <%u> words of unreferenced data in <%u> blocks, "
+           "<%u> words saved\n",
+      dead.num_instructions, dead.num_data_words, dead.num_blocks, dead.num_instructions + dead.num_data_words);
+  }
+
+  // remove the instructions that do not change what the program does, and
+  // the constants another one already holds, before relaxation so it sees
+  // the final distances to the labels
+  if ((flags & LC3ASM_OPTIMIZE) && fa->sink.num_errors == 0)
+  {
+    peep_stats optimized = peephole(opl, st);
+    printf("Peephole optimized in <%u> passes\n", optimized.num_passes);
+    for (unsigned rule = 0; rule < PEEP_NUM_RULES; rule++)
+    {
+      printf("    %-12s <%u> instructions removed, <%u> words and <%u> cycles saved\n", peep_rule_name(rule),
+        optimized.num_removed[rule], optimized.num_removed[rule], optimized.cycles_saved[rule]);
+    }
+    pool_stats pooled = pool_literals(opl, st);
+    printf("Literal pool merged <%u> .FILL constants into <%u> slots, <%u> words saved\n", pooled.num_merged,
+      pooled.num_slots, pooled.num_merged);
+  }
+
+  // rewrite the operations that can not reach their labels, this moves the
+  // code after them so it is done before the symbol table is shown
+  relax_stats relaxed = relax(opl, st);
+  if (relaxed.num_relaxed > 0)
+  {
+    printf("Relaxed <%u> operations out of range of their labels in <%u> passes, <%u> words added\n",
+      relaxed.num_relaxed, relaxed.num_passes, relaxed.words_added);
+  }
   if (verbose)
   {
     printf("Pass 1 Symbol Table Results\n");
@@ -68,24 +283,462 @@ void lc3asm(const char* asmfile, const char* binfile, bool verbose)
 
   // perform pass 2, which requires the symbol table and the operation list
   // created in pass 1
-  pass_two(opl, st);
+  pass_two_parallel(opl, st, num_threads);
+
+  // every error has been found once pass two is done, the errors stop the
+  // assembly before anything is written
+  if (fa->sink.num_errors > 0)
+  {
+    return;
+  }
   if (verbose)
   {
     printf("\n\nPass 2 Assembly Results\n");
     opl_display(opl);
   }
+  if (flags & LC3ASM_ANALYZE)
+  {
+    flow_graph* fg = fg_construct(opl, st);
+    fg_display(fg);
+    fg_destruct(fg);
+  }
+
+  // write the assembled binary file, and keep the outputs in the cache,
+  // unless there were warnings, like relaxed operations, which a cache hit
+  // would not report
+  write_bin_file(binfile, opl, verbose);
+  if (cacheable && fa->sink.num_diags == 0)
+  {
+    cache_store(ch, key, binfile, st, opl);
+  }
+  if (flags & LC3ASM_DEPFILE)
+  {
+    char* depfile = dep_file_name(binfile);
+    write_dep_file(depfile, binfile, asmfile, opl);
+    free(depfile);
+  }
+}
+
+/** @brief LC-3 Assembler of a file
+ *
+ * Assemble a file like `lc3asm()`, but return when it has errors instead
+ * of exiting, so a batch of files goes on to the next one.  The errors
+ * that only spoil their line are collected and reported after pass two,
+ * and an error that stops the assembly, like a file that can not be read,
+ * is caught and reported with them.  Nothing is written if there were
+ * errors.
+ *
+ * @param asmfile The name of the input file with LC-3 assembly.
+ * @param binfile The name of the binary file, if NULL the name is
+ *   determined from asmfile.
+ * @param verbose If true we display the results of the passes.
+ * @param flags The assembly flags, see `lc3asm()`.
+ * @param num_threads The number of threads to assemble with in pass two,
+ *   1 for a serial pass two, 0 for one thread per cpu.
+ * @param ch The output cache, or NULL.
+ *
+ * @returns bool true if the file assembled without errors.
+ */
+bool lc3asm_file(const char* asmfile, const char* binfile, bool verbose, unsigned flags, unsigned num_threads,
+  cache* ch)
+{
+  file_assembly* fa = begin_file_assembly();
+  diag_sink* previous_sink = diag_set_sink(&fa->sink);
+  diag_trap trap;
+  diag_set_trap(&trap);
+  if (setjmp(trap.jump) == 0)
+  {
+    assemble_file(fa, asmfile, binfile, verbose, flags, num_threads, ch);
+  }
+  diag_clear_trap(&trap);
+  return end_file_assembly(fa, &trap, previous_sink);
+}
+
+/** @brief streaming LC-3 Assembler
+ *
+ * Assemble a file into LC-3 machine instructions in a single streaming
+ * pass, see `pass_stream()`.  Unlike `lc3asm()` the machine words are
+ * written to the binary file as soon as they can be assembled, and the
+ * operation list only ever holds the operations with forward references
+ * still waiting on a symbol.  Since most of the operations are never kept,
+ * the verbose output shows the symbol table but not the assembly listing.
+ *
+ * @param asmfile The name of the input file with LC-3 assembly
+ *   operation lines to be parsed and assembled into a binary file.
+ * @param binfile The name of the resulting binary/executable file, if
+ *   NULL the name is determined from asmfile.
+ * @param verbose If true we display the symbol table and statistics
+ *   about the assembly on standard output.
+ */
+void lc3asm_stream(const char* asmfile, const char* binfile, bool verbose)
+{
+  if (!lc3asm_stream_file(asmfile, binfile, verbose))
+  {
+    exit(1);
+  }
+}
+
+/** @brief stream file
+ *
+ * The streaming pass of `lc3asm_stream_file()`, everything it allocates is
+ * kept in the assembly, so it is freed even when a fatal error stops it.
+ */
+static void stream_file(file_assembly* fa, const char* asmfile, const char* binfile, bool verbose)
+{
+  tokenizer* tk = fa->tk = tk_construct(asmfile);
+  symbol_table* st = fa->st = st_construct(0);
 
-  // determine output file name and write the assembled binary file
   if (!binfile)
   {
-    binfile = bin_file_name(asmfile);
+    binfile = fa->binfile_name = bin_file_name(asmfile);
   }
-  write_bin_file(binfile, opl, verbose);
+  fa->binfile = binfile;
+  FILE* out = fa->out = fopen(binfile, "wb");
+  if (out == NULL)
+  {
+    diag_fatal(NULL, 0, "<assembler::lc3asm_stream> error could not open file <%s>", binfile);
+  }
+
+  unsigned max_pending;
+  size_t total_writ = pass_stream(tk, st, out, &max_pending);
+  fa->out = NULL;
+  fclose(out);
+
+  // the code before an error was already written, so the file is removed
+  if (fa->sink.num_errors > 0)
+  {
+    remove(binfile);
+    return;
+  }
+
+  if (verbose)
+  {
+    printf("Streaming Assembly Symbol Table Results\n");
+    st_display(st);
+    printf("\n\nAssembly complete\n");
+    printf("    bin file: <%s>\n", binfile);
+    printf("    words written: <0X%04X>\n", (int)total_writ);
+    printf("    most operations waiting on forward references: <%u>\n", max_pending);
+  }
+}
+
+/** @brief streaming LC-3 Assembler of a file
+ *
+ * Assemble a file like `lc3asm_stream()`, but return when it has errors
+ * instead of exiting, see `lc3asm_file()`.  The errors are collected and
+ * reported at the end, and the binary file is removed if there were any.
+ *
+ * @param asmfile The name of the input file with LC-3 assembly.
+ * @param binfile The name of the binary file, if NULL the name is
+ *   determined from asmfile.
+ * @param verbose If true we display the symbol table and statistics
+ *   about the assembly on standard output.
+ *
+ * @returns bool true if the file assembled without errors.
+ */
+bool lc3asm_stream_file(const char* asmfile, const char* binfile, bool verbose)
+{
+  file_assembly* fa = begin_file_assembly();
+  diag_sink* previous_sink = diag_set_sink(&fa->sink);
+  diag_trap trap;
+  diag_set_trap(&trap);
+  if (setjmp(trap.jump) == 0)
+  {
+    stream_file(fa, asmfile, binfile, verbose);
+  }
+  diag_clear_trap(&trap);
+  return end_file_assembly(fa, &trap, previous_sink);
+}
+
+/** @brief write diagnostic file
+ *
+ * Write the errors of one file of a batch as JSON, to the file
+ * `diag_file_name()` names after its binary file.
+ *
+ * @param binfile The name of the binary file of the source.
+ * @param diags The errors and warnings of the source.
+ * @param num_diags The number of errors and warnings.
+ */
+static void write_diag_file(const char* binfile, diagnostic* diags, unsigned num_diags)
+{
+  char* diagfile = diag_file_name(binfile);
+  FILE* out = fopen(diagfile, "w");
+  if (out != NULL)
+  {
+    diag_sink sink = {.diags = diags, .num_diags = num_diags};
+    diag_write_json(&sink, out);
+    fclose(out);
+  }
+  else
+  {
+    fprintf(stderr, "<assembler::write_diag_file> error could not open file <%s>\n", diagfile);
+  }
+  free(diagfile);
+}
+
+/** @brief batch LC-3 Assembler
+ *
+ * Assemble a batch of files concurrently, see `lc3asm_assemble_files()`.
+ * Each file is written to the binary file named after it.  The errors of
+ * each file are kept until the whole batch is done, and then reported on
+ * standard error in the order the files were given, so the output does
+ * not depend on which thread finished first.  An error in one file does
+ * not stop the rest of the batch.
+ *
+ * @param asmfiles The names of the input files with LC-3 assembly.
+ * @param num_files The number of files.
+ * @param flags The assembly flags, only LC3ASM_DIAGFILE is supported in a
+ *   batch, it writes the errors of each file as JSON next to its binary
+ *   file, see `diag_file_name()`, an empty array for a file found in the
+ *   cache.
+ * @param num_threads The number of threads to assemble with, 0 for one
+ *   thread per cpu.
+ * @param ch The output cache, or NULL.  Files found in the cache are
+ *   copied from it, and the rest are assembled and added to it.
+ *
+ * @returns bool true if every file assembled without errors.
+ */
+bool lc3asm_batch(char* const* asmfiles, unsigned num_files, unsigned flags, unsigned num_threads, cache* ch)
+{
+  char** binfiles = (char**)malloc(num_files * sizeof(char*));
+  for (unsigned idx = 0; idx < num_files; idx++)
+  {
+    binfiles[idx] = bin_file_name(asmfiles[idx]);
+  }
+
+  // copy the files found in the cache, only the misses are assembled
+  const char** miss_asm = (const char**)malloc(num_files * sizeof(char*));
+  const char** miss_bin = (const char**)malloc(num_files * sizeof(char*));
+  char(*miss_key)[CACHE_KEY_SIZE] = malloc(num_files * CACHE_KEY_SIZE);
+  unsigned* miss_idx = (unsigned*)malloc(num_files * sizeof(unsigned));
+  unsigned num_misses = 0;
+  for (unsigned idx = 0; idx < num_files; idx++)
+  {
+    size_t length;
+    char* source = ch ? lc3asm_read_source(asmfiles[idx], &length) : NULL;
+    bool cacheable = source != NULL && cache_cacheable(source, length);
+    miss_key[num_misses][0] = '\0';
+    if (cacheable)
+    {
+      cache_key(source, length, 0, miss_key[num_misses]);
+    }
+    free(source);
+    if (cacheable && cache_fetch(ch, miss_key[num_misses], binfiles[idx], false))
+    {
+      if (flags & LC3ASM_DIAGFILE)
+      {
+        write_diag_file(binfiles[idx], NULL, 0);
+      }
+      continue;
+    }
+    miss_asm[num_misses] = asmfiles[idx];
+    miss_bin[num_misses] = binfiles[idx];
+    miss_idx[num_misses] = idx;
+    num_misses++;
+  }
+
+  lc3asm_result** results = lc3asm_assemble_files(miss_asm, miss_bin, num_misses, num_threads);
+
+  bool ok = true;
+  for (unsigned miss = 0; miss < num_misses; miss++)
+  {
+    lc3asm_result* result = results[miss];
+    for (unsigned index = 0; index < result->num_diagnostics; index++)
+    {
+      diag_print(stderr, &result->diagnostics[index]);
+    }
+    if (flags & LC3ASM_DIAGFILE)
+    {
+      write_diag_file(miss_bin[miss], result->diagnostics, result->num_diagnostics);
+    }
+    if (result->ok && result->num_diagnostics == 0 && miss_key[miss][0] != '\0')
+    {
+      cache_store(ch, miss_key[miss], miss_bin[miss], NULL, NULL);
+    }
+    ok = ok && result->ok;
+    lc3asm_result_destruct(result);
+  }
+  for (unsigned idx = 0; idx < num_files; idx++)
+  {
+    free(binfiles[idx]);
+  }
+  free(results);
+  free(miss_asm);
+  free(miss_bin);
+  free(miss_key);
+  free(miss_idx);
+  free(binfiles);
+  return ok;
+}
+
+/** @brief patch section header
+ *
+ * Fill in the placeholder header of a section of a binary file that is
+ * being streamed, and go back to the end of the file.
+ */
+static void patch_section(FILE* out, long section_pos, uint16_t section_address, uint16_t section_size)
+{
+  fseek(out, section_pos, SEEK_SET);
+  fwrite(&section_address, WORD_SIZE, 1, out);
+  fwrite(&section_size, WORD_SIZE, 1, out);
+  fseek(out, 0, SEEK_END);
+}
+
+/** @brief streaming assembly pass
+ *
+ * Assemble while reading the file, in one pass.  Each line gets the work
+ * of pass one done on it, and then if every SYMBOL operand of the operation
+ * is already in the symbol table (there are no operands that are forward
+ * references to a label further on in the file) the operation is assembled
+ * and written out immediately and then dropped.  Only operations with
+ * forward references are kept in the operation list, and a placeholder
+ * word is written for each of them.  At the end of the file all labels are
+ * known, so the waiting operations are assembled and patched into the binary
+ * file in place.  A section header is written as a placeholder when its
+ * section starts, and filled in once the next .ORIG or the end of the file
+ * closes the section.  Memory use is thus
+ * proportional to the number of unresolved forward references instead of
+ * the size of the program.  The binary file is identical to the one
+ * `write_bin_file()` creates after `pass_one()` and `pass_two()`.  Code
+ * is written before the labels after it are known, so operations can not
+ * be relaxed, see relax.h, and an offset that does not fit is an error.
+ *
+ * @param tk The tokenizer of the file to assemble.
+ * @param st An empty symbol table that the labels are inserted into.
+ * @param out The open binary file to write to, which needs to be seekable
+ *   so the placeholder words can be patched.
+ * @param max_pending If not NULL, returns the largest number of operations
+ *   that were waiting on forward references at any one time.
+ *
+ * @returns size_t The number of words written to the binary file, including
+ *   the section headers.
+ */
+size_t pass_stream(tokenizer* tk, symbol_table* st, FILE* out, unsigned* max_pending)
+{
+  operation_list* opl = opl_construct();
+  unsigned file = opl_add_file(opl, tk->asmfile);
+  macro_processor* mp = mac_construct(tk);
+  tokens* tks;
+  uint16_t address = 0x0000;
 
-  // cleanly close and exit
-  tk_destruct(tk);
-  st_destruct(st);
+  // file position of the placeholder words of each waiting entry
+  long* pending_pos = NULL;
+  unsigned pending_capacity = 0;
+  unsigned most_pending = 0;
+
+  // we don't know the section address or size until we have seen the
+  // operations, so write placeholders for the header for now
+  uint16_t section_address = 0x0;
+  uint16_t section_size = 0x0;
+  long section_pos = ftell(out);
+  bool first = true;
+  size_t total_writ = 0;
+  total_writ += fwrite(&section_address, WORD_SIZE, 1, out);
+  total_writ += fwrite(&section_size, WORD_SIZE, 1, out);
+
+  while ((tks = mac_next_line(mp)) != NULL)
+  {
+    unsigned idx = pass_one_line(opl, source_file(opl, file, tks), tks, st, &address);
+    tokens_destruct(tks);
+
+    // a line without an opcode was skipped, its error is in the sink
+    if (idx == LC3ASM_NO_ENTRY)
+    {
+      continue;
+    }
+
+    // a later .ORIG closes the current section and starts a new one
+    if (opl->hot.opc[idx] == ORIG && !first)
+    {
+      patch_section(out, section_pos, section_address, section_size);
+      section_pos = ftell(out);
+      section_size = 0x0;
+      total_writ += fwrite(&section_address, WORD_SIZE, 1, out);
+      total_writ += fwrite(&section_size, WORD_SIZE, 1, out);
+      first = true;
+    }
+    if (first)
+    {
+      section_address = opl->hot.address[idx];
+      first = false;
+    }
+    section_size += opl->hot.size[idx];
+
+    // backward references are already in the symbol table
+    bool resolved = true;
+    for (int opr = 0; opr < opl->hot.num_opr[idx]; opr++)
+    {
+      if (opl->hot.oprtype[opr][idx] == SYMBOL && st_lookup(st, opl->entries[idx].opr[opr]->svalue) == NULL)
+      {
+        resolved = false;
+      }
+    }
+
+    if (resolved)
+    {
+      pass_two_range(opl, st, idx, idx + 1);
+      total_writ += write_entry(out, opl, idx);
+      opl_remove_last(opl);
+    }
+    else
+    {
+      if (idx == pending_capacity)
+      {
+        pending_capacity = pending_capacity ? pending_capacity * 2 : 64;
+        pending_pos = (long*)realloc(pending_pos, pending_capacity * sizeof(long));
+        if (pending_pos == NULL)
+        {
+          diag_fatal(NULL, 0, "<assembler::pass_stream> error allocating pending entries");
+        }
+      }
+      pending_pos[idx] = ftell(out);
+      total_writ += write_entry(out, opl, idx);
+      if (opl->num_entries > most_pending)
+      {
+        most_pending = opl->num_entries;
+      }
+    }
+  }
+
+  // all labels are known now, assemble the waiting entries and patch them in
+  pass_two(opl, st);
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    fseek(out, pending_pos[idx], SEEK_SET);
+    write_entry(out, opl, idx);
+  }
+  patch_section(out, section_pos, section_address, section_size);
+
+  if (max_pending)
+  {
+    *max_pending = most_pending;
+  }
+  free(pending_pos);
+  mac_destruct(mp);
   opl_destruct(opl);
+  return total_writ;
+}
+
+/** @brief find file
+ *
+ * Find an included file in the file table, adding it the first time it is
+ * seen.
+ *
+ * @param opl The operation list.
+ * @param name The path of the included file.
+ *
+ * @returns unsigned The index of the included file in the file table.
+ */
+static unsigned find_file(operation_list* opl, const char* name)
+{
+  for (unsigned idx = opl->num_files; idx-- > 0;)
+  {
+    if (strcmp(opl->files[idx].name, name) == 0)
+    {
+      return idx;
+    }
+  }
+  return opl_add_file(opl, name);
 }
 
 /** @brief assembly 1st pass
@@ -116,79 +769,292 @@ operation_list* pass_one(tokenizer* tk, symbol_table* st)
 {
   operation_list* opl = opl_construct();
   tokens* tks;
-  opcode* opc;
-  operand* opr;
-  opl_entry* entry;
-
-  char* label;
   uint16_t address = 0x0000;
+  unsigned file = opl_add_file(opl, tk->asmfile);
+  macro_processor* mp = mac_construct(tk);
 
-  // tokenize each line with an opcode/operands operation we find
-  while ((tks = tk_next_line(tk)) != NULL)
+  // tokenize each line with an opcode/operands operation we find, with
+  // the macros expanded
+  while ((tks = mac_next_line(mp)) != NULL)
   {
-    // extract opcode first
-    opc = extract_opcode(tks);
+    pass_one_line(opl, source_file(opl, file, tks), tks, st, &address);
+    tokens_destruct(tks);
+  }
 
-    // check for ORIG pseudoopcode, which changes the address
-    if (opc->opc == ORIG)
-    {
-      opr = extract_operand(tks, 1);
-      address = opr->value;
-    }
+  // an included file that only defines macros has no entries, it is
+  // added to the file table anyway so the table lists every file read
+  for (unsigned idx = 1; idx < mp->num_included; idx++)
+  {
+    find_file(opl, mp->included[idx]);
+  }
 
-    // check for a line label symbol on this line and insert
-    // it into the symbol table if needed
-    int opr_index = 1;
-    label = check_for_symbol(tks);
-    if (label != NULL)
-    {
-      st_insert(st, label, address);
-      // if label is present, operands begin at token 2 in the token list
-      opr_index = 2;
-    }
+  mac_destruct(mp);
+  return opl;
+}
 
-    // append new operation to operation list
-    entry = opl_append(opl, tks->line, tks->linenum, label, opc, address);
+/** @brief column of an operand
+ *
+ * Find the column of an operand in the source line of its entry, for the
+ * diagnostic of an error about it.  The line is only read back here, once
+ * there is an error.
+ *
+ * @returns unsigned The column of the operand, counted from 1, or 0 if it
+ *   is not found.
+ */
+static unsigned opr_column(operation_list* opl, unsigned idx, unsigned opr)
+{
+  char line[256];
+  operand* operand = opr < opl->entries[idx].num_opr ? opl->entries[idx].opr[opr] : NULL;
+  return operand != NULL ? diag_column(opl_line(opl, idx, line, sizeof(line)), operand->token) : 0;
+}
 
-    // extract the operands and add to the new entry
-    for (int idx = opr_index; idx < tks->num_tokens; idx++)
-    {
-      opr = extract_operand(tks, idx);
-      opl_append_operand(entry, opr);
-    }
+/** @brief size of an .INCBIN
+ *
+ * Map the binary file of an .INCBIN "file"[, offset[, length]] and find
+ * its size, like the size of a .BLKW.  The offset is in bytes, and the
+ * length in words, the words from the offset to the end of the file are
+ * included if there is no length.  The file is never read here, the words
+ * are only written from its mapping by the binary file writers.
+ *
+ * @param opl The operation list.
+ * @param file The index of the file of the .INCBIN line, a relative file
+ *   name is relative to its directory.
+ * @param idx The index of the .INCBIN entry.
+ *
+ * @returns uint16_t The number of words the .INCBIN includes.
+ */
+static uint16_t incbin_size(operation_list* opl, unsigned file, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+  const char* asmfile = opl->files[file].name;
+  unsigned linenum = opl->entries[idx].linenum;
+  if (hot->num_opr[idx] == 0 || hot->oprtype[0][idx] != STRING ||
+      (hot->num_opr[idx] > 1 && hot->oprtype[1][idx] != NUMERIC) ||
+      (hot->num_opr[idx] > 2 && hot->oprtype[2][idx] != NUMERIC))
+  {
+    diag_error(asmfile, linenum, 0, DIAG_BAD_INCBIN,
+      "<assembler::incbin_size> Error .INCBIN needs a quoted file name, offset and length");
+    return 0;
+  }
 
-    // figure out this entry size to determine next address
-    if (opc->opc == ORIG)
-    {
-      entry->size = 0;
-    }
-    else if (opc->opc == END)
-    {
-      entry->size = 0;
-    }
-    else if (opc->opc == BLKW)
+  char path[PATH_MAX];
+  operand* name = opl->entries[idx].opr[0];
+  mac_include_path(asmfile, name->svalue, path, sizeof(path));
+  int binary = opl_add_binary(opl, path);
+  if (binary < 0)
+  {
+    diag_error(asmfile, linenum, opr_column(opl, idx, 0), DIAG_BAD_INCBIN,
+      "<assembler::incbin_size> Error could not read binary file <%s>", path);
+    return 0;
+  }
+  // the operand of the file name keeps the binary, it moves with the entry
+  // when operations are relaxed
+  name->value = binary;
+
+  size_t length = opl->binaries[binary].length;
+  size_t offset = hot->num_opr[idx] > 1 ? hot->value[1][idx] : 0;
+  if (offset > length)
+  {
+    diag_error(asmfile, linenum, opr_column(opl, idx, 1), DIAG_BAD_INCBIN,
+      "<assembler::incbin_size> Error offset <%zu> past the end of binary file <%s>", offset, path);
+    return 0;
+  }
+  size_t num_words = (length - offset) / WORD_SIZE;
+  if (hot->num_opr[idx] > 2)
+  {
+    if (hot->value[2][idx] > num_words)
     {
-      entry->size = entry->opr[0]->value;
+      diag_error(asmfile, linenum, opr_column(opl, idx, 2), DIAG_BAD_INCBIN,
+        "<assembler::incbin_size> Error length <%u> past the end of binary file <%s>", hot->value[2][idx], path);
+      return 0;
     }
-    else if (opc->opc == STRINGZ)
+    num_words = hot->value[2][idx];
+  }
+  else if ((length - offset) % WORD_SIZE != 0)
+  {
+    diag_error(asmfile, linenum, opr_column(opl, idx, 0), DIAG_BAD_INCBIN,
+      "<assembler::incbin_size> Error binary file <%s> has an odd number of bytes", path);
+    return 0;
+  }
+  if (num_words > 0xFFFF)
+  {
+    diag_error(asmfile, linenum, opr_column(opl, idx, 0), DIAG_BAD_INCBIN,
+      "<assembler::incbin_size> Error binary file <%s> is larger than memory", path);
+    return 0;
+  }
+
+  // like a .STRINGZ the value is the first word, for ease of assembly
+  if (num_words > 0)
+  {
+    hot->value[0][idx] = opl_binary_word(opl, idx, 0);
+  }
+  return num_words;
+}
+
+/** @brief assembly 1st pass of a single line
+ *
+ * Perform the work of pass one for one tokenized operation line.  The opcode,
+ * label and operands are extracted, the label is added to the symbol table,
+ * and a new entry for the operation is appended to the operation list
+ * with its address and size.
+ *
+ * @param opl The operation list to append the new entry to.
+ * @param file The index in the list file table of the file the line is from.
+ * @param tks The tokens of the operation line.
+ * @param st The symbol table that line labels are inserted into.
+ * @param address The address of this operation, updated to the address of
+ *   the next operation.
+ *
+ * @returns unsigned The index of the new entry in the operation list, or
+ *   LC3ASM_NO_ENTRY if the line has no opcode and was skipped after its
+ *   error was recorded in the diagnostic sink.
+ */
+unsigned pass_one_line(operation_list* opl, unsigned file, tokens* tks, symbol_table* st, uint16_t* address)
+{
+  opcode* opc;
+  operand* opr;
+  unsigned idx;
+  uint16_t size;
+  char* label;
+
+  // errors on this line are reported at this line
+  diag_locate(opl->files[file].name, tks->linenum);
+
+  // extract opcode first
+  opc = extract_opcode(tks);
+  if (opc == NULL)
+  {
+    return LC3ASM_NO_ENTRY;
+  }
+
+  // check for ORIG pseudoopcode, which changes the address
+  if (opc->opc == ORIG)
+  {
+    opr = extract_operand(tks, 1);
+    *address = opr->value;
+    opr_destruct(opr);
+  }
+
+  // check for a line label symbol on this line, if label is present,
+  // operands begin at token 2 in the token list
+  int opr_index = 1;
+  label = check_for_symbol(tks);
+  if (label != NULL)
+  {
+    opr_index = 2;
+  }
+
+  // append new operation to operation list, and then insert the label
+  // into the symbol table if needed, the list owns the opcode once it
+  // is appended so nothing is lost if the label is a duplicate
+  idx = opl_append(opl, file, tks, label, opc, *address);
+  if (label != NULL)
+  {
+    st_insert(st, label, *address);
+  }
+
+  // extract the operands and add to the new entry
+  for (int tk_pos = opr_index; tk_pos < tks->num_tokens; tk_pos++)
+  {
+    opr = extract_operand(tks, tk_pos);
+    opl_append_operand(opl, idx, opr);
+  }
+
+  // figure out this entry size to determine next address
+  if (opc->opc == ORIG)
+  {
+    size = 0;
+  }
+  else if (opc->opc == END)
+  {
+    size = 0;
+  }
+  else if (opc->opc == BLKW)
+  {
+    size = opl->hot.value[0][idx];
+  }
+  else if (opc->opc == STRINGZ)
+  {
+    // after we get size, set value to be first character for ease of
+    // assembly
+    size = strlen(opl->entries[idx].opr[0]->svalue) + 1;
+    opl->hot.value[0][idx] = opl->entries[idx].opr[0]->svalue[0];
+  }
+  else if (opc->opc == INCBIN)
+  {
+    size = incbin_size(opl, file, idx);
+  }
+  // all others the size should be 1 memory word for the operation or pseudo op
+  else
+  {
+    size = 1;
+  }
+  opl->hot.size[idx] = size;
+
+  // the opcode and operand types are known now, so determine how the
+  // instruction will be encoded in pass two
+  enc_classify(opl, idx);
+
+  // update address by the operation entry size to advance to next location for next
+  // operation line we read
+  *address += size;
+  opl->size += size;
+
+  return idx;
+}
+
+/** @brief source file of a line
+ *
+ * Find the index in the file table of the file a line is from.  A line of
+ * an included file adds the file to the table the first time a line of it
+ * is seen, so its entries read their lines back from the included file,
+ * and its errors are reported in it.
+ *
+ * @param opl The operation list.
+ * @param file The index of the file being assembled.
+ * @param tks The line.
+ *
+ * @returns unsigned The index of the file of the line.
+ */
+unsigned source_file(operation_list* opl, unsigned file, tokens* tks)
+{
+  return tks->file == NULL ? file : find_file(opl, tks->file);
+}
+
+/** @brief assign addresses
+ *
+ * Give the entries from an index on their addresses again after the sizes
+ * of some of them changed, and move their labels in the symbol table.  An
+ * .ORIG sets the address again, as in pass one.  The passes that run
+ * between pass one and pass two and grow or remove operations, relaxation
+ * and the peephole optimizer, use this to keep the addresses and symbols
+ * of the program right.
+ *
+ * @param opl The operation list of pass one.
+ * @param st The symbol table of pass one.
+ * @param begin The index of the first entry whose size changed, the
+ *   entries before it keep their addresses.
+ */
+void assign_addresses(operation_list* opl, symbol_table* st, unsigned begin)
+{
+  opl_hot* hot = &opl->hot;
+  uint16_t address = hot->address[begin];
+  for (unsigned idx = begin; idx < opl->num_entries; idx++)
+  {
+    if (hot->opc[idx] == ORIG)
     {
-      // after we get size, set value to be first character for ease of
-      // assembly
-      entry->size = strlen(entry->opr[0]->svalue) + 1;
+      address = hot->address[idx];
     }
-    // all others the size should be 1 memory word for the operation or pseudo op
-    else
+    else if (hot->address[idx] != address)
     {
-      entry->size = 1;
+      hot->address[idx] = address;
+      if (opl->entries[idx].label != NULL)
+      {
+        st_lookup(st, opl->entries[idx].label)->address = address;
+      }
     }
-
-    // update address by the operation entry size to advance to next location for next
-    // operation line we read
-    address += entry->size;
-    opl->size += entry->size;
+    address += hot->size[idx];
   }
-
-  return opl;
 }
 
 /** @brief assembly 2nd pass
@@ -202,7 +1068,7 @@ operation_list* pass_one(tokenizer* tk, symbol_table* st)
  * - Construct the machine instruction using the opcode and operand
  *   values for the operation list entry.
  *
- * @param opl The linked list of operation lines partiatlly translated
+ * @param opl The list of operation lines partiatlly translated
  *   and constructued from the first pass.
  * @param st The symbol table constructed from the first pass, which contains
  *   the assigned addresses of all line labels encountered during that pass.
@@ -211,31 +1077,194 @@ operation_list* pass_one(tokenizer* tk, symbol_table* st)
  */
 void pass_two(operation_list* opl, symbol_table* st)
 {
-  // iterate through the operation list entries starting at the beginning
-  // of the operation list
-  opl_entry* entry = opl_begin(opl);
+  pass_two_range(opl, st, 0, opl->num_entries);
+}
+
+/** @brief assembly 2nd pass over a range of entries
+ *
+ * Perform the second pass for the operation list entries from index
+ * begin up to but not including end.  Each entry is assembled using
+ * only its own fields and the symbol table, which is only read from in
+ * the second pass, so different ranges can be assembled concurrently.
+ *
+ * @param opl The list of operation lines constructed in the first pass.
+ * @param st The symbol table constructed in the first pass.
+ * @param begin The index of the first entry to assemble.
+ * @param end The index one past the last entry to assemble.
+ */
+void pass_two_range(operation_list* opl, symbol_table* st, unsigned begin, unsigned end)
+{
+  opl_hot* hot = &opl->hot;
 
-  while (entry)
+  bool relaxed = false;
+
+  // stream through the hot field arrays of the operation list entries
+  // in the range
+  for (unsigned idx = begin; idx < end; idx++)
   {
     // if any operand is a SYMBOL, calculate its offset from the symbol address
-    // in the symbol table
-    operand* opr;
-    for (int idx = 0; idx < entry->num_opr; idx++)
+    // in the symbol table, only symbols need to look at the cold entry for the
+    // symbol name
+    for (int opr = 0; opr < hot->num_opr[idx]; opr++)
     {
-      opr = entry->opr[idx];
-      if (opr->opr == SYMBOL)
+      if (hot->oprtype[opr][idx] == SYMBOL)
       {
-        calculate_symbol_offset(opr, entry->address, st);
+        operand* symbol = opl->entries[idx].opr[opr];
+        diag_locate(opl_file_name(opl, idx), opl->entries[idx].linenum);
+        if (!calculate_symbol_offset(symbol, hot->address[idx], st))
+        {
+          diag_error(NULL, 0, opr_column(opl, idx, opr), DIAG_UNDEFINED_SYMBOL,
+            "<assembler::calculate_symbol_offset> Error undefined symbol <%s>", symbol->svalue);
+          hot->value[opr][idx] = 0;
+          continue;
+        }
+        hot->value[opr][idx] = symbol->value;
+
+        // an offset that does not fit would be masked into a wrong one,
+        // unless `relax()` rewrote the operation to reach its label
+        unsigned bits = relax_offset_bits(hot, idx, opr);
+        if (bits && !relax_fits(symbol->value, bits))
+        {
+          if (!relax_is_relaxed(hot, idx))
+          {
+            diag_error(NULL, 0, opr_column(opl, idx, opr), DIAG_OFFSET_RANGE,
+              "<assembler::pass_two_range> Error offset to symbol <%s> does not fit in %u bits", symbol->svalue, bits);
+          }
+          relaxed = true;
+        }
       }
     }
+  }
+
+  // now all operand values are known, construct the machine instructions for
+  // the range using the batch encoder, which gives the same instructions as
+  // asm_inst() on each entry
+  enc_batch(opl, begin, end, true);
+
+  // a relaxed entry keeps the first word of its sequence as its instruction
+  for (unsigned idx = begin; relaxed && idx < end; idx++)
+  {
+    if (relax_is_relaxed(hot, idx))
+    {
+      uint16_t words[RELAX_MAX_WORDS];
+      relax_words(opl, idx, words);
+      hot->inst[idx] = words[0];
+    }
+  }
+}
+
+/// The operation list and symbol table that the workers of a parallel
+/// pass two share, and the diagnostic sink of the assembly they record
+/// their errors in
+typedef struct pass_two_work
+{
+  operation_list* opl;
+  symbol_table* st;
+  diag_sink* sink;
+} pass_two_work;
+
+/** @brief parallel pass two worker
+ *
+ * Work function for the work pool that assembles one range of entries.
+ */
+static void pass_two_worker(void* arg, unsigned begin, unsigned end)
+{
+  pass_two_work* work = (pass_two_work*)arg;
+  diag_sink* previous = diag_set_sink(work->sink);
+  pass_two_range(work->opl, work->st, begin, end);
+  diag_set_sink(previous);
+}
+
+/** @brief parallel assembly 2nd pass
+ *
+ * Perform the second pass using a pool of threads.  Once pass one is done
+ * the symbol table is frozen, and each entry is assembled independently of
+ * all the others, so we split the operation list into ranges of
+ * PASS_TWO_CHUNK entries and let a work stealing pool assemble the ranges
+ * in parallel.  The resulting instructions are identical to those of the
+ * serial `pass_two()`.
+ *
+ * @param opl The list of operation lines constructed in the first pass.
+ * @param st The symbol table constructed in the first pass.
+ * @param num_threads The number of threads to use, 1 runs the serial pass
+ *   two and 0 uses one thread per cpu.
+ */
+void pass_two_parallel(operation_list* opl, symbol_table* st, unsigned num_threads)
+{
+  pass_two_work work = {opl, st, diag_get_sink()};
+  wp_parallel_for(num_threads, opl->num_entries, PASS_TWO_CHUNK, pass_two_worker, &work);
+}
+
+/** @brief display assembly complete
+ *
+ * Display the summary of a binary file that has been written, the
+ * sections of the file are displayed after it with `display_section()`.
+ */
+static void display_assembly_complete(const char* binfile, size_t total_writ)
+{
+  printf("Assembly complete\n");
+  printf("    bin file: <%s>\n", binfile);
+  printf("    words written: <0X%04X>\n", (int)total_writ);
+}
+
+/** @brief display section
+ *
+ * Display the header of one section of a binary file.
+ */
+static void display_section(uint16_t section_num, uint16_t section_address, uint16_t section_size)
+{
+  printf("    section: <0X%04X> address: <0x%04X> size: <0X%04X>\n", section_num, section_address, section_size);
+}
 
-    // construct the machine instruction for this entry using the opcode and
-    // list of operations.
-    asm_inst(entry);
+/** @brief section end
+ *
+ * Find the end of the section that starts at an entry.  Each .ORIG starts
+ * a new section that runs until the next .ORIG or the end of the list, and
+ * any entries before the first .ORIG are a section of their own.
+ *
+ * @param opl The assembled operation list.
+ * @param begin The index of the first entry of the section.
+ * @param size Returns the size of the section code in words.
+ *
+ * @returns unsigned The index of the first entry after the section.
+ */
+static unsigned section_end(operation_list* opl, unsigned begin, uint16_t* size)
+{
+  opl_hot* hot = &opl->hot;
+  unsigned end = begin;
+  *size = 0;
+  do
+  {
+    *size += hot->size[end++];
+  } while (end < opl->num_entries && hot->opc[end] != ORIG);
+  return end;
+}
 
-    // go to next entry
-    entry = opl_next(opl);
+/** @brief write all
+ *
+ * Write exactly size bytes to a file, retrying short and interrupted
+ * writes.
+ *
+ * @returns bool true if all of the bytes were written.
+ */
+static bool write_all(int fd, const void* data, size_t size)
+{
+  const char* next = (const char*)data;
+  while (size > 0)
+  {
+    ssize_t put = write(fd, next, size);
+    if (put < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (put <= 0)
+    {
+      return false;
+    }
+    next += put;
+    size -= put;
   }
+  return true;
 }
 
 /** @brief Write binary file
@@ -246,31 +1275,32 @@ void pass_two(operation_list* opl, symbol_table* st)
  * We have a primitive obj/exe format here we define.
  * All LC-3 bin files have the following expected format
  *
- * //number_of_sections
- * //section_num
  * section_address section_size
  * section_code
- * //section_num
  * section_address section_size
  * section_code
+ * ...
+ *
+ * NOTE: we had planned a number_of_sections word, and a section_num
+ * before each section, but decided to just use section_address
+ * section_size as header for each section.  The number of sections is
+ * the number of headers, the loader just keeps reading sections until
+ * it reaches the end of file, which also allows for a simple linker
+ * where we just concatenate binary files together.
  *
- * NOTE: left in code for number_of_sections and section_num,
- * but decided to just use section_address section_size as
- * header for the binary, this allows for a simple linker
- * where we just concatenate sections together, and the loader
- * just keeps reading sections until reaches end of file
- *
- * All of the output are 16 bit words in the bin file.  The
- * first word specifies the number of sections total that are
- * in the binary file.  A section is basically a starting
- * address where the section should be loaded into the LC-3
- * machine memory, and then the assembled 16-bit instruction/data
- * words.  Each section is preceeded by its number, its starting
- * address, and the size in words of the assembled code. The
- * loader expects exactly the number of words specified are
- * present in the section_code, and that the next expected
- * section number is found after that if multiple sections
- * are linked together in the binary file.
+ * All of the output are 16 bit words in the bin file.  A section is
+ * basically a starting address where the section should be loaded into
+ * the LC-3 machine memory, and then the assembled 16-bit
+ * instruction/data words.  Each .ORIG/.END block of the program is
+ * written as its own section, preceeded by its starting address, and
+ * the size in words of the assembled code. The loader expects exactly
+ * the number of words specified are present in the section_code, and
+ * that the header of the next section is found after that.
+ *
+ * The whole file is first built in memory by `write_image()`, its size
+ * is known from the operation list after pass one, and then written with
+ * a single write() instead of a call for each word, so a .BLKW or
+ * .STRINGZ costs a memset or a copy rather than a write per word.
  *
  * @param binfile The name of the binary file to be created and
  *   have the assembled instructions in the LC-3 bin format
@@ -283,100 +1313,269 @@ void pass_two(operation_list* opl, symbol_table* st)
  */
 void write_bin_file(const char* binfile, operation_list* opl, bool verbose)
 {
+  // build the image, an empty program is still written as an empty
+  // section, so every binary file has at least one section header
+  opl_hot* hot = &opl->hot;
+  uint16_t* image = (uint16_t*)malloc(image_size(opl) * WORD_SIZE);
+  if (image == NULL)
+  {
+    diag_fatal(NULL, 0, "<assembler::write_bin_file> error allocating image of file <%s>", binfile);
+  }
+  size_t total_writ = write_image(opl, image);
+
   // open file for writing
-  FILE* out = fopen(binfile, "wb");
-  if (out == NULL)
+  int out = open(binfile, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (out < 0)
   {
-    fprintf(stderr, "<assembler::write_bin_file> error could not open file <%s>\n", binfile);
-    exit(1);
+    free(image);
+    diag_fatal(NULL, 0, "<assembler::write_bin_file> error could not open file <%s>", binfile);
+  }
+  bool written = write_all(out, image, total_writ * WORD_SIZE);
+  written = close(out) == 0 && written;
+  free(image);
+  if (!written)
+  {
+    diag_fatal(NULL, 0, "<assembler::write_bin_file> error could not write file <%s>", binfile);
   }
 
-  // we currently only support a single section here, but
-  // we might want to either create a linker and/or also allow
-  // a program with multiple .ORIG/.END in same file?
-  // output number_of_sections
+  if (verbose)
+  {
+    display_assembly_complete(binfile, total_writ);
+    if (opl->num_entries == 0)
+    {
+      display_section(0x1, 0x0, 0x0);
+    }
+    uint16_t section_num = 0x1;
+    for (unsigned begin = 0, end; begin < opl->num_entries; begin = end)
+    {
+      uint16_t section_size;
+      end = section_end(opl, begin, &section_size);
+      display_section(section_num++, hot->address[begin], section_size);
+    }
+  }
+}
+
+/** @brief display binary file
+ *
+ * Display the same summary of a binary file as `write_bin_file()`, for a
+ * binary file that was copied from the cache instead of written.
+ *
+ * @param binfile The name of the binary file.
+ */
+void display_bin_file(const char* binfile)
+{
+  uint16_t header[2] = {0, 0};
   size_t total_writ = 0;
-  size_t writ;
-  size_t word_size = 2; // word size is 2 bytes for LC-3
-  // uint16_t number_of_sections = 0x1;
-  // writ = fwrite(&number_of_sections, word_size, 1, out);
-  // total_writ += writ;
-
-  // next the section_num, section_address and section_size are written
-  // we assume that the starting section address is the address of the
-  // first entry in the opl we have
-  opl_entry* current;
-  current = opl_begin(opl);
+  FILE* in = fopen(binfile, "rb");
+  if (in == NULL)
+  {
+    display_assembly_complete(binfile, total_writ);
+    display_section(0x1, header[0], header[1]);
+    return;
+  }
+  fseek(in, 0, SEEK_END);
+  total_writ = ftell(in) / WORD_SIZE;
+  display_assembly_complete(binfile, total_writ);
+
+  // walk the section headers, skipping over the code of each section
+  fseek(in, 0, SEEK_SET);
   uint16_t section_num = 0x1;
-  uint16_t section_address = current->address;
-  uint16_t section_size = opl->size;
-  // writ = fwrite(&section_num, word_size, 1, out);
-  // total_writ += writ;
-  writ = fwrite(&section_address, word_size, 1, out);
-  total_writ += writ;
-  writ = fwrite(&section_size, word_size, 1, out);
-  total_writ += writ;
-
-  // now iterate through the list of assembled operations.
-  // some pseudoops, such as .BLKW and .STRINGZ have multiple
-  // words that are written
-  while (current)
-  {
-    opctype opc = current->opc->opc;
-
-    // output a block of 0's for BLKW pseudo op
+  while (fread(header, WORD_SIZE, 2, in) == 2)
+  {
+    display_section(section_num++, header[0], header[1]);
+    fseek(in, header[1] * WORD_SIZE, SEEK_CUR);
+  }
+  fclose(in);
+}
+
+/** @brief image size
+ *
+ * The number of words of the binary file of an assembled operation list,
+ * the code of all of its entries plus the two header words of each of
+ * its sections.
+ *
+ * @param opl The assembled operation list.
+ *
+ * @returns size_t The number of words `write_image()` writes.
+ */
+size_t image_size(operation_list* opl)
+{
+  size_t num_sections = opl->num_entries == 0 || opl->hot.opc[0] != ORIG ? 1 : 0;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    num_sections += opl->hot.opc[idx] == ORIG;
+  }
+  return opl->size + 2 * num_sections;
+}
+
+/** @brief write image
+ *
+ * Write the binary file contents, the header and the machine words of
+ * each section of the assembled entries, into a buffer in memory
+ * instead of to a file.  The words are the same as `write_bin_file()`
+ * writes.
+ *
+ * @param opl The assembled operation list.
+ * @param image The buffer to write into, it must have room for
+ *   `image_size()` words.
+ *
+ * @returns size_t The number of words written.
+ */
+size_t write_image(operation_list* opl, uint16_t* image)
+{
+  opl_hot* hot = &opl->hot;
+  size_t total_writ = 0;
+
+  if (opl->num_entries == 0)
+  {
+    image[total_writ++] = 0x0;
+    image[total_writ++] = 0x0;
+  }
+
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    opctype opc = hot->opc[idx];
+    if (idx == 0 || opc == ORIG)
+    {
+      section_end(opl, idx, &image[total_writ + 1]);
+      image[total_writ] = hot->address[idx];
+      total_writ += 2;
+    }
+
+    // ORIG, END and removed entries have no words
+    if (hot->size[idx] == 0)
+    {
+      continue;
+    }
     if (opc == BLKW)
     {
-      uint16_t b = 0x0;
-      uint16_t block_size = current->opr[0]->value;
-      for (int idx = 0; idx < block_size; idx++)
+      memset(&image[total_writ], 0, hot->size[idx] * WORD_SIZE);
+      total_writ += hot->size[idx];
+    }
+    else if (opc == STRINGZ)
+    {
+      for (char* s = opl->entries[idx].opr[0]->svalue; *s; s++)
       {
-        writ = fwrite(&b, word_size, 1, out);
-        total_writ += writ;
+        image[total_writ++] = *s;
       }
+      image[total_writ++] = 0x0;
     }
-    // output string data for STRINGZ pseudo op
-    else if (opc == STRINGZ)
+    else if (opc == INCBIN)
+    {
+      opl_binary_words(opl, idx, &image[total_writ]);
+      total_writ += hot->size[idx];
+    }
+    // any other entry of more than one word is a relaxed operation
+    else if (hot->size[idx] > 1)
+    {
+      total_writ += relax_words(opl, idx, &image[total_writ]);
+    }
+    else
+    {
+      image[total_writ++] = hot->inst[idx];
+    }
+  }
+
+  return total_writ;
+}
+
+/** @brief write an assembled entry
+ *
+ * Write the machine words of one assembled operation list entry to
+ * the binary file.  Some pseudoops, such as .BLKW, .STRINGZ and .INCBIN
+ * have multiple words that are written, and .ORIG and .END have none.
+ *
+ * @param out The binary file stream to write to.
+ * @param opl The operation list holding the assembled entry.
+ * @param idx The index of the entry to write.
+ *
+ * @returns size_t The number of words that were written.
+ */
+size_t write_entry(FILE* out, operation_list* opl, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+  opctype opc = hot->opc[idx];
+  size_t total_writ = 0;
+  size_t writ;
+
+  // do nothing for ORIG begin and END end, the section
+  // headers are written by the caller, or for entries
+  // the optimizations removed
+  if (opc == ORIG || opc == END || peep_is_removed(hot, idx))
+  {
+    // pass
+  }
+  // output a block of 0's for BLKW pseudo op, a buffer of zeros at a
+  // time
+  else if (opc == BLKW)
+  {
+    static const uint16_t zeros[256] = {0x0};
+    for (unsigned word = 0; word < hot->size[idx]; word += 256)
+    {
+      unsigned count = hot->size[idx] - word < 256 ? hot->size[idx] - word : 256;
+      writ = fwrite(zeros, WORD_SIZE, count, out);
+      total_writ += writ;
+    }
+  }
+  // output string data for STRINGZ pseudo op, the characters are
+  // only kept in the cold entry, through a buffer of words that
+  // ends with the null '\0' at end of string
+  else if (opc == STRINGZ)
+  {
+    uint16_t words[256];
+    char* s = opl->entries[idx].opr[0]->svalue;
+    for (unsigned word = 0; word < hot->size[idx]; word++)
     {
-      uint16_t c;
-      char* s = current->opr[0]->svalue;
-      for (int idx = 0; idx < strlen(s); idx++)
+      words[word % 256] = word < hot->size[idx] - 1U ? (uint16_t)s[word] : 0x0;
+      if (word % 256 == 255 || word == hot->size[idx] - 1U)
       {
-        c = s[idx];
-        writ = fwrite(&c, word_size, 1, out);
+        writ = fwrite(words, WORD_SIZE, word % 256 + 1, out);
         total_writ += writ;
       }
-      // write a null '\0' at end of string
-      c = 0x0;
-      writ = fwrite(&c, word_size, 1, out);
-      total_writ += writ;
     }
-    // do nothing for ORIG begin and END end
-    // though in future we could maybe start a new
-    // section for each ORIG/END block defined ?
-    else if (opc == ORIG || opc == END)
+  }
+  // output the words of a binary file for INCBIN pseudo op, straight from
+  // the mapping of the file when it has the byte order of the binary file,
+  // or through a buffer that swaps them
+  else if (opc == INCBIN)
+  {
+    if (hot->variant[idx] == INCBIN_HOST_ORDER)
     {
-      // pass, though could create sections here
+      writ = fwrite(opl_binary_bytes(opl, idx), WORD_SIZE, hot->size[idx], out);
+      total_writ += writ;
     }
-    // should be a LC3 operation or the FILL operation,
-    // just output the single assembled instruction
     else
     {
-      writ = fwrite(&current->inst, word_size, 1, out);
-      total_writ += writ;
+      uint16_t words[256];
+      for (unsigned word = 0; word < hot->size[idx]; word++)
+      {
+        words[word % 256] = opl_binary_word(opl, idx, word);
+        if (word % 256 == 255 || word == hot->size[idx] - 1U)
+        {
+          writ = fwrite(words, WORD_SIZE, word % 256 + 1, out);
+          total_writ += writ;
+        }
+      }
     }
-
-    // process the next entry
-    current = opl_next(opl);
   }
-
-  if (verbose)
+  // output the sequence of an operation that was relaxed to
+  // reach its label
+  else if (relax_is_relaxed(hot, idx))
   {
-    printf("Assembly complete\n");
-    printf("    bin file: <%s>\n", binfile);
-    printf("    words written: <0X%04X>\n", (int)total_writ);
-    printf("    section: <0X%04X> address: <0x%04X> size: <0X%04X>\n", section_num, section_address, section_size);
+    uint16_t words[RELAX_MAX_WORDS];
+    unsigned num_words = relax_words(opl, idx, words);
+    writ = fwrite(words, WORD_SIZE, num_words, out);
+    total_writ += writ;
+  }
+  // should be a LC3 operation or the FILL operation,
+  // just output the single assembled instruction
+  else
+  {
+    writ = fwrite(&hot->inst[idx], WORD_SIZE, 1, out);
+    total_writ += writ;
   }
+
+  return total_writ;
 }
 
 /** @brief binary file name
@@ -404,8 +1603,8 @@ char* bin_file_name(const char* asmfile)
   ext = strstr(binfile, ".asm");
   if (ext == NULL)
   {
-    fprintf(stderr, "<assembler::write_bin_file> unexpected file name, need .asm file <%s>\n", asmfile);
-    exit(1);
+    free(binfile);
+    diag_fatal(NULL, 0, "<assembler::write_bin_file> unexpected file name, need .asm file <%s>", asmfile);
   }
   ext[0] = '\0';
 
@@ -414,6 +1613,140 @@ char* bin_file_name(const char* asmfile)
   return binfile;
 }
 
+/** @brief output file name
+ *
+ * Name a file written next to a binary file, the .lc3 extension of the
+ * binary file is replaced by ext, or ext is added if it has another
+ * extension.
+ */
+static char* output_file_name(const char* binfile, const char* ext)
+{
+  size_t length = strlen(binfile);
+  char* name = (char*)malloc(length + strlen(ext) + 1);
+  strcpy(name, binfile);
+  if (length > 4 && strcmp(binfile + length - 4, ".lc3") == 0)
+  {
+    length -= 4;
+  }
+  strcpy(name + length, ext);
+  return name;
+}
+
+/** @brief dependency file name
+ *
+ * Determine the name of the make dependency file of a binary file, like
+ * the compilers do for -MD, the .lc3 extension of the binary file is
+ * replaced by .d, or .d is added if it has another extension.
+ *
+ * @param binfile The name of the binary file.
+ *
+ * @returns char* The name of the dependency file, freed by the caller.
+ */
+char* dep_file_name(const char* binfile)
+{
+  return output_file_name(binfile, ".d");
+}
+
+/** @brief diagnostic file name
+ *
+ * Determine the name of the JSON file the errors of a binary file are
+ * written to for `-J`, the .lc3 extension of the binary file is replaced
+ * by .json, or .json is added if it has another extension.
+ *
+ * @param binfile The name of the binary file.
+ *
+ * @returns char* The name of the diagnostic file, freed by the caller.
+ */
+char* diag_file_name(const char* binfile)
+{
+  return output_file_name(binfile, ".json");
+}
+
+/** @brief write dependency name
+ *
+ * Write a file name in a make rule, quoting the characters make would
+ * read as something else.
+ */
+static void write_dep_name(FILE* out, const char* name)
+{
+  for (const char* c = name; *c != '\0'; c++)
+  {
+    if (*c == ' ' || *c == '#')
+    {
+      fputc('\\', out);
+    }
+    else if (*c == '$')
+    {
+      fputc('$', out);
+    }
+    fputc(*c, out);
+  }
+}
+
+/** @brief dependency name
+ *
+ * @returns const char* The name of a file the assembly read, the files of
+ *   the file table and then the files of the binary table.
+ */
+static const char* dep_name(operation_list* opl, unsigned idx)
+{
+  return idx < opl->num_files ? opl->files[idx].name : opl->binaries[idx - opl->num_files].name;
+}
+
+/** @brief write dependency file
+ *
+ * Write a make dependency file, as the compilers do for -MD, with a rule
+ * that makes the binary file depend on every file the assembler read for
+ * it, the assembly file and each file it included or included with
+ * .INCBIN.  An empty rule is also
+ * written for each included file, so make does not fail when a file stops
+ * including it and it is removed.  A makefile includes the dependency
+ * files, and make then only assembles a program again if one of its files
+ * changed:
+ *
+ *   progs/lc3-os.lc3: \
+ *     progs/lc3-os.asm \
+ *     /home/os/progs/traps.asm
+ *
+ *   /home/os/progs/traps.asm:
+ *
+ * @param depfile The name of the dependency file to write.
+ * @param binfile The name of the binary file, the target of the rule.
+ * @param asmfile The name of the assembly file.
+ * @param opl The operation list of the assembly, its file and binary
+ *   tables list the included files, or NULL if the source included no
+ *   files.
+ */
+void write_dep_file(const char* depfile, const char* binfile, const char* asmfile, operation_list* opl)
+{
+  FILE* out = fopen(depfile, "w");
+  if (out == NULL)
+  {
+    diag_fatal(NULL, 0, "<assembler::write_dep_file> error could not open file <%s>", depfile);
+  }
+
+  // the files after the assembly file in the file table are the included
+  // files, every one of them whether or not it has entries, and the
+  // binary table has the files of the .INCBINs
+  unsigned num_files = opl != NULL ? opl->num_files : 1;
+  unsigned num_binaries = opl != NULL ? opl->num_binaries : 0;
+  write_dep_name(out, binfile);
+  fprintf(out, ":");
+  for (unsigned idx = 0; idx < num_files + num_binaries; idx++)
+  {
+    fprintf(out, " \\\n  ");
+    write_dep_name(out, idx == 0 ? asmfile : dep_name(opl, idx));
+  }
+  fprintf(out, "\n");
+  for (unsigned idx = 1; idx < num_files + num_binaries; idx++)
+  {
+    fprintf(out, "\n");
+    write_dep_name(out, dep_name(opl, idx));
+    fprintf(out, ":\n");
+  }
+  fclose(out);
+}
+
 /** @brief match symbols
  *
  * Convenience method to determine if two c char array/string symbols
@@ -430,6 +1763,36 @@ bool match(const char* symbol1, const char* symbol2)
   return strcmp(symbol1, symbol2) == 0;
 }
 
+/** @brief match symbols ignoring case
+ *
+ * Like `match()` but ASCII letters are folded to the same case before
+ * they are compared, so `add` matches `ADD` and `r1` matches `R1`.  The
+ * comparison is done in place, a character at a time, so no lowercased
+ * copies of either string need to be allocated.
+ *
+ * @param symbol1 A c char array/string to see if it matches with
+ * @param symbol2 Another c char array/string we are seeing if match
+ *
+ * @returns bool true if the symbols are a match ignoring case, false if not.
+ */
+bool match_nocase(const char* symbol1, const char* symbol2)
+{
+  unsigned char c1, c2;
+  do
+  {
+    c1 = (unsigned char)*symbol1++;
+    c2 = (unsigned char)*symbol2++;
+
+    // fold only A-Z, so punctuation like . is never confused with a control character
+    if (c1 >= 'A' && c1 <= 'Z')
+      c1 |= 0x20;
+    if (c2 >= 'A' && c2 <= 'Z')
+      c2 |= 0x20;
+  } while (c1 == c2 && c1 != '\0');
+
+  return c1 == c2;
+}
+
 /** @brief check for symbol
  *
  * In the LC-3 assembley operations, a line of tokens has an optional
@@ -446,8 +1809,13 @@ bool match(const char* symbol1, const char* symbol2)
  */
 char* check_for_symbol(tokens* tks)
 {
-  // task 6 part 1 goes here
-  return NULL;
+  // an opcode in the first position means there is no label on this line
+  if (is_keyword(tks->token[0]))
+  {
+    return NULL;
+  }
+
+  return tks->token[0];
 }
 
 /** @brief calculate symbol offset
@@ -467,10 +1835,21 @@ char* check_for_symbol(tokens* tks)
  * @param st The symbol table with label/address entries
  *   determined from the first pass of the assembler.
  *
+ * @returns bool false if the symbol is undefined, the caller reports it
+ *   at the operand, and true once the offset is calculated.
  */
-void calculate_symbol_offset(operand* opr, uint16_t opaddress, symbol_table* st)
+bool calculate_symbol_offset(operand* opr, uint16_t opaddress, symbol_table* st)
 {
-  // task 6 part 2 goes here
+  st_entry* entry = st_lookup(st, opr->svalue);
+  if (entry == NULL)
+  {
+    return false;
+  }
+
+  // offsets are relative to the incremented PC, e.g. the address of the
+  // operation following this one
+  opr->value = entry->address - (opaddress + 1);
+  return true;
 }
 
 /** @brief assemble LC-3 instruction
@@ -480,63 +1859,65 @@ void calculate_symbol_offset(operand* opr, uint16_t opaddress, symbol_table* st)
  * we are ready to determine and assemble the final LC-3 machine
  * instruction.
  *
- * An operation_list entry should have all of the information we need about the
- * opcode and parsed operands to assemble the instruction when this
- * function is called at the end of pass two.
+ * The hot fields of an operation_list entry should have all of the information
+ * we need about the opcode and parsed operands to assemble the instruction when
+ * this function is called at the end of pass two.
  *
- * @param entry An operation_list entry with the information about the machine
+ * @param opl The operation_list holding the entry to be assembled.
+ * @param idx The index of the entry with the information about the machine
  *   instruction to be assembled.
  */
-void asm_inst(opl_entry* entry)
+void asm_inst(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // determine instruction so we can correctly interpet operands for assembly
   uint16_t i = 0x0000;
-  switch (entry->opc->opc)
+  switch (hot->opc[idx])
   {
   case ADD:
-    i = asm_add(entry);
+    i = asm_add(opl, idx);
     break;
   case AND:
-    i = asm_and(entry);
+    i = asm_and(opl, idx);
     break;
   case BR:
-    i = asm_br(entry);
+    i = asm_br(opl, idx);
     break;
   case JMP: // JMP and RET instructions
-    i = asm_jmp(entry);
+    i = asm_jmp(opl, idx);
     break;
   case JSR: // JSR and JSRR instructions
-    i = asm_jsr(entry);
+    i = asm_jsr(opl, idx);
     break;
   case LD:
-    i = asm_ld(entry);
+    i = asm_ld(opl, idx);
     break;
   case LDI:
-    i = asm_ldi(entry);
+    i = asm_ldi(opl, idx);
     break;
   case LDR:
-    i = asm_ldr(entry);
+    i = asm_ldr(opl, idx);
     break;
   case LEA:
-    i = asm_lea(entry);
+    i = asm_lea(opl, idx);
     break;
   case NOT:
-    i = asm_not(entry);
+    i = asm_not(opl, idx);
     break;
   case RTI:
-    i = asm_rti(entry);
+    i = asm_rti(opl, idx);
     break;
   case ST:
-    i = asm_st(entry);
+    i = asm_st(opl, idx);
     break;
   case STI:
-    i = asm_sti(entry);
+    i = asm_sti(opl, idx);
     break;
   case STR:
-    i = asm_str(entry);
+    i = asm_str(opl, idx);
     break;
   case TRAP:
-    i = asm_trap(entry);
+    i = asm_trap(opl, idx);
     break;
   // pseudo instructions
   case ORIG:
@@ -550,16 +1931,42 @@ void asm_inst(opl_entry* entry)
     // nothing to do, operand indicates number of 0x0000 bytes to reserve for data
     break;
   case FILL:
-    i = asm_fill(entry);
+    i = asm_fill(opl, idx);
     break;
   case STRINGZ:
-    i = asm_stringz(entry);
+    i = asm_stringz(opl, idx);
+    break;
+  case INCBIN:
+    // the first word of the file, the rest are written from the mapping of
+    // the file by the binary file writers
+    i = hot->value[0][idx];
     break;
   default:
-    fprintf(stderr, "Error: could not determine opcode type <%04X>\n", entry->opc->opc);
-    exit(1);
+    diag_fatal(NULL, 0, "Error: could not determine opcode type <%04X>", hot->opc[idx]);
   }
-  entry->inst = i;
+  hot->inst[idx] = i;
+}
+
+/** @brief malformed operation error
+ *
+ * Report an operation line whose operands do not match what its opcode
+ * expects.  The assembly stops, unless the error is recorded in the
+ * diagnostic sink, then the operation is assembled from whatever operands
+ * it has and the binary file is never written.  The original source line
+ * is only loaded here, when we actually need to show it in the error
+ * message.
+ *
+ * @param opl The operation list holding the malformed entry.
+ * @param idx The index of the malformed entry.
+ * @param where The name of the function that detected the error.
+ * @param what A description of the operation that was malformed.
+ */
+void asm_malformed(operation_list* opl, unsigned idx, const char* where, const char* what)
+{
+  char line[256];
+  diag_error(opl_file_name(opl, idx), opl->entries[idx].linenum, 0, DIAG_MALFORMED,
+    "<assembler::%s> Error malformed %s line: %05d: <%s>", where, what, opl->entries[idx].linenum,
+    opl_line(opl, idx, line, sizeof(line)));
 }
 
 /** @brief assemble add operation
@@ -568,35 +1975,36 @@ void asm_inst(opl_entry* entry)
  * ADD DR, SR, imm5
  * bit[5] = 0 if SR2, bit[5] = 1 if imm5
  *
- * @param entry The operation list entry that has an ADD opcode that needs to be
- *   assembled into a machine instruction.
+ * @param opl The operation list holding the entry to be assembled.
+ * @param idx The index of the operation list entry that has an ADD opcode that
+ *   needs to be assembled into a machine instruction.
  *
  * @returns uint16_t The assembled 16 bit instruction is returned from this
  *   function.
  */
-uint16_t asm_add(opl_entry* entry)
+uint16_t asm_add(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 3 operands to ADD, DR, SR1 and SR2/imm5
-  if (entry->num_opr != 3)
+  if (hot->num_opr[idx] != 3)
   {
-    fprintf(stderr, "<assembler::asm_add> Error malformed ADD instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_add", "ADD instruction");
   }
 
   // if both operands are registers, use version 0
   uint16_t i = 0x0000;
-  uint16_t DR = entry->opr[0]->value;
-  uint16_t SR1 = entry->opr[1]->value;
-  if (entry->opr[2]->opr == REGISTER)
+  uint16_t DR = hot->value[0][idx];
+  uint16_t SR1 = hot->value[1][idx];
+  if (hot->oprtype[2][idx] == REGISTER)
   {
-    uint16_t SR2 = entry->opr[2]->value;
+    uint16_t SR2 = hot->value[2][idx];
     i = (ADD << 12) | (DR << 9) | (SR1 << 6) | (SR2);
   }
   else
   {
     // only keep least significant 5 bits of operand 2 value
     // should we error check?  can only range from -0x10 to +0xF
-    uint16_t imm5 = entry->opr[2]->value & 0x001F;
+    uint16_t imm5 = hot->value[2][idx] & 0x001F;
     // don't forget 1 at bit position 5 indicates immediate
     i = (ADD << 12) | (DR << 9) | (SR1 << 6) | (0x1 << 5) | (imm5);
   }
@@ -609,29 +2017,29 @@ uint16_t asm_add(opl_entry* entry)
  * AND DR, SR, imm5
  * bit[5] = 0 if SR2, bit[5] = 1 if imm5
  */
-uint16_t asm_and(opl_entry* entry)
+uint16_t asm_and(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 3 operands to AND, DR, SR1 and SR2/imm5
-  if (entry->num_opr != 3)
+  if (hot->num_opr[idx] != 3)
   {
-    fprintf(stderr, "<assembler::asm_and> Error malformed AND instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_and", "AND instruction");
   }
 
   // if both operands are registers, use version 0
   uint16_t i = 0x0000;
-  uint16_t DR = entry->opr[0]->value;
-  uint16_t SR1 = entry->opr[1]->value;
-  if (entry->opr[2]->opr == REGISTER)
+  uint16_t DR = hot->value[0][idx];
+  uint16_t SR1 = hot->value[1][idx];
+  if (hot->oprtype[2][idx] == REGISTER)
   {
-    uint16_t SR2 = entry->opr[2]->value;
+    uint16_t SR2 = hot->value[2][idx];
     i = (AND << 12) | (DR << 9) | (SR1 << 6) | (SR2);
   }
   else
   {
     // only keep least significant 5 bits of operand 2 value
     // should we error check?  can only range from -0x10 to +0xF
-    uint16_t imm5 = entry->opr[2]->value & 0x001F;
+    uint16_t imm5 = hot->value[2][idx] & 0x001F;
     // don't forget 1 at bit position 5 indicates immediate
     i = (AND << 12) | (DR << 9) | (SR1 << 6) | (0x1 << 5) | (imm5);
   }
@@ -642,35 +2050,35 @@ uint16_t asm_and(opl_entry* entry)
  *
  * BRnzp PCoffset9
  */
-uint16_t asm_br(opl_entry* entry)
+uint16_t asm_br(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 1 operands to BR
-  if (entry->num_opr != 1)
+  if (hot->num_opr[idx] != 1)
   {
-    fprintf(stderr, "<assembler::asm_br> Error malformed BR instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_br", "BR instruction");
   }
 
   // the flags have already been set as the entries opcode flags, make sure only get
   // low 9 bits of the PCoffset9
-  return (BR << 12) | (entry->opc->flags << 9) | (entry->opr[0]->value & 0x01FF);
+  return (BR << 12) | (hot->flags[idx] << 9) | (hot->value[0][idx] & 0x01FF);
 }
 
 /** @brief assemble .FILL pseudo operation
  *
  * .FILL 0x1234
  */
-uint16_t asm_fill(opl_entry* entry)
+uint16_t asm_fill(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 1 operands to FILL
-  if (entry->num_opr != 1)
+  if (hot->num_opr[idx] != 1)
   {
-    fprintf(stderr, "<assembler::asm_fill> Error malformed .FILL pseudo operation line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_fill", ".FILL pseudo operation");
   }
 
   // make sure only get low 8 bits of the trapvect8
-  return (entry->opr[0]->value);
+  return (hot->value[0][idx]);
 }
 
 /** @brief assemble JMP/RET operation
@@ -678,28 +2086,27 @@ uint16_t asm_fill(opl_entry* entry)
  * JMP R1
  * RET, implicit that base register is R7 for RET
  */
-uint16_t asm_jmp(opl_entry* entry)
+uint16_t asm_jmp(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 1 operand for JMP
-  if (entry->opc->variant == 0 && entry->num_opr != 1)
+  if (hot->variant[idx] == 0 && hot->num_opr[idx] != 1)
   {
-    fprintf(stderr, "<assembler::asm_fill> Error malformed JMP operation line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_fill", "JMP operation");
   }
   // error checking, we expect 0 operands for RET
-  if (entry->opc->variant == 1 && entry->num_opr != 0)
+  if (hot->variant[idx] == 1 && hot->num_opr[idx] != 0)
   {
-    fprintf(stderr, "<assembler::asm_fill> Error malformed RET operation line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_fill", "RET operation");
   }
 
   // JMP variant
-  if (entry->opc->variant == 0)
+  if (hot->variant[idx] == 0)
   {
-    return (JMP << 12) | (entry->opr[0]->value << 6);
+    return (JMP << 12) | (hot->value[0][idx] << 6);
   }
 
-  else if (entry->opc->variant == 1)
+  else if (hot->variant[idx] == 1)
   {
     // defaults to base register R7 for return
     return (JMP << 12) | (7 << 6);
@@ -720,24 +2127,24 @@ uint16_t asm_jmp(opl_entry* entry)
  * Both variants expect 1 operand
  *
  */
-uint16_t asm_jsr(opl_entry* entry)
+uint16_t asm_jsr(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 1 operand for JSR/JSRR
-  if (entry->num_opr != 1)
+  if (hot->num_opr[idx] != 1)
   {
-    fprintf(stderr, "<assembler::asm_jsr> Error malformed JSR/JSRR operation line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_jsr", "JSR/JSRR operation");
   }
 
   // JSRR variant, expect a register operand
-  if (entry->opc->variant == 0)
+  if (hot->variant[idx] == 0)
   {
-    return (JSR << 12) | (entry->opr[0]->value << 6);
+    return (JSR << 12) | (hot->value[0][idx] << 6);
   }
   // JSR should use PCoffset 11 value?, bit[11] is 1 for JSR
-  else if (entry->opc->variant == 1)
+  else if (hot->variant[idx] == 1)
   {
-    return (JSR << 12) | (0x1 << 11) | (entry->opr[0]->value & 0x07FF);
+    return (JSR << 12) | (0x1 << 11) | (hot->value[0][idx] & 0x07FF);
   }
   else
   {
@@ -750,52 +2157,52 @@ uint16_t asm_jsr(opl_entry* entry)
  *
  * LD DR, PCoffset9
  */
-uint16_t asm_ld(opl_entry* entry)
+uint16_t asm_ld(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 2 operands to LD
-  if (entry->num_opr != 2)
+  if (hot->num_opr[idx] != 2)
   {
-    fprintf(stderr, "<assembler::asm_ld> Error malformed LD instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_ld", "LD instruction");
   }
 
   // make sure only get low 9 bits of the PCoffset9
-  return (LD << 12) | (entry->opr[0]->value << 9) | (entry->opr[1]->value & 0x01FF);
+  return (LD << 12) | (hot->value[0][idx] << 9) | (hot->value[1][idx] & 0x01FF);
 }
 
 /** @brief assemble LDI operation
  *
  * LDI DR, PCoffset9
  */
-uint16_t asm_ldi(opl_entry* entry)
+uint16_t asm_ldi(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 2 operands to LDI
-  if (entry->num_opr != 2)
+  if (hot->num_opr[idx] != 2)
   {
-    fprintf(stderr, "<assembler::asm_ldi> Error malformed LDI instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_ldi", "LDI instruction");
   }
 
   // make sure only get low 9 bits of the PCoffset9
-  return (LDI << 12) | (entry->opr[0]->value << 9) | (entry->opr[1]->value & 0x01FF);
+  return (LDI << 12) | (hot->value[0][idx] << 9) | (hot->value[1][idx] & 0x01FF);
 }
 
 /** @brief assemble LDR operation
  *
  * LDI DR, BaseR, offset6
  */
-uint16_t asm_ldr(opl_entry* entry)
+uint16_t asm_ldr(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 3 operands to LDR
-  if (entry->num_opr != 3)
+  if (hot->num_opr[idx] != 3)
   {
-    fprintf(stderr, "<assembler::asm_ldr> Error malformed LDR instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_ldr", "LDR instruction");
   }
 
-  uint16_t DR = entry->opr[0]->value;
-  uint16_t BaseR = entry->opr[1]->value;
-  uint16_t offset6 = entry->opr[2]->value;
+  uint16_t DR = hot->value[0][idx];
+  uint16_t BaseR = hot->value[1][idx];
+  uint16_t offset6 = hot->value[2][idx];
 
   // make sure only get low 9 bits of the PCoffset9
   return (LDR << 12) | (DR << 9) | (BaseR << 6) | (offset6 & 0x003F);
@@ -805,17 +2212,17 @@ uint16_t asm_ldr(opl_entry* entry)
  *
  * LEA DR, PCoffset9
  */
-uint16_t asm_lea(opl_entry* entry)
+uint16_t asm_lea(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 2 operands to LEA
-  if (entry->num_opr != 2)
+  if (hot->num_opr[idx] != 2)
   {
-    fprintf(stderr, "<assembler::asm_lea> Error malformed LEA instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_lea", "LEA instruction");
   }
 
-  uint16_t DR = entry->opr[0]->value;
-  uint16_t PCoffset9 = entry->opr[1]->value;
+  uint16_t DR = hot->value[0][idx];
+  uint16_t PCoffset9 = hot->value[1][idx];
 
   // make sure only get low 9 bits of the PCoffset9
   return (LEA << 12) | (DR << 9) | (PCoffset9 & 0x01FF);
@@ -828,17 +2235,17 @@ uint16_t asm_lea(opl_entry* entry)
  * The LC-3 manual shows low 6 bits filled with 1 for NOT
  * so we will folow that, usually unused are filled with 0?
  */
-uint16_t asm_not(opl_entry* entry)
+uint16_t asm_not(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 2 operands to LEA
-  if (entry->num_opr != 2)
+  if (hot->num_opr[idx] != 2)
   {
-    fprintf(stderr, "<assembler::asm_not> Error malformed NOT instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_not", "NOT instruction");
   }
 
-  uint16_t DR = entry->opr[0]->value;
-  uint16_t SR = entry->opr[1]->value;
+  uint16_t DR = hot->value[0][idx];
+  uint16_t SR = hot->value[1][idx];
 
   // make sure only get low 9 bits of the PCoffset9
   return (NOT << 12) | (DR << 9) | (SR << 6) | (0x003F);
@@ -851,13 +2258,13 @@ uint16_t asm_not(opl_entry* entry)
  * RTI and RET are only instructions with no operands,
  * besides the .END pseudo operation.
  */
-uint16_t asm_rti(opl_entry* entry)
+uint16_t asm_rti(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 2 operands to RTI
-  if (entry->num_opr != 0)
+  if (hot->num_opr[idx] != 0)
   {
-    fprintf(stderr, "<assembler::asm_rti> Error malformed RTI instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_rti", "RTI instruction");
   }
   // make sure only get low 9 bits of the PCoffset9
   return (RTI << 12);
@@ -867,87 +2274,87 @@ uint16_t asm_rti(opl_entry* entry)
  *
  * ST SR, PCoffset9
  */
-uint16_t asm_st(opl_entry* entry)
+uint16_t asm_st(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 2 operands to ST
-  if (entry->num_opr != 2)
+  if (hot->num_opr[idx] != 2)
   {
-    fprintf(stderr, "<assembler::asm_st> Error malformed ST instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_st", "ST instruction");
   }
 
   // make sure only get low 9 bits of the PCoffset9
-  return (ST << 12) | (entry->opr[0]->value << 9) | (entry->opr[1]->value & 0x01FF);
+  return (ST << 12) | (hot->value[0][idx] << 9) | (hot->value[1][idx] & 0x01FF);
 }
 
 /** @brief assemble STI operation
  *
  * STI SR, PCoffset9
  */
-uint16_t asm_sti(opl_entry* entry)
+uint16_t asm_sti(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 2 operands to STI
-  if (entry->num_opr != 2)
+  if (hot->num_opr[idx] != 2)
   {
-    fprintf(stderr, "<assembler::asm_sti> Error malformed STI instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_sti", "STI instruction");
   }
 
   // make sure only get low 9 bits of the PCoffset9
-  return (STI << 12) | (entry->opr[0]->value << 9) | (entry->opr[1]->value & 0x01FF);
+  return (STI << 12) | (hot->value[0][idx] << 9) | (hot->value[1][idx] & 0x01FF);
 }
 
 /** @brief assemble STR operation
  *
  * STR SR, BaseR, offset6
  */
-uint16_t asm_str(opl_entry* entry)
+uint16_t asm_str(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 3 operands to STR
-  if (entry->num_opr != 3)
+  if (hot->num_opr[idx] != 3)
   {
-    fprintf(stderr, "<assembler::asm_str> Error malformed STR instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_str", "STR instruction");
   }
 
-  uint16_t SR = entry->opr[0]->value;
-  uint16_t BaseR = entry->opr[1]->value;
-  uint16_t offset6 = entry->opr[2]->value;
+  uint16_t SR = hot->value[0][idx];
+  uint16_t BaseR = hot->value[1][idx];
+  uint16_t offset6 = hot->value[2][idx];
 
   // make sure only get low 9 bits of the PCoffset9
-  return (LDR << 12) | (SR << 9) | (BaseR << 6) | (offset6 & 0x003F);
+  return (STR << 12) | (SR << 9) | (BaseR << 6) | (offset6 & 0x003F);
 }
 
 /** @brief assemble .STRINGZ pseudo operation
  *
  * .STRINGZ "Hello World"
  */
-uint16_t asm_stringz(opl_entry* entry)
+uint16_t asm_stringz(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 1 operands to STRINGZ
-  if (entry->num_opr != 1)
+  if (hot->num_opr[idx] != 1)
   {
-    fprintf(stderr, "<assembler::asm_fill> Error malformed .STRINGZ pseudo operation line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_fill", ".STRINGZ pseudo operation");
   }
 
   // make sure only get low 8 bits of the trapvect8
-  return (entry->opr[0]->value);
+  return (hot->value[0][idx]);
 }
 
 /** @brief assemble TRAP operation
  *
  * TRAP trapvect8
  */
-uint16_t asm_trap(opl_entry* entry)
+uint16_t asm_trap(operation_list* opl, unsigned idx)
 {
+  opl_hot* hot = &opl->hot;
   // error checking, we expect 1 operands to TRAP
-  if (entry->num_opr != 1)
+  if (hot->num_opr[idx] != 1)
   {
-    fprintf(stderr, "<assembler::asm_trap> Error malformed TRAP instruction line: %05d: <%s>\n", entry->linenum, entry->line);
-    exit(1);
+    asm_malformed(opl, idx, "asm_trap", "TRAP instruction");
   }
 
   // make sure only get low 8 bits of the trapvect8
-  return (TRAP << 12) | (entry->opr[0]->value & 0x00FF);
+  return (TRAP << 12) | (hot->value[0][idx] & 0x00FF);
 }
\ No newline at end of file
@@ -11,23 +11,40 @@
 #include "catch.hpp"
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
 
 using namespace std;
 
 #define TEST
 #include "assembler.h"
+#include "cache.h"
+#include "dead-code.h"
+#include "encoder.h"
+#include "flow-graph.h"
+#include "include-cache.h"
+#include "incremental.h"
+#include "lc3asm-lib.h"
+#include "literal-pool.h"
+#include "macro.h"
 #include "opcode.h"
 #include "operand.h"
 #include "operation-list.h"
+#include "peephole.h"
+#include "relax.h"
+#include "server.h"
 #include "symbol-table.h"
 #include "tokenizer.h"
+#include "watch.h"
+#include "work-pool.h"
 
 #define task1
 #define task2
 #define task3
 #define task4
 #define task5
-#undef task6
+#define task6
 
 /**
  * @brief Task 1: test symbol-table functions
@@ -308,6 +325,19 @@ TEST_CASE("Task 3: test opcode functions", "[task3]")
   CHECK(opc->opc == END);
   tokens_destruct(tks);
 
+  // keywords are recognized regardless of case
+  CHECK(is_keyword("ADD"));
+  CHECK(is_keyword("add"));
+  CHECK(is_keyword("brNZp"));
+  CHECK(is_keyword(".orig"));
+  CHECK(is_keyword(".StringZ"));
+  CHECK_FALSE(is_keyword("ADDR"));
+  CHECK_FALSE(is_keyword("AGAIN"));
+  CHECK_FALSE(is_keyword("BR"));
+  CHECK(match_nocase("jsrr", "JSRR"));
+  CHECK_FALSE(match_nocase("JSR", "JSRR"));
+  CHECK_FALSE(match_nocase(".", "\x0e"));
+
   // TODO: should add in tests of the jsr/jsrr and jmp/ret variant parsing
   // TODO: and really should also test more BR flag parsing cases
 }
@@ -323,7 +353,12 @@ TEST_CASE("Task 4: test operand `is_*()` functions", "[task4]")
   CHECK(is_register("R0"));
   CHECK(is_register("R5"));
   CHECK(is_register("R7"));
-  CHECK_FALSE(is_register("r7"));
+  CHECK(is_register("r7"));
+  CHECK(is_register("r0"));
+  CHECK_FALSE(is_register("R8"));
+  CHECK_FALSE(is_register("R"));
+  CHECK_FALSE(is_register("R10"));
+  CHECK_FALSE(is_register("RESULT"));
   CHECK_FALSE(is_register("\"Error string\""));
   CHECK_FALSE(is_register("\"Output Message\""));
   CHECK_FALSE(is_register("0xaa"));
@@ -543,48 +578,125 @@ TEST_CASE("Task 5: test operaion_list functions", "[task5]")
   operation_list* opl;
 
   opl = pass_one(tk, st);
-  opl_entry* entry = opl_begin(opl);
+  unsigned cursor;
+  opl_entry* entry = opl_begin(opl, &cursor);
 
   // .ORIG 0x3050 file line 5
   CHECK(entry->linenum == 5);
   CHECK(entry->opc->opc == ORIG);
   CHECK(entry->num_opr == 1);
-  CHECK(entry->address == 0x3050);
-  CHECK(entry->size == 0);
-  entry = opl_next(opl);
+  CHECK(opl->hot.address[0] == 0x3050);
+  CHECK(opl->hot.size[0] == 0);
+  entry = opl_next(opl, &cursor);
 
   // LD R1, SIX file line 6
   CHECK(entry->linenum == 6);
   CHECK(entry->opc->opc == LD);
   CHECK(entry->num_opr == 2);
-  CHECK(entry->address == 0x3050);
-  CHECK(entry->size == 1);
-  entry = opl_next(opl);
+  CHECK(opl->hot.address[1] == 0x3050);
+  CHECK(opl->hot.size[1] == 1);
+  entry = opl_next(opl, &cursor);
 
   // LD R2, NUMBER file line 7
   CHECK(entry->linenum == 7);
   CHECK(entry->opc->opc == LD);
   CHECK(entry->num_opr == 2);
-  CHECK(entry->address == 0x3051);
-  CHECK(entry->size == 1);
-  entry = opl_next(opl);
+  CHECK(opl->hot.address[2] == 0x3051);
+  CHECK(opl->hot.size[2] == 1);
+  entry = opl_next(opl, &cursor);
 
   // AND R3, R3, #0 file line 8
   CHECK(entry->linenum == 8);
   CHECK(entry->opc->opc == AND);
   CHECK(entry->num_opr == 3);
-  CHECK(entry->address == 0x3052);
-  CHECK(entry->size == 1);
-  entry = opl_next(opl);
+  CHECK(opl->hot.address[3] == 0x3052);
+  CHECK(opl->hot.size[3] == 1);
+  entry = opl_next(opl, &cursor);
 
   // AGAIN ADD R3, R3, R2 file line 13
   CHECK(entry->linenum == 13);
   // CHECK(match(entry->label, "AGAIN"));
   CHECK(entry->opc->opc == ADD);
   CHECK(entry->num_opr == 3);
-  CHECK(entry->address == 0x3053);
-  CHECK(entry->size == 1);
-  entry = opl_next(opl);
+  CHECK(opl->hot.address[4] == 0x3053);
+  CHECK(opl->hot.size[4] == 1);
+  entry = opl_next(opl, &cursor);
+
+  // the hot fields are filled in from the parsed opcode and operands
+  CHECK(opl->hot.opc[1] == LD);
+  CHECK(opl->hot.num_opr[1] == 2);
+  CHECK(opl->hot.oprtype[0][1] == REGISTER);
+  CHECK(opl->hot.value[0][1] == R1);
+  CHECK(opl->hot.oprtype[1][1] == SYMBOL);
+  CHECK(opl->hot.oprtype[2][3] == NUMERIC);
+  CHECK(opl->hot.value[2][3] == 0);
+  CHECK(opl->hot.opc[6] == BR);
+  CHECK(opl->hot.flags[6] == FP);
+
+  // BLKW and STRINGZ sizes
+  CHECK(opl->hot.opc[8] == BLKW);
+  CHECK(opl->hot.size[8] == 5);
+  CHECK(opl->hot.opc[10] == STRINGZ);
+  CHECK(opl->hot.size[10] == 14);
+  CHECK(opl->num_entries == 12);
+  CHECK(opl->size == 0x1B);
+
+  // source lines are not kept, but can be read back from the file when needed
+  char line[256];
+  CHECK(match(opl_line(opl, 0, line, sizeof(line)), "        .ORIG   0x3050"));
+  CHECK(match(opl_line(opl, 4, line, sizeof(line)), "AGAIN   ADD     R3, R3, R2"));
+  CHECK(match(opl_line(opl, 11, line, sizeof(line)), "        .END"));
+
+  opl_destruct(opl);
+  st_destruct(st);
+  tk_destruct(tk);
+}
+
+TEST_CASE("Task 5: test operation_list growth and index addressing", "[task5]")
+{
+  operation_list* opl = opl_construct();
+  CHECK(opl->num_entries == 0);
+  unsigned cursor;
+  CHECK(opl_begin(opl, &cursor) == NULL);
+
+  // append enough entries that the list has to grow several times
+  tokens tks;
+  unsigned file = opl_add_file(opl, "progs/multiply-by-six.asm");
+  for (unsigned n = 0; n < 1000; n++)
+  {
+    opcode* opc = opc_construct();
+    opc->opc = NOT;
+    tks.linenum = n + 1;
+    tks.offset = 0;
+    tks.length = 0;
+    unsigned idx = opl_append(opl, file, &tks, NULL, opc, 0x3000 + n);
+    CHECK(idx == n);
+
+    operand* opr = opr_construct();
+    opr->opr = REGISTER;
+    opr->value = n % 8;
+    opl_append_operand(opl, idx, opr);
+  }
+  CHECK(opl->num_entries == 1000);
+  CHECK(opl->capacity >= 1000);
+
+  // entries and hot fields are still in order after growing
+  CHECK(opl->entries[0].linenum == 1);
+  CHECK(opl->entries[999].linenum == 1000);
+  CHECK(opl->hot.address[0] == 0x3000);
+  CHECK(opl->hot.address[999] == 0x3000 + 999);
+  CHECK(opl->hot.value[0][13] == 13 % 8);
+  CHECK(opl->hot.num_opr[500] == 1);
+
+  // the iteration interface still visits every entry
+  unsigned count = 0;
+  for (opl_entry* entry = opl_begin(opl, &cursor); entry; entry = opl_next(opl, &cursor))
+  {
+    count++;
+  }
+  CHECK(count == 1000);
+
+  opl_destruct(opl);
 }
 #endif // task 5
 
@@ -664,34 +776,2077 @@ TEST_CASE("Task 6: test assembler `calculate_symbol_offset()` function", "[task6
   operand* opr;
 
   opl = pass_one(tk, st);
-  opl_entry* entry = opl_begin(opl);
+  unsigned cursor;
+  opl_entry* entry = opl_begin(opl, &cursor);
 
   // .ORIG 0x3050 line 1 skip, no symbol
-  entry = opl_next(opl);
+  entry = opl_next(opl, &cursor);
 
   // LD R1, SIX line 2, offset is +11 from PC+1
   opr = entry->opr[1];
-  calculate_symbol_offset(opr, entry->address, st);
+  calculate_symbol_offset(opr, opl->hot.address[1], st);
   CHECK(opr->value == 11);
-  entry = opl_next(opl);
+  entry = opl_next(opl, &cursor);
 
   // LD R2, NUMBER line 3, offset is +5 from PC+1
   opr = entry->opr[1];
-  calculate_symbol_offset(opr, entry->address, st);
+  calculate_symbol_offset(opr, opl->hot.address[2], st);
   CHECK(opr->value == 5);
-  entry = opl_next(opl);
+  entry = opl_next(opl, &cursor);
 
   // AND R3, R3, #0 line 4 skip, no symbol
-  entry = opl_next(opl);
+  entry = opl_next(opl, &cursor);
   // AGAIN ADD R3, R3, R2 line 5 skip, no symbol
-  entry = opl_next(opl);
+  entry = opl_next(opl, &cursor);
   // ADD R1, R1, #-1 line 6 skip, no symbol
-  entry = opl_next(opl);
+  entry = opl_next(opl, &cursor);
 
   // BRp AGAIN line 7, offset is -3 from PC+1
   opr = entry->opr[0];
-  calculate_symbol_offset(opr, entry->address, st);
+  calculate_symbol_offset(opr, opl->hot.address[6], st);
   CHECK(opr->value == 65533); // -3 unsigned is 65533
-  entry = opl_next(opl);
+  entry = opl_next(opl, &cursor);
+}
+#endif // task 6
+
+/**
+ * @brief Parallel pass two and the work pool it runs on
+ */
+static void count_indexes(void* arg, unsigned begin, unsigned end)
+{
+  int* visits = (int*)arg;
+  for (unsigned idx = begin; idx < end; idx++)
+  {
+    __atomic_fetch_add(&visits[idx], 1, __ATOMIC_RELAXED);
+  }
+}
+
+TEST_CASE("Parallel: test work pool visits every index once", "[parallel]")
+{
+  const unsigned count = 10007;
+  int* visits = (int*)calloc(count, sizeof(int));
+
+  // uneven chunks, more threads than chunks, and a single thread
+  wp_parallel_for(4, count, 100, count_indexes, visits);
+  wp_parallel_for(64, count, 5000, count_indexes, visits);
+  wp_parallel_for(1, count, 7, count_indexes, visits);
+  wp_parallel_for(0, count, 1, count_indexes, visits);
+
+  unsigned wrong = 0;
+  for (unsigned idx = 0; idx < count; idx++)
+  {
+    if (visits[idx] != 4)
+      wrong++;
+  }
+  CHECK(wrong == 0);
+  free(visits);
+
+  // an empty loop does nothing
+  wp_parallel_for(4, 0, 100, count_indexes, NULL);
+}
+
+TEST_CASE("Parallel: test `pass_two_parallel()` matches `pass_two()`", "[parallel]")
+{
+  const char* asmfile = "progs/test-allopc.asm";
+
+  tokenizer* tk = tk_construct(asmfile);
+  symbol_table* st = st_construct(0);
+  operation_list* serial = pass_one(tk, st);
+  pass_two(serial, st);
+  tk_destruct(tk);
+  st_destruct(st);
+
+  tk = tk_construct(asmfile);
+  st = st_construct(0);
+  operation_list* parallel = pass_one(tk, st);
+  pass_two_range(parallel, st, 0, 5);
+  pass_two_range(parallel, st, 5, parallel->num_entries);
+  CHECK(memcmp(serial->hot.inst, parallel->hot.inst, serial->num_entries * sizeof(uint16_t)) == 0);
+
+  pass_two_parallel(parallel, st, 4);
+  CHECK(serial->num_entries == parallel->num_entries);
+  CHECK(memcmp(serial->hot.inst, parallel->hot.inst, serial->num_entries * sizeof(uint16_t)) == 0);
+
+  // BRp AGAIN, offset -3 from PC+1
+  CHECK(parallel->hot.inst[6] == 0x03FD);
+
+  tk_destruct(tk);
+  st_destruct(st);
+  opl_destruct(serial);
+  opl_destruct(parallel);
+}
+
+/** @brief read the rest of an open binary file into a std::string for comparison
+ */
+static std::string read_bin(FILE* in)
+{
+  std::string bytes;
+  int c;
+  while ((c = fgetc(in)) != EOF)
+    bytes.push_back((char)c);
+  return bytes;
+}
+
+TEST_CASE("Streaming: test `pass_stream()` matches two pass assembly", "[stream]")
+{
+  const char* asmfile = "progs/test-allopc.asm";
+
+  tokenizer* tk = tk_construct(asmfile);
+  symbol_table* st = st_construct(0);
+  operation_list* opl = pass_one(tk, st);
+  tk_destruct(tk);
+  st_destruct(st);
+
+  tk = tk_construct(asmfile);
+  st = st_construct(0);
+  FILE* out = tmpfile();
+  REQUIRE(out != NULL);
+  unsigned max_pending = 0;
+  size_t total_writ = pass_stream(tk, st, out, &max_pending);
+
+  // header plus every word of the program, same bytes as the reference binary
+  CHECK(total_writ == 2u + opl->size);
+  FILE* ref = fopen("progs/test-allopc.lc3", "rb");
+  REQUIRE(ref != NULL);
+  rewind(out);
+  CHECK(read_bin(out) == read_bin(ref));
+  fclose(ref);
+  fclose(out);
+
+  // only the operations with forward references were ever held
+  CHECK(max_pending > 0);
+  CHECK(max_pending < opl->num_entries);
+
+  tk_destruct(tk);
+  st_destruct(st);
+  opl_destruct(opl);
+}
+
+TEST_CASE("Streaming: test `opl_remove_last()`", "[stream]")
+{
+  tokenizer* tk = tk_construct("progs/test-allopc.asm");
+  symbol_table* st = st_construct(0);
+  operation_list* opl = pass_one(tk, st);
+
+  unsigned num_entries = opl->num_entries;
+  unsigned size = opl->size;
+  uint16_t last_size = opl->hot.size[num_entries - 1];
+  opl_remove_last(opl);
+  CHECK(opl->num_entries == num_entries - 1);
+  CHECK(opl->size == size - last_size);
+
+  while (opl->num_entries > 0)
+    opl_remove_last(opl);
+  CHECK(opl->size == 0);
+  unsigned cursor;
+  CHECK(opl_begin(opl, &cursor) == NULL);
+
+  // removing from an empty list does nothing
+  opl_remove_last(opl);
+  CHECK(opl->num_entries == 0);
+
+  tk_destruct(tk);
+  st_destruct(st);
+  opl_destruct(opl);
+}
+
+/// one kind of operation for the encoder tests, the opcode, its variant
+/// and the types of its operands
+typedef struct enc_test_kind
+{
+  opctype opc;
+  uint16_t variant;
+  int num_opr;
+  oprtype type[3];
+} enc_test_kind;
+
+TEST_CASE("Encoder: test `enc_batch()` matches `asm_inst()`", "[encoder]")
+{
+  const enc_test_kind kinds[] = {
+    {ADD, 0, 3, {REGISTER, REGISTER, REGISTER}},
+    {ADD, 0, 3, {REGISTER, REGISTER, NUMERIC}},
+    {AND, 0, 3, {REGISTER, REGISTER, REGISTER}},
+    {AND, 0, 3, {REGISTER, REGISTER, NUMERIC}},
+    {BR, 0, 1, {NUMERIC}},
+    {JMP, 0, 1, {REGISTER}},
+    {JMP, 1, 0, {}},
+    {JSR, 0, 1, {REGISTER}},
+    {JSR, 1, 1, {NUMERIC}},
+    {LD, 0, 2, {REGISTER, NUMERIC}},
+    {LDI, 0, 2, {REGISTER, NUMERIC}},
+    {LDR, 0, 3, {REGISTER, REGISTER, NUMERIC}},
+    {LEA, 0, 2, {REGISTER, NUMERIC}},
+    {NOT, 0, 2, {REGISTER, REGISTER}},
+    {RTI, 0, 0, {}},
+    {ST, 0, 2, {REGISTER, NUMERIC}},
+    {STI, 0, 2, {REGISTER, NUMERIC}},
+    {STR, 0, 3, {REGISTER, REGISTER, NUMERIC}},
+    {TRAP, 0, 1, {NUMERIC}},
+    {ORIG, 0, 1, {NUMERIC}},
+    {BLKW, 0, 1, {NUMERIC}},
+    {FILL, 0, 1, {NUMERIC}},
+    {STRINGZ, 0, 1, {NUMERIC}},
+    {END, 0, 0, {}},
+  };
+  const unsigned num_kinds = sizeof(kinds) / sizeof(kinds[0]);
+
+  // a long mixed list, so every format has full 16 lane vectors and a
+  // scalar tail, with pseudo random operand values
+  operation_list* opl = opl_construct();
+  tokens tks;
+  tks.offset = 0;
+  tks.length = 0;
+  unsigned file = opl_add_file(opl, "progs/test-allopc.asm");
+  uint32_t seed = 12345;
+  for (unsigned n = 0; n < 2000; n++)
+  {
+    seed = seed * 1103515245 + 12345;
+    const enc_test_kind* kind = &kinds[(seed >> 16) % num_kinds];
+    opcode* opc = opc_construct();
+    opc->opc = kind->opc;
+    opc->variant = kind->variant;
+    opc->flags = (seed >> 8) & 0x7;
+    tks.linenum = n + 1;
+    unsigned idx = opl_append(opl, file, &tks, NULL, opc, 0x3000 + n);
+    for (int k = 0; k < kind->num_opr; k++)
+    {
+      seed = seed * 1103515245 + 12345;
+      operand* opr = opr_construct();
+      opr->opr = kind->type[k];
+      opr->value = kind->type[k] == REGISTER ? (seed >> 16) % 8 : (seed >> 16);
+      opl_append_operand(opl, idx, opr);
+    }
+  }
+
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    asm_inst(opl, idx);
+  }
+  uint16_t* expected = (uint16_t*)malloc(opl->num_entries * sizeof(uint16_t));
+  memcpy(expected, opl->hot.inst, opl->num_entries * sizeof(uint16_t));
+
+  // scalar loop, in one range and in mixed ranges that leave scalar tails
+  memset(opl->hot.inst, 0, opl->num_entries * sizeof(uint16_t));
+  enc_batch(opl, 0, opl->num_entries, false);
+  CHECK(memcmp(expected, opl->hot.inst, opl->num_entries * sizeof(uint16_t)) == 0);
+
+  memset(opl->hot.inst, 0, opl->num_entries * sizeof(uint16_t));
+  enc_batch(opl, 0, 7, false);
+  enc_batch(opl, 7, 300, true);
+  enc_batch(opl, 300, opl->num_entries, false);
+  CHECK(memcmp(expected, opl->hot.inst, opl->num_entries * sizeof(uint16_t)) == 0);
+
+  // every entry has been classified by now
+  unsigned unclassified = 0;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    if (opl->hot.format[idx] == ENC_UNCLASSIFIED)
+      unclassified++;
+  }
+  CHECK(unclassified == 0);
+
+  // simd loop, falls back to scalar when the cpu has no AVX2
+  memset(opl->hot.inst, 0, opl->num_entries * sizeof(uint16_t));
+  enc_batch(opl, 0, opl->num_entries, true);
+  CHECK(memcmp(expected, opl->hot.inst, opl->num_entries * sizeof(uint16_t)) == 0);
+
+  // simd loop with some entries that still need to be classified
+  memset(opl->hot.inst, 0, opl->num_entries * sizeof(uint16_t));
+  memset(&opl->hot.format[100], ENC_UNCLASSIFIED, 50);
+  enc_batch(opl, 0, opl->num_entries, true);
+  CHECK(memcmp(expected, opl->hot.inst, opl->num_entries * sizeof(uint16_t)) == 0);
+
+  free(expected);
+  opl_destruct(opl);
+}
+
+TEST_CASE("Encoder: test STR is encoded with the STR opcode", "[encoder]")
+{
+  operation_list* opl = opl_construct();
+  tokens tks;
+  tks.linenum = 1;
+  tks.offset = 0;
+  tks.length = 0;
+  unsigned file = opl_add_file(opl, "progs/test-allopc.asm");
+  opcode* opc = opc_construct();
+  opc->opc = STR;
+  unsigned idx = opl_append(opl, file, &tks, NULL, opc, 0x3000);
+  const uint16_t values[3] = {5, 6, (uint16_t)-2};
+  for (int k = 0; k < 3; k++)
+  {
+    operand* opr = opr_construct();
+    opr->opr = k < 2 ? REGISTER : NUMERIC;
+    opr->value = values[k];
+    opl_append_operand(opl, idx, opr);
+  }
+
+  // STR R5, R6, #-2
+  CHECK(asm_str(opl, idx) == 0x7BBE);
+  enc_batch(opl, 0, 1, true);
+  CHECK(opl->hot.inst[idx] == 0x7BBE);
+
+  opl_destruct(opl);
+}
+
+/** @brief read a whole file into a std::string
+ */
+static std::string read_file(const char* name)
+{
+  FILE* in = fopen(name, "rb");
+  REQUIRE(in != NULL);
+  std::string bytes = read_bin(in);
+  fclose(in);
+  return bytes;
+}
+
+TEST_CASE("Library: test `lc3asm_assemble()` of a source in memory", "[library]")
+{
+  std::string source = read_file("progs/test-allopc.asm");
+  std::string binary = read_file("progs/test-allopc.lc3");
+
+  lc3asm_result* result = lc3asm_assemble("test-allopc.asm", source.data(), source.size());
+  REQUIRE(result->ok);
+  CHECK(result->num_diagnostics == 0);
+
+  // same words as the assembled binary file
+  CHECK(result->image_size * 2 == binary.size());
+  CHECK(memcmp(result->image, binary.data(), binary.size()) == 0);
+  CHECK(result->image[0] == 0x3050);
+
+  // symbols are sorted by address
+  REQUIRE(result->num_symbols > 0);
+  bool found = false;
+  for (unsigned index = 0; index < result->num_symbols; index++)
+  {
+    if (index > 0)
+      CHECK(result->symbols[index - 1].address <= result->symbols[index].address);
+    if (std::string(result->symbols[index].symbol) == "AGAIN")
+      found = true;
+  }
+  CHECK(found);
+  lc3asm_result_destruct(result);
+
+  // an empty source assembles into an empty image
+  result = lc3asm_assemble(NULL, "", 0);
+  CHECK(result->ok);
+  CHECK(result->image_size == 2);
+  CHECK(result->num_symbols == 0);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Library: test each .ORIG/.END block is its own section", "[library]")
+{
+  const char* source = "        .ORIG x3000\n"
+                       "        LD    R0, DATA\n"
+                       "        TRAP  x25\n"
+                       "        .END\n"
+                       "        .ORIG x3010\n"
+                       "DATA    .FILL x0007\n"
+                       "        .STRINGZ \"hi\"\n"
+                       "        .END\n";
+  lc3asm_result* result = lc3asm_assemble("sections.asm", source, strlen(source));
+  REQUIRE(result->ok);
+
+  // (address, size) header before the code of each section
+  uint16_t expected[] = {0x3000, 0x0002, 0x200F, 0xF025, 0x3010, 0x0004, 0x0007, 'h', 'i', 0x0000};
+  REQUIRE(result->image_size == sizeof(expected) / sizeof(uint16_t));
+  CHECK(memcmp(result->image, expected, sizeof(expected)) == 0);
+  lc3asm_result_destruct(result);
+
+  // the operating system assembles into the same image that the separate
+  // routines linked together do, also when streamed
+  std::string binary = read_file("progs/lc3-os.lc3");
+  tokenizer* tk = tk_construct("progs/lc3-os.asm");
+  symbol_table* st = st_construct(0);
+  operation_list* opl = pass_one(tk, st);
+  pass_two(opl, st);
+  CHECK(image_size(opl) == opl->size + 2 * 4);
+  std::vector<uint16_t> image(image_size(opl));
+  REQUIRE(write_image(opl, image.data()) * 2 == binary.size());
+  CHECK(memcmp(image.data(), binary.data(), binary.size()) == 0);
+  tk_destruct(tk);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  tk = tk_construct("progs/lc3-os.asm");
+  st = st_construct(0);
+  FILE* out = tmpfile();
+  REQUIRE(out != NULL);
+  CHECK(pass_stream(tk, st, out, NULL) * 2 == binary.size());
+  rewind(out);
+  CHECK(read_bin(out) == binary);
+  fclose(out);
+  tk_destruct(tk);
+  st_destruct(st);
+}
+
+TEST_CASE("Library: test `lc3asm_assemble()` returns diagnostics instead of exiting", "[library]")
+{
+  // undefined symbol found in pass two
+  const char* undefined = "        .ORIG   x3000\n"
+                          "        LD      R1, NOWHERE\n"
+                          "        TRAP    x25\n"
+                          "        .END\n";
+  lc3asm_result* result = lc3asm_assemble("undefined.asm", undefined, strlen(undefined));
+  CHECK_FALSE(result->ok);
+  CHECK(result->image == NULL);
+  REQUIRE(result->num_diagnostics == 1);
+  CHECK(std::string(result->diagnostics[0].file) == "undefined.asm");
+  CHECK(result->diagnostics[0].line == 2);
+  CHECK(std::string(result->diagnostics[0].message).find("undefined symbol <NOWHERE>") != std::string::npos);
+  lc3asm_result_destruct(result);
+
+  // duplicate label found in pass one, the labels before the error are listed
+  const char* duplicate = "        .ORIG   x3000\n"
+                          "LOOP    ADD     R1, R1, #1\n"
+                          "\n"
+                          "LOOP    BRp     LOOP\n"
+                          "        .END\n";
+  result = lc3asm_assemble("duplicate.asm", duplicate, strlen(duplicate));
+  CHECK_FALSE(result->ok);
+  REQUIRE(result->num_diagnostics == 1);
+  CHECK(result->diagnostics[0].line == 4);
+  CHECK(std::string(result->diagnostics[0].message).find("duplicate") != std::string::npos);
+  CHECK(result->num_symbols == 1);
+  lc3asm_result_destruct(result);
+
+  // malformed operation, the message shows the line read back from memory
+  const char* malformed = "        .ORIG   x3000\n"
+                          "        ADD     R1, R2\n"
+                          "        .END\n";
+  result = lc3asm_assemble("malformed.asm", malformed, strlen(malformed));
+  CHECK_FALSE(result->ok);
+  REQUIRE(result->num_diagnostics == 1);
+  CHECK(result->diagnostics[0].line == 2);
+  CHECK(std::string(result->diagnostics[0].message).find("<        ADD     R1, R2>") != std::string::npos);
+  lc3asm_result_destruct(result);
+
+  // not an operation
+  const char* unknown = "        FOO     R1\n";
+  result = lc3asm_assemble("unknown.asm", unknown, strlen(unknown));
+  CHECK_FALSE(result->ok);
+  REQUIRE(result->num_diagnostics == 1);
+  CHECK(result->diagnostics[0].line == 1);
+  lc3asm_result_destruct(result);
+
+  // the library still works after errors
+  const char* good = "        .ORIG   x3000\n"
+                     "        TRAP    x25\n"
+                     "        .END\n";
+  result = lc3asm_assemble("good.asm", good, strlen(good));
+  CHECK(result->ok);
+  REQUIRE(result->image_size == 3);
+  CHECK(result->image[2] == 0xF025);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Macro: test macros are expanded from their templates", "[macro]")
+{
+  const char* source = "        .MACRO PUSH REG\n"
+                       "        ADD    R6, R6, #-1\n"
+                       "        STR    REG, R6, #0\n"
+                       "        .ENDM\n"
+                       "        .macro WAIT REG\n"
+                       "LOOP\\@  ADD    REG, REG, #-1\n"
+                       "        BRp    LOOP\\@\n"
+                       "        .endm\n"
+                       "        .MACRO SAVE2 A, B\n"
+                       "        PUSH   A\n"
+                       "        PUSH   B\n"
+                       "        .ENDM\n"
+                       "        .ORIG  x3000\n"
+                       "START   SAVE2  R1, R2\n"
+                       "        WAIT   R3\n"
+                       "        WAIT   R4\n"
+                       "        BRnzp  START\n"
+                       "        .END\n";
+  tokenizer* tk = tk_construct_buffer("macro.asm", source, strlen(source));
+  macro_processor* mp = mac_construct(tk);
+  std::vector<std::string> lines;
+  std::vector<unsigned> linenums;
+  tokens* tks;
+  while ((tks = mac_next_line(mp)) != NULL)
+  {
+    std::string line;
+    for (int tok = 0; tok < tks->num_tokens; tok++)
+    {
+      line += (tok ? " " : "") + std::string(tks->token[tok]);
+    }
+    lines.push_back(line);
+    linenums.push_back(tks->linenum);
+    tokens_destruct(tks);
+  }
+
+  // the label of the use is on the first line of the nested expansion,
+  // and each use of WAIT has labels of its own
+  CHECK(mp->num_macros == 3);
+  CHECK(mp->num_expansions == 5);
+  CHECK(mac_lookup(mp, "WAIT")->lines[1].token[0].text != NULL);
+  CHECK(mac_lookup(mp, "PUSH")->lines[1].token[1].param == 0);
+  std::vector<std::string> expected = {".ORIG x3000", "START ADD R6 R6 #-1", "STR R1 R6 #0", "ADD R6 R6 #-1",
+    "STR R2 R6 #0", "LOOP4 ADD R3 R3 #-1", "BRp LOOP4", "LOOP5 ADD R4 R4 #-1", "BRp LOOP5", "BRnzp START", ".END"};
+  CHECK(lines == expected);
+  CHECK(linenums[1] == 14);
+  CHECK(linenums[4] == 14);
+  CHECK(linenums[6] == 15);
+  mac_destruct(mp);
+  tk_destruct(tk);
+
+  lc3asm_result* result = lc3asm_assemble("macro.asm", source, strlen(source));
+  REQUIRE(result->ok);
+  uint16_t image[] = {0x3000, 9, 0x1DBF, 0x7380, 0x1DBF, 0x7580, 0x16FF, 0x03FE, 0x193F, 0x03FE, 0x0FF7};
+  REQUIRE(result->image_size == 11);
+  CHECK(memcmp(result->image, image, sizeof(image)) == 0);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Macro: test macro errors are reported at their lines", "[macro]")
+{
+  struct
+  {
+    const char* source;
+    unsigned line;
+    const char* message;
+  } cases[] = {
+    {"  .MACRO ONE A\n  ADD A, A, #1\n  .ENDM\n  .ORIG x3000\n  ONE R1, R2\n  .END\n", 5, "takes <1> arguments, not <2>"},
+    {"  .ORIG x3000\n  .MACRO FOREVER\n  ADD R1, R1, #1\n  .END\n", 2, "<FOREVER> has no .ENDM"},
+    {"  .ORIG x3000\n  .ENDM\n", 2, ".ENDM without .MACRO"},
+    {"  .MACRO ADD\n  .ENDM\n", 1, "<ADD> is already an opcode or macro"},
+    {"  .MACRO OUTER\n  .MACRO INNER\n  .ENDM\n", 2, ".MACRO inside macro <OUTER>"},
+    {"  .MACRO LOOPY\n  LOOPY\n  .ENDM\n  .ORIG x3000\n  LOOPY\n", 5, "more than <16> deep"},
+    {"  .MACRO LBL\nX ADD R1, R1, #1\n  .ENDM\n  .ORIG x3000\nY LBL\n", 5, "whose first line has a label"},
+  };
+  for (auto& c : cases)
+  {
+    lc3asm_result* result = lc3asm_assemble("macro.asm", c.source, strlen(c.source));
+    CHECK_FALSE(result->ok);
+    REQUIRE(result->num_diagnostics == 1);
+    CHECK(result->diagnostics[0].line == c.line);
+    CHECK(std::string(result->diagnostics[0].message).find(c.message) != std::string::npos);
+    lc3asm_result_destruct(result);
+  }
+
+  // the errors only skip their lines, so the errors after them are found
+  const char* source = "  .MACRO ONE A\n"
+                       "  ADD A, A, #1\n"
+                       "  .ENDM\n"
+                       "  .INCLUDE \"missing.asm\"\n"
+                       "  .ORIG x3000\n"
+                       "  ONE R1, R2\n"
+                       "  ONE R3\n"
+                       "  BRz NOWHERE\n"
+                       "  .END\n";
+  lc3asm_result* result = lc3asm_assemble("macro.asm", source, strlen(source));
+  CHECK_FALSE(result->ok);
+  REQUIRE(result->num_diagnostics == 3);
+  CHECK(result->diagnostics[0].line == 4);
+  CHECK(result->diagnostics[0].code == DIAG_BAD_INCLUDE);
+  CHECK(result->diagnostics[0].column == 13);
+  CHECK(result->diagnostics[1].line == 6);
+  CHECK(result->diagnostics[1].code == DIAG_BAD_MACRO);
+  CHECK(result->diagnostics[1].column == 3);
+  CHECK(result->diagnostics[2].line == 8);
+  CHECK(result->diagnostics[2].code == DIAG_UNDEFINED_SYMBOL);
+  lc3asm_result_destruct(result);
+}
+
+/// write a file for the include tests
+static void write_text(const std::string& path, const char* text)
+{
+  FILE* out = fopen(path.c_str(), "w");
+  REQUIRE(out != NULL);
+  fputs(text, out);
+  fclose(out);
+}
+
+/// assemble a file through the library
+static lc3asm_result* assemble_path(const std::string& path)
+{
+  const char* asmfiles[] = {path.c_str()};
+  lc3asm_result** results = lc3asm_assemble_files(asmfiles, NULL, 1, 1);
+  lc3asm_result* result = results[0];
+  free(results);
+  return result;
+}
+
+TEST_CASE("Include: test included files are tokenized once and included once", "[include]")
+{
+  std::string dir = "/tmp/lc3asm-include-" + std::to_string(getpid());
+  REQUIRE(system(("mkdir -p " + dir).c_str()) == 0);
+  write_text(dir + "/stack.asm", "; macros of the stack\n"
+                                 "        .INCLUDE \"stack.asm\"\n"
+                                 "        .MACRO PUSH REG\n"
+                                 "        ADD    R6, R6, #-1\n"
+                                 "        STR    REG, R6, #0\n"
+                                 "        .ENDM\n");
+  write_text(dir + "/consts.asm", "KBSR    .FILL  xFE00\n"
+                                  "KBDR    .FILL  xFE02\n");
+  std::string main = dir + "/main.asm";
+  write_text(main, "        .INCLUDE \"stack.asm\"\n"
+                   "        .ORIG  x3000\n"
+                   "        PUSH   R1\n"
+                   "        .include stack.asm\n"
+                   "        LDI    R0, KBSR\n"
+                   "        TRAP   x25\n"
+                   "        .INCLUDE \"consts.asm\"\n"
+                   "        .END\n");
+
+  // the second assembly copies the lines the first one tokenized
+  ic_clear();
+  symbol_table* st = st_construct(0);
+  tokenizer* tk = tk_construct(main.c_str());
+  operation_list* opl = pass_one(tk, st);
+  tk_destruct(tk);
+  CHECK(ic_num_reads() == 2);
+  REQUIRE(opl->num_entries == 8);
+  // the lines of a macro from an included file are at the use of the
+  // macro, the lines of an included file at their own lines
+  CHECK(opl_file_name(opl, 1) == main);
+  CHECK(opl->entries[2].linenum == 3);
+  CHECK(opl->entries[3].linenum == 5);
+  CHECK(std::string(opl_file_name(opl, 5)).find("/consts.asm") != std::string::npos);
+  CHECK(opl->entries[6].linenum == 2);
+  char buffer[100];
+  CHECK(std::string(opl_line(opl, 6, buffer, sizeof(buffer))) == "KBDR    .FILL  xFE02");
+  st_destruct(st);
+  opl_destruct(opl);
+
+  lc3asm_result* result = assemble_path(main);
+  REQUIRE(result->ok);
+  CHECK(ic_num_reads() == 2);
+  uint16_t image[] = {0x3000, 6, 0x1DBF, 0x7380, 0xA001, 0xF025, 0xFE00, 0xFE02};
+  REQUIRE(result->image_size == 8);
+  CHECK(memcmp(result->image, image, sizeof(image)) == 0);
+  lc3asm_result_destruct(result);
+
+  // an error in an included file is reported at its line in that file,
+  // and the changed file is read again
+  write_text(dir + "/consts.asm", "KBSR    .FILL  xFE00\n"
+                                  "KBDR    .FILL  NOWHERE\n");
+  result = assemble_path(main);
+  REQUIRE_FALSE(result->ok);
+  CHECK(ic_num_reads() == 3);
+  REQUIRE(result->num_diagnostics == 1);
+  CHECK(std::string(result->diagnostics[0].file).find("/consts.asm") != std::string::npos);
+  CHECK(result->diagnostics[0].line == 2);
+  lc3asm_result_destruct(result);
+
+  // the new version replaces the old one, but a version still held keeps
+  // its lines until it is released
+  CHECK(ic_num_cached() == 2);
+  ic_file* held = ic_load((dir + "/consts.asm").c_str());
+  REQUIRE(held != NULL);
+  write_text(dir + "/consts.asm", "KBSR    .FILL  xFE00\n");
+  ic_file* newer = ic_load((dir + "/consts.asm").c_str());
+  REQUIRE(newer != NULL);
+  CHECK(newer != held);
+  CHECK(newer->num_lines == 1);
+  CHECK(ic_num_cached() == 2);
+  CHECK(held->replaced);
+  CHECK(held->num_lines == 2);
+  tokens* copy = ic_copy_line(held, 1);
+  CHECK(std::string(copy->token[0]) == "KBDR");
+  tokens_destruct(copy);
+  ic_release(held);
+  ic_release(newer);
+
+  write_text(main, "        .ORIG  x3000\n"
+                   "        .INCLUDE \"missing.asm\"\n"
+                   "        .END\n");
+  result = assemble_path(main);
+  REQUIRE_FALSE(result->ok);
+  CHECK(result->diagnostics[0].line == 2);
+  CHECK(std::string(result->diagnostics[0].message).find("could not read included file") != std::string::npos);
+  lc3asm_result_destruct(result);
+  ic_clear();
+  REQUIRE(system(("rm -rf " + dir).c_str()) == 0);
+}
+
+TEST_CASE("Depfile: test the dependency file lists every file read", "[depfile]")
+{
+  char* depfile = dep_file_name("progs/lc3-os.lc3");
+  CHECK(std::string(depfile) == "progs/lc3-os.d");
+  free(depfile);
+  depfile = dep_file_name("out/os.bin");
+  CHECK(std::string(depfile) == "out/os.bin.d");
+  free(depfile);
+
+  // a file that only defines macros is read, so it is a dependency
+  std::string dir = "/tmp/lc3asm-depfile-" + std::to_string(getpid());
+  REQUIRE(system(("mkdir -p " + dir).c_str()) == 0);
+  write_text(dir + "/macros.asm", "        .MACRO CLEAR REG\n"
+                                  "        AND    REG, REG, #0\n"
+                                  "        .ENDM\n");
+  write_text(dir + "/consts.asm", "KBSR    .FILL  xFE00\n");
+  std::string main = dir + "/main.asm";
+  write_text(main, "        .ORIG  x3000\n"
+                   "        .INCLUDE \"macros.asm\"\n"
+                   "        .INCLUDE \"consts.asm\"\n"
+                   "        .END\n");
+  ic_clear();
+  symbol_table* st = st_construct(0);
+  tokenizer* tk = tk_construct(main.c_str());
+  operation_list* opl = pass_one(tk, st);
+  tk_destruct(tk);
+  REQUIRE(opl->num_files == 3);
+
+  std::string depname = dir + "/main.d";
+  write_dep_file(depname.c_str(), "main.lc3", main.c_str(), opl);
+  std::string text = read_file(depname.c_str());
+  CHECK(text.rfind("main.lc3: \\\n  " + main + " \\\n  ", 0) == 0);
+  // the rule lists both included files, before the empty rules
+  size_t rule_end = text.find("\n\n");
+  CHECK(text.find("/macros.asm") < rule_end);
+  CHECK(text.find("/consts.asm") < rule_end);
+  CHECK(text.find("/macros.asm:\n") != std::string::npos);
+  CHECK(text.find("/consts.asm:\n") != std::string::npos);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  // a name with a space is quoted for make
+  std::string spaced = dir + "/two words.d";
+  write_dep_file(spaced.c_str(), "a b.lc3", "a b.asm", NULL);
+  CHECK(read_file(spaced.c_str()) == "a\\ b.lc3: \\\n  a\\ b.asm\n");
+  ic_clear();
+  REQUIRE(system(("rm -rf " + dir).c_str()) == 0);
+}
+
+TEST_CASE("Incbin: test binary files are included without tokenizing them", "[incbin]")
+{
+  std::string dir = "/tmp/lc3asm-incbin-" + std::to_string(getpid());
+  REQUIRE(system(("mkdir -p " + dir).c_str()) == 0);
+  write_text(dir + "/data.bin", "\x01\x02\x03\x04\x05\x06\x07\x08");
+  write_text(dir + "/odd.bin", "\x01\x02\x03");
+  std::string main = dir + "/main.asm";
+  write_text(main, "        .ORIG  x3000\n"
+                   "        LEA    R0, AFTER\n"
+                   "DATA    .INCBIN \"data.bin\"\n"
+                   "        .incbinbe \"data.bin\", #2, #2\n"
+                   "AFTER   .FILL  x1234\n"
+                   "        .END\n");
+
+  // the binary files are sized like a .BLKW, so the labels after them
+  // have the right addresses
+  uint16_t image[] = {0x3000, 8, 0xE006, 0x0201, 0x0403, 0x0605, 0x0807, 0x0304, 0x0506, 0x1234};
+  lc3asm_result* result = assemble_path(main);
+  REQUIRE(result->ok);
+  REQUIRE(result->image_size == 10);
+  CHECK(memcmp(result->image, image, sizeof(image)) == 0);
+  lc3asm_result_destruct(result);
+
+  // the binary file written a word at a time has the same words, in both
+  // byte orders
+  tokenizer* tk = tk_construct(main.c_str());
+  symbol_table* st = st_construct(0);
+  FILE* out = tmpfile();
+  REQUIRE(out != NULL);
+  CHECK(pass_stream(tk, st, out, NULL) == 10);
+  rewind(out);
+  CHECK(read_bin(out) == std::string((const char*)image, sizeof(image)));
+  fclose(out);
+  tk_destruct(tk);
+  st_destruct(st);
+
+  write_text(main, "        .ORIG  x3000\n"
+                   "        .INCBIN \"data.bin\", #6, #2\n"
+                   "        .END\n");
+  result = assemble_path(main);
+  REQUIRE_FALSE(result->ok);
+  CHECK(std::string(result->diagnostics[0].message).find("past the end") != std::string::npos);
+  lc3asm_result_destruct(result);
+
+  write_text(main, "        .ORIG  x3000\n"
+                   "        .INCBIN \"odd.bin\"\n"
+                   "        .END\n");
+  result = assemble_path(main);
+  REQUIRE_FALSE(result->ok);
+  CHECK(std::string(result->diagnostics[0].message).find("odd number of bytes") != std::string::npos);
+  lc3asm_result_destruct(result);
+  REQUIRE(system(("rm -rf " + dir).c_str()) == 0);
+}
+
+/// assemble a source held in memory through pass two, with one of the
+/// passes that change the program, like `relax()` or `peephole()`, run
+/// between pass one and pass two, returning what the pass did.  The lines
+/// of the source are read back from it, for the columns of errors and the
+/// @bound comments of the flow graph.
+template <typename Pass>
+static auto pass_source(const char* source, symbol_table* st, operation_list** opl, Pass pass)
+{
+  tokenizer* tk = tk_construct_buffer("source.asm", source, strlen(source));
+  *opl = pass_one(tk, st);
+  tk_destruct(tk);
+  opl_set_source(*opl, 0, source, strlen(source));
+  auto stats = pass(*opl, st);
+  pass_two(*opl, st);
+  return stats;
+}
+
+TEST_CASE("Relax: test out of range operations are relaxed", "[relax]")
+{
+  const char* source = "        .ORIG x3000\n"
+                       "        BRz   FAR\n"
+                       "        BRnzp FAR\n"
+                       "        LD    R1, FAR\n"
+                       "        LDI   R2, FAR\n"
+                       "        LEA   R3, FAR\n"
+                       "        ST    R4, FAR\n"
+                       "        JSR   FAR\n"
+                       "        .BLKW 300\n"
+                       "FAR     ADD   R0, R0, #1\n"
+                       "        .END\n";
+  symbol_table* st = st_construct(0);
+  operation_list* opl;
+  relax_stats stats = pass_source(source, st, &opl, relax);
+
+  // everything but JSR, which reaches 1023 words, is relaxed in one pass,
+  // and a second pass finds the addresses have converged
+  CHECK(stats.num_relaxed == 6);
+  CHECK(stats.words_added == 14);
+  CHECK(stats.num_passes == 2);
+  CHECK(st_lookup(st, "FAR")->address == 0x3141);
+  CHECK(opl->size == 7 + 14 + 300 + 1);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  lc3asm_result* result = lc3asm_assemble("relax.asm", source, strlen(source));
+  REQUIRE(result->ok);
+
+  // each relaxed operation is a warning at its label, and only the relaxed
+  // branches overwrite R7 and the condition codes
+  REQUIRE(result->num_diagnostics == 6);
+  for (unsigned index = 0; index < result->num_diagnostics; index++)
+  {
+    CHECK(result->diagnostics[index].code == DIAG_RELAXED);
+    CHECK(diag_is_warning(result->diagnostics[index].code));
+    CHECK(result->diagnostics[index].line == index + 2);
+    CHECK(result->diagnostics[index].column == (index < 2 ? 15 : 19));
+    CHECK((std::string(result->diagnostics[index].message).find("overwrite R7") != std::string::npos) == (index < 2));
+  }
+  CHECK(std::string(result->diagnostics[0].message).find("<BRz> relaxed into 4 words") != std::string::npos);
+
+  uint16_t expected[] = {0x3000, 7 + 14 + 300 + 1,
+    0x0A03, 0x2E01, 0xC1C0, 0x3141,  // BRz: BRnp over LD R7 / JMP R7 through the literal
+    0x2E01, 0xC1C0, 0x3141,          // BRnzp: LD R7 / JMP R7
+    0xA201, 0x0E01, 0x3141,          // LD: LDI through the literal
+    0xA402, 0x6480, 0x0E01, 0x3141,  // LDI: LDI then LDR
+    0x2601, 0x0E01, 0x3141,          // LEA: LD of the literal
+    0xB801, 0x0E01, 0x3141,          // ST: STI through the literal
+    0x492C};                         // JSR reaches
+  REQUIRE(result->image_size == 2 + 7 + 14 + 300 + 1);
+  CHECK(memcmp(result->image, expected, sizeof(expected)) == 0);
+  CHECK(result->image[result->image_size - 1] == 0x1021);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Relax: test relaxation repeats until addresses converge", "[relax]")
+{
+  // relaxing the branch to FAR pushes NEAR out of reach of the first branch
+  const char* source = "        .ORIG x3000\n"
+                       "        BRnzp NEAR\n"
+                       "        BRnzp FAR\n"
+                       "        .BLKW 254\n"
+                       "NEAR    ADD   R0, R0, #1\n"
+                       "        .BLKW 300\n"
+                       "FAR     ADD   R0, R0, #1\n"
+                       "        .END\n";
+  symbol_table* st = st_construct(0);
+  operation_list* opl;
+  relax_stats stats = pass_source(source, st, &opl, relax);
+  CHECK(stats.num_relaxed == 2);
+  CHECK(stats.words_added == 4);
+  CHECK(stats.num_passes == 3);
+  CHECK(st_lookup(st, "NEAR")->address == 0x3104);
+  CHECK(relax_is_relaxed(&opl->hot, 1));
+  CHECK(opl->hot.inst[1] == 0x2E01);
+
+  // undoing the relaxation gives back the addresses of pass one
+  CHECK(relax_reset(opl, st) == 2);
+  CHECK(st_lookup(st, "NEAR")->address == 0x3100);
+  CHECK(opl->size == 2 + 254 + 1 + 300 + 1);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  // STI would need a free register to be relaxed, so it is reported
+  const char* far_sti = "        .ORIG x3000\n"
+                        "        STI   R0, FAR\n"
+                        "        .BLKW 300\n"
+                        "FAR     .FILL x4000\n"
+                        "        .END\n";
+  lc3asm_result* result = lc3asm_assemble("relax.asm", far_sti, strlen(far_sti));
+  REQUIRE_FALSE(result->ok);
+  REQUIRE(result->num_diagnostics == 1);
+  CHECK(result->diagnostics[0].line == 2);
+  CHECK(std::string(result->diagnostics[0].message).find("<FAR> does not fit in 9 bits") != std::string::npos);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Relax: test a section relaxed over the next section is an error", "[relax]")
+{
+  // the first section ends right before the second one, until its branch
+  // is relaxed
+  const char* source = "        .ORIG x3000\n"
+                       "        BRnzp FAR\n"
+                       "        .BLKW 256\n"
+                       "        .END\n"
+                       "        .ORIG x3101\n"
+                       "FAR     ADD   R0, R0, #1\n"
+                       "        .END\n";
+  lc3asm_result* result = lc3asm_assemble("relax.asm", source, strlen(source));
+  REQUIRE_FALSE(result->ok);
+  REQUIRE(result->num_diagnostics == 2);
+  CHECK(result->diagnostics[0].code == DIAG_SECTION_OVERLAP);
+  CHECK(result->diagnostics[0].line == 1);
+  CHECK(std::string(result->diagnostics[0].message)
+          .find("<x3000> relaxed to end at <x3102>, over the section at <x3101>") != std::string::npos);
+  CHECK(result->diagnostics[1].code == DIAG_RELAXED);
+  CHECK(result->diagnostics[1].line == 2);
+  lc3asm_result_destruct(result);
+
+  // a section with room after it can grow
+  std::string room(source);
+  room.replace(room.find("x3101"), 5, "x3200");
+  result = lc3asm_assemble("relax.asm", room.c_str(), room.size());
+  CHECK(result->ok);
+  REQUIRE(result->num_diagnostics == 1);
+  CHECK(result->diagnostics[0].code == DIAG_RELAXED);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Peephole: test instructions that do not change the program are removed", "[peephole]")
+{
+  const char* source = "        .ORIG x3000\n"
+                       "        LD    R1, COUNT\n"
+                       "        ADD   R1, R1, #0\n"
+                       "        BRz   DONE\n"
+                       "        AND   R2, R2, #0\n"
+                       "        AND   R2, R2, #0\n"
+                       "        LD    R2, COUNT\n"
+                       "LOOP    ADD   R1, R1, #-1\n"
+                       "        BRnzp NEXT\n"
+                       "NEXT    BRp   LOOP\n"
+                       "        BRnzp SKIP\n"
+                       "        AND   R3, R3, #0\n"
+                       "SKIP    NOT   R3, R4\n"
+                       "DONE    TRAP  x25\n"
+                       "COUNT   .FILL #5\n"
+                       "        .END\n";
+  symbol_table* st = st_construct(0);
+  operation_list* opl;
+  peep_stats stats = pass_source(source, st, &opl, peephole);
+
+  // removing the dead clear before SKIP makes the branch to SKIP a
+  // branch to the next instruction in the second pass
+  CHECK(stats.num_passes == 3);
+  CHECK(stats.num_removed[PEEP_BRANCH_NEXT] == 2);
+  CHECK(stats.num_removed[PEEP_SET_CC] == 1);
+  CHECK(stats.num_removed[PEEP_DEAD_CLEAR] == 3);
+  CHECK(stats.cycles_saved[PEEP_BRANCH_NEXT] == 12);
+  CHECK(stats.cycles_saved[PEEP_SET_CC] == 5);
+  CHECK(stats.cycles_saved[PEEP_DEAD_CLEAR] == 15);
+  CHECK(peep_is_removed(&opl->hot, 2));
+  CHECK_FALSE(peep_is_removed(&opl->hot, 3));
+  CHECK(st_lookup(st, "NEXT")->address == 0x3004);
+  CHECK(st_lookup(st, "SKIP")->address == 0x3005);
+  CHECK(st_lookup(st, "COUNT")->address == 0x3007);
+  CHECK(opl->size == 8);
+
+  // the removed instructions have no words, and the offsets are to the
+  // moved labels
+  uint16_t image[16];
+  REQUIRE(image_size(opl) == 10);
+  CHECK(write_image(opl, image) == 10);
+  uint16_t expected[] = {0x3000, 8, 0x2206, 0x0404, 0x2404, 0x127F, 0x03FE, 0x973F, 0xF025, 0x0005};
+  CHECK(memcmp(image, expected, sizeof(expected)) == 0);
+  st_destruct(st);
+  opl_destruct(opl);
+}
+
+TEST_CASE("Peephole: test instructions the rules can not prove redundant are kept", "[peephole]")
+{
+  const char* source = "        .ORIG x3000\n"
+                       "        LD    R1, COUNT\n"
+                       "TOP     ADD   R1, R1, #0\n"        // reached by the branch, CC unknown
+                       "        LEA   R2, COUNT\n"
+                       "        ADD   R2, R2, #0\n"        // LEA is not trusted to set CC
+                       "        AND   R3, R3, #0\n"
+                       "        ADD   R3, R3, #1\n"        // reads the clear
+                       "        AND   R4, R4, #0\n"
+                       "        BRp   TOP\n"               // the clear sets CC for the branch
+                       "        BRnzp #1\n"                // pins the clear after it
+                       "        AND   R5, R5, #0\n"
+                       "        LD    R5, COUNT\n"
+                       "COUNT   .FILL #5\n"
+                       "        .END\n";
+  symbol_table* st = st_construct(0);
+  operation_list* opl;
+  peep_stats stats = pass_source(source, st, &opl, peephole);
+  CHECK(stats.num_passes == 1);
+  for (unsigned rule = 0; rule < PEEP_NUM_RULES; rule++)
+  {
+    CHECK(stats.num_removed[rule] == 0);
+  }
+  CHECK(opl->size == 12);
+  CHECK(st_lookup(st, "COUNT")->address == 0x300B);
+  st_destruct(st);
+  opl_destruct(opl);
+}
+
+TEST_CASE("Literal pool: test constants only loaded from are merged", "[pool]")
+{
+  const char* source = "        .ORIG x3000\n"
+                       "        LD    R1, SIX\n"
+                       "        LDI   R2, SIX2\n"
+                       "        LD    R3, TEN\n"
+                       "        BRnzp DONE\n"
+                       "SIX     .FILL #6\n"
+                       "TEN     .FILL #10\n"
+                       "SIX2    .FILL #6\n"         // merged into SIX
+                       "DONE    LEA   R4, TABLE\n"
+                       "        LD    R5, TEN2\n"
+                       "        ST    R1, COPY\n"
+                       "        LD    R6, COPY\n"
+                       "        TRAP  x25\n"
+                       "TABLE   .FILL #10\n"        // its address is taken
+                       "TEN2    .FILL #10\n"        // in the table of TABLE
+                       "        BRnzp DONE\n"
+                       "COPY    .FILL #10\n"        // written, not a literal
+                       "        .END\n";
+  symbol_table* st = st_construct(0);
+  operation_list* opl;
+  pool_stats stats = pass_source(source, st, &opl, pool_literals);
+  CHECK(stats.num_merged == 1);
+  CHECK(stats.num_slots == 1);
+  CHECK(peep_is_removed(&opl->hot, 7));
+  CHECK(std::string(opl->entries[2].opr[1]->svalue) == "SIX");
+  CHECK(st_lookup(st, "DONE")->address == 0x3006);
+  CHECK(opl->size == 15);
+
+  // the merged constant has no word, and the offsets are to the moved
+  // labels
+  uint16_t image[20];
+  REQUIRE(image_size(opl) == 17);
+  CHECK(write_image(opl, image) == 17);
+  uint16_t expected[] = {0x3000, 15, 0x2203, 0xA402, 0x2602, 0x0E02, 0x0006, 0x000A, 0xE804, 0x2A04, 0x3205, 0x2C04,
+    0xF025, 0x000A, 0x000A, 0x0FF8, 0x000A};
+  CHECK(memcmp(image, expected, sizeof(expected)) == 0);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  // a constant whose loads can not reach the first one stays, and becomes
+  // a slot for the constants after it
+  source = "        .ORIG x3000\n"
+           "        LD    R1, FIRST\n"
+           "FIRST   .FILL #7\n"
+           "        .BLKW #300\n"
+           "        LD    R2, SECOND\n"
+           "SECOND  .FILL #7\n"
+           "        LD    R3, THIRD\n"
+           "THIRD   .FILL #7\n"
+           "        .END\n";
+  st = st_construct(0);
+  stats = pass_source(source, st, &opl, pool_literals);
+  CHECK(stats.num_merged == 1);
+  CHECK(stats.num_slots == 1);
+  CHECK_FALSE(peep_is_removed(&opl->hot, 5));
+  CHECK(peep_is_removed(&opl->hot, 7));
+  CHECK(std::string(opl->entries[6].opr[1]->svalue) == "SECOND");
+  CHECK(opl->hot.inst[6] == 0x27FE);
+  st_destruct(st);
+  opl_destruct(opl);
+}
+
+TEST_CASE("Dead code: test unreachable code and unreferenced data are removed", "[deadcode]")
+{
+  const char* source = "        .ORIG x3000\n"
+                       "        LEA   R0, MSG\n"
+                       "        TRAP  x22\n"
+                       "        JSR   USED\n"
+                       "        TRAP  x25\n"
+                       "USED    LD    R1, ONE\n"
+                       "        RET\n"
+                       "MSG     .STRINGZ \"hi\"\n"
+                       "ONE     .FILL #1\n"
+                       "UNUSED  ADD   R1, R1, #1\n"     // never called
+                       "        RET\n"
+                       "OLD     .STRINGZ \"old\"\n"    // never referenced
+                       "        .END\n"
+                       "        .ORIG x0022\n"
+                       "        .FILL HANDLER\n"         // a TRAP vector
+                       "        .END\n"
+                       "        .ORIG x0460\n"
+                       "HANDLER BRnzp SKIP\n"
+                       "        .BLKW #2\n"              // jumped over
+                       "SKIP    RET\n"
+                       "        .END\n";
+  symbol_table* st = st_construct(0);
+  operation_list* opl;
+  dead_stats stats = pass_source(source, st, &opl, dead_code);
+  CHECK(stats.num_instructions == 2);
+  CHECK(stats.num_data_words == 6);
+  CHECK(stats.num_blocks == 2);
+  CHECK(peep_is_removed(&opl->hot, 9));
+  CHECK(peep_is_removed(&opl->hot, 11));
+  CHECK(peep_is_removed(&opl->hot, 18));
+  CHECK_FALSE(peep_is_removed(&opl->hot, 5));
+  CHECK_FALSE(peep_is_removed(&opl->hot, 17));
+  CHECK(st_lookup(st, "SKIP")->address == 0x0461);
+  CHECK(opl->size == 13);
+
+  // the removed entries have no words, in the image or the binary file
+  uint16_t image[24];
+  REQUIRE(image_size(opl) == 19);
+  CHECK(write_image(opl, image) == 19);
+  uint16_t expected[] = {0x3000, 10, 0xE005, 0xF022, 0x4801, 0xF025, 0x2204, 0xC1C0, 0x0068, 0x0069, 0x0000, 0x0001,
+    0x0022, 1, 0x043D, 0x0460, 2, 0x0E00, 0xC1C0};
+  CHECK(memcmp(image, expected, sizeof(expected)) == 0);
+  std::string binfile = "/tmp/lc3asm-dead-" + std::to_string(getpid()) + ".lc3";
+  write_bin_file(binfile.c_str(), opl, false);
+  uint16_t written[24];
+  FILE* in = fopen(binfile.c_str(), "rb");
+  REQUIRE(in != NULL);
+  CHECK(fread(written, WORD_SIZE, 24, in) == 19);
+  fclose(in);
+  remove(binfile.c_str());
+  CHECK(memcmp(written, expected, sizeof(expected)) == 0);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  // a word between a numeric offset and its target stays, removing it
+  // would move the target
+  source = "        .ORIG x3000\n"
+           "        BRnzp #1\n"
+           "        .FILL #5\n"
+           "        TRAP  x25\n"
+           "        .END\n";
+  st = st_construct(0);
+  stats = pass_source(source, st, &opl, dead_code);
+  CHECK(stats.num_instructions == 0);
+  CHECK(stats.num_data_words == 0);
+  CHECK(opl->size == 3);
+  st_destruct(st);
+  opl_destruct(opl);
+}
+
+/// assemble a source held in memory and build its control flow graph, no
+/// pass changes the program, and the @bound comments are read back from
+/// the source
+static flow_graph* flow_source(const char* source, symbol_table* st, operation_list** opl)
+{
+  pass_source(source, st, opl, [](operation_list*, symbol_table*) { return 0; });
+  return fg_construct(*opl, st);
+}
+
+TEST_CASE("Flow graph: test loop bounds and worst case paths of routines", "[flowgraph]")
+{
+  const char* source = "        .ORIG x3000\n"
+                       "        JSR   DELAY\n"
+                       "        TRAP  x25\n"
+                       "DELAY   AND   R1, R1, #0\n"
+                       "        ADD   R1, R1, #3\n"
+                       "OUTER   AND   R2, R2, #0\n"
+                       "        ADD   R2, R2, #2\n"
+                       "INNER   ADD   R2, R2, #-1\n"
+                       "        BRp   INNER\n"
+                       "        ADD   R1, R1, #-1\n"
+                       "        BRp   OUTER\n"
+                       "POLL    LDI   R3, DSR           ; @bound 10\n"
+                       "        BRzp  POLL\n"
+                       "        RET\n"
+                       "DSR     .FILL xFE04\n"
+                       "        .END\n";
+  symbol_table* st = st_construct(0);
+  operation_list* opl;
+  flow_graph* fg = flow_source(source, st, &opl);
+  CHECK(fg->num_blocks == 8);
+  REQUIRE(fg->num_routines == 2);
+  REQUIRE(fg->num_loops == 3);
+
+  // the loops, the counted ones are inferred and the polling one annotated
+  unsigned inner = fg->blocks[fg->block_of[7]].loop;
+  unsigned outer = fg->blocks[fg->block_of[5]].loop;
+  unsigned poll = fg->blocks[fg->block_of[11]].loop;
+  REQUIRE(inner != FG_NONE);
+  REQUIRE(outer != FG_NONE);
+  REQUIRE(poll != FG_NONE);
+  CHECK(fg->loops[inner].parent == outer);
+  CHECK(fg->loops[inner].depth == 2);
+  CHECK(fg->loops[inner].bound == 2);
+  CHECK(fg->loops[inner].bound_kind == FG_INFERRED);
+  CHECK(fg->loops[outer].bound == 3);
+  CHECK(fg->loops[outer].bound_kind == FG_INFERRED);
+  CHECK(fg->loops[poll].bound == 10);
+  CHECK(fg->loops[poll].bound_kind == FG_ANNOTATED);
+
+  // the inner loop goes around once and out, a taken branch is one cycle
+  // more, the outer loop goes around twice with the inner loop each time
+  fg_cost cost = fg_loop_cost(fg, inner);
+  CHECK(cost.instructions == 4);
+  CHECK(cost.cycles == 21);
+  cost = fg_loop_cost(fg, outer);
+  CHECK(cost.instructions == 24);
+  CHECK(cost.cycles == 125);
+
+  // the routine counts its own instructions, and the worst case of the
+  // main program has the worst case of the routine it calls
+  fg_routine* delay = &fg->routines[1];
+  CHECK(delay->num_blocks == 6);
+  CHECK(delay->num_instructions == 11);
+  CHECK(delay->num_loops == 3);
+  CHECK(delay->max_depth == 2);
+  cost = fg_routine_cost(fg, 1);
+  CHECK_FALSE(cost.unbounded);
+  CHECK(cost.instructions == 47);
+  CHECK(cost.cycles == 289);
+  cost = fg_routine_cost(fg, 0);
+  CHECK(cost.instructions == 49);
+  CHECK(cost.cycles == 302);
+  fg_destruct(fg);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  // a polling loop with no bound has no worst case
+  source = "        .ORIG x0420\n"
+           "POLL    LDI   R3, DSR\n"
+           "        BRzp  POLL\n"
+           "        RTI\n"
+           "DSR     .FILL xFE04\n"
+           "        .END\n";
+  st = st_construct(0);
+  fg = flow_source(source, st, &opl);
+  REQUIRE(fg->num_loops == 1);
+  CHECK(fg->loops[0].bound_kind == FG_UNBOUNDED);
+  CHECK(fg_routine_cost(fg, 0).unbounded);
+  fg_destruct(fg);
+  st_destruct(st);
+  opl_destruct(opl);
+
+  // a .FILL of a label is an offset, not a pointer to code, so the label
+  // does not start a routine
+  source = "        .ORIG x3000\n"
+           "        ADD   R1, R1, #1\n"
+           "        TRAP  x25\n"
+           "HANDLER ADD   R2, R2, #1\n"
+           "        RET\n"
+           "VECTOR  .FILL HANDLER\n"
+           "        .END\n";
+  st = st_construct(0);
+  fg = flow_source(source, st, &opl);
+  CHECK(fg->num_routines == 1);
+  fg_destruct(fg);
+  st_destruct(st);
+  opl_destruct(opl);
+}
+
+TEST_CASE("Server: test requests to `srv_serve()` match `lc3asm_assemble()`", "[server]")
+{
+  std::string socket_path = "/tmp/lc3asm-test-" + std::to_string(getpid()) + ".sock";
+  std::thread server(srv_serve, socket_path.c_str(), false);
+
+  // wait for the server to start listening
+  const char* good = "        .ORIG   x3000\n"
+                     "        TRAP    x25\n"
+                     "        .END\n";
+  lc3asm_result* remote = NULL;
+  for (int tries = 0; remote == NULL && tries < 500; tries++)
+  {
+    remote = srv_request(socket_path.c_str(), SRV_SOURCE, "good.asm", good, strlen(good));
+    if (remote == NULL)
+      usleep(10000);
+  }
+  REQUIRE(remote != NULL);
+  CHECK(remote->ok);
+  REQUIRE(remote->image_size == 3);
+  CHECK(remote->image[2] == 0xF025);
+  lc3asm_result_destruct(remote);
+
+  // a second server does not take the socket of a running one
+  diag_trap trap;
+  diag_set_trap(&trap);
+  if (setjmp(trap.jump) == 0)
+  {
+    srv_serve(socket_path.c_str(), false);
+  }
+  diag_clear_trap(&trap);
+  CHECK(std::string(trap.diag.message).find("already listening") != std::string::npos);
+  diag_destruct(&trap.diag);
+
+  // a path request, the server reads the file
+  std::string source = read_file("progs/test-allopc.asm");
+  lc3asm_result* local = lc3asm_assemble("test-allopc.asm", source.data(), source.size());
+  const char* path = "progs/test-allopc.asm";
+  remote = srv_request(socket_path.c_str(), SRV_PATH, "test-allopc.asm", path, strlen(path));
+  REQUIRE(remote != NULL);
+  REQUIRE(remote->ok);
+  REQUIRE(remote->image_size == local->image_size);
+  CHECK(memcmp(remote->image, local->image, local->image_size * 2) == 0);
+  REQUIRE(remote->num_symbols == local->num_symbols);
+  for (unsigned index = 0; index < local->num_symbols; index++)
+  {
+    CHECK(std::string(remote->symbols[index].symbol) == local->symbols[index].symbol);
+    CHECK(remote->symbols[index].address == local->symbols[index].address);
+  }
+  lc3asm_result_destruct(local);
+  lc3asm_result_destruct(remote);
+
+  // errors come back as diagnostics, and the warm tables are reused after
+  const char* undefined = "        .ORIG   x3000\n"
+                          "        LD      R1, NOWHERE\n"
+                          "        .END\n";
+  remote = srv_request(socket_path.c_str(), SRV_SOURCE, "undefined.asm", undefined, strlen(undefined));
+  REQUIRE(remote != NULL);
+  CHECK_FALSE(remote->ok);
+  REQUIRE(remote->num_diagnostics == 1);
+  CHECK(std::string(remote->diagnostics[0].file) == "undefined.asm");
+  CHECK(remote->diagnostics[0].line == 2);
+  CHECK(std::string(remote->diagnostics[0].message).find("undefined symbol <NOWHERE>") != std::string::npos);
+  lc3asm_result_destruct(remote);
+
+  path = "progs/no-such-file.asm";
+  remote = srv_request(socket_path.c_str(), SRV_PATH, path, path, strlen(path));
+  REQUIRE(remote != NULL);
+  CHECK_FALSE(remote->ok);
+  CHECK(remote->num_diagnostics == 1);
+  lc3asm_result_destruct(remote);
+
+  // shut the server down, after which nothing is listening
+  remote = srv_request(socket_path.c_str(), SRV_SHUTDOWN, NULL, NULL, 0);
+  REQUIRE(remote != NULL);
+  CHECK(remote->ok);
+  lc3asm_result_destruct(remote);
+  server.join();
+  CHECK(srv_request(socket_path.c_str(), SRV_SOURCE, "good.asm", good, strlen(good)) == NULL);
+}
+
+TEST_CASE("Batch: test `lc3asm_assemble_files()` assembles each file independently", "[batch]")
+{
+  const char* asmfiles[] = {"progs/trap-vector.asm", "progs/cout.asm", "progs/no-such-file.asm", "progs/cin.asm",
+    "progs/halt.asm", "progs/test-allopc.asm"};
+  const char* binfiles[] = {"progs/trap-vector.lc3", "progs/cout.lc3", NULL, "progs/cin.lc3", "progs/halt.lc3",
+    "progs/test-allopc.lc3"};
+  unsigned num_files = sizeof(asmfiles) / sizeof(asmfiles[0]);
+
+  // results only, with more threads than files
+  lc3asm_result** results = lc3asm_assemble_files(asmfiles, NULL, num_files, 8);
+  for (unsigned idx = 0; idx < num_files; idx++)
+  {
+    lc3asm_result* result = results[idx];
+    REQUIRE(result != NULL);
+    if (binfiles[idx] == NULL)
+    {
+      // the missing file does not stop the rest of the batch
+      CHECK_FALSE(result->ok);
+      REQUIRE(result->num_diagnostics == 1);
+      CHECK(std::string(result->diagnostics[0].message).find("File Not Found") != std::string::npos);
+    }
+    else
+    {
+      std::string binary = read_file(binfiles[idx]);
+      REQUIRE(result->ok);
+      CHECK(result->image_size * 2 == binary.size());
+      CHECK(memcmp(result->image, binary.data(), binary.size()) == 0);
+    }
+    lc3asm_result_destruct(result);
+  }
+  free(results);
+
+  // binary files are written for the files that assembled
+  std::string outfile = "/tmp/lc3asm-test-" + std::to_string(getpid()) + ".lc3";
+  const char* batch_asm[] = {"progs/test-allopc.asm"};
+  const char* batch_bin[] = {outfile.c_str()};
+  results = lc3asm_assemble_files(batch_asm, batch_bin, 1, 0);
+  CHECK(results[0]->ok);
+  CHECK(read_file(outfile.c_str()) == read_file("progs/test-allopc.lc3"));
+  lc3asm_result_destruct(results[0]);
+  free(results);
+  remove(outfile.c_str());
+
+  // a binary file that can not be written is an error of its file
+  const char* full_bin[] = {"/dev/full"};
+  results = lc3asm_assemble_files(batch_asm, full_bin, 1, 0);
+  CHECK_FALSE(results[0]->ok);
+  REQUIRE(results[0]->num_diagnostics == 1);
+  CHECK(std::string(results[0]->diagnostics[0].message).find("could not write file") != std::string::npos);
+  lc3asm_result_destruct(results[0]);
+  free(results);
+}
+
+TEST_CASE("Cache: test `cache_hash()` is XXH64", "[cache]")
+{
+  CHECK(cache_hash("", 0, 0) == 0xEF46DB3751D8E999ULL);
+  CHECK(cache_hash("abc", 3, 0) == 0x44BC2CF5AD770999ULL);
+
+  // long enough to use all four lanes, with a tail of every size
+  std::string bytes;
+  for (int copy = 0; copy < 3; copy++)
+    for (int byte = 0; byte < 256; byte++)
+      bytes.push_back((char)byte);
+  bytes += "xyz";
+  CHECK(cache_hash(bytes.data(), bytes.size(), 7) == 0xB63555D1BF05377FULL);
+}
+
+TEST_CASE("Cache: test outputs are stored and fetched by source key", "[cache]")
+{
+  std::string dir = "/tmp/lc3asm-test-cache-" + std::to_string(getpid());
+  std::string binfile = dir + "/out.lc3";
+  std::string source = read_file("progs/test-allopc.asm");
+  cache* ch = cache_construct(dir.c_str());
+
+  // keys depend on the source and the flags
+  char key[CACHE_KEY_SIZE];
+  char other[CACHE_KEY_SIZE];
+  cache_key(source.data(), source.size(), 0, key);
+  CHECK(strlen(key) == CACHE_KEY_SIZE - 1);
+  cache_key(source.data(), source.size(), 1, other);
+  CHECK(std::string(key) != other);
+  cache_key(source.data(), source.size() - 1, 0, other);
+  CHECK(std::string(key) != other);
+
+  // a miss, then store the image only, which is a hit unless the listing
+  // is needed
+  CHECK_FALSE(cache_fetch(ch, key, binfile.c_str(), false));
+  cache_store(ch, key, "progs/test-allopc.lc3", NULL, NULL);
+  CHECK_FALSE(cache_fetch(ch, key, binfile.c_str(), true));
+  CHECK(cache_fetch(ch, key, binfile.c_str(), false));
+  CHECK(read_file(binfile.c_str()) == read_file("progs/test-allopc.lc3"));
+  CHECK(ch->hits == 1);
+  CHECK(ch->misses == 2);
+
+  // with the symbol table and listing it is a hit for verbose output too
+  symbol_table* st = st_construct(0);
+  operation_list* opl = opl_construct();
+  st_insert(st, "AGAIN", 0x3050);
+  cache_store(ch, key, "progs/test-allopc.lc3", st, opl);
+  CHECK(cache_fetch(ch, key, binfile.c_str(), true));
+  st_destruct(st);
+  opl_destruct(opl);
+
+  std::string rm = "rm -rf " + dir;
+  CHECK(system(rm.c_str()) == 0);
+  cache_destruct(ch);
+}
+
+TEST_CASE("Cache: test a source with warnings is not cached", "[cache]")
+{
+  std::string dir = "/tmp/lc3asm-test-cache-" + std::to_string(getpid());
+  std::string asmfile = dir + "-relax.asm";
+  std::string binfile = dir + "-relax.lc3";
+  cache* ch = cache_construct(dir.c_str());
+
+  // the relaxed branch is a warning every time the source is assembled
+  FILE* out = fopen(asmfile.c_str(), "w");
+  REQUIRE(out != NULL);
+  fputs("        .ORIG x3000\n"
+        "        BRz   FAR\n"
+        "        .BLKW 300\n"
+        "FAR     ADD   R0, R0, #1\n"
+        "        .END\n",
+    out);
+  fclose(out);
+  CHECK(lc3asm_file(asmfile.c_str(), binfile.c_str(), false, 0, 1, ch));
+  CHECK(lc3asm_file(asmfile.c_str(), binfile.c_str(), false, 0, 1, ch));
+  CHECK(ch->hits == 0);
+  CHECK(ch->misses == 2);
+
+  // a source without warnings is a hit the second time
+  CHECK(lc3asm_file("progs/test-allopc.asm", binfile.c_str(), false, 0, 1, ch));
+  CHECK(lc3asm_file("progs/test-allopc.asm", binfile.c_str(), false, 0, 1, ch));
+  CHECK(ch->hits == 1);
+  CHECK(read_file(binfile.c_str()) == read_file("progs/test-allopc.lc3"));
+
+  remove(asmfile.c_str());
+  remove(binfile.c_str());
+  std::string rm = "rm -rf " + dir;
+  CHECK(system(rm.c_str()) == 0);
+  cache_destruct(ch);
+}
+
+/// join the lines of an incremental test source into one source text
+static std::string join_lines(const std::vector<std::string>& lines)
+{
+  std::string source;
+  for (const std::string& line : lines)
+    source += line + "\n";
+  return source;
+}
+
+/// check the engine agrees with a full assembly of the same lines
+static bool check_incremental(inc_engine* eng, const std::vector<std::string>& lines)
+{
+  std::string source = join_lines(lines);
+  lc3asm_result* result = lc3asm_assemble("inc.asm", source.data(), source.size());
+  bool ok = result->ok;
+  CHECK(eng->num_lines == lines.size());
+  if (ok)
+  {
+    REQUIRE(eng->num_errors == 0);
+    std::vector<uint16_t> image(image_size(eng->opl));
+    REQUIRE(inc_image(eng, image.data()) == result->image_size);
+    CHECK(memcmp(image.data(), result->image, result->image_size * sizeof(uint16_t)) == 0);
+  }
+  else
+  {
+    CHECK(eng->num_errors > 0);
+  }
+  lc3asm_result_destruct(result);
+  return ok;
+}
+
+TEST_CASE("Incremental: test edits match a full `lc3asm_assemble()`", "[incremental]")
+{
+  std::string source = read_file("progs/test-allopc.asm");
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start < source.size())
+  {
+    size_t end = source.find('\n', start);
+    if (end == std::string::npos)
+      end = source.size();
+    lines.push_back(source.substr(start, end - start));
+    start = end + 1;
+  }
+
+  inc_engine* eng = inc_construct("inc.asm", source.data(), source.size());
+  REQUIRE(check_incremental(eng, lines));
+
+  // random edits, with lines that change sizes, define and refer to labels,
+  // duplicate labels and start new sections
+  const char* pool[] = {"        ADD     R1, R1, #1",
+    "        .BLKW   3",
+    "        .STRINGZ \"hi\"",
+    "        BRnzp   AGAIN",
+    "NEWLBL  .FILL   #5",
+    "        LD      R0, NEWLBL",
+    "        LEA     R2, MSG",
+    "AGAIN   ADD     R3, R3, R3",
+    "; a comment",
+    "",
+    "        .ORIG   0x3100"};
+  unsigned num_pool = sizeof(pool) / sizeof(pool[0]);
+  srand(450);
+  unsigned num_ok = 0;
+  for (int edit = 0; edit < 400; edit++)
+  {
+    unsigned line = rand() % (lines.size() + 1);
+    int kind = rand() % 4;
+    const diagnostic* diag;
+    if (eng->num_errors > 0 && rand() % 2 && inc_diagnostics(eng, &diag, 1) == 1)
+    {
+      // delete a line with an error, like fixing it
+      line = diag->line - 1;
+      kind = 0;
+    }
+    if (kind == 0 && line < lines.size())
+    {
+      // delete a line
+      inc_edit(eng, line, 1, "", 0);
+      lines.erase(lines.begin() + line);
+    }
+    else if (kind == 1 && line < lines.size())
+    {
+      // type over a line
+      std::string text = pool[rand() % num_pool];
+      inc_edit(eng, line, 1, (text + "\n").data(), text.size() + 1);
+      lines[line] = text;
+    }
+    else if (kind == 2 && line + 1 < lines.size())
+    {
+      // move a line down, two lines replaced at once
+      std::string text = lines[line + 1] + "\n" + lines[line] + "\n";
+      inc_edit(eng, line, 2, text.data(), text.size());
+      std::swap(lines[line], lines[line + 1]);
+    }
+    else
+    {
+      // insert a line
+      std::string text = pool[rand() % num_pool];
+      inc_edit(eng, line, 0, (text + "\n").data(), text.size() + 1);
+      lines.insert(lines.begin() + line, text);
+    }
+    if (check_incremental(eng, lines))
+      num_ok++;
+  }
+  CHECK(num_ok > 20);
+  inc_destruct(eng);
+}
+
+TEST_CASE("Incremental: test errors are kept per line and recover", "[incremental]")
+{
+  const char* source = "        .ORIG   0x3000\n"
+                       "        LD      R0, VALUE\n"
+                       "        ADD     R0, R0, #1\n"
+                       "        TRAP    x25\n"
+                       "        .END\n";
+  inc_engine* eng = inc_construct("inc.asm", source, strlen(source));
+
+  // the undefined symbol is an error of line 2
+  const diagnostic* diags[4];
+  REQUIRE(inc_diagnostics(eng, diags, 4) == 1);
+  CHECK(diags[0]->line == 2);
+  CHECK(std::string(diags[0]->message).find("VALUE") != std::string::npos);
+  CHECK(inc_image(eng, NULL) == 0);
+
+  // a bad line is a second error, and the errors move with their lines
+  inc_edit(eng, 1, 0, "        ADD     R9, R0, #1\n", 27);
+  REQUIRE(inc_diagnostics(eng, diags, 4) == 2);
+  CHECK(diags[0]->line == 2);
+  CHECK(diags[1]->line == 3);
+
+  // defining the label fixes the reference, only the new line, the
+  // reference and the line still in error are assembled
+  inc_edit(eng, 5, 0, "VALUE   .FILL   #7", 18);
+  REQUIRE(inc_diagnostics(eng, diags, 4) == 1);
+  CHECK(diags[0]->line == 2);
+  CHECK(eng->num_parsed == 1);
+  CHECK(eng->num_encoded == 3);
+
+  // typing on a line only assembles that line
+  inc_edit(eng, 1, 1, "        ADD     R1, R0, #1", 26);
+  CHECK(eng->num_errors == 0);
+  CHECK(eng->num_parsed == 1);
+  CHECK(eng->num_encoded == 1);
+
+  uint16_t image[16];
+  REQUIRE(inc_image(eng, image) == 7);
+  CHECK(image[0] == 0x3000);
+  CHECK(image[2] == 0x1221);
+  CHECK(image[3] == 0x2002);
+  CHECK(image[6] == 0x0007);
+
+  // a duplicate label is an error until the first definition is deleted
+  inc_edit(eng, 0, 0, "VALUE   .FILL   #1\n", 19);
+  CHECK(eng->num_errors == 1);
+  inc_edit(eng, 0, 1, "", 0);
+  CHECK(eng->num_errors == 0);
+  inc_destruct(eng);
+}
+
+/// write a file the way an editor saves it, a new file renamed over the old
+static void save_file(const std::string& name, const std::string& text)
+{
+  std::string temp = name + ".tmp";
+  FILE* out = fopen(temp.c_str(), "w");
+  REQUIRE(out != NULL);
+  fwrite(text.data(), 1, text.size(), out);
+  fclose(out);
+  REQUIRE(rename(temp.c_str(), name.c_str()) == 0);
+}
+
+/// check a binary file has the image of a full assembly of a source
+static void check_watch_image(const std::string& binfile, const std::string& source)
+{
+  lc3asm_result* result = lc3asm_assemble("watch.asm", source.data(), source.size());
+  REQUIRE(result->ok);
+  std::string binary = read_file(binfile.c_str());
+  CHECK(binary.size() == result->image_size * sizeof(uint16_t));
+  CHECK(memcmp(binary.data(), result->image, binary.size()) == 0);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Watch: test changed files are assembled again", "[watch]")
+{
+  std::string dir = "/tmp/lc3asm-test-watch-" + std::to_string(getpid());
+  std::string asmfile = dir + "/watch.asm";
+  std::string binfile = dir + "/watch.lc3";
+  REQUIRE(system(("mkdir -p " + dir).c_str()) == 0);
+  std::string source = read_file("progs/test-allopc.asm") + "\n";
+  save_file(asmfile, source);
+
+  // the first build is done right away
+  char* asmfiles[] = {(char*)asmfile.c_str()};
+  watcher* w = watch_construct(asmfiles, 1, NULL, false);
+  CHECK(w->num_builds == 1);
+  check_watch_image(binfile, source);
+
+  // an edit is assembled again, only the changed line is parsed
+  size_t pos = source.find("#-1");
+  source.replace(pos, 3, "#-2");
+  save_file(asmfile, source);
+  CHECK(watch_wait(w, 5000) == 1);
+  CHECK(w->num_builds == 2);
+  CHECK(w->files[0].eng->num_parsed == 1);
+  check_watch_image(binfile, source);
+
+  // saving the same text again is not a change
+  save_file(asmfile, source);
+  CHECK(watch_wait(w, 5000) == 0);
+  CHECK(w->num_builds == 2);
+
+  // a burst of saves is built once
+  for (int save = 0; save < 3; save++)
+  {
+    source += "        ADD     R1, R1, #" + std::to_string(save) + "\n";
+    save_file(asmfile, source);
+  }
+  CHECK(watch_wait(w, 5000) == 1);
+  CHECK(w->num_builds == 3);
+  check_watch_image(binfile, source);
+
+  // nothing changes, the wait times out
+  CHECK(watch_wait(w, 10) == 0);
+
+  watch_destruct(w);
+  CHECK(system(("rm -rf " + dir).c_str()) == 0);
+}
+
+/// check a binary file has the image of a full assembly of an assembly file
+static void check_watch_file(const std::string& binfile, const std::string& asmfile)
+{
+  lc3asm_result* result = assemble_path(asmfile);
+  REQUIRE(result->ok);
+  std::string binary = read_file(binfile.c_str());
+  CHECK(binary.size() == result->image_size * sizeof(uint16_t));
+  CHECK(memcmp(binary.data(), result->image, binary.size()) == 0);
+  lc3asm_result_destruct(result);
+}
+
+TEST_CASE("Watch: test files with macros and includes are assembled in full", "[watch]")
+{
+  std::string dir = "/tmp/lc3asm-test-watch-full-" + std::to_string(getpid());
+  std::string asmfile = dir + "/main.asm";
+  std::string binfile = dir + "/main.lc3";
+  std::string defsfile = dir + "/defs.asm";
+  REQUIRE(system(("mkdir -p " + dir).c_str()) == 0);
+  save_file(defsfile, "        .MACRO PUSH REG\n"
+                      "        ADD   R6, R6, #-1\n"
+                      "        STR   REG, R6, #0\n"
+                      "        .ENDM\n");
+  std::string source = "        .INCLUDE \"defs.asm\"\n"
+                       "        .ORIG x3000\n"
+                       "        LD    R1, COUNT\n"
+                       "        PUSH  R1\n"
+                       "        TRAP  x25\n"
+                       "COUNT   .FILL #5\n"
+                       "        .END\n";
+  save_file(asmfile, source);
+  CHECK_FALSE(inc_supported(source.data(), source.size()));
+  CHECK(inc_supported("  ADD R1, R1, #1 ; .INCLUDE in a comment\n", 40));
+
+  // the file is assembled with its macro and included file, and the
+  // included file is watched
+  char* asmfiles[] = {(char*)asmfile.c_str()};
+  watcher* w = watch_construct(asmfiles, 1, NULL, false);
+  CHECK(w->num_builds == 1);
+  CHECK(w->files[0].eng == NULL);
+  REQUIRE(w->files[0].num_deps == 1);
+  CHECK(std::string(w->files[0].deps[0].name) == "defs.asm");
+  check_watch_file(binfile, asmfile);
+
+  // a change to the included file alone builds the file again
+  save_file(defsfile, "        .MACRO PUSH REG\n"
+                      "        ADD   R6, R6, #-2\n"
+                      "        STR   REG, R6, #0\n"
+                      "        .ENDM\n");
+  CHECK(watch_wait(w, 5000) == 1);
+  CHECK(w->num_builds == 2);
+  check_watch_file(binfile, asmfile);
+
+  // without the directives the file goes back to an incremental assembly
+  source = "        .ORIG x3000\n"
+           "        ADD   R1, R1, #1\n"
+           "        .END\n";
+  save_file(asmfile, source);
+  CHECK(watch_wait(w, 5000) == 1);
+  CHECK(w->files[0].eng != NULL);
+  CHECK(w->files[0].num_deps == 0);
+  check_watch_image(binfile, source);
+
+  watch_destruct(w);
+  CHECK(system(("rm -rf " + dir).c_str()) == 0);
+}
+
+/// a source with an error of each kind that assembling goes on after
+static const char* diagnostic_source = "        .ORIG   x3000\n"
+                                       "LOOP    ADD     R1, R1, #1\n"
+                                       "        FOO     R1\n"
+                                       "LOOP    BRp     LOOP\n"
+                                       "        LD      R2, NOWHERE\n"
+                                       "        ADD     R1, R2\n"
+                                       "        AND     R1, R1, R2, R3\n"
+                                       "        BRz     MISSING\n"
+                                       "        .END\n";
+
+TEST_CASE("Diagnostic: test every error of a source is collected", "[diagnostic]")
+{
+  lc3asm_result* result = lc3asm_assemble("errors.asm", diagnostic_source, strlen(diagnostic_source));
+  CHECK_FALSE(result->ok);
+  CHECK(result->image == NULL);
+  struct
+  {
+    unsigned line;
+    unsigned column;
+    diag_code code;
+  } expected[] = {
+    {3, 9, DIAG_UNKNOWN_OPCODE},
+    {4, 0, DIAG_DUPLICATE_LABEL},
+    {5, 21, DIAG_UNDEFINED_SYMBOL},
+    {6, 0, DIAG_MALFORMED},
+    {7, 29, DIAG_TOO_MANY_OPERANDS},
+    {8, 17, DIAG_UNDEFINED_SYMBOL},
+  };
+  REQUIRE(result->num_diagnostics == 6);
+  for (unsigned index = 0; index < 6; index++)
+  {
+    CHECK(std::string(result->diagnostics[index].file) == "errors.asm");
+    CHECK(result->diagnostics[index].line == expected[index].line);
+    CHECK(result->diagnostics[index].column == expected[index].column);
+    CHECK(result->diagnostics[index].code == expected[index].code);
+  }
+  CHECK(std::string(result->diagnostics[2].message).find("undefined symbol <NOWHERE>") != std::string::npos);
+  CHECK(std::string(diag_code_name(DIAG_TOO_MANY_OPERANDS)) == "too-many-operands");
+  lc3asm_result_destruct(result);
+
+  // a streamed assembly skips the line without an opcode too, and goes on
+  diag_sink sink;
+  diag_sink_construct(&sink, NULL);
+  diag_sink* previous = diag_set_sink(&sink);
+  tokenizer* tk = tk_construct_buffer("errors.asm", diagnostic_source, strlen(diagnostic_source));
+  symbol_table* st = st_construct(0);
+  FILE* out = tmpfile();
+  REQUIRE(out != NULL);
+  pass_stream(tk, st, out, NULL);
+  fclose(out);
+  diag_set_sink(previous);
+  diag_sink_sort(&sink);
+  REQUIRE(sink.num_diags == 6);
+  CHECK(sink.diags[0].line == 3);
+  CHECK(sink.diags[0].code == DIAG_UNKNOWN_OPCODE);
+  CHECK(sink.diags[5].line == 8);
+  CHECK(sink.diags[5].code == DIAG_UNDEFINED_SYMBOL);
+  diag_sink_destruct(&sink);
+  tk_destruct(tk);
+  st_destruct(st);
+
+  // without a sink a recoverable error stops the assembly like a fatal one
+  diag_trap trap;
+  diag_set_trap(&trap);
+  if (setjmp(trap.jump) == 0)
+  {
+    diag_error("trap.asm", 7, 3, DIAG_OFFSET_RANGE, "out of <%s>", "range");
+  }
+  diag_clear_trap(&trap);
+  CHECK(trap.diag.line == 7);
+  CHECK(trap.diag.column == 3);
+  CHECK(trap.diag.code == DIAG_OFFSET_RANGE);
+  CHECK(std::string(trap.diag.message) == "out of <range>");
+  diag_destruct(&trap.diag);
+}
+
+TEST_CASE("Diagnostic: test a parallel pass two collects its errors as JSON", "[diagnostic]")
+{
+  // an undefined symbol in every chunk of the workers
+  std::string source = "        .ORIG   x3000\n        ADD     R1, R1, #0\n";
+  for (unsigned line = 0; line < 4 * PASS_TWO_CHUNK; line++)
+  {
+    source += line % PASS_TWO_CHUNK == 7 ? "        LD      R1, GONE\n" : "        ADD     R1, R1, #1\n";
+  }
+  source += "        .END\n";
+
+  diag_sink sink;
+  diag_sink_construct(&sink, NULL);
+  diag_sink* previous = diag_set_sink(&sink);
+  tokenizer* tk = tk_construct_buffer("json.asm", source.data(), source.size());
+  symbol_table* st = st_construct(0);
+  operation_list* opl = pass_one(tk, st);
+  opl_set_source(opl, 0, source.data(), source.size());
+  pass_two_parallel(opl, st, 4);
+
+  // an error with a quote in it, recorded by this thread
+  diag_error("json.asm", 1, 0, DIAG_BAD_INCBIN, "<%s>", "\"quoted\"");
+  diag_set_sink(previous);
+
+  REQUIRE(sink.num_diags == 5);
+  diag_sink_sort(&sink);
+  CHECK(sink.diags[0].code == DIAG_BAD_INCBIN);
+  for (unsigned index = 1; index < sink.num_diags; index++)
+  {
+    CHECK(sink.diags[index].code == DIAG_UNDEFINED_SYMBOL);
+    CHECK(sink.diags[index].line == 3 + 7 + (index - 1) * PASS_TWO_CHUNK);
+    CHECK(sink.diags[index].column == 21);
+  }
+
+  char* json = NULL;
+  size_t length = 0;
+  FILE* out = open_memstream(&json, &length);
+  diag_write_json(&sink, out);
+  fclose(out);
+  std::string text(json, length);
+  CHECK(text.find("{\"file\": \"json.asm\", \"line\": 1, \"column\": 0, \"code\": \"bad-incbin\", "
+                  "\"severity\": \"error\", \"message\": \"<\\\"quoted\\\">\"}") != std::string::npos);
+  CHECK(text.find("\"line\": 10, \"column\": 21, \"code\": \"undefined-symbol\"") != std::string::npos);
+  free(json);
+
+  tk_destruct(tk);
+  st_destruct(st);
+  opl_destruct(opl);
+  diag_sink_destruct(&sink);
+}
+
+TEST_CASE("Diagnostic: test `lc3asm_file()` returns on errors instead of exiting", "[diagnostic]")
+{
+  std::string base = "/tmp/lc3asm-file-" + std::to_string(getpid());
+  std::string badfile = base + ".asm";
+  std::string binfile = base + ".lc3";
+  FILE* out = fopen(badfile.c_str(), "w");
+  REQUIRE(out != NULL);
+  fputs(diagnostic_source, out);
+  fclose(out);
+
+  // the errors of a file, or a file that can not be read, are reported and
+  // nothing is written, then the next file assembles as usual
+  remove(binfile.c_str());
+  CHECK_FALSE(lc3asm_file(badfile.c_str(), binfile.c_str(), false, LC3ASM_OPTIMIZE, 1, NULL));
+  CHECK(fopen(binfile.c_str(), "rb") == NULL);
+  CHECK_FALSE(lc3asm_file("progs/no-such-file.asm", binfile.c_str(), false, 0, 1, NULL));
+  CHECK_FALSE(lc3asm_stream_file(badfile.c_str(), binfile.c_str(), false));
+  CHECK(fopen(binfile.c_str(), "rb") == NULL);
+  CHECK(diag_get_sink() == NULL);
+
+  CHECK(lc3asm_file("progs/test-allopc.asm", binfile.c_str(), false, LC3ASM_DEPFILE, 2, NULL));
+  CHECK(read_file(binfile.c_str()) == read_file("progs/test-allopc.lc3"));
+  CHECK(lc3asm_stream_file("progs/test-allopc.asm", binfile.c_str(), false));
+  CHECK(read_file(binfile.c_str()) == read_file("progs/test-allopc.lc3"));
+
+  remove(badfile.c_str());
+  remove(binfile.c_str());
+  remove((base + ".d").c_str());
+}
+
+TEST_CASE("Context: test contexts are reset for reuse and assemble concurrently", "[context]")
+{
+  // two buffers tokenized at the same time, each with its own cursor
+  char first[] = "ADD R1, R2";
+  char second[] = "LD  R3, \"a b\"";
+  char* cursor1;
+  char* cursor2;
+  CHECK(std::string(strtokquote_r(first, (char*)" ,", &cursor1)) == "ADD");
+  CHECK(std::string(strtokquote_r(second, (char*)" ,", &cursor2)) == "LD");
+  CHECK(std::string(strtokquote_r(NULL, (char*)" ,", &cursor1)) == "R1");
+  CHECK(std::string(strtokquote_r(NULL, (char*)" ,", &cursor2)) == "R3");
+  CHECK(std::string(strtokquote_r(NULL, (char*)" ,", &cursor2)) == "\"a b\"");
+  CHECK(std::string(strtokquote_r(NULL, (char*)" ,", &cursor1)) == "R2");
+  CHECK(strtokquote_r(NULL, (char*)" ,", &cursor1) == NULL);
+
+  // a reset context keeps the capacity of its tables
+  std::string source = read_file("progs/test-allopc.asm");
+  lc3asm_result* expected = lc3asm_assemble("allopc.asm", source.data(), source.size());
+  REQUIRE(expected->ok);
+  lc3asm_context* ctx = lc3asm_context_construct();
+  lc3asm_result* result = lc3asm_context_assemble(ctx, "allopc.asm", source.data(), source.size());
+  unsigned capacity = ctx->opl->capacity;
+  CHECK(capacity > 0);
+  CHECK(ctx->opl->num_entries == 0);
+  CHECK(ctx->st->num_entries == 0);
+  lc3asm_result_destruct(result);
+
+  // an error does not leave anything behind for the next assembly
+  result = lc3asm_context_assemble(ctx, "bad.asm", diagnostic_source, strlen(diagnostic_source));
+  CHECK(result->num_diagnostics == 6);
+  CHECK(ctx->sink.num_diags == 0);
+  CHECK(ctx->tk == NULL);
+  lc3asm_result_destruct(result);
+  result = lc3asm_context_assemble(ctx, "allopc.asm", source.data(), source.size());
+  REQUIRE(result->ok);
+  CHECK(result->image_size == expected->image_size);
+  CHECK(memcmp(result->image, expected->image, expected->image_size * sizeof(uint16_t)) == 0);
+  CHECK(ctx->opl->capacity == capacity);
+  CHECK(ctx->num_assemblies == 3);
+  lc3asm_result_destruct(result);
+  lc3asm_context_destruct(ctx);
+
+  // threads that each reuse their own context, some of the sources have
+  // errors
+  const unsigned num_threads = 4;
+  const unsigned num_assemblies = 20;
+  std::vector<unsigned> matched(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (unsigned thread = 0; thread < num_threads; thread++)
+  {
+    threads.emplace_back([&, thread]() {
+      lc3asm_context* own = lc3asm_context_construct();
+      for (unsigned assembly = 0; assembly < num_assemblies; assembly++)
+      {
+        bool bad = (assembly + thread) % 3 == 0;
+        lc3asm_result* r = bad ? lc3asm_context_assemble(own, "bad.asm", diagnostic_source, strlen(diagnostic_source))
+                               : lc3asm_context_assemble(own, "allopc.asm", source.data(), source.size());
+        matched[thread] += bad ? r->num_diagnostics == 6
+                               : r->ok && r->image_size == expected->image_size &&
+                                   memcmp(r->image, expected->image, r->image_size * sizeof(uint16_t)) == 0;
+        lc3asm_result_destruct(r);
+      }
+      lc3asm_context_destruct(own);
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  for (unsigned thread = 0; thread < num_threads; thread++)
+  {
+    CHECK(matched[thread] == num_assemblies);
+  }
+  lc3asm_result_destruct(expected);
+}
+
+TEST_CASE("Writer: test the image is written in one piece and by entry alike", "[writer]")
+{
+  // a .STRINGZ and a .BLKW longer than the blocks `write_entry()` writes
+  // them in, in two sections
+  std::string text(300, 'x');
+  text[255] = 'y';
+  std::string source = "        .ORIG x3000\n"
+                       "        LEA   R0, TEXT\n"
+                       "        TRAP  x22\n"
+                       "        TRAP  x25\n"
+                       "TEXT    .STRINGZ \"" +
+                       text +
+                       "\"\n"
+                       "        .END\n"
+                       "        .ORIG x4000\n"
+                       "        .BLKW #600\n"
+                       "        .FILL x1234\n"
+                       "        .END\n";
+  std::string asmfile = "/tmp/lc3asm-writer-" + std::to_string(getpid()) + ".asm";
+  std::string binfile = "/tmp/lc3asm-writer-" + std::to_string(getpid()) + ".lc3";
+  FILE* out = fopen(asmfile.c_str(), "w");
+  REQUIRE(out != NULL);
+  fputs(source.c_str(), out);
+  fclose(out);
+
+  tokenizer* tk = tk_construct(asmfile.c_str());
+  symbol_table* st = st_construct(0);
+  operation_list* opl = pass_one(tk, st);
+  pass_two(opl, st);
+  REQUIRE(image_size(opl) == 2 + 3 + 301 + 2 + 601);
+  std::vector<uint16_t> image(image_size(opl));
+  REQUIRE(write_image(opl, image.data()) == image.size());
+  CHECK(image[5 + 255] == 'y');
+  CHECK(image[5 + 300] == 0x0);
+  CHECK(image[image.size() - 1] == 0x1234);
+
+  // the binary file is the image
+  write_bin_file(binfile.c_str(), opl, false);
+  std::string written = read_file(binfile.c_str());
+  REQUIRE(written.size() == image.size() * WORD_SIZE);
+  CHECK(memcmp(written.data(), image.data(), written.size()) == 0);
+
+  // and so is the binary file that is streamed an entry at a time
+  tk_destruct(tk);
+  st_destruct(st);
+  tk = tk_construct(asmfile.c_str());
+  st = st_construct(0);
+  FILE* streamed = tmpfile();
+  REQUIRE(streamed != NULL);
+  CHECK(pass_stream(tk, st, streamed, NULL) == image.size());
+  rewind(streamed);
+  std::string bytes = read_bin(streamed);
+  fclose(streamed);
+  REQUIRE(bytes.size() == image.size() * WORD_SIZE);
+  CHECK(memcmp(bytes.data(), image.data(), bytes.size()) == 0);
+
+  remove(asmfile.c_str());
+  remove(binfile.c_str());
+  tk_destruct(tk);
+  st_destruct(st);
+  opl_destruct(opl);
 }
-#endif // task 6
\ No newline at end of file
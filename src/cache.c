@@ -0,0 +1,423 @@
+/** @file cache.c
+ * @brief LC-3 Assembler output cache
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * A content addressed cache of assembler outputs, see cache.h.  Keys are
+ * XXH64 hashes, which hash a source many times faster than it can be
+ * tokenized.  Entry files are written under a temporary name and renamed
+ * into place, the image last, so concurrent assemblers sharing a cache
+ * never see a partly written entry.  Files are copied in and out of the
+ * cache with a reflink where the file system supports it, so a hit shares
+ * the blocks of the cached image instead of copying them.
+ */
+#define _GNU_SOURCE
+#include "cache.h"
+#include "assembler.h"
+#include "diagnostic.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+/// XXH64 primes
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t value, int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const unsigned char* p)
+{
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint32_t read32(const unsigned char* p)
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+  acc += input * PRIME2;
+  acc = rotl64(acc, 31);
+  return acc * PRIME1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t value)
+{
+  acc ^= xxh_round(0, value);
+  return acc * PRIME1 + PRIME4;
+}
+
+/** @brief hash bytes
+ *
+ * The XXH64 hash of a block of bytes.  The bytes are read in host byte
+ * order, so on a little endian machine this is exactly XXH64.
+ *
+ * @param data The bytes to hash.
+ * @param length The number of bytes.
+ * @param seed The seed of the hash, a previous hash to chain hashes.
+ *
+ * @returns uint64_t The hash.
+ */
+uint64_t cache_hash(const void* data, size_t length, uint64_t seed)
+{
+  const unsigned char* p = (const unsigned char*)data;
+  const unsigned char* end = p + length;
+  uint64_t hash;
+
+  if (length >= 32)
+  {
+    uint64_t v1 = seed + PRIME1 + PRIME2;
+    uint64_t v2 = seed + PRIME2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME1;
+    do
+    {
+      v1 = xxh_round(v1, read64(p));
+      v2 = xxh_round(v2, read64(p + 8));
+      v3 = xxh_round(v3, read64(p + 16));
+      v4 = xxh_round(v4, read64(p + 24));
+      p += 32;
+    } while (p + 32 <= end);
+
+    hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    hash = xxh_merge(hash, v1);
+    hash = xxh_merge(hash, v2);
+    hash = xxh_merge(hash, v3);
+    hash = xxh_merge(hash, v4);
+  }
+  else
+  {
+    hash = seed + PRIME5;
+  }
+  hash += (uint64_t)length;
+
+  for (; p + 8 <= end; p += 8)
+  {
+    hash ^= xxh_round(0, read64(p));
+    hash = rotl64(hash, 27) * PRIME1 + PRIME4;
+  }
+  if (p + 4 <= end)
+  {
+    hash ^= (uint64_t)read32(p) * PRIME1;
+    hash = rotl64(hash, 23) * PRIME2 + PRIME3;
+    p += 4;
+  }
+  for (; p < end; p++)
+  {
+    hash ^= (*p) * PRIME5;
+    hash = rotl64(hash, 11) * PRIME1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= PRIME2;
+  hash ^= hash >> 29;
+  hash *= PRIME3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/** @brief cache key of a source
+ *
+ * The key a source is cached under, a hash of the source bytes, the
+ * assembler version and the flags that change the output.
+ *
+ * @param source The assembly source.
+ * @param length The length of the source.
+ * @param flags The flags of the assembly that change its output.
+ * @param key Returns the key, it must have room for CACHE_KEY_SIZE chars.
+ */
+void cache_key(const char* source, size_t length, unsigned flags, char* key)
+{
+  uint64_t hash = cache_hash(source, length, 0);
+  hash = cache_hash(LC3ASM_VERSION, strlen(LC3ASM_VERSION), hash);
+  hash = cache_hash(&flags, sizeof(flags), hash);
+  snprintf(key, CACHE_KEY_SIZE, "%016llx", (unsigned long long)hash);
+}
+
+/** @brief source can be cached
+ *
+ * The key of a source only covers its own text, so a source that includes
+ * other files is not cached, an edit of an included file would not change
+ * its key.  Any .INCLUDE or .INCBIN in the text counts, even one in a
+ * comment.
+ *
+ * @param source The assembly source.
+ * @param length The length of the source.
+ *
+ * @returns bool true if the outputs of the source can be cached.
+ */
+bool cache_cacheable(const char* source, size_t length)
+{
+  const char* end = source + length;
+  for (const char* dot = source; (dot = memchr(dot, '.', end - dot)) != NULL; dot++)
+  {
+    if ((end - dot >= 8 && strncasecmp(dot, ".INCLUDE", 8) == 0) ||
+        (end - dot >= 7 && strncasecmp(dot, ".INCBIN", 7) == 0))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** @brief construct cache
+ *
+ * Open a cache directory, creating it if it does not exist yet.
+ *
+ * @param dir The cache directory.
+ *
+ * @returns cache* The new cache, destructed with `cache_destruct()`.
+ */
+cache* cache_construct(const char* dir)
+{
+  if (mkdir(dir, 0777) < 0 && errno != EEXIST)
+  {
+    diag_fatal(NULL, 0, "<cache::cache_construct> could not create cache directory <%s>: %s", dir, strerror(errno));
+  }
+
+  cache* ch = (cache*)malloc(sizeof(cache));
+  ch->dir = strdup(dir);
+  ch->hits = 0;
+  ch->misses = 0;
+  return ch;
+}
+
+/** @brief destruct cache
+ *
+ * Free a cache, the cache directory and its entries are kept.
+ *
+ * @param ch The cache to destruct.
+ */
+void cache_destruct(cache* ch)
+{
+  free(ch->dir);
+  free(ch);
+}
+
+/** @brief entry file name
+ *
+ * The newly allocated name of a file of a cache entry.
+ */
+static char* entry_file(cache* ch, const char* key, const char* ext)
+{
+  size_t length = strlen(ch->dir) + 1 + strlen(key) + strlen(ext) + 1;
+  char* name = (char*)malloc(length);
+  snprintf(name, length, "%s/%s%s", ch->dir, key, ext);
+  return name;
+}
+
+/** @brief copy file
+ *
+ * Copy a file, with a reflink if the file system can share the blocks of
+ * the two files, else with copy_file_range() so the copy stays in the
+ * kernel, else by reading and writing.
+ *
+ * @returns bool true if the file was copied.
+ */
+static bool copy_file(const char* from, const char* to)
+{
+  int in = open(from, O_RDONLY);
+  if (in < 0)
+  {
+    return false;
+  }
+  int out = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (out < 0)
+  {
+    close(in);
+    return false;
+  }
+
+  bool copied = false;
+#ifdef FICLONE
+  copied = ioctl(out, FICLONE, in) == 0;
+#endif
+  ssize_t got = 1;
+  while (!copied && got > 0)
+  {
+    got = copy_file_range(in, NULL, out, NULL, 1 << 30, 0);
+    copied = got == 0;
+  }
+  if (!copied)
+  {
+    // copy_file_range() is not supported between these files, copy the
+    // rest from where it stopped
+    char block[8192];
+    while ((got = read(in, block, sizeof(block))) > 0 && write(out, block, got) == got)
+    {
+    }
+    copied = got == 0;
+  }
+
+  close(in);
+  copied = close(out) == 0 && copied;
+  return copied;
+}
+
+/** @brief fetch cache entry
+ *
+ * Look up an entry in the cache and on a hit copy its image to the
+ * binary file.
+ *
+ * @param ch The cache.
+ * @param key The key of the source being assembled.
+ * @param binfile The binary file to write.
+ * @param listing true if the symbol table and listing of the entry are also
+ *   needed, for verbose output, an entry without them is a miss.
+ *
+ * @returns bool true on a hit, when the binary file has been written.
+ */
+bool cache_fetch(cache* ch, const char* key, const char* binfile, bool listing)
+{
+  bool hit = true;
+  if (listing)
+  {
+    char* symbols = entry_file(ch, key, CACHE_SYMBOLS);
+    char* lst = entry_file(ch, key, CACHE_LISTING);
+    hit = access(symbols, R_OK) == 0 && access(lst, R_OK) == 0;
+    free(symbols);
+    free(lst);
+  }
+  if (hit)
+  {
+    char* image = entry_file(ch, key, CACHE_IMAGE);
+    hit = copy_file(image, binfile);
+    free(image);
+  }
+
+  if (hit)
+  {
+    ch->hits++;
+  }
+  else
+  {
+    ch->misses++;
+  }
+  return hit;
+}
+
+/** @brief display cache entry file
+ *
+ * Copy the symbol table report or listing of an entry to standard output,
+ * exactly as it was displayed when the entry was assembled.
+ *
+ * @param ch The cache.
+ * @param key The key of the entry.
+ * @param ext CACHE_SYMBOLS or CACHE_LISTING.
+ */
+void cache_display(cache* ch, const char* key, const char* ext)
+{
+  char* name = entry_file(ch, key, ext);
+  FILE* in = fopen(name, "r");
+  free(name);
+  if (in == NULL)
+  {
+    return;
+  }
+  char block[8192];
+  size_t got;
+  while ((got = fread(block, 1, sizeof(block), in)) > 0)
+  {
+    fwrite(block, 1, got, stdout);
+  }
+  fclose(in);
+}
+
+/** @brief publish entry file
+ *
+ * Move a finished temporary file into place as a file of an entry.
+ */
+static void publish(cache* ch, const char* key, const char* ext, const char* temp)
+{
+  char* name = entry_file(ch, key, ext);
+  if (rename(temp, name) < 0)
+  {
+    unlink(temp);
+  }
+  free(name);
+}
+
+/** @brief store cache entry
+ *
+ * Add the outputs of an assembly to the cache.  A failure to write to the
+ * cache is not an error, the entry is just missing next time.
+ *
+ * @param ch The cache.
+ * @param key The key of the source that was assembled.
+ * @param binfile The binary file the assembly wrote.
+ * @param st The symbol table of the assembly, or NULL to not keep the
+ *   symbol table report.
+ * @param opl The operation list of the assembly, or NULL to not keep the
+ *   listing.
+ */
+void cache_store(cache* ch, const char* key, const char* binfile, symbol_table* st, operation_list* opl)
+{
+  char temp[64];
+  snprintf(temp, sizeof(temp), ".%d", (int)getpid());
+  char* name = entry_file(ch, key, temp);
+
+  if (st != NULL)
+  {
+    FILE* out = fopen(name, "w");
+    if (out != NULL)
+    {
+      st_fdisplay(out, st);
+      fclose(out);
+      publish(ch, key, CACHE_SYMBOLS, name);
+    }
+  }
+  if (opl != NULL)
+  {
+    FILE* out = fopen(name, "w");
+    if (out != NULL)
+    {
+      opl_fdisplay(out, opl);
+      fclose(out);
+      publish(ch, key, CACHE_LISTING, name);
+    }
+  }
+
+  // the image goes in last, it is what makes the entry a hit
+  if (copy_file(binfile, name))
+  {
+    publish(ch, key, CACHE_IMAGE, name);
+  }
+  else
+  {
+    unlink(name);
+  }
+  free(name);
+}
+
+/** @brief display cache statistics
+ *
+ * Display the hits and misses of this process on standard output.
+ *
+ * @param ch The cache.
+ */
+void cache_display_stats(cache* ch)
+{
+  printf("cache <%s>: hits <%u> misses <%u>\n", ch->dir, ch->hits, ch->misses);
+}
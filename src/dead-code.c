@@ -0,0 +1,268 @@
+/** @file dead-code.c
+ * @brief LC-3 Assembler dead code and unreferenced data elimination
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Dead code elimination, see dead-code.h.  Labels and offsets are turned
+ * into entries through a table of the entry at each address, and the
+ * entries are reached with a work list, each entry is put on it once when
+ * it is first reached, so the walk is linear in the size of the program.
+ */
+#include "dead-code.h"
+#include "assembler.h"
+#include "peephole.h"
+#include "relax.h"
+#include <stdlib.h>
+#include <string.h>
+
+/// no entry at an address
+#define NO_ENTRY ((unsigned)-1)
+
+/// The walk of the program, the entries reached so far and those still to
+/// follow.
+typedef struct dead_walk
+{
+  operation_list* opl;
+  symbol_table* st;
+
+  // the entry at each address, the first entry with words there
+  unsigned* entry_at;
+
+  // a flag for each entry, nonzero once it is reached, and the reached
+  // entries that are still to be followed
+  uint8_t* reached;
+  unsigned* work;
+  unsigned num_work;
+} dead_walk;
+
+/** @brief is data
+ *
+ * Check if an entry is data, a pseudo op that has words.
+ */
+static bool is_data(opl_hot* hot, unsigned idx)
+{
+  return hot->opc[idx] == FILL || hot->opc[idx] == BLKW || hot->opc[idx] == STRINGZ || hot->opc[idx] == INCBIN;
+}
+
+/** @brief falls through
+ *
+ * Check if an instruction can go on to the instruction after it.  A TRAP
+ * returns to the instruction after it, even a HALT, when the operating
+ * system lets the program continue.
+ */
+static bool falls_through(opl_hot* hot, unsigned idx)
+{
+  switch (hot->opc[idx])
+  {
+  case BR:
+    return hot->flags[idx] != 0x7;
+  case JMP:
+  case RTI:
+    return false;
+  default:
+    return true;
+  }
+}
+
+/** @brief reach entry
+ *
+ * Reach an entry, putting it on the work list the first time.
+ */
+static void reach(dead_walk* walk, unsigned idx)
+{
+  if (idx != NO_ENTRY && !walk->reached[idx])
+  {
+    walk->reached[idx] = 1;
+    walk->work[walk->num_work++] = idx;
+  }
+}
+
+/** @brief reach address
+ *
+ * Reach the entry at an address, if the program has one.
+ */
+static void reach_address(dead_walk* walk, uint16_t address)
+{
+  reach(walk, walk->entry_at[address]);
+}
+
+/** @brief follow operands
+ *
+ * Reach the labels an entry uses, and the targets of its numeric PC
+ * offsets.
+ */
+static void follow_operands(dead_walk* walk, unsigned idx)
+{
+  opl_hot* hot = &walk->opl->hot;
+  for (unsigned opr = 0; opr < hot->num_opr[idx]; opr++)
+  {
+    if (hot->oprtype[opr][idx] == SYMBOL)
+    {
+      // an undefined label is left for pass two to report
+      st_entry* target = st_lookup(walk->st, walk->opl->entries[idx].opr[opr]->svalue);
+      if (target != NULL)
+      {
+        reach_address(walk, target->address);
+      }
+    }
+    else if (hot->oprtype[opr][idx] == NUMERIC && hot->opc[idx] < ORIG && relax_offset_bits(hot, idx, opr) > 0)
+    {
+      reach_address(walk, hot->address[idx] + 1 + (int16_t)hot->value[opr][idx]);
+    }
+  }
+}
+
+/** @brief follow entry
+ *
+ * Reach everything a reached entry reaches.  An instruction reaches the
+ * instruction after it, and data the rest of its run.
+ */
+static void follow(dead_walk* walk, unsigned idx)
+{
+  operation_list* opl = walk->opl;
+  opl_hot* hot = &opl->hot;
+  follow_operands(walk, idx);
+  if (is_data(hot, idx))
+  {
+    for (unsigned prev = idx; prev-- > 0 && is_data(hot, prev);)
+    {
+      reach(walk, prev);
+    }
+    for (unsigned next = idx + 1; next < opl->num_entries && is_data(hot, next); next++)
+    {
+      reach(walk, next);
+    }
+  }
+  else if (hot->opc[idx] < ORIG && falls_through(hot, idx))
+  {
+    // the next entry with words, unless the section ends first
+    unsigned next = idx + 1;
+    for (; next < opl->num_entries && hot->size[next] == 0 && hot->opc[next] != ORIG && hot->opc[next] != END;
+         next++)
+    {
+    }
+    if (next < opl->num_entries && hot->opc[next] != ORIG && hot->opc[next] != END)
+    {
+      reach(walk, next);
+    }
+  }
+}
+
+/** @brief is pinned
+ *
+ * Check if any word of an entry is pinned by a numeric offset.
+ */
+static bool is_pinned(opl_hot* hot, unsigned idx, const uint8_t* pinned)
+{
+  for (unsigned word = 0; pinned != NULL && word < hot->size[idx]; word++)
+  {
+    if (pinned[(uint16_t)(hot->address[idx] + word)])
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** @brief dead code elimination
+ *
+ * Remove the instructions no entry point reaches and the data they do not
+ * reference.  Run after pass one and before the `-O` passes, so they only
+ * look at the code that is kept, and before `relax()`, the entries and the
+ * symbol table get the addresses of the smaller program.
+ *
+ * @param opl The operation list of pass one.
+ * @param st The symbol table of pass one.
+ *
+ * @returns dead_stats The instructions and words of data removed.
+ */
+dead_stats dead_code(operation_list* opl, symbol_table* st)
+{
+  opl_hot* hot = &opl->hot;
+  dead_stats stats;
+  memset(&stats, 0, sizeof(stats));
+
+  dead_walk walk;
+  walk.opl = opl;
+  walk.st = st;
+  walk.entry_at = (unsigned*)malloc(NUM_ADDRESSES * sizeof(unsigned));
+  memset(walk.entry_at, 0xff, NUM_ADDRESSES * sizeof(unsigned));
+  walk.reached = (uint8_t*)calloc(opl->num_entries + 1, sizeof(uint8_t));
+  walk.work = (unsigned*)malloc((opl->num_entries + 1) * sizeof(unsigned));
+  walk.num_work = 0;
+  for (unsigned idx = opl->num_entries; idx-- > 0;)
+  {
+    if (hot->size[idx] > 0)
+    {
+      walk.entry_at[hot->address[idx]] = idx;
+    }
+  }
+
+  // the entry points, the first word of the program and of each section
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    if (idx == 0 || hot->opc[idx] == ORIG)
+    {
+      unsigned first = hot->opc[idx] == ORIG ? idx + 1 : idx;
+      for (; first < opl->num_entries && hot->size[first] == 0 && hot->opc[first] != ORIG && hot->opc[first] != END;
+           first++)
+      {
+      }
+      if (first < opl->num_entries && hot->size[first] > 0)
+      {
+        reach(&walk, first);
+      }
+    }
+  }
+  while (walk.num_work > 0)
+  {
+    follow(&walk, walk.work[--walk.num_work]);
+  }
+
+  uint8_t* pinned = peep_pin_numeric_offsets(opl);
+  unsigned first_removed = opl->num_entries;
+  bool in_block = false;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    // a block of removed entries ends with its section
+    if (hot->size[idx] == 0)
+    {
+      in_block = in_block && hot->opc[idx] != ORIG && hot->opc[idx] != END;
+      continue;
+    }
+    if (walk.reached[idx] || is_pinned(hot, idx, pinned))
+    {
+      in_block = false;
+      continue;
+    }
+    if (is_data(hot, idx))
+    {
+      stats.num_data_words += hot->size[idx];
+    }
+    else
+    {
+      stats.num_instructions++;
+    }
+    stats.num_blocks += !in_block;
+    in_block = true;
+    opl->size -= hot->size[idx];
+    hot->size[idx] = 0;
+    if (first_removed == opl->num_entries)
+    {
+      first_removed = idx;
+    }
+  }
+  free(pinned);
+  free(walk.entry_at);
+  free(walk.reached);
+  free(walk.work);
+
+  if (first_removed < opl->num_entries)
+  {
+    assign_addresses(opl, st, first_removed);
+  }
+  return stats;
+}
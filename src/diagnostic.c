@@ -0,0 +1,583 @@
+/** @file diagnostic.c
+ * @brief assembler error diagnostics
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * All of the errors found while assembling are reported through
+ * `diag_fatal()`.  Normally a fatal error is printed on standard error
+ * and the assembler exits.  When the assembler is used as a library it
+ * must not exit, so the library sets an error trap first.  While a trap is
+ * set, a fatal error in that thread is recorded as a diagnostic in the trap
+ * and control jumps back to where the trap was set, which then cleans up
+ * and returns the diagnostic to its caller.
+ *
+ * The trap and the current location are kept per thread, so independent
+ * assemblies can run in different threads at the same time.  So is the
+ * diagnostic sink, the threads of a parallel pass two are given the sink
+ * of their assembly, and the sink itself is locked while an error is
+ * recorded in it.
+ */
+#define __STDC_WANT_LIB_EXT2__ 1
+#include "diagnostic.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// the innermost error trap set by this thread, or NULL if errors exit
+static _Thread_local diag_trap* current_trap = NULL;
+
+/// the file and line this thread is currently assembling, used for
+/// errors that are reported without a location
+static _Thread_local const char* current_file = NULL;
+static _Thread_local unsigned current_line = 0;
+
+/// the sink this thread records the errors it goes on after in, or NULL if
+/// they stop the assembly
+static _Thread_local diag_sink* current_sink = NULL;
+
+/// the names of the codes, in the order of diag_code
+static const char* code_names[DIAG_NUM_CODES] = {"fatal", "unknown-opcode", "duplicate-label", "too-many-operands",
+  "bad-incbin", "undefined-symbol", "offset-range", "malformed-operation", "bad-macro", "bad-include", "section-overlap",
+  "relaxed-offset"};
+
+/** @brief set error trap
+ *
+ * Catch the fatal errors of this thread in trap, until the trap is cleared.
+ * The caller must call setjmp() on the trap jump buffer right after setting
+ * the trap, a fatal error returns there with a nonzero value.
+ *
+ * @param trap The trap to catch errors in.
+ */
+void diag_set_trap(diag_trap* trap)
+{
+  trap->diag.file = NULL;
+  trap->diag.line = 0;
+  trap->diag.message = NULL;
+  trap->previous = current_trap;
+  current_trap = trap;
+}
+
+/** @brief clear error trap
+ *
+ * Stop catching errors in trap, the trap set before it, if any, catches
+ * them again.  The diagnostic recorded in the trap is left for the caller.
+ *
+ * @param trap The innermost trap of this thread.
+ */
+void diag_clear_trap(diag_trap* trap)
+{
+  current_trap = trap->previous;
+  current_file = NULL;
+  current_line = 0;
+}
+
+/** @brief set current location
+ *
+ * Record the file and line being assembled, errors found by code that
+ * does not know which line it is working on are reported at this location.
+ *
+ * @param file The name of the assembly file, it is not copied so must stay
+ *   valid until the location changes.
+ * @param line The line number in the file.
+ */
+void diag_locate(const char* file, unsigned line)
+{
+  current_file = file;
+  current_line = line;
+}
+
+/** @brief format diagnostic
+ *
+ * Build a diagnostic from a printf() format and its arguments.
+ */
+static diagnostic diag_vformat(const char* file, unsigned line, unsigned column, diag_code code, const char* format,
+  va_list args)
+{
+  diagnostic diag = {file ? strdup(file) : NULL, line, NULL, column, code};
+
+  va_list copy;
+  va_copy(copy, args);
+  int length = vsnprintf(NULL, 0, format, copy);
+  va_end(copy);
+  diag.message = (char*)malloc(length + 1);
+  if (diag.message)
+  {
+    vsnprintf(diag.message, length + 1, format, args);
+  }
+  return diag;
+}
+
+/** @brief format diagnostic
+ *
+ * Build a diagnostic about an error that does not stop the assembly, for
+ * example a file of a batch that could not be read.  The message is
+ * formatted like printf().
+ *
+ * @param file The name of the file the error is in, or NULL.
+ * @param line The line the error is on, or 0.
+ * @param format The printf() format of the message.
+ *
+ * @returns diagnostic The diagnostic, its file and message are newly
+ *   allocated and freed with `diag_destruct()`.
+ */
+diagnostic diag_format(const char* file, unsigned line, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  diagnostic diag = diag_vformat(file, line, 0, DIAG_FATAL, format, args);
+  va_end(args);
+  return diag;
+}
+
+/** @brief record diagnostic
+ *
+ * Add an error to a sink, at the current location if it has none.
+ */
+static void diag_record(diag_sink* sink, const char* file, unsigned line, unsigned column, diag_code code,
+  const char* format, va_list args)
+{
+  if (file == NULL && line == 0)
+  {
+    file = current_file;
+    line = current_line;
+  }
+  diag_sink_add(sink, diag_vformat(file, line, column, code, format, args));
+}
+
+/** @brief fatal error
+ *
+ * Stop the assembly with an error, see `diag_fatal()`.  A thread with a
+ * sink but no trap reports the errors recorded so far along with this one
+ * before it exits.
+ */
+static DIAG_NORETURN void diag_vfatal(const char* file, unsigned line, unsigned column, diag_code code,
+  const char* format, va_list args)
+{
+  if (current_trap == NULL && current_sink != NULL)
+  {
+    diag_record(current_sink, file, line, column, code, format, args);
+    diag_sink_report(current_sink);
+    exit(1);
+  }
+  if (current_trap == NULL)
+  {
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    exit(1);
+  }
+
+  if (file == NULL && line == 0)
+  {
+    file = current_file;
+    line = current_line;
+  }
+
+  diag_trap* trap = current_trap;
+  trap->diag = diag_vformat(file, line, column, code, format, args);
+  longjmp(trap->jump, 1);
+}
+
+/** @brief fatal error
+ *
+ * Report an error that stops the assembly.  The message is formatted like
+ * printf().  If this thread has set an error trap the message is recorded
+ * as a diagnostic in the trap and we jump back to the trap, otherwise the
+ * message is printed on standard error and the process exits.
+ *
+ * @param file The name of the file the error is in, NULL to use the current
+ *   location.
+ * @param line The line the error is on, 0 to use the current location.
+ * @param format The printf() format of the message.
+ */
+void diag_fatal(const char* file, unsigned line, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  diag_vfatal(file, line, 0, DIAG_FATAL, format, args);
+}
+
+/** @brief recoverable error
+ *
+ * Report an error that only spoils the operation it is in.  If this thread
+ * has set a diagnostic sink the error is recorded in it and we return, the
+ * caller skips the operation and the assembly goes on, otherwise this is
+ * the same as `diag_fatal()` and does not return.
+ *
+ * @param file The name of the file the error is in, NULL to use the current
+ *   location.
+ * @param line The line the error is on, 0 to use the current location.
+ * @param column The column of the token the error is about, counted from 1,
+ *   or 0 for the whole line.
+ * @param code The kind of error.
+ * @param format The printf() format of the message.
+ */
+void diag_error(const char* file, unsigned line, unsigned column, diag_code code, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  if (current_sink == NULL)
+  {
+    diag_vfatal(file, line, column, code, format, args);
+  }
+  diag_record(current_sink, file, line, column, code, format, args);
+  va_end(args);
+}
+
+/** @brief warning
+ *
+ * Report something the assembler did that the user should know about,
+ * but that is not an error, like an operation it relaxed.  If this thread
+ * has set a diagnostic sink the warning is recorded in it, otherwise it is
+ * printed on standard error, and we always return.
+ *
+ * @param file The name of the file the warning is about, NULL to use the
+ *   current location.
+ * @param line The line the warning is about, 0 to use the current location.
+ * @param column The column of the token the warning is about, counted from
+ *   1, or 0 for the whole line.
+ * @param code The kind of warning, one of the warning codes.
+ * @param format The printf() format of the message.
+ */
+void diag_warning(const char* file, unsigned line, unsigned column, diag_code code, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  if (current_sink != NULL)
+  {
+    diag_record(current_sink, file, line, column, code, format, args);
+  }
+  else
+  {
+    if (file == NULL && line == 0)
+    {
+      file = current_file;
+      line = current_line;
+    }
+    diagnostic diag = diag_vformat(file, line, column, code, format, args);
+    diag_print(stderr, &diag);
+    diag_destruct(&diag);
+  }
+  va_end(args);
+}
+
+/** @brief column of a token
+ *
+ * @param line The source line, or NULL.
+ * @param token A token of the line, or NULL.
+ *
+ * @returns unsigned The column the token starts at in the line, counted
+ *   from 1, or 0 if it is not found.
+ */
+unsigned diag_column(const char* line, const char* token)
+{
+  const char* found = line != NULL && token != NULL && token[0] != '\0' ? strstr(line, token) : NULL;
+  return found != NULL ? (unsigned)(found - line) + 1 : 0;
+}
+
+/** @brief code name
+ *
+ * @returns const char* The name of an error code, used to report it.
+ */
+const char* diag_code_name(diag_code code)
+{
+  return code < DIAG_NUM_CODES ? code_names[code] : code_names[DIAG_FATAL];
+}
+
+/** @brief is a warning
+ *
+ * @returns bool true if a code is a warning, which does not fail the
+ *   assembly, false if it is an error.
+ */
+bool diag_is_warning(diag_code code)
+{
+  return code >= DIAG_RELAXED && code < DIAG_NUM_CODES;
+}
+
+/** @brief destruct diagnostic
+ *
+ * Free the file name and message of a diagnostic, the diagnostic itself
+ * is usually part of an array or a trap so it is not freed.
+ *
+ * @param diag The diagnostic to free the contents of.
+ */
+void diag_destruct(diagnostic* diag)
+{
+  free(diag->file);
+  free(diag->message);
+  diag->file = NULL;
+  diag->message = NULL;
+}
+
+/** @brief construct diagnostic sink
+ *
+ * Initialize an empty sink, usually a local of the assembly that sets it.
+ *
+ * @param sink The sink to initialize.
+ * @param json_file The file the errors are also written to as JSON when
+ *   they are reported, or NULL.  It is not copied so must stay valid until
+ *   the sink is destructed.
+ */
+void diag_sink_construct(diag_sink* sink, const char* json_file)
+{
+  sink->diags = NULL;
+  sink->num_diags = 0;
+  sink->capacity = 0;
+  sink->num_errors = 0;
+  sink->json_file = json_file;
+  pthread_mutex_init(&sink->lock, NULL);
+}
+
+/** @brief destruct diagnostic sink
+ *
+ * Free the diagnostics recorded in a sink, a caller that keeps them takes
+ * them out and sets the number of diagnostics to 0 first.
+ *
+ * @param sink The sink to free the contents of.
+ */
+void diag_sink_destruct(diag_sink* sink)
+{
+  for (unsigned index = 0; index < sink->num_diags; index++)
+  {
+    diag_destruct(&sink->diags[index]);
+  }
+  free(sink->diags);
+  sink->diags = NULL;
+  sink->num_diags = 0;
+  sink->capacity = 0;
+  sink->num_errors = 0;
+  pthread_mutex_destroy(&sink->lock);
+}
+
+/** @brief clear diagnostic sink
+ *
+ * Free the diagnostics recorded in a sink, but keep its capacity, so a
+ * sink that is reused for another assembly does not grow again.
+ *
+ * @param sink The sink to clear.
+ */
+void diag_sink_clear(diag_sink* sink)
+{
+  for (unsigned index = 0; index < sink->num_diags; index++)
+  {
+    diag_destruct(&sink->diags[index]);
+  }
+  sink->num_diags = 0;
+  sink->num_errors = 0;
+}
+
+/** @brief add diagnostic to sink
+ *
+ * Append a diagnostic to a sink, the sink takes over the file and message
+ * of the diagnostic.  An assembly that catches its fatal error in a trap
+ * adds the error of the trap this way, to report it with the others.
+ *
+ * @param sink The sink to add the diagnostic to.
+ * @param diag The diagnostic to add.
+ */
+void diag_sink_add(diag_sink* sink, diagnostic diag)
+{
+  pthread_mutex_lock(&sink->lock);
+  if (sink->num_diags == sink->capacity)
+  {
+    unsigned capacity = sink->capacity ? 2 * sink->capacity : 16;
+    diagnostic* diags = (diagnostic*)realloc(sink->diags, capacity * sizeof(diagnostic));
+    if (diags == NULL)
+    {
+      pthread_mutex_unlock(&sink->lock);
+      diag_destruct(&diag);
+      return;
+    }
+    sink->diags = diags;
+    sink->capacity = capacity;
+  }
+  sink->diags[sink->num_diags++] = diag;
+  if (!diag_is_warning(diag.code))
+  {
+    sink->num_errors++;
+  }
+  pthread_mutex_unlock(&sink->lock);
+}
+
+/** @brief set diagnostic sink
+ *
+ * Record the recoverable errors of this thread in sink, or stop at the
+ * first one again if sink is NULL.
+ *
+ * @param sink The sink to record errors in, or NULL.
+ *
+ * @returns diag_sink* The sink that was set before, to set it again when
+ *   done.
+ */
+diag_sink* diag_set_sink(diag_sink* sink)
+{
+  diag_sink* previous = current_sink;
+  current_sink = sink;
+  return previous;
+}
+
+/** @brief get diagnostic sink
+ *
+ * @returns diag_sink* The sink of this thread, or NULL, handed to the
+ *   threads that work on the same assembly.
+ */
+diag_sink* diag_get_sink(void)
+{
+  return current_sink;
+}
+
+/** @brief compare diagnostics
+ *
+ * Order diagnostics by file, line and column, the threads of pass two
+ * record them in any order.
+ */
+static int compare_diagnostics(const void* a, const void* b)
+{
+  const diagnostic* diag1 = (const diagnostic*)a;
+  const diagnostic* diag2 = (const diagnostic*)b;
+  int order = strcmp(diag1->file ? diag1->file : "", diag2->file ? diag2->file : "");
+  if (order == 0)
+  {
+    order = (diag1->line > diag2->line) - (diag1->line < diag2->line);
+  }
+  if (order == 0)
+  {
+    order = (diag1->column > diag2->column) - (diag1->column < diag2->column);
+  }
+  return order;
+}
+
+/** @brief sort diagnostics
+ *
+ * Put the errors recorded in a sink in the order of their files, lines and
+ * columns.
+ *
+ * @param sink The sink with the errors.
+ */
+void diag_sink_sort(diag_sink* sink)
+{
+  pthread_mutex_lock(&sink->lock);
+  if (sink->num_diags > 1)
+  {
+    qsort(sink->diags, sink->num_diags, sizeof(diagnostic), compare_diagnostics);
+  }
+  pthread_mutex_unlock(&sink->lock);
+}
+
+/** @brief write JSON string
+ *
+ * Write a string as a quoted JSON string, or null.
+ */
+static void write_json_string(FILE* out, const char* string)
+{
+  if (string == NULL)
+  {
+    fprintf(out, "null");
+    return;
+  }
+  fputc('"', out);
+  for (const unsigned char* c = (const unsigned char*)string; *c != '\0'; c++)
+  {
+    if (*c == '"' || *c == '\\')
+    {
+      fprintf(out, "\\%c", *c);
+    }
+    else if (*c < 0x20)
+    {
+      fprintf(out, "\\u%04x", *c);
+    }
+    else
+    {
+      fputc(*c, out);
+    }
+  }
+  fputc('"', out);
+}
+
+/** @brief write diagnostics as JSON
+ *
+ * Write the errors recorded in a sink as a JSON array, one object with the
+ * file, line, column, code, severity and message of each error or warning.
+ * An array without an "error" severity means the assembly had no errors.
+ *
+ * @param sink The sink with the errors.
+ * @param out The stream to write to.
+ */
+void diag_write_json(diag_sink* sink, FILE* out)
+{
+  fprintf(out, "[");
+  for (unsigned index = 0; index < sink->num_diags; index++)
+  {
+    diagnostic* diag = &sink->diags[index];
+    fprintf(out, "%s\n  {\"file\": ", index > 0 ? "," : "");
+    write_json_string(out, diag->file);
+    fprintf(out, ", \"line\": %u, \"column\": %u, \"code\": \"%s\", \"severity\": \"%s\", \"message\": ",
+      diag->line, diag->column, diag_code_name(diag->code), diag_is_warning(diag->code) ? "warning" : "error");
+    write_json_string(out, diag->message);
+    fprintf(out, "}");
+  }
+  fprintf(out, "%s]\n", sink->num_diags > 0 ? "\n" : "");
+}
+
+/** @brief print diagnostic
+ *
+ * Print a diagnostic on one line, with its location, severity and code.
+ *
+ * @param out The stream to print to.
+ * @param diag The diagnostic to print.
+ */
+void diag_print(FILE* out, const diagnostic* diag)
+{
+  if (diag->file != NULL && diag->column > 0)
+  {
+    fprintf(out, "%s:%u:%u: ", diag->file, diag->line, diag->column);
+  }
+  else if (diag->file != NULL)
+  {
+    fprintf(out, "%s:%u: ", diag->file, diag->line);
+  }
+  fprintf(out, "%s: [%s] %s\n", diag_is_warning(diag->code) ? "warning" : "error", diag_code_name(diag->code),
+    diag->message ? diag->message : "");
+}
+
+/** @brief report diagnostics
+ *
+ * Report the errors recorded in a sink, in the order of their lines.  Each
+ * error or warning is printed on standard error with its location and
+ * code, followed by the number of errors if there are any, and all of them
+ * are written to the JSON file of the sink, if it has one.  A sink with
+ * nothing recorded writes an empty JSON array, so the file never shows the
+ * errors of an earlier assembly.
+ *
+ * @param sink The sink with the errors.
+ */
+void diag_sink_report(diag_sink* sink)
+{
+  diag_sink_sort(sink);
+  pthread_mutex_lock(&sink->lock);
+  for (unsigned index = 0; index < sink->num_diags; index++)
+  {
+    diag_print(stderr, &sink->diags[index]);
+  }
+  if (sink->num_errors > 0)
+  {
+    fprintf(stderr, "Assembly failed with <%u> errors\n", sink->num_errors);
+  }
+
+  if (sink->json_file != NULL)
+  {
+    FILE* out = fopen(sink->json_file, "w");
+    if (out != NULL)
+    {
+      diag_write_json(sink, out);
+      fclose(out);
+    }
+    else
+    {
+      fprintf(stderr, "<diagnostic::diag_sink_report> error could not open file <%s>\n", sink->json_file);
+    }
+  }
+  pthread_mutex_unlock(&sink->lock);
+}
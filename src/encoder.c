@@ -0,0 +1,325 @@
+/** @file encoder.c
+ * @brief batched machine instruction encoder
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Once the SYMBOL operands of the operation list have been resolved
+ * in pass two, encoding a machine instruction is just masking, shifting
+ * and or'ing together small integer operand values.  Every operation is
+ * classified into one of a few encoding formats when it is parsed, and
+ * all operations of a format are encoded with the same masks and shifts.
+ * The encoder then encodes runs of entries straight from the hot field
+ * arrays of the operation list, 16 entries at a time using AVX2 vector
+ * instructions on 16 bit lanes when the cpu supports them, or with a
+ * scalar loop when it does not.  Compile with -DNO_SIMD to only build the
+ * scalar loop.
+ *
+ * The vector loop does not sort the entries into a group per format, the
+ * gathering and scattering that needs costs more than the encoding itself.
+ * Instead each lane looks up the masks and shifts of its own format in a
+ * 16 entry table with a byte shuffle, and shifts by multiplying, so any
+ * mix of formats is encoded in place.
+ */
+#include "encoder.h"
+#include "assembler.h"
+
+// the AVX2 loop is only built for x86 with gcc/clang, which can compile a
+// single function for AVX2 and check for AVX2 support when we run
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ENC_AVX2
+#include <immintrin.h>
+#endif
+
+/// The masks and shifts applied to the operand values of an encoding
+/// format.  An unused operand has a mask of 0, and the third operand is
+/// never shifted.
+typedef struct enc_shape
+{
+  uint16_t mask[3];
+  uint8_t shift[2];
+} enc_shape;
+
+/// The shape of each encoding format, the register operands are not masked,
+/// same as in the asm_xxx() functions
+static const enc_shape shapes[ENC_NUM_FORMATS] = {
+  [ENC_UNCLASSIFIED] = {{0x0000, 0x0000, 0x0000}, {0, 0}},
+  [ENC_NONE] = {{0x0000, 0x0000, 0x0000}, {0, 0}},
+  [ENC_R_R_IMM5] = {{0xFFFF, 0xFFFF, 0x001F}, {9, 6}},
+  [ENC_R_R_OFF6] = {{0xFFFF, 0xFFFF, 0x003F}, {9, 6}},
+  [ENC_R_R] = {{0xFFFF, 0xFFFF, 0x0000}, {9, 6}},
+  [ENC_R_OFF9] = {{0xFFFF, 0x01FF, 0x0000}, {9, 0}},
+  [ENC_OFF9] = {{0x01FF, 0x0000, 0x0000}, {0, 0}},
+  [ENC_OFF11] = {{0x07FF, 0x0000, 0x0000}, {0, 0}},
+  [ENC_BASER] = {{0xFFFF, 0x0000, 0x0000}, {6, 0}},
+  [ENC_TRAP8] = {{0x00FF, 0x0000, 0x0000}, {0, 0}},
+  [ENC_WORD] = {{0xFFFF, 0x0000, 0x0000}, {0, 0}},
+};
+
+/** @brief classify entry
+ *
+ * Determine the encoding format and the base word of an operation list
+ * entry, once all of its operands have been appended.  An entry that does
+ * not have the operands its opcode expects is left unclassified, and is
+ * encoded by `asm_inst()`, which reports it as malformed.
+ *
+ * @param opl The operation list holding the entry.
+ * @param idx The index of the entry to classify.
+ */
+void enc_classify(operation_list* opl, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+  uint8_t opc = hot->opc[idx];
+  uint8_t num_opr = hot->num_opr[idx];
+  uint8_t variant = hot->variant[idx];
+  uint16_t base = 0x0000;
+  enc_format format = ENC_UNCLASSIFIED;
+
+  switch (opc)
+  {
+  case ADD:
+  case AND:
+    // bit[5] = 1 indicates the imm5 variant
+    base = (opc << 12) | (hot->oprtype[2][idx] == REGISTER ? 0x0 : 0x1 << 5);
+    format = num_opr == 3 ? ENC_R_R_IMM5 : ENC_UNCLASSIFIED;
+    break;
+  case LDR:
+  case STR:
+    base = opc << 12;
+    format = num_opr == 3 ? ENC_R_R_OFF6 : ENC_UNCLASSIFIED;
+    break;
+  case NOT:
+    // the low 6 bits of NOT are filled with 1
+    base = (NOT << 12) | 0x003F;
+    format = num_opr == 2 ? ENC_R_R : ENC_UNCLASSIFIED;
+    break;
+  case LD:
+  case LDI:
+  case LEA:
+  case ST:
+  case STI:
+    base = opc << 12;
+    format = num_opr == 2 ? ENC_R_OFF9 : ENC_UNCLASSIFIED;
+    break;
+  case BR:
+    base = (BR << 12) | (hot->flags[idx] << 9);
+    format = num_opr == 1 ? ENC_OFF9 : ENC_UNCLASSIFIED;
+    break;
+  case JSR:
+    // JSRR uses a base register, JSR a PCoffset11 with bit[11] set
+    if (variant == 0)
+    {
+      base = JSR << 12;
+      format = num_opr == 1 ? ENC_BASER : ENC_UNCLASSIFIED;
+    }
+    else if (variant == 1)
+    {
+      base = (JSR << 12) | (0x1 << 11);
+      format = num_opr == 1 ? ENC_OFF11 : ENC_UNCLASSIFIED;
+    }
+    break;
+  case JMP:
+    // RET is a JMP with an implicit base register R7
+    if (variant == 0)
+    {
+      base = JMP << 12;
+      format = num_opr == 1 ? ENC_BASER : ENC_UNCLASSIFIED;
+    }
+    else if (variant == 1)
+    {
+      base = (JMP << 12) | (7 << 6);
+      format = num_opr == 0 ? ENC_NONE : ENC_UNCLASSIFIED;
+    }
+    break;
+  case RTI:
+    base = RTI << 12;
+    format = num_opr == 0 ? ENC_NONE : ENC_UNCLASSIFIED;
+    break;
+  case TRAP:
+    base = TRAP << 12;
+    format = num_opr == 1 ? ENC_TRAP8 : ENC_UNCLASSIFIED;
+    break;
+  case ORIG:
+  case END:
+  case BLKW:
+    // nothing to encode, the words of a .BLKW are written as 0
+    format = ENC_NONE;
+    break;
+  case FILL:
+  case STRINGZ:
+    format = num_opr == 1 ? ENC_WORD : ENC_UNCLASSIFIED;
+    break;
+  case INCBIN:
+    // the first word of the file, kept in the value of the file name
+    format = ENC_WORD;
+    break;
+  default:
+    break;
+  }
+
+  hot->format[idx] = format;
+  hot->base[idx] = base;
+}
+
+/** @brief scalar encoding loop
+ *
+ * Encode the entries from begin up to but not including end one at a time,
+ * classifying any entry that was not classified yet.
+ *
+ * @param opl The operation list holding the entries.
+ * @param begin The index of the first entry to encode.
+ * @param end The index one past the last entry to encode.
+ */
+static void enc_batch_scalar(operation_list* opl, unsigned begin, unsigned end)
+{
+  opl_hot* hot = &opl->hot;
+  for (unsigned idx = begin; idx < end; idx++)
+  {
+    if (hot->format[idx] == ENC_UNCLASSIFIED)
+    {
+      enc_classify(opl, idx);
+      if (hot->format[idx] == ENC_UNCLASSIFIED)
+      {
+        asm_inst(opl, idx);
+        continue;
+      }
+    }
+
+    const enc_shape* shape = &shapes[hot->format[idx]];
+    hot->inst[idx] = hot->base[idx] | ((hot->value[0][idx] & shape->mask[0]) << shape->shift[0]) |
+                     ((hot->value[1][idx] & shape->mask[1]) << shape->shift[1]) | (hot->value[2][idx] & shape->mask[2]);
+  }
+}
+
+#ifdef ENC_AVX2
+/// Byte tables of the format shapes for the vector loop, the low and high
+/// byte of each mask and of each shift as a multiplier, indexed by format
+typedef struct enc_tables
+{
+  __m128i mask_lo[3];
+  __m128i mask_hi[3];
+  __m128i mul_lo[2];
+  __m128i mul_hi[2];
+} enc_tables;
+
+/** @brief lookup 16 bit words by format
+ *
+ * Look up the 16 bit word of the format of each of 16 lanes, from tables
+ * holding the low and high bytes of the words.
+ */
+__attribute__((target("avx2"))) static inline __m256i enc_lookup(__m128i lo, __m128i hi, __m128i format)
+{
+  __m128i lo_bytes = _mm_shuffle_epi8(lo, format);
+  __m128i hi_bytes = _mm_shuffle_epi8(hi, format);
+  return _mm256_set_m128i(_mm_unpackhi_epi8(lo_bytes, hi_bytes), _mm_unpacklo_epi8(lo_bytes, hi_bytes));
+}
+
+/** @brief AVX2 encoding loop
+ *
+ * Encode the entries from begin up to but not including end 16 at a time,
+ * one 16 bit lane for each entry.  Each lane looks up the masks and shift
+ * multipliers of its format, so the formats can be mixed in any order.
+ * Blocks of 16 with an unclassified entry, and the last end - begin % 16
+ * entries, are encoded by the scalar loop.
+ */
+__attribute__((target("avx2"))) static void enc_batch_avx2(operation_list* opl, unsigned begin, unsigned end)
+{
+  opl_hot* hot = &opl->hot;
+
+  uint8_t bytes[10][16] = {{0}};
+  for (int format = 0; format < ENC_NUM_FORMATS; format++)
+  {
+    for (int opr = 0; opr < 3; opr++)
+    {
+      bytes[opr][format] = shapes[format].mask[opr] & 0xFF;
+      bytes[3 + opr][format] = shapes[format].mask[opr] >> 8;
+    }
+    for (int opr = 0; opr < 2; opr++)
+    {
+      uint16_t mul = 1 << shapes[format].shift[opr];
+      bytes[6 + opr][format] = mul & 0xFF;
+      bytes[8 + opr][format] = mul >> 8;
+    }
+  }
+  enc_tables tables;
+  for (int opr = 0; opr < 3; opr++)
+  {
+    tables.mask_lo[opr] = _mm_loadu_si128((const __m128i*)bytes[opr]);
+    tables.mask_hi[opr] = _mm_loadu_si128((const __m128i*)bytes[3 + opr]);
+  }
+  for (int opr = 0; opr < 2; opr++)
+  {
+    tables.mul_lo[opr] = _mm_loadu_si128((const __m128i*)bytes[6 + opr]);
+    tables.mul_hi[opr] = _mm_loadu_si128((const __m128i*)bytes[8 + opr]);
+  }
+
+  __m128i unclassified = _mm_setzero_si128();
+  unsigned idx = begin;
+  for (; idx + 16 <= end; idx += 16)
+  {
+    __m128i format = _mm_loadu_si128((const __m128i*)&hot->format[idx]);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(format, unclassified)) != 0)
+    {
+      enc_batch_scalar(opl, idx, idx + 16);
+      continue;
+    }
+
+    __m256i v0 = _mm256_loadu_si256((const __m256i*)&hot->value[0][idx]);
+    __m256i v1 = _mm256_loadu_si256((const __m256i*)&hot->value[1][idx]);
+    __m256i v2 = _mm256_loadu_si256((const __m256i*)&hot->value[2][idx]);
+    v0 = _mm256_and_si256(v0, enc_lookup(tables.mask_lo[0], tables.mask_hi[0], format));
+    v1 = _mm256_and_si256(v1, enc_lookup(tables.mask_lo[1], tables.mask_hi[1], format));
+    v2 = _mm256_and_si256(v2, enc_lookup(tables.mask_lo[2], tables.mask_hi[2], format));
+    v0 = _mm256_mullo_epi16(v0, enc_lookup(tables.mul_lo[0], tables.mul_hi[0], format));
+    v1 = _mm256_mullo_epi16(v1, enc_lookup(tables.mul_lo[1], tables.mul_hi[1], format));
+
+    __m256i word = _mm256_loadu_si256((const __m256i*)&hot->base[idx]);
+    word = _mm256_or_si256(word, _mm256_or_si256(v0, _mm256_or_si256(v1, v2)));
+    _mm256_storeu_si256((__m256i*)&hot->inst[idx], word);
+  }
+
+  enc_batch_scalar(opl, idx, end);
+}
+#endif
+
+/** @brief simd available
+ *
+ * @returns bool true if the AVX2 loop was built and the cpu we are
+ *   running on supports it.
+ */
+bool enc_simd_available()
+{
+#ifdef ENC_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+/** @brief batch encode entries
+ *
+ * Encode the machine instructions of the operation list entries from index
+ * begin up to but not including end, giving the same instructions as calling
+ * `asm_inst()` on each of them.  The SYMBOL operands of the entries must
+ * already be resolved.  Entries that were not classified when they were
+ * parsed are classified first.
+ *
+ * @param opl The operation list whose entries are to be encoded.
+ * @param begin The index of the first entry to encode.
+ * @param end The index one past the last entry to encode.
+ * @param simd If true use the AVX2 loop when the cpu supports it,
+ *   otherwise always use the scalar loop.
+ */
+void enc_batch(operation_list* opl, unsigned begin, unsigned end, bool simd)
+{
+#ifdef ENC_AVX2
+  if (simd && end - begin >= 16 && enc_simd_available())
+  {
+    enc_batch_avx2(opl, begin, end);
+    return;
+  }
+#endif
+  enc_batch_scalar(opl, begin, end);
+}
@@ -0,0 +1,1210 @@
+/** @file flow-graph.c
+ * @brief LC-3 Assembler control flow analysis
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Control flow analysis, see flow-graph.h.  The loops are found with one
+ * depth first walk of the blocks, and nested by the number of blocks in
+ * them.  The worst case of a loop or routine is the longest path through
+ * its blocks with each loop in it collapsed into one node, whose cost is
+ * the worst case of the loop, so the paths are found in a graph with no
+ * cycles, innermost loops first.
+ */
+#include "flow-graph.h"
+#include "assembler.h"
+#include "peephole.h"
+#include "relax.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// the states of a loop, a routine, or a node of a path, while its worst
+/// case is found
+#define FG_UNSEEN 0
+#define FG_VISITING 1
+#define FG_DONE 2
+
+/// The longest paths from the nodes of a loop or routine, its scope.  A
+/// node is a block, or a loop nested in the scope, numbered after the
+/// blocks.
+typedef struct fg_eval
+{
+  flow_graph* fg;
+  unsigned scope;
+
+  uint8_t* state;
+
+  // the worst path from each node back to the header of the scope loop,
+  // and out of the scope, if the node has one
+  fg_cost* it;
+  fg_cost* ex;
+  uint8_t* has_it;
+  uint8_t* has_ex;
+
+  // true if the nodes of the scope have a cycle that is not a loop
+  bool cyclic;
+} fg_eval;
+
+/** @brief is instruction
+ *
+ * Check if an entry is an LC-3 instruction that is still in the program.
+ */
+static bool is_instruction(opl_hot* hot, unsigned idx)
+{
+  return hot->opc[idx] < ORIG && hot->size[idx] > 0;
+}
+
+/** @brief ends block
+ *
+ * Check if an instruction is the last one of its block.
+ */
+static bool ends_block(opl_hot* hot, unsigned idx)
+{
+  switch (hot->opc[idx])
+  {
+  case BR:
+  case JMP:
+  case RTI:
+  case JSR:
+  case TRAP:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/** @brief branch target
+ *
+ * Find the address a BR or JSR goes to, from its label or its numeric
+ * offset.
+ *
+ * @returns bool true if the entry has a target, false for other entries,
+ *   JSRR and labels that are not defined.
+ */
+static bool branch_target(flow_graph* fg, unsigned idx, uint16_t* target)
+{
+  opl_hot* hot = &fg->opl->hot;
+  if ((hot->opc[idx] != BR && hot->opc[idx] != JSR) || relax_offset_bits(hot, idx, 0) == 0)
+  {
+    return false;
+  }
+  if (hot->oprtype[0][idx] == SYMBOL)
+  {
+    st_entry* entry = st_lookup(fg->st, fg->opl->entries[idx].opr[0]->svalue);
+    if (entry == NULL)
+    {
+      return false;
+    }
+    *target = entry->address;
+    return true;
+  }
+  *target = hot->address[idx] + 1 + (int16_t)hot->value[0][idx];
+  return hot->oprtype[0][idx] == NUMERIC;
+}
+
+/** @brief entry cost
+ *
+ * The instructions and cycles of an entry.  A relaxed operation is the
+ * instructions of its sequence, and the address after them.
+ */
+static fg_cost entry_cost(operation_list* opl, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+  fg_cost cost = {1, opc_cycles(hot->opc[idx]), false};
+  if (relax_is_relaxed(hot, idx))
+  {
+    uint16_t words[RELAX_MAX_WORDS];
+    unsigned num_words = relax_words(opl, idx, words);
+    cost.instructions = num_words - 1;
+    cost.cycles = 0;
+    for (unsigned word = 0; word < num_words - 1; word++)
+    {
+      cost.cycles += opc_cycles((opctype)(words[word] >> 12));
+    }
+  }
+  return cost;
+}
+
+/** @brief add cost
+ *
+ * @returns fg_cost The cost of one part of a path and then another.
+ */
+static fg_cost cost_add(fg_cost a, fg_cost b)
+{
+  a.instructions += b.instructions;
+  a.cycles += b.cycles;
+  a.unbounded = a.unbounded || b.unbounded;
+  return a;
+}
+
+/** @brief is worse
+ *
+ * Check if a path takes more cycles than another one.
+ */
+static bool cost_worse(fg_cost a, fg_cost b)
+{
+  return a.unbounded != b.unbounded ? a.unbounded : a.cycles > b.cycles;
+}
+
+/** @brief unbounded cost
+ *
+ * @returns fg_cost The cost of a path with no worst case.
+ */
+static fg_cost cost_unbounded()
+{
+  fg_cost cost = {0, 0, true};
+  return cost;
+}
+
+/** @brief add block
+ *
+ * Start a new block at an instruction.
+ */
+static void add_block(flow_graph* fg, unsigned idx, unsigned* capacity)
+{
+  if (fg->num_blocks == *capacity)
+  {
+    *capacity = *capacity ? 2 * *capacity : 64;
+    fg->blocks = (fg_block*)realloc(fg->blocks, *capacity * sizeof(fg_block));
+  }
+  fg_block* block = &fg->blocks[fg->num_blocks++];
+  memset(block, 0, sizeof(fg_block));
+  block->first = idx;
+  block->last = idx;
+  block->callee = FG_NONE;
+  block->loop = FG_NONE;
+}
+
+/** @brief add successor
+ *
+ * Join a block to a block it can go on to.
+ */
+static void add_succ(fg_block* block, unsigned succ, unsigned cycles)
+{
+  if (succ != FG_NONE)
+  {
+    block->succ[block->num_succ] = succ;
+    block->succ_cycles[block->num_succ] = cycles;
+    block->num_succ++;
+  }
+}
+
+/** @brief find blocks
+ *
+ * Split the instructions into blocks and join the blocks.  A JSR keeps the
+ * block it calls in `callee` until the routines are known.
+ */
+static void find_blocks(flow_graph* fg, const unsigned* entry_at)
+{
+  operation_list* opl = fg->opl;
+  opl_hot* hot = &opl->hot;
+
+  // the branch targets start blocks, even without a label of their own
+  // when they are reached by a numeric offset
+  uint8_t* leader = (uint8_t*)calloc(opl->num_entries + 1, sizeof(uint8_t));
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    uint16_t target;
+    if (is_instruction(hot, idx) && branch_target(fg, idx, &target) && entry_at[target] != FG_NONE)
+    {
+      leader[entry_at[target]] = 1;
+    }
+  }
+
+  unsigned capacity = 0;
+  unsigned current = FG_NONE;
+  bool labelled = false;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    // the label of a removed entry is on the entry after it
+    labelled = labelled || opl->entries[idx].label != NULL;
+    if (peep_is_removed(hot, idx))
+    {
+      continue;
+    }
+    if (!is_instruction(hot, idx))
+    {
+      current = FG_NONE;
+      labelled = false;
+      continue;
+    }
+    if (current == FG_NONE || labelled || leader[idx] || ends_block(hot, fg->blocks[current].last))
+    {
+      add_block(fg, idx, &capacity);
+      current = fg->num_blocks - 1;
+    }
+    fg_block* block = &fg->blocks[current];
+    block->last = idx;
+    block->cost = cost_add(block->cost, entry_cost(opl, idx));
+    fg->block_of[idx] = current;
+    labelled = false;
+  }
+  free(leader);
+
+  for (unsigned b = 0; b < fg->num_blocks; b++)
+  {
+    fg_block* block = &fg->blocks[b];
+    unsigned last = block->last;
+
+    // the block the last instruction falls into, if the next entry is an
+    // instruction
+    unsigned next = last + 1;
+    for (; next < opl->num_entries && peep_is_removed(hot, next); next++)
+    {
+    }
+    unsigned fall = next < opl->num_entries ? fg->block_of[next] : FG_NONE;
+
+    uint16_t address;
+    unsigned target = branch_target(fg, last, &address) && entry_at[address] != FG_NONE
+                        ? fg->block_of[entry_at[address]]
+                        : FG_NONE;
+    switch (hot->opc[last])
+    {
+    case BR:
+      add_succ(block, target, 1);
+      if (hot->flags[last] != 0x7)
+      {
+        add_succ(block, fall, 0);
+      }
+      break;
+    case JMP:
+    case RTI:
+      break;
+    case TRAP:
+      if ((hot->value[0][last] & 0xFF) != 0x25)
+      {
+        add_succ(block, fall, 0);
+      }
+      break;
+    case JSR:
+      block->callee = target;
+      add_succ(block, fall, 0);
+      break;
+    default:
+      add_succ(block, fall, 0);
+      break;
+    }
+  }
+}
+
+/** @brief find predecessors
+ *
+ * Make the lists of the blocks that go on to each block.
+ */
+static void find_preds(flow_graph* fg)
+{
+  fg->pred_begin = (unsigned*)calloc(fg->num_blocks + 2, sizeof(unsigned));
+  unsigned num_edges = 0;
+  for (unsigned b = 0; b < fg->num_blocks; b++)
+  {
+    for (unsigned k = 0; k < fg->blocks[b].num_succ; k++)
+    {
+      fg->pred_begin[fg->blocks[b].succ[k] + 2]++;
+      num_edges++;
+    }
+  }
+  for (unsigned b = 0; b < fg->num_blocks; b++)
+  {
+    fg->pred_begin[b + 2] += fg->pred_begin[b + 1];
+  }
+  fg->preds = (unsigned*)malloc((num_edges + 1) * sizeof(unsigned));
+  for (unsigned b = 0; b < fg->num_blocks; b++)
+  {
+    for (unsigned k = 0; k < fg->blocks[b].num_succ; k++)
+    {
+      fg->preds[fg->pred_begin[fg->blocks[b].succ[k] + 1]++] = b;
+    }
+  }
+}
+
+/** @brief add routine
+ *
+ * Start a routine at a block, unless one already starts there.
+ */
+static void add_routine(flow_graph* fg, unsigned block, unsigned* routine_of)
+{
+  if (block == FG_NONE || routine_of[block] != FG_NONE)
+  {
+    return;
+  }
+  routine_of[block] = fg->num_routines;
+  fg->routines = (fg_routine*)realloc(fg->routines, (fg->num_routines + 1) * sizeof(fg_routine));
+  fg_routine* routine = &fg->routines[fg->num_routines++];
+  memset(routine, 0, sizeof(fg_routine));
+  routine->entry = block;
+}
+
+/** @brief find routines
+ *
+ * Start a routine at the first instruction of each section, and at each
+ * block a JSR calls, and turn the blocks the JSRs call into routines.  A
+ * label named by a .FILL does not start a routine, pass two assembles the
+ * .FILL to the offset of the label from it, not its address, so it is not
+ * a pointer to code, like a TRAP vector, that the program could jump to.
+ */
+static void find_routines(flow_graph* fg)
+{
+  operation_list* opl = fg->opl;
+  opl_hot* hot = &opl->hot;
+  unsigned* routine_of = (unsigned*)malloc((fg->num_blocks + 1) * sizeof(unsigned));
+  memset(routine_of, 0xff, (fg->num_blocks + 1) * sizeof(unsigned));
+
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    if (idx == 0 || hot->opc[idx] == ORIG)
+    {
+      unsigned first = hot->opc[idx] == ORIG ? idx + 1 : idx;
+      for (; first < opl->num_entries && peep_is_removed(hot, first); first++)
+      {
+      }
+      if (first < opl->num_entries)
+      {
+        add_routine(fg, fg->block_of[first], routine_of);
+      }
+    }
+  }
+  for (unsigned b = 0; b < fg->num_blocks; b++)
+  {
+    add_routine(fg, fg->blocks[b].callee, routine_of);
+  }
+  for (unsigned b = 0; b < fg->num_blocks; b++)
+  {
+    if (fg->blocks[b].callee != FG_NONE)
+    {
+      fg->blocks[b].callee = routine_of[fg->blocks[b].callee];
+    }
+  }
+  free(routine_of);
+}
+
+/** @brief add latch
+ *
+ * Add a block that branches back to a header to the loop of the header,
+ * starting the loop if it is the first.
+ */
+static void add_latch(flow_graph* fg, unsigned header, unsigned latch, unsigned* loop_of_header)
+{
+  unsigned l = loop_of_header[header];
+  if (l == FG_NONE)
+  {
+    l = loop_of_header[header] = fg->num_loops;
+    fg->loops = (fg_loop*)realloc(fg->loops, (fg->num_loops + 1) * sizeof(fg_loop));
+    fg_loop* loop = &fg->loops[fg->num_loops++];
+    memset(loop, 0, sizeof(fg_loop));
+    loop->header = header;
+    loop->parent = FG_NONE;
+  }
+  fg_loop* loop = &fg->loops[l];
+  if (loop->num_latches > 0 && loop->latches[loop->num_latches - 1] == latch)
+  {
+    return;
+  }
+  loop->latches = (unsigned*)realloc(loop->latches, (loop->num_latches + 1) * sizeof(unsigned));
+  loop->latches[loop->num_latches++] = latch;
+}
+
+/** @brief find loops
+ *
+ * Walk the blocks depth first from the routines, and then from any block
+ * not walked yet, a branch to a block that is still being walked is a
+ * branch back to the header of a loop.  The blocks of a loop are the
+ * blocks that reach one of its latches without going through its header.
+ */
+static void find_loops(flow_graph* fg)
+{
+  unsigned num_blocks = fg->num_blocks;
+  uint8_t* color = (uint8_t*)calloc(num_blocks + 1, sizeof(uint8_t));
+  unsigned* next_succ = (unsigned*)calloc(num_blocks + 1, sizeof(unsigned));
+  unsigned* stack = (unsigned*)malloc((num_blocks + 1) * sizeof(unsigned));
+  unsigned* loop_of_header = (unsigned*)malloc((num_blocks + 1) * sizeof(unsigned));
+  memset(loop_of_header, 0xff, (num_blocks + 1) * sizeof(unsigned));
+
+  for (unsigned root = 0; root < fg->num_routines + num_blocks; root++)
+  {
+    unsigned start = root < fg->num_routines ? fg->routines[root].entry : root - fg->num_routines;
+    if (color[start] != FG_UNSEEN)
+    {
+      continue;
+    }
+    unsigned sp = 0;
+    stack[sp++] = start;
+    color[start] = FG_VISITING;
+    while (sp > 0)
+    {
+      fg_block* block = &fg->blocks[stack[sp - 1]];
+      if (next_succ[stack[sp - 1]] == block->num_succ)
+      {
+        color[stack[--sp]] = FG_DONE;
+        continue;
+      }
+      unsigned succ = block->succ[next_succ[stack[sp - 1]]++];
+      if (color[succ] == FG_UNSEEN)
+      {
+        color[succ] = FG_VISITING;
+        stack[sp++] = succ;
+      }
+      else if (color[succ] == FG_VISITING)
+      {
+        add_latch(fg, succ, stack[sp - 1], loop_of_header);
+      }
+    }
+  }
+
+  // the blocks of each loop, found backwards from its latches, reuse the
+  // stack as the list of blocks
+  unsigned* stamp = loop_of_header;
+  memset(stamp, 0xff, (num_blocks + 1) * sizeof(unsigned));
+  for (unsigned l = 0; l < fg->num_loops; l++)
+  {
+    fg_loop* loop = &fg->loops[l];
+    unsigned count = 0;
+    stamp[loop->header] = l;
+    stack[count++] = loop->header;
+    for (unsigned k = 0; k < loop->num_latches; k++)
+    {
+      if (stamp[loop->latches[k]] != l)
+      {
+        stamp[loop->latches[k]] = l;
+        stack[count++] = loop->latches[k];
+      }
+    }
+    for (unsigned next = 1; next < count; next++)
+    {
+      unsigned b = stack[next];
+      for (unsigned p = fg->pred_begin[b]; p < fg->pred_begin[b + 1]; p++)
+      {
+        if (stamp[fg->preds[p]] != l)
+        {
+          stamp[fg->preds[p]] = l;
+          stack[count++] = fg->preds[p];
+        }
+      }
+    }
+    loop->blocks = (unsigned*)malloc(count * sizeof(unsigned));
+    memcpy(loop->blocks, stack, count * sizeof(unsigned));
+    loop->num_blocks = count;
+  }
+  free(color);
+  free(next_succ);
+  free(stack);
+  free(loop_of_header);
+}
+
+/** @brief compare loop sizes
+ *
+ * Order loops from the fewest blocks to the most, for qsort.
+ */
+static int compare_loops(const void* a, const void* b)
+{
+  unsigned size_a = (*(fg_loop* const*)a)->num_blocks;
+  unsigned size_b = (*(fg_loop* const*)b)->num_blocks;
+  return size_a < size_b ? -1 : size_a > size_b;
+}
+
+/** @brief nest loops
+ *
+ * Give each block its innermost loop, and each loop the loop it is
+ * nested in.  A loop is nested in the smallest loop that has all of its
+ * blocks, so the loops are taken from the smallest on, and each block
+ * goes to the first loop that has it.
+ */
+static void nest_loops(flow_graph* fg)
+{
+  fg_loop** order = (fg_loop**)malloc((fg->num_loops + 1) * sizeof(fg_loop*));
+  for (unsigned l = 0; l < fg->num_loops; l++)
+  {
+    order[l] = &fg->loops[l];
+  }
+  qsort(order, fg->num_loops, sizeof(fg_loop*), compare_loops);
+  for (unsigned pos = 0; pos < fg->num_loops; pos++)
+  {
+    unsigned l = order[pos] - fg->loops;
+    for (unsigned k = 0; k < fg->loops[l].num_blocks; k++)
+    {
+      fg_block* block = &fg->blocks[fg->loops[l].blocks[k]];
+      if (block->loop == FG_NONE)
+      {
+        block->loop = l;
+        continue;
+      }
+      unsigned outer = block->loop;
+      for (; fg->loops[outer].parent != FG_NONE; outer = fg->loops[outer].parent)
+      {
+      }
+      if (outer != l)
+      {
+        fg->loops[outer].parent = l;
+      }
+    }
+  }
+  free(order);
+
+  for (unsigned l = 0; l < fg->num_loops; l++)
+  {
+    fg->loops[l].depth = 1;
+    for (unsigned outer = fg->loops[l].parent; outer != FG_NONE; outer = fg->loops[outer].parent)
+    {
+      fg->loops[l].depth++;
+    }
+  }
+}
+
+/** @brief in loop
+ *
+ * Check if a block is in a loop, or in a loop nested in it.
+ */
+static bool in_loop(flow_graph* fg, unsigned block, unsigned loop)
+{
+  for (unsigned l = fg->blocks[block].loop; l != FG_NONE; l = fg->loops[l].parent)
+  {
+    if (l == loop)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** @brief writes register
+ *
+ * Check if an instruction can write a register.  A JSR can write any of
+ * them, and a relaxed operation writes R7.
+ */
+static bool writes(opl_hot* hot, unsigned idx, uint16_t reg)
+{
+  if (relax_is_relaxed(hot, idx) && reg == 7)
+  {
+    return true;
+  }
+  switch (hot->opc[idx])
+  {
+  case ADD:
+  case AND:
+  case NOT:
+  case LD:
+  case LDI:
+  case LDR:
+  case LEA:
+    return hot->num_opr[idx] > 0 && hot->oprtype[0][idx] == REGISTER && hot->value[0][idx] == reg;
+  case JSR:
+    return true;
+  case TRAP:
+    return reg == 0 || reg == 7;
+  default:
+    return false;
+  }
+}
+
+/** @brief counter value
+ *
+ * Find the value a register has after an instruction, from the
+ * instructions of its block that set it, an LD of a .FILL of a number, or
+ * a clear and the ADDs of numbers to it.
+ *
+ * @returns bool true if the value is known.
+ */
+static bool counter_value(flow_graph* fg, const unsigned* entry_at, unsigned idx, uint16_t reg, int32_t* value)
+{
+  opl_hot* hot = &fg->opl->hot;
+  unsigned first = fg->blocks[fg->block_of[idx]].first;
+  int32_t added = 0;
+  for (;; idx--)
+  {
+    if (!peep_is_removed(hot, idx) && writes(hot, idx, reg))
+    {
+      if (hot->opc[idx] == LD && !relax_is_relaxed(hot, idx) && hot->oprtype[1][idx] == SYMBOL)
+      {
+        st_entry* entry = st_lookup(fg->st, fg->opl->entries[idx].opr[1]->svalue);
+        unsigned data = entry != NULL ? entry_at[entry->address] : FG_NONE;
+        if (data == FG_NONE || hot->opc[data] != FILL || hot->oprtype[0][data] != NUMERIC)
+        {
+          return false;
+        }
+        *value = (int16_t)hot->value[0][data] + added;
+        return true;
+      }
+      if (hot->opc[idx] != ADD && hot->opc[idx] != AND)
+      {
+        return false;
+      }
+      if (hot->num_opr[idx] != 3 || hot->oprtype[2][idx] != NUMERIC || hot->oprtype[1][idx] != REGISTER ||
+          hot->value[1][idx] != reg)
+      {
+        return false;
+      }
+      if (hot->opc[idx] == AND)
+      {
+        // only a clear gives a known value
+        *value = added;
+        return hot->value[2][idx] == 0;
+      }
+      added += (int16_t)hot->value[2][idx];
+    }
+    if (idx == first)
+    {
+      return false;
+    }
+  }
+}
+
+/** @brief infer bound
+ *
+ * Infer the bound of a loop that counts a register down to 0, with one
+ * latch that ends with an ADD of -1 to the register and a BRp or BRzp
+ * back to the header.
+ *
+ * @returns unsigned The most times the header runs, or 0 if it can not be
+ *   inferred.
+ */
+static unsigned infer_bound(flow_graph* fg, const unsigned* entry_at, unsigned l)
+{
+  opl_hot* hot = &fg->opl->hot;
+  fg_loop* loop = &fg->loops[l];
+  if (loop->num_latches != 1)
+  {
+    return 0;
+  }
+  fg_block* latch = &fg->blocks[loop->latches[0]];
+  unsigned branch = latch->last;
+  if (hot->opc[branch] != BR || relax_is_relaxed(hot, branch) ||
+      (hot->flags[branch] != FP && hot->flags[branch] != (FZ | FP)))
+  {
+    return 0;
+  }
+  unsigned dec = branch;
+  do
+  {
+    if (dec == latch->first)
+    {
+      return 0;
+    }
+    dec--;
+  } while (peep_is_removed(hot, dec));
+  if (hot->opc[dec] != ADD || hot->num_opr[dec] != 3 || hot->oprtype[0][dec] != REGISTER ||
+      hot->oprtype[1][dec] != REGISTER || hot->value[0][dec] != hot->value[1][dec] ||
+      hot->oprtype[2][dec] != NUMERIC || (int16_t)hot->value[2][dec] != -1)
+  {
+    return 0;
+  }
+  uint16_t reg = hot->value[0][dec];
+
+  // nothing else in the loop writes the counter
+  for (unsigned k = 0; k < loop->num_blocks; k++)
+  {
+    fg_block* block = &fg->blocks[loop->blocks[k]];
+    for (unsigned idx = block->first; idx <= block->last; idx++)
+    {
+      if (idx != dec && !peep_is_removed(hot, idx) && writes(hot, idx, reg))
+      {
+        return 0;
+      }
+    }
+  }
+
+  // the loop is only entered by the instruction before its header
+  unsigned first = fg->blocks[loop->header].first;
+  unsigned prev = first;
+  do
+  {
+    if (prev == 0)
+    {
+      return 0;
+    }
+    prev--;
+  } while (peep_is_removed(hot, prev));
+  unsigned before = fg->block_of[prev];
+  if (before == FG_NONE || in_loop(fg, before, l))
+  {
+    return 0;
+  }
+  for (unsigned p = fg->pred_begin[loop->header]; p < fg->pred_begin[loop->header + 1]; p++)
+  {
+    if (fg->preds[p] != before && !in_loop(fg, fg->preds[p], l))
+    {
+      return 0;
+    }
+  }
+
+  int32_t value;
+  if (!counter_value(fg, entry_at, prev, reg, &value))
+  {
+    return 0;
+  }
+  int32_t runs = hot->flags[branch] == FP ? value : value + 1;
+  return runs < 1 ? 1 : runs;
+}
+
+/** @brief annotated bound
+ *
+ * Find a bound given by a comment with @bound on the line of an entry.
+ *
+ * @returns unsigned The bound, or 0 if the line has none.
+ */
+static unsigned annotated_bound(operation_list* opl, unsigned idx)
+{
+  char line[256];
+  opl_line(opl, idx, line, sizeof(line));
+  char* comment = strchr(line, ';');
+  char* annotation = comment != NULL ? strstr(comment, FG_BOUND_ANNOTATION) : NULL;
+  if (annotation == NULL)
+  {
+    return 0;
+  }
+  unsigned long bound = strtoul(annotation + strlen(FG_BOUND_ANNOTATION), NULL, 0);
+  return bound <= UINT32_MAX ? bound : 0;
+}
+
+/** @brief bound loops
+ *
+ * Give each loop the bound of its annotation, or the bound that can be
+ * inferred.
+ */
+static void bound_loops(flow_graph* fg, const unsigned* entry_at)
+{
+  for (unsigned l = 0; l < fg->num_loops; l++)
+  {
+    fg_loop* loop = &fg->loops[l];
+    loop->bound = annotated_bound(fg->opl, fg->blocks[loop->header].first);
+    for (unsigned k = 0; loop->bound == 0 && k < loop->num_latches; k++)
+    {
+      loop->bound = annotated_bound(fg->opl, fg->blocks[loop->latches[k]].last);
+    }
+    if (loop->bound > 0)
+    {
+      loop->bound_kind = FG_ANNOTATED;
+      continue;
+    }
+    loop->bound = infer_bound(fg, entry_at, l);
+    loop->bound_kind = loop->bound > 0 ? FG_INFERRED : FG_UNBOUNDED;
+  }
+}
+
+/** @brief routine blocks
+ *
+ * Find the blocks a routine is made of, the blocks its entry reaches.
+ *
+ * @param seen A flag for each block, set for the blocks of the routine,
+ *   which must be clear when called.
+ * @param queue Room for a block number for each block.
+ *
+ * @returns unsigned The number of blocks of the routine, which are the
+ *   first ones in queue.
+ */
+static unsigned routine_blocks(flow_graph* fg, unsigned r, uint8_t* seen, unsigned* queue)
+{
+  unsigned count = 0;
+  queue[count++] = fg->routines[r].entry;
+  seen[fg->routines[r].entry] = 1;
+  for (unsigned next = 0; next < count; next++)
+  {
+    fg_block* block = &fg->blocks[queue[next]];
+    for (unsigned k = 0; k < block->num_succ; k++)
+    {
+      if (!seen[block->succ[k]])
+      {
+        seen[block->succ[k]] = 1;
+        queue[count++] = block->succ[k];
+      }
+    }
+  }
+  return count;
+}
+
+/** @brief count routines
+ *
+ * Count the blocks, instructions and loops of each routine.
+ */
+static void count_routines(flow_graph* fg)
+{
+  uint8_t* seen = (uint8_t*)calloc(fg->num_blocks + 1, sizeof(uint8_t));
+  unsigned* queue = (unsigned*)malloc((fg->num_blocks + 1) * sizeof(unsigned));
+  for (unsigned r = 0; r < fg->num_routines; r++)
+  {
+    fg_routine* routine = &fg->routines[r];
+    routine->num_blocks = routine_blocks(fg, r, seen, queue);
+    for (unsigned k = 0; k < routine->num_blocks; k++)
+    {
+      fg_block* block = &fg->blocks[queue[k]];
+      routine->num_instructions += block->cost.instructions;
+      if (block->loop != FG_NONE && fg->loops[block->loop].header == queue[k])
+      {
+        routine->num_loops++;
+        if (fg->loops[block->loop].depth > routine->max_depth)
+        {
+          routine->max_depth = fg->loops[block->loop].depth;
+        }
+      }
+      seen[queue[k]] = 0;
+    }
+  }
+  free(seen);
+  free(queue);
+}
+
+/** @brief construct flow graph
+ *
+ * Build the control flow graph of an operation list after pass two, and
+ * find its routines and loops.  The worst cases are only found when they
+ * are asked for.
+ *
+ * @param opl The assembled operation list.
+ * @param st The symbol table of the operation list.
+ *
+ * @returns flow_graph* The new graph, freed with `fg_destruct()`.
+ */
+flow_graph* fg_construct(operation_list* opl, symbol_table* st)
+{
+  flow_graph* fg = (flow_graph*)calloc(1, sizeof(flow_graph));
+  fg->opl = opl;
+  fg->st = st;
+  fg->block_of = (unsigned*)malloc((opl->num_entries + 1) * sizeof(unsigned));
+  memset(fg->block_of, 0xff, (opl->num_entries + 1) * sizeof(unsigned));
+
+  // the entry at each address, the first entry with words there
+  unsigned* entry_at = (unsigned*)malloc(NUM_ADDRESSES * sizeof(unsigned));
+  memset(entry_at, 0xff, NUM_ADDRESSES * sizeof(unsigned));
+  for (unsigned idx = opl->num_entries; idx-- > 0;)
+  {
+    if (opl->hot.size[idx] > 0)
+    {
+      entry_at[opl->hot.address[idx]] = idx;
+    }
+  }
+
+  find_blocks(fg, entry_at);
+  find_preds(fg);
+  find_routines(fg);
+  find_loops(fg);
+  nest_loops(fg);
+  bound_loops(fg, entry_at);
+  count_routines(fg);
+  free(entry_at);
+  return fg;
+}
+
+/** @brief destruct flow graph
+ *
+ * Free a flow graph, the operation list and symbol table are not freed.
+ */
+void fg_destruct(flow_graph* fg)
+{
+  for (unsigned l = 0; l < fg->num_loops; l++)
+  {
+    free(fg->loops[l].blocks);
+    free(fg->loops[l].latches);
+  }
+  free(fg->loops);
+  free(fg->routines);
+  free(fg->blocks);
+  free(fg->block_of);
+  free(fg->preds);
+  free(fg->pred_begin);
+  free(fg);
+}
+
+/** @brief node of block
+ *
+ * Find the node a block is part of in a scope, the block itself, or the
+ * outermost loop nested in the scope that has it.
+ *
+ * @returns unsigned The node, or FG_NONE if the block is not in the scope.
+ */
+static unsigned node_of(flow_graph* fg, unsigned block, unsigned scope)
+{
+  unsigned inner = FG_NONE;
+  unsigned l = fg->blocks[block].loop;
+  for (; l != FG_NONE && l != scope; l = fg->loops[l].parent)
+  {
+    inner = l;
+  }
+  if (l != scope)
+  {
+    return FG_NONE;
+  }
+  return inner == FG_NONE ? block : fg->num_blocks + inner;
+}
+
+/** @brief candidate path
+ *
+ * Keep a path if it is the first or the worst one found so far.
+ */
+static void candidate(fg_cost* best, uint8_t* has, fg_cost cost)
+{
+  if (!*has || cost_worse(cost, *best))
+  {
+    *best = cost;
+    *has = 1;
+  }
+}
+
+static void visit(fg_eval* ev, unsigned node);
+
+/** @brief follow edge
+ *
+ * Extend the paths of a node along an edge to a block.  An edge to the
+ * header of the scope loop goes around the loop, and an edge to a block
+ * that is not in the scope leaves it.
+ */
+static void follow(fg_eval* ev, unsigned node, fg_cost weight, unsigned succ, unsigned cycles)
+{
+  flow_graph* fg = ev->fg;
+  weight.cycles += cycles;
+  if (ev->scope != FG_NONE && succ == fg->loops[ev->scope].header)
+  {
+    candidate(&ev->it[node], &ev->has_it[node], weight);
+    return;
+  }
+  unsigned next = node_of(fg, succ, ev->scope);
+  if (next == FG_NONE)
+  {
+    candidate(&ev->ex[node], &ev->has_ex[node], weight);
+    return;
+  }
+  visit(ev, next);
+  if (ev->has_it[next])
+  {
+    candidate(&ev->it[node], &ev->has_it[node], cost_add(weight, ev->it[next]));
+  }
+  if (ev->has_ex[next])
+  {
+    candidate(&ev->ex[node], &ev->has_ex[node], cost_add(weight, ev->ex[next]));
+  }
+}
+
+/** @brief visit node
+ *
+ * Find the worst paths from a node of the scope, after the nodes it goes
+ * on to.  A node that goes nowhere ends the paths through it.
+ */
+static void visit(fg_eval* ev, unsigned node)
+{
+  flow_graph* fg = ev->fg;
+  if (ev->state[node] != FG_UNSEEN)
+  {
+    // a node on the current path again is a cycle that is not a loop
+    ev->cyclic = ev->cyclic || ev->state[node] == FG_VISITING;
+    return;
+  }
+  ev->state[node] = FG_VISITING;
+
+  bool any = false;
+  if (node < fg->num_blocks)
+  {
+    fg_block* block = &fg->blocks[node];
+    fg_cost weight = block->cost;
+    if (block->callee != FG_NONE)
+    {
+      weight = cost_add(weight, fg_routine_cost(fg, block->callee));
+    }
+    for (unsigned k = 0; k < block->num_succ; k++)
+    {
+      any = true;
+      follow(ev, node, weight, block->succ[k], block->succ_cycles[k]);
+    }
+    if (!any)
+    {
+      candidate(&ev->ex[node], &ev->has_ex[node], weight);
+    }
+  }
+  else
+  {
+    unsigned l = node - fg->num_blocks;
+    fg_cost weight = fg_loop_cost(fg, l);
+    fg_loop* loop = &fg->loops[l];
+    for (unsigned b = 0; b < loop->num_blocks; b++)
+    {
+      fg_block* block = &fg->blocks[loop->blocks[b]];
+      for (unsigned k = 0; k < block->num_succ; k++)
+      {
+        if (!in_loop(fg, block->succ[k], l))
+        {
+          any = true;
+          follow(ev, node, weight, block->succ[k], block->succ_cycles[k]);
+        }
+      }
+    }
+    if (!any)
+    {
+      candidate(&ev->ex[node], &ev->has_ex[node], weight);
+    }
+  }
+  ev->state[node] = FG_DONE;
+}
+
+/** @brief evaluate scope
+ *
+ * Find the worst paths from a node of a loop or routine.
+ */
+static void evaluate(flow_graph* fg, unsigned scope, unsigned start, fg_eval* ev)
+{
+  unsigned num_nodes = fg->num_blocks + fg->num_loops;
+  ev->fg = fg;
+  ev->scope = scope;
+  ev->state = (uint8_t*)calloc(num_nodes, sizeof(uint8_t));
+  ev->has_it = (uint8_t*)calloc(num_nodes, sizeof(uint8_t));
+  ev->has_ex = (uint8_t*)calloc(num_nodes, sizeof(uint8_t));
+  ev->it = (fg_cost*)calloc(num_nodes, sizeof(fg_cost));
+  ev->ex = (fg_cost*)calloc(num_nodes, sizeof(fg_cost));
+  ev->cyclic = false;
+  visit(ev, start);
+}
+
+/** @brief free evaluation
+ */
+static void eval_free(fg_eval* ev)
+{
+  free(ev->state);
+  free(ev->has_it);
+  free(ev->has_ex);
+  free(ev->it);
+  free(ev->ex);
+}
+
+/** @brief loop cost
+ *
+ * The worst case of a loop each time it is entered.  The header runs at
+ * most bound times, bound - 1 times around the loop and once more on the
+ * way out, or around the loop once more if it has no way out.
+ *
+ * @param fg The flow graph.
+ * @param loop The index of the loop.
+ *
+ * @returns fg_cost The worst case, unbounded if the loop or a loop nested
+ *   in it has no bound.
+ */
+fg_cost fg_loop_cost(flow_graph* fg, unsigned loop)
+{
+  if (fg->loops[loop].state == FG_DONE)
+  {
+    return fg->loops[loop].cost;
+  }
+  if (fg->loops[loop].state == FG_VISITING)
+  {
+    return cost_unbounded();
+  }
+  fg->loops[loop].state = FG_VISITING;
+
+  fg_eval ev;
+  unsigned header = fg->loops[loop].header;
+  evaluate(fg, loop, header, &ev);
+  fg_cost cost = cost_unbounded();
+  if (fg->loops[loop].bound_kind != FG_UNBOUNDED && !ev.cyclic && ev.has_it[header])
+  {
+    fg_cost around = ev.it[header];
+    cost = ev.has_ex[header] ? ev.ex[header] : around;
+    cost.instructions += (uint64_t)(fg->loops[loop].bound - 1) * around.instructions;
+    cost.cycles += (uint64_t)(fg->loops[loop].bound - 1) * around.cycles;
+    cost.unbounded = cost.unbounded || around.unbounded;
+  }
+  eval_free(&ev);
+
+  fg->loops[loop].cost = cost;
+  fg->loops[loop].state = FG_DONE;
+  return cost;
+}
+
+/** @brief routine cost
+ *
+ * The worst case path of a routine, from its entry to where it returns or
+ * halts, with the worst case of each routine it calls.
+ *
+ * @param fg The flow graph.
+ * @param routine The index of the routine.
+ *
+ * @returns fg_cost The worst case, unbounded if a loop of the routine has
+ *   no bound, the routine never ends, or it calls itself.
+ */
+fg_cost fg_routine_cost(flow_graph* fg, unsigned routine)
+{
+  fg_routine* r = &fg->routines[routine];
+  if (r->state == FG_DONE)
+  {
+    return r->cost;
+  }
+  if (r->state == FG_VISITING)
+  {
+    return cost_unbounded();
+  }
+  r->state = FG_VISITING;
+
+  fg_eval ev;
+  unsigned start = node_of(fg, r->entry, FG_NONE);
+  evaluate(fg, FG_NONE, start, &ev);
+  fg_cost cost = ev.has_ex[start] && !ev.cyclic ? ev.ex[start] : cost_unbounded();
+  eval_free(&ev);
+
+  r->cost = cost;
+  r->state = FG_DONE;
+  return cost;
+}
+
+/** @brief block name
+ *
+ * @returns const char* The label of the first instruction of a block, or
+ *   "-" if it has none.
+ */
+static const char* block_name(flow_graph* fg, unsigned block)
+{
+  const char* label = fg->opl->entries[fg->blocks[block].first].label;
+  return label != NULL ? label : "-";
+}
+
+/** @brief display flow graph
+ *
+ * Display the routines of the program, their loops and worst cases.
+ */
+void fg_display(flow_graph* fg)
+{
+  opl_hot* hot = &fg->opl->hot;
+  uint8_t* seen = (uint8_t*)calloc(fg->num_blocks + 1, sizeof(uint8_t));
+  unsigned* queue = (unsigned*)malloc((fg->num_blocks + 1) * sizeof(unsigned));
+  printf("Control Flow Analysis\n");
+  for (unsigned r = 0; r < fg->num_routines; r++)
+  {
+    fg_routine* routine = &fg->routines[r];
+    printf("Routine %-20s %04X: <%u> instructions in <%u> blocks, <%u> loops nested <%u> deep\n",
+      block_name(fg, routine->entry), hot->address[fg->blocks[routine->entry].first], routine->num_instructions,
+      routine->num_blocks, routine->num_loops, routine->max_depth);
+
+    // the loops in the order of the program
+    unsigned num_blocks = routine_blocks(fg, r, seen, queue);
+    for (unsigned b = 0; b < fg->num_blocks; b++)
+    {
+      unsigned l = fg->blocks[b].loop;
+      if (!seen[b] || l == FG_NONE || fg->loops[l].header != b)
+      {
+        continue;
+      }
+      printf("    Loop %-16s %04X: depth <%u>, ", block_name(fg, b), hot->address[fg->blocks[b].first],
+        fg->loops[l].depth);
+      if (fg->loops[l].bound_kind == FG_UNBOUNDED)
+      {
+        printf("unbounded\n");
+      }
+      else
+      {
+        printf("at most <%u> times, %s\n", fg->loops[l].bound,
+          fg->loops[l].bound_kind == FG_INFERRED ? "inferred" : "annotated");
+      }
+    }
+    for (unsigned k = 0; k < num_blocks; k++)
+    {
+      seen[queue[k]] = 0;
+    }
+
+    fg_cost cost = fg_routine_cost(fg, r);
+    if (cost.unbounded)
+    {
+      printf("    Worst case unbounded\n");
+    }
+    else
+    {
+      printf("    Worst case <%" PRIu64 "> instructions, <%" PRIu64 "> cycles\n", cost.instructions, cost.cycles);
+    }
+  }
+  free(seen);
+  free(queue);
+}
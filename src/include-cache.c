@@ -0,0 +1,239 @@
+/** @file include-cache.c
+ * @brief LC-3 Assembler cache of included files
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Cache of included files, see include-cache.h.  The newest version of
+ * each file that was read is kept in one list.  One lock guards the list
+ * and the reference counts of the versions, and a file is read and
+ * tokenized while holding it, so two assemblies that include the same
+ * file at the same time do not both read it.
+ */
+#define _XOPEN_SOURCE 700
+#include "include-cache.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/// guards the list of cached files
+static pthread_mutex_t ic_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/// the newest version of every file read
+static ic_file** ic_files = NULL;
+static unsigned ic_num_files = 0;
+static unsigned ic_capacity = 0;
+
+/// the number of times a file was read and tokenized
+static unsigned ic_reads = 0;
+
+/** @brief read file
+ *
+ * Read and tokenize a file, the caller holds the lock.
+ *
+ * @returns ic_file* The new cached file, or NULL if it can not be read.
+ */
+static ic_file* read_file(const char* path, const struct stat* st)
+{
+  // the tokenizer reports a file it can not open as a fatal error, which
+  // must not happen while the lock is held
+  FILE* in = fopen(path, "r");
+  if (in == NULL)
+  {
+    return NULL;
+  }
+  fclose(in);
+
+  ic_file* file = (ic_file*)calloc(1, sizeof(ic_file));
+  file->path = strdup(path);
+  file->size = st->st_size;
+  file->mtime = st->st_mtim;
+
+  tokenizer* tk = tk_construct(path);
+  unsigned capacity = 0;
+  tokens* tks;
+  while ((tks = tk_next_line(tk)) != NULL)
+  {
+    if (file->num_lines == capacity)
+    {
+      capacity = capacity ? 2 * capacity : 64;
+      file->lines = (tokens**)realloc(file->lines, capacity * sizeof(tokens*));
+    }
+    tks->file = file->path;
+    file->lines[file->num_lines++] = tks;
+  }
+  tk_destruct(tk);
+  ic_reads++;
+  return file;
+}
+
+/** @brief free cached file
+ *
+ * Free a version of a file and its lines.
+ */
+static void free_file(ic_file* file)
+{
+  for (unsigned line = 0; line < file->num_lines; line++)
+  {
+    tokens_destruct(file->lines[line]);
+  }
+  free(file->lines);
+  free(file->path);
+  free(file);
+}
+
+/** @brief load included file
+ *
+ * Find the tokenized lines of a file in the cache, reading and tokenizing
+ * the file if it is not cached yet or changed since it was cached.  The
+ * new version of a changed file replaces the old one, which is freed once
+ * no assembly holds it.
+ *
+ * @param path The path of the file.
+ *
+ * @returns ic_file* The cached file, held by the caller until it calls
+ *   `ic_release()`, or NULL if the file can not be read.
+ */
+ic_file* ic_load(const char* path)
+{
+  char real[PATH_MAX];
+  struct stat st;
+  if (realpath(path, real) == NULL || stat(real, &st) != 0 || !S_ISREG(st.st_mode))
+  {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&ic_lock);
+  unsigned idx = 0;
+  while (idx < ic_num_files && strcmp(ic_files[idx]->path, real) != 0)
+  {
+    idx++;
+  }
+  ic_file* file = idx < ic_num_files ? ic_files[idx] : NULL;
+  if (file == NULL || file->size != st.st_size || file->mtime.tv_sec != st.st_mtim.tv_sec ||
+      file->mtime.tv_nsec != st.st_mtim.tv_nsec)
+  {
+    ic_file* old = file;
+    file = read_file(real, &st);
+    if (file != NULL && old != NULL)
+    {
+      // the old version goes now, or with the last assembly holding it
+      ic_files[idx] = file;
+      old->replaced = true;
+      if (old->refs == 0)
+      {
+        free_file(old);
+      }
+    }
+    else if (file != NULL)
+    {
+      if (ic_num_files == ic_capacity)
+      {
+        ic_capacity = ic_capacity ? 2 * ic_capacity : 16;
+        ic_files = (ic_file**)realloc(ic_files, ic_capacity * sizeof(ic_file*));
+      }
+      ic_files[ic_num_files++] = file;
+    }
+  }
+  if (file != NULL)
+  {
+    file->refs++;
+  }
+  pthread_mutex_unlock(&ic_lock);
+  return file;
+}
+
+/** @brief release included file
+ *
+ * Let go of a file loaded by `ic_load()`, once the assembly no longer
+ * copies its lines or uses the path of its lines.
+ *
+ * @param file The cached file.
+ */
+void ic_release(ic_file* file)
+{
+  pthread_mutex_lock(&ic_lock);
+  file->refs--;
+  if (file->refs == 0 && file->replaced)
+  {
+    free_file(file);
+  }
+  pthread_mutex_unlock(&ic_lock);
+}
+
+/** @brief copy a line of an included file
+ *
+ * @param file The cached file.
+ * @param line The index of the line, of the lines that have tokens.
+ *
+ * @returns tokens* A new copy of the tokens of the line, destructed by the
+ *   caller with `tokens_destruct()`.
+ */
+tokens* ic_copy_line(const ic_file* file, unsigned line)
+{
+  const tokens* cached = file->lines[line];
+  tokens* tks = (tokens*)malloc(sizeof(tokens));
+  tks->line = strdup(cached->line);
+  tks->linenum = cached->linenum;
+  tks->offset = cached->offset;
+  tks->length = cached->length;
+  tks->file = cached->file;
+  tks->num_tokens = cached->num_tokens;
+  for (int tok = 0; tok < cached->num_tokens; tok++)
+  {
+    tks->token[tok] = strdup(cached->token[tok]);
+  }
+  return tks;
+}
+
+/** @brief number of reads
+ *
+ * @returns unsigned The number of times a file was read and tokenized, a
+ *   file that was only copied from the cache is not counted.
+ */
+unsigned ic_num_reads()
+{
+  pthread_mutex_lock(&ic_lock);
+  unsigned num_reads = ic_reads;
+  pthread_mutex_unlock(&ic_lock);
+  return num_reads;
+}
+
+/** @brief number of cached files
+ *
+ * @returns unsigned The number of files in the cache, only the newest
+ *   version of a file that changed is counted.
+ */
+unsigned ic_num_cached()
+{
+  pthread_mutex_lock(&ic_lock);
+  unsigned num_cached = ic_num_files;
+  pthread_mutex_unlock(&ic_lock);
+  return num_cached;
+}
+
+/** @brief clear the cache
+ *
+ * Free every cached file, when a program that assembles many sources, like
+ * the assembler server, is done.  No assembly may be running, the lines of
+ * included files are copied from the cache, and the names of the included
+ * files of their lines point into it.
+ */
+void ic_clear()
+{
+  pthread_mutex_lock(&ic_lock);
+  for (unsigned idx = 0; idx < ic_num_files; idx++)
+  {
+    free_file(ic_files[idx]);
+  }
+  free(ic_files);
+  ic_files = NULL;
+  ic_num_files = 0;
+  ic_capacity = 0;
+  ic_reads = 0;
+  pthread_mutex_unlock(&ic_lock);
+}
@@ -0,0 +1,779 @@
+/** @file incremental.c
+ * @brief LC-3 Assembler incremental reassembly engine
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * An incremental assembler for editor integration, see incremental.h.
+ *
+ * Every line that has an operation list entry owns a slot of the list
+ * file table that points at the text of the line, so entries of different
+ * lines can be added and removed without rereading the whole source.  The
+ * entries of new lines are appended to the list by the usual pass one and
+ * then spliced into place.  The entries after them are given their new
+ * addresses, walking forward until an entry already has the right address
+ * or an .ORIG fixes the addresses from there on, so all of the entries that
+ * moved, moved by the same amount.  The offset of a symbol operand can
+ * only change when the entry moved, when the symbol was at an old address
+ * of the moved entries, or when the symbol itself was removed or defined by
+ * the edit.  Only those entries look up their symbols again, and only the
+ * ones whose offsets really changed are resolved and encoded again.
+ */
+#include "incremental.h"
+#include "assembler.h"
+#include "relax.h"
+#include "tokenizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/// size of the hash table of the labels an edit removed or defined
+#define CHANGED_TABLE_SIZE 61
+
+/** @brief set line error
+ *
+ * Make a diagnostic the error of a line, replacing any error it had.
+ */
+static void set_error(inc_engine* eng, inc_line* ln, diagnostic diag)
+{
+  if (ln->diag.message != NULL)
+  {
+    diag_destruct(&ln->diag);
+    eng->num_errors--;
+  }
+  ln->diag = diag;
+  eng->num_errors++;
+}
+
+/** @brief clear line error
+ *
+ * Remove the error of a line, if it has one.
+ */
+static void clear_error(inc_engine* eng, inc_line* ln)
+{
+  if (ln->diag.message != NULL)
+  {
+    diag_destruct(&ln->diag);
+    eng->num_errors--;
+  }
+}
+
+/** @brief take a file slot
+ *
+ * Get a slot of the operation list file table pointing at the text of a
+ * line, reusing a slot freed by a deleted line if there is one.
+ */
+static unsigned take_file(inc_engine* eng, inc_line* ln)
+{
+  if (eng->num_free_files > 0)
+  {
+    unsigned file = eng->free_files[--eng->num_free_files];
+    opl_set_source(eng->opl, file, ln->text, ln->length);
+    return file;
+  }
+  // there is room to free every slot, grown like the file table
+  unsigned num_files = eng->opl->num_files;
+  if ((num_files & (num_files - 1)) == 0)
+  {
+    eng->free_files = (unsigned*)realloc(eng->free_files, (num_files ? 2 * num_files : 1) * sizeof(unsigned));
+  }
+  return opl_add_source(eng->opl, eng->name, ln->text, ln->length);
+}
+
+/** @brief release a file slot
+ *
+ * Give back the file slot of a line that no longer has an entry.
+ */
+static void release_file(inc_engine* eng, unsigned file)
+{
+  opl_set_source(eng->opl, file, NULL, 0);
+  eng->free_files[eng->num_free_files++] = file;
+}
+
+/** @brief blank line
+ *
+ * Check if a line has nothing to assemble, so it does not need to be
+ * tokenized at all.
+ */
+static bool is_blank(const char* text, unsigned length)
+{
+  for (unsigned pos = 0; pos < length; pos++)
+  {
+    if (text[pos] == ';')
+    {
+      return true;
+    }
+    if (text[pos] != ' ' && text[pos] != '\t' && text[pos] != '\r')
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** @brief preprocessor directive
+ *
+ * Check if the first or second word of a line, after a label, is one of
+ * the directives the engine can not assemble a line at a time.
+ */
+static bool has_directive(const char* text, size_t length)
+{
+  static const char* directives[] = {".MACRO", ".INCLUDE", ".INCBIN"};
+  size_t pos = 0;
+  for (int word = 0; word < 2; word++)
+  {
+    while (pos < length && strchr(" \t,\r", text[pos]) != NULL)
+    {
+      pos++;
+    }
+    size_t begin = pos;
+    while (pos < length && strchr(" \t,\r;", text[pos]) == NULL)
+    {
+      pos++;
+    }
+    if (pos == begin)
+    {
+      return false;
+    }
+    for (unsigned idx = 0; idx < sizeof(directives) / sizeof(directives[0]); idx++)
+    {
+      if (pos - begin == strlen(directives[idx]) && strncasecmp(text + begin, directives[idx], pos - begin) == 0)
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/** @brief source supported
+ *
+ * Check if the engine can assemble a source.  The engine tokenizes each
+ * line by itself, so a source that defines macros, includes files or
+ * includes binary files has to be assembled in full, with the macro
+ * preprocessor.  This only scans the text, it is cheap next to an edit.
+ *
+ * @param source The source text.
+ * @param length The length of the source text.
+ *
+ * @returns bool true if the source has none of those directives.
+ */
+bool inc_supported(const char* source, size_t length)
+{
+  size_t pos = 0;
+  while (pos < length)
+  {
+    const char* newline = (const char*)memchr(source + pos, '\n', length - pos);
+    size_t end = newline != NULL ? (size_t)(newline - source) : length;
+    if (has_directive(source + pos, end - pos))
+    {
+      return false;
+    }
+    pos = end + 1;
+  }
+  return true;
+}
+
+/** @brief pass one of a line
+ *
+ * Tokenize a line and run pass one on it, appending its entry to the end
+ * of the operation list.  An error becomes the error of the line, and
+ * anything the line had added to the tables is taken back out.
+ *
+ * @param eng The engine.
+ * @param line The index of the line.
+ * @param address The address of the line, returns the address of the
+ *   next line.
+ *
+ * @returns unsigned The index of the new entry, or INC_NO_ENTRY.
+ */
+static unsigned parse_line(inc_engine* eng, unsigned line, uint16_t* address)
+{
+  inc_line* ln = &eng->lines[line];
+  if (is_blank(ln->text, ln->length))
+  {
+    return INC_NO_ENTRY;
+  }
+  operation_list* opl = eng->opl;
+  unsigned num_entries = opl->num_entries;
+  uint16_t line_address = *address;
+
+  // what has to be undone when an error jumps back to the trap, these are
+  // changed after setjmp() so must be volatile
+  tokenizer* volatile tk = NULL;
+  tokens* volatile tks = NULL;
+  char* volatile label = NULL;
+  volatile bool inserted = false;
+  volatile unsigned entry = INC_NO_ENTRY;
+
+  diag_trap trap;
+  diag_set_trap(&trap);
+  if (setjmp(trap.jump) == 0)
+  {
+    tk = tk_construct_buffer(eng->name, ln->text, ln->length);
+    tks = tk_next_line(tk);
+    if (tks != NULL)
+    {
+      tks->linenum = line + 1;
+      label = check_for_symbol(tks);
+      inserted = label != NULL && st_lookup(eng->st, label) == NULL;
+      ln->file = take_file(eng, ln);
+      entry = pass_one_line(opl, ln->file, tks, eng->st, address);
+    }
+  }
+  else
+  {
+    set_error(eng, ln, trap.diag);
+    if (opl->num_entries > num_entries)
+    {
+      opl_remove_last(opl);
+    }
+    if (inserted && st_lookup(eng->st, label) != NULL)
+    {
+      st_remove(eng->st, label);
+    }
+    if (ln->file != INC_NO_ENTRY)
+    {
+      release_file(eng, ln->file);
+      ln->file = INC_NO_ENTRY;
+    }
+    *address = line_address;
+    entry = INC_NO_ENTRY;
+  }
+  diag_clear_trap(&trap);
+
+  if (tks != NULL)
+  {
+    tokens_destruct(tks);
+  }
+  if (tk != NULL)
+  {
+    tk_destruct(tk);
+  }
+  eng->num_parsed++;
+  return entry;
+}
+
+/** @brief resolve an entry
+ *
+ * Resolve the symbol operands of an entry and encode it again, like pass
+ * two does.  An error becomes the error of the line of the entry, and a
+ * success clears the error the line had.
+ */
+static void resolve_entry(inc_engine* eng, unsigned idx)
+{
+  inc_line* ln = &eng->lines[eng->opl->entries[idx].linenum - 1];
+
+  diag_trap trap;
+  diag_set_trap(&trap);
+  if (setjmp(trap.jump) == 0)
+  {
+    pass_two_range(eng->opl, eng->st, idx, idx + 1);
+    clear_error(eng, ln);
+  }
+  else
+  {
+    set_error(eng, ln, trap.diag);
+    if (relax_needed(eng->opl, eng->st, idx) > 0)
+    {
+      eng->relax_pending = true;
+    }
+  }
+  diag_clear_trap(&trap);
+  eng->num_encoded++;
+}
+
+/** @brief relax the program
+ *
+ * Undo the relaxation of the program and relax it again, and resolve all
+ * of the entries with symbol operands at their new addresses.  The engine
+ * only keeps errors, so the warnings about the relaxed operations are
+ * dropped, and a section that grew over another one is the error of its
+ * .ORIG line until the next relaxation.
+ */
+static void relax_program(inc_engine* eng)
+{
+  operation_list* opl = eng->opl;
+  for (unsigned line = 0; line < eng->num_lines; line++)
+  {
+    if (eng->lines[line].diag.message != NULL && eng->lines[line].diag.code == DIAG_SECTION_OVERLAP)
+    {
+      clear_error(eng, &eng->lines[line]);
+    }
+  }
+
+  diag_sink sink;
+  diag_sink_construct(&sink, NULL);
+  diag_sink* previous_sink = diag_set_sink(&sink);
+  relax_reset(opl, eng->st);
+  eng->num_relaxed = relax(opl, eng->st).num_relaxed;
+  eng->relax_pending = false;
+  diag_set_sink(previous_sink);
+  for (unsigned index = 0; index < sink.num_diags; index++)
+  {
+    if (diag_is_warning(sink.diags[index].code))
+    {
+      diag_destruct(&sink.diags[index]);
+    }
+    else
+    {
+      set_error(eng, &eng->lines[sink.diags[index].line - 1], sink.diags[index]);
+    }
+  }
+  sink.num_diags = 0;
+  diag_sink_destruct(&sink);
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    for (int opr = 0; opr < opl->hot.num_opr[idx]; opr++)
+    {
+      if (opl->hot.oprtype[opr][idx] == SYMBOL)
+      {
+        resolve_entry(eng, idx);
+        break;
+      }
+    }
+  }
+}
+
+/** @brief note a removed label
+ *
+ * Remember a label of a removed line and its old address, constructing
+ * the table of changed labels when the first one is noted.
+ */
+static symbol_table* note_removed(symbol_table* changed, const char* label, uint16_t address)
+{
+  if (changed == NULL)
+  {
+    changed = st_construct(CHANGED_TABLE_SIZE);
+  }
+  if (st_lookup(changed, label) == NULL)
+  {
+    st_insert(changed, label, address);
+  }
+  return changed;
+}
+
+/** @brief note a defined label
+ *
+ * Remember a label defined by a new line.  A label that a removed line
+ * defined at the same address has not really changed, editing a labelled
+ * line in place puts its label right back, so it is forgotten again.
+ */
+static symbol_table* note_defined(symbol_table* changed, const char* label, uint16_t address)
+{
+  st_entry* removed = changed != NULL ? st_lookup(changed, label) : NULL;
+  if (removed != NULL && removed->address == address)
+  {
+    st_remove(changed, label);
+  }
+  else if (removed == NULL)
+  {
+    changed = note_removed(changed, label, address);
+  }
+  return changed;
+}
+
+/** @brief needs resolving
+ *
+ * Check if the symbol offsets of an entry outside the edit changed.  Only
+ * an entry that moved, or that refers to an old address in the moved
+ * entries or to a label the edit removed or defined, can have a changed
+ * offset.  The old address it refers to is found from its old offset,
+ * relative to the old address of the entry.  Those entries look up their
+ * symbols to see if the offset really changed, since an entry and its
+ * symbol that moved together keep their offset.  Only symbol operands can
+ * be fixed by an edit elsewhere, so entries with symbol operands and errors
+ * are always tried again.
+ */
+static bool needs_resolving(inc_engine* eng, unsigned idx, bool moved, uint16_t delta, uint16_t old_begin,
+  uint16_t old_end, bool any_moved, symbol_table* changed)
+{
+  operation_list* opl = eng->opl;
+  opl_hot* hot = &opl->hot;
+  bool symbolic = false;
+  for (int opr = 0; opr < hot->num_opr[idx]; opr++)
+  {
+    symbolic = symbolic || hot->oprtype[opr][idx] == SYMBOL;
+  }
+  if (!symbolic)
+  {
+    return false;
+  }
+  if (eng->num_errors > 0 && eng->lines[opl->entries[idx].linenum - 1].diag.message != NULL)
+  {
+    return true;
+  }
+
+  uint16_t old_address = moved ? hot->address[idx] - delta : hot->address[idx];
+  for (int opr = 0; opr < hot->num_opr[idx]; opr++)
+  {
+    if (hot->oprtype[opr][idx] != SYMBOL)
+    {
+      continue;
+    }
+    const char* symbol = opl->entries[idx].opr[opr]->svalue;
+    uint16_t target = old_address + 1 + hot->value[opr][idx];
+    if (moved || (any_moved && (uint16_t)(target - old_begin) <= (uint16_t)(old_end - old_begin)) ||
+        (changed != NULL && changed->num_entries > 0 && st_lookup(changed, symbol) != NULL))
+    {
+      st_entry* entry = st_lookup(eng->st, symbol);
+      if (entry == NULL || (uint16_t)(entry->address - (hot->address[idx] + 1)) != hot->value[opr][idx])
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/** @brief count lines
+ *
+ * The number of lines in a text, a last line does not need a newline.
+ */
+static unsigned count_lines(const char* text, size_t length)
+{
+  unsigned num_lines = 0;
+  for (size_t pos = 0; pos < length; pos++)
+  {
+    if (text[pos] == '\n')
+    {
+      num_lines++;
+    }
+  }
+  if (length > 0 && text[length - 1] != '\n')
+  {
+    num_lines++;
+  }
+  return num_lines;
+}
+
+/** @brief replace lines
+ *
+ * Replace the removed lines with the lines of the new text, and put in
+ * new lines for them.
+ */
+static void replace_lines(inc_engine* eng, unsigned first_line, unsigned num_removed, const char* text, size_t length,
+  unsigned num_new)
+{
+  for (unsigned line = first_line; line < first_line + num_removed; line++)
+  {
+    inc_line* ln = &eng->lines[line];
+    if (ln->file != INC_NO_ENTRY)
+    {
+      release_file(eng, ln->file);
+    }
+    clear_error(eng, ln);
+    free(ln->text);
+  }
+
+  unsigned num_lines = eng->num_lines - num_removed + num_new;
+  if (num_lines > eng->capacity)
+  {
+    eng->capacity = num_lines > 2 * eng->capacity ? num_lines : 2 * eng->capacity;
+    eng->lines = (inc_line*)realloc(eng->lines, eng->capacity * sizeof(inc_line));
+  }
+  if (num_new != num_removed)
+  {
+    memmove(&eng->lines[first_line + num_new], &eng->lines[first_line + num_removed],
+      (eng->num_lines - first_line - num_removed) * sizeof(inc_line));
+  }
+  eng->num_lines = num_lines;
+
+  const char* end = text + length;
+  for (unsigned line = first_line; line < first_line + num_new; line++)
+  {
+    const char* newline = (const char*)memchr(text, '\n', end - text);
+    const char* next = newline != NULL ? newline : end;
+    inc_line* ln = &eng->lines[line];
+    ln->length = next - text;
+    if (ln->length > 0 && text[ln->length - 1] == '\r')
+    {
+      ln->length--;
+    }
+    ln->text = (char*)malloc(ln->length + 1);
+    memcpy(ln->text, text, ln->length);
+    ln->text[ln->length] = '\0';
+    ln->entry = INC_NO_ENTRY;
+    ln->file = INC_NO_ENTRY;
+    ln->diag = (diagnostic){NULL, 0, NULL};
+    text = newline != NULL ? newline + 1 : end;
+  }
+}
+
+/** @brief edit lines
+ *
+ * Do an edit, see `inc_edit()`.  Lines with pass one errors are tried
+ * again after an edit that removed labels, since they may have been
+ * duplicates of a removed label, unless this edit is itself such a retry.
+ */
+static void edit_lines(inc_engine* eng, unsigned first_line, unsigned num_removed, const char* text, size_t length,
+  bool retry)
+{
+  operation_list* opl = eng->opl;
+  opl_hot* hot = &opl->hot;
+  symbol_table* changed = NULL;
+  bool removed_labels = false;
+
+  if (first_line > eng->num_lines)
+  {
+    first_line = eng->num_lines;
+  }
+  if (num_removed > eng->num_lines - first_line)
+  {
+    num_removed = eng->num_lines - first_line;
+  }
+
+  // the entries of the removed lines start after the entry of the last
+  // line before them that has one
+  unsigned begin = 0;
+  for (unsigned line = first_line; line-- > 0;)
+  {
+    if (eng->lines[line].entry != INC_NO_ENTRY)
+    {
+      begin = eng->lines[line].entry + 1;
+      break;
+    }
+  }
+
+  // the labels of the removed entries are no longer defined
+  unsigned num_removed_entries = 0;
+  for (unsigned line = first_line; line < first_line + num_removed; line++)
+  {
+    unsigned entry = eng->lines[line].entry;
+    if (entry != INC_NO_ENTRY)
+    {
+      num_removed_entries++;
+      char* label = opl->entries[entry].label;
+      if (label != NULL)
+      {
+        changed = note_removed(changed, label, hot->address[entry]);
+        st_remove(eng->st, label);
+        removed_labels = true;
+      }
+    }
+  }
+
+  unsigned num_new = count_lines(text, length);
+  replace_lines(eng, first_line, num_removed, text, length, num_new);
+
+  // pass one of the new lines, their entries are appended to the end of
+  // the list and then spliced into the place of the removed entries
+  unsigned first_new = opl->num_entries;
+  uint16_t address = begin > 0 ? hot->address[begin - 1] + hot->size[begin - 1] : 0x0000;
+  for (unsigned line = first_line; line < first_line + num_new; line++)
+  {
+    unsigned entry = parse_line(eng, line, &address);
+    if (entry != INC_NO_ENTRY && opl->entries[entry].label != NULL)
+    {
+      changed = note_defined(changed, opl->entries[entry].label, hot->address[entry]);
+    }
+    eng->lines[line].entry = entry == INC_NO_ENTRY ? INC_NO_ENTRY : begin + (entry - first_new);
+  }
+  unsigned num_new_entries = opl->num_entries - first_new;
+  opl_splice(opl, begin, num_removed_entries, first_new);
+  unsigned end_new = begin + num_new_entries;
+
+  // the lines and entries after the edit have new indices and line numbers
+  int entry_delta = (int)num_new_entries - (int)num_removed_entries;
+  int line_delta = (int)num_new - (int)num_removed;
+  if (entry_delta != 0 || line_delta != 0)
+  {
+    for (unsigned line = first_line + num_new; line < eng->num_lines; line++)
+    {
+      inc_line* ln = &eng->lines[line];
+      if (ln->entry != INC_NO_ENTRY)
+      {
+        ln->entry += entry_delta;
+        opl->entries[ln->entry].linenum += line_delta;
+      }
+      if (ln->diag.message != NULL)
+      {
+        ln->diag.line += line_delta;
+      }
+    }
+  }
+
+  // move the entries after the edit to their new addresses, up to the
+  // first entry that is already at its address or the next .ORIG
+  unsigned moved_end = end_new;
+  uint16_t delta = 0;
+  uint16_t old_begin = 0;
+  uint16_t old_end = 0;
+  for (unsigned idx = end_new; idx < opl->num_entries && hot->opc[idx] != ORIG && hot->address[idx] != address;
+       idx++)
+  {
+    if (idx == end_new)
+    {
+      delta = address - hot->address[idx];
+      old_begin = hot->address[idx];
+    }
+    old_end = hot->address[idx] + hot->size[idx];
+    hot->address[idx] = address;
+    if (opl->entries[idx].label != NULL)
+    {
+      st_lookup(eng->st, opl->entries[idx].label)->address = address;
+    }
+    address += hot->size[idx];
+    moved_end = idx + 1;
+  }
+  bool any_moved = moved_end > end_new;
+
+  // pass two of the new entries, and of the other entries whose symbol
+  // offsets changed, which needs something to have moved or a label to have
+  // changed, that is also the only way an entry with an error can be fixed
+  for (unsigned idx = begin; idx < end_new; idx++)
+  {
+    resolve_entry(eng, idx);
+  }
+  if (any_moved || (changed != NULL && changed->num_entries > 0))
+  {
+    for (unsigned idx = 0; idx < opl->num_entries; idx++)
+    {
+      if (idx == begin)
+      {
+        idx = end_new;
+        if (idx >= opl->num_entries)
+        {
+          break;
+        }
+      }
+      bool moved = idx >= end_new && idx < moved_end;
+      if (needs_resolving(eng, idx, moved, delta, old_begin, old_end, any_moved, changed))
+      {
+        resolve_entry(eng, idx);
+      }
+    }
+  }
+  if (changed != NULL)
+  {
+    st_destruct(changed);
+  }
+
+  // a line that was a duplicate of a removed label may be fine now
+  if (removed_labels && !retry && eng->num_errors > 0)
+  {
+    for (unsigned line = 0; line < eng->num_lines; line++)
+    {
+      inc_line* ln = &eng->lines[line];
+      if (ln->diag.message != NULL && ln->entry == INC_NO_ENTRY)
+      {
+        char* again = strdup(ln->text);
+        edit_lines(eng, line, 1, again, strlen(again), true);
+        free(again);
+      }
+    }
+  }
+}
+
+/** @brief construct engine
+ *
+ * Start an incremental assembly of a source.  The source is assembled
+ * right away, like an edit that inserts all of its lines.
+ *
+ * @param name The name of the source, used in diagnostics.
+ * @param source The assembly source text, it is copied.
+ * @param length The length of the source text.
+ *
+ * @returns inc_engine* The new engine, destructed with `inc_destruct()`.
+ */
+inc_engine* inc_construct(const char* name, const char* source, size_t length)
+{
+  inc_engine* eng = (inc_engine*)calloc(1, sizeof(inc_engine));
+  eng->name = strdup(name != NULL ? name : "<source>");
+  eng->st = st_construct(0);
+  eng->opl = opl_construct();
+  inc_edit(eng, 0, 0, source, length);
+  return eng;
+}
+
+/** @brief destruct engine
+ *
+ * Free an engine, its lines, diagnostics and tables.
+ *
+ * @param eng The engine to destruct.
+ */
+void inc_destruct(inc_engine* eng)
+{
+  for (unsigned line = 0; line < eng->num_lines; line++)
+  {
+    free(eng->lines[line].text);
+    diag_destruct(&eng->lines[line].diag);
+  }
+  free(eng->lines);
+  st_destruct(eng->st);
+  opl_destruct(eng->opl);
+  free(eng->free_files);
+  free(eng->name);
+  free(eng);
+}
+
+/** @brief edit the source
+ *
+ * Replace a range of lines of the source with new text, and bring the
+ * assembly up to date with the edit.  An insertion removes no lines, a
+ * deletion has no text, and typing on a line replaces that one line.
+ *
+ * @param eng The engine.
+ * @param first_line The index of the first line replaced, from 0.
+ * @param num_removed The number of lines replaced.
+ * @param text The new lines, separated by newlines, a last line does not
+ *   need a newline.
+ * @param length The length of the new text.
+ */
+void inc_edit(inc_engine* eng, unsigned first_line, unsigned num_removed, const char* text, size_t length)
+{
+  eng->num_parsed = 0;
+  eng->num_encoded = 0;
+  edit_lines(eng, first_line, num_removed, text, length, false);
+  if (eng->num_relaxed > 0 || eng->relax_pending)
+  {
+    relax_program(eng);
+  }
+}
+
+/** @brief diagnostics
+ *
+ * The errors of the current source, in line order.
+ *
+ * @param eng The engine.
+ * @param diags Returns the errors, the diagnostics are owned by the engine
+ *   and only valid until the next edit.
+ * @param max The room in diags.
+ *
+ * @returns unsigned The number of errors returned.
+ */
+unsigned inc_diagnostics(inc_engine* eng, const diagnostic** diags, unsigned max)
+{
+  unsigned num_diags = 0;
+  for (unsigned line = 0; line < eng->num_lines && num_diags < max && num_diags < eng->num_errors; line++)
+  {
+    if (eng->lines[line].diag.message != NULL)
+    {
+      diags[num_diags++] = &eng->lines[line].diag;
+    }
+  }
+  return num_diags;
+}
+
+/** @brief binary image
+ *
+ * The binary image of the current source, the same words that a full
+ * assembly writes to a .lc3 file.
+ *
+ * @param eng The engine.
+ * @param image Returns the words of the image, it must have room for
+ *   `image_size(eng->opl)` words.
+ *
+ * @returns size_t The number of words of the image, 0 if the source has
+ *   errors.
+ */
+size_t inc_image(inc_engine* eng, uint16_t* image)
+{
+  if (eng->num_errors > 0)
+  {
+    return 0;
+  }
+  return write_image(eng->opl, image);
+}
@@ -0,0 +1,359 @@
+/** @file lc3asm-bench.c
+ * @brief LC-3 Assembler benchmarks
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Throughput benchmarks of the assembler passes.  We generate a large
+ * synthetic LC-3 assembly program with a mix of register, immediate,
+ * PC relative and pseudo operations, then time each of the assembly
+ * passes and the binary file writer separately, repeating the
+ * passes that can be rerun so that the timings are stable.  The latency of
+ * incremental reassembly after an edit of the program is timed too.  The
+ * throughput of the binary file writer is measured on a second program,
+ * an image of data and code that fills most of the 64K words of memory.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include "assembler.h"
+#include "encoder.h"
+#include "incremental.h"
+#include "lc3asm-lib.h"
+#include "relax.h"
+#include "work-pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+void usage()
+{
+  printf("usage: bench [-n LINES -r REPEAT -j JOBS -o OUTFILE]\n");
+  printf("Benchmark the LC-3 assembler passes on a generated program");
+  printf("\n");
+  printf("Arguments:\n");
+  printf("  -n LINES      number of operation lines to generate (default 100000)\n");
+  printf("  -r REPEAT     number of times to repeat the timed passes (default 20)\n");
+  printf("  -j JOBS       also time the parallel pass two with JOBS threads, 0 for one per cpu (default 0)\n");
+  printf("  -o OUTFILE    base name of generated .asm/.lc3 files (default output/bench)\n");
+  exit(1);
+}
+
+/** @brief current time in seconds
+ *
+ * @returns double The monotonic clock time in seconds.
+ */
+double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/** @brief generate benchmark program
+ *
+ * Write a synthetic assembly program of the asked for number of lines.
+ * The program repeats a block of 10 operations that has a forward
+ * referenced LD, backward referenced BR and LEA, register and immediate
+ * forms of the ALU operations, base+offset memory operations, a TRAP
+ * and a .FILL constant.
+ *
+ * @param asmfile The name of the assembly file to create.
+ * @param lines The number of operation lines to generate.
+ */
+void generate_program(const char* asmfile, unsigned lines)
+{
+  FILE* out = fopen(asmfile, "w");
+  if (out == NULL)
+  {
+    fprintf(stderr, "<bench::generate_program> error could not open file <%s>\n", asmfile);
+    exit(1);
+  }
+
+  fprintf(out, "        .ORIG   0x3000\n");
+  for (unsigned i = 0; i < lines; i++)
+  {
+    switch (i % 10)
+    {
+    case 0:
+      fprintf(out, "L%u      LD      R1, C%u\n", i, i);
+      break;
+    case 1:
+      fprintf(out, "        ADD     R2, R1, #-1\n");
+      break;
+    case 2:
+      fprintf(out, "        AND     R3, R3, R2\n");
+      break;
+    case 3:
+      fprintf(out, "        BRnp    L%u\n", i - 3);
+      break;
+    case 4:
+      fprintf(out, "        LDR     R4, R6, #3\n");
+      break;
+    case 5:
+      fprintf(out, "        NOT     R5, R4\n");
+      break;
+    case 6:
+      fprintf(out, "        STR     R5, R6, #-2\n");
+      break;
+    case 7:
+      fprintf(out, "        LEA     R0, L%u\n", i - 7);
+      break;
+    case 8:
+      fprintf(out, "        TRAP    x21\n");
+      break;
+    default:
+      fprintf(out, "C%u      .FILL   x%04X\n", i - 9, i & 0xFFFF);
+      break;
+    }
+  }
+  fprintf(out, "        .END\n");
+  fclose(out);
+}
+
+/** @brief generate image program
+ *
+ * Write an assembly program whose image is close to the 64K word limit of
+ * the LC-3 memory.  The program repeats a block of 256 words, 16 ADD
+ * instructions, a .STRINGZ of 47 characters and a .BLKW of 192 words,
+ * like the tables and buffers that make up most of a large image.
+ *
+ * @param asmfile The name of the assembly file to create.
+ *
+ * @returns unsigned The number of words of code in the image.
+ */
+unsigned generate_image_program(const char* asmfile)
+{
+  FILE* out = fopen(asmfile, "w");
+  if (out == NULL)
+  {
+    fprintf(stderr, "<bench::generate_image_program> error could not open file <%s>\n", asmfile);
+    exit(1);
+  }
+
+  unsigned num_blocks = 253;
+  fprintf(out, "        .ORIG   x0000\n");
+  for (unsigned block = 0; block < num_blocks; block++)
+  {
+    for (unsigned i = 0; i < 16; i++)
+    {
+      fprintf(out, "        ADD     R%u, R%u, #%u\n", i % 8, (i + 1) % 8, i);
+    }
+    fprintf(out, "        .STRINGZ \"block %03u of the image, the text to copy it out\"\n", block);
+    fprintf(out, "        .BLKW   #192\n");
+  }
+  fprintf(out, "        .END\n");
+  fclose(out);
+  return num_blocks * 256;
+}
+
+/** @brief write binary file by entry
+ *
+ * Write the binary file of a program of a single section the way it was
+ * written before the image was built in memory, with `write_entry()`
+ * writing each entry through a FILE stream, to compare with
+ * `write_bin_file()`.
+ *
+ * @param binfile The name of the binary file to create.
+ * @param opl The assembled operation list.
+ */
+void write_bin_file_by_entry(const char* binfile, operation_list* opl)
+{
+  FILE* out = fopen(binfile, "wb");
+  if (out == NULL)
+  {
+    fprintf(stderr, "<bench::write_bin_file_by_entry> error could not open file <%s>\n", binfile);
+    exit(1);
+  }
+  uint16_t header[2] = {opl->hot.address[0], opl->size};
+  fwrite(header, WORD_SIZE, 2, out);
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    write_entry(out, opl, idx);
+  }
+  fclose(out);
+}
+
+int main(int argc, char** argv)
+{
+  unsigned lines = 100000;
+  unsigned repeat = 20;
+  unsigned num_threads = 0;
+  const char* outbase = "output/bench";
+  int c;
+
+  // check command line arguments/flags
+  while ((c = getopt(argc, argv, "n:r:j:o:")) != -1)
+  {
+    switch (c)
+    {
+    case 'n':
+      lines = atoi(optarg);
+      break;
+    case 'r':
+      repeat = atoi(optarg);
+      break;
+    case 'j':
+      num_threads = atoi(optarg);
+      break;
+    case 'o':
+      outbase = optarg;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (lines == 0 || repeat == 0)
+  {
+    usage();
+  }
+
+  char asmfile[1024];
+  char binfile[1024];
+  snprintf(asmfile, sizeof(asmfile), "%s.asm", outbase);
+  snprintf(binfile, sizeof(binfile), "%s.lc3", outbase);
+  generate_program(asmfile, lines);
+
+  // pass one consumes the tokenizer, so it is only timed once
+  double start = now();
+  tokenizer* tk = tk_construct(asmfile);
+  symbol_table* st = st_construct(0);
+  operation_list* opl = pass_one(tk, st);
+  double pass_one_time = now() - start;
+
+  // nothing in the generated program is out of range, so this is the cost
+  // of checking every PC relative label
+  start = now();
+  relax_stats relaxed = relax(opl, st);
+  double relax_time = now() - start;
+
+  start = now();
+  for (unsigned r = 0; r < repeat; r++)
+  {
+    pass_two(opl, st);
+  }
+  double pass_two_time = (now() - start) / repeat;
+
+  start = now();
+  for (unsigned r = 0; r < repeat; r++)
+  {
+    pass_two_parallel(opl, st, num_threads);
+  }
+  double pass_two_parallel_time = (now() - start) / repeat;
+
+  // encoding only, the operands are all resolved by now
+  start = now();
+  for (unsigned r = 0; r < repeat; r++)
+  {
+    for (unsigned idx = 0; idx < opl->num_entries; idx++)
+    {
+      asm_inst(opl, idx);
+    }
+  }
+  double encode_time = (now() - start) / repeat;
+
+  start = now();
+  for (unsigned r = 0; r < repeat; r++)
+  {
+    enc_batch(opl, 0, opl->num_entries, false);
+  }
+  double batch_time = (now() - start) / repeat;
+
+  start = now();
+  for (unsigned r = 0; r < repeat; r++)
+  {
+    enc_batch(opl, 0, opl->num_entries, true);
+  }
+  double batch_simd_time = (now() - start) / repeat;
+
+  start = now();
+  for (unsigned r = 0; r < repeat; r++)
+  {
+    write_bin_file(binfile, opl, false);
+  }
+  double write_time = (now() - start) / repeat;
+
+  // incremental reassembly, typing on an ADD line in the middle of the
+  // program, and inserting and deleting a line there, which moves all of
+  // the code after it.  Edits are fast, so there are many more of them.
+  size_t length;
+  char* source = lc3asm_read_source(asmfile, &length);
+  start = now();
+  inc_engine* eng = inc_construct(asmfile, source, length);
+  double inc_construct_time = now() - start;
+
+  unsigned line = lines / 20 * 10 + 2;
+  const char* typed[2] = {"        ADD     R2, R1, #1", "        ADD     R2, R1, #-1"};
+  unsigned num_edits = repeat * 100;
+  start = now();
+  for (unsigned r = 0; r < num_edits; r++)
+  {
+    inc_edit(eng, line, 1, typed[r % 2], strlen(typed[r % 2]));
+  }
+  double inc_type_time = (now() - start) / num_edits;
+
+  const char* inserted = "        NOT     R5, R4\n";
+  start = now();
+  for (unsigned r = 0; r < num_edits; r++)
+  {
+    inc_edit(eng, line, 0, inserted, strlen(inserted));
+    inc_edit(eng, line, 1, "", 0);
+  }
+  double inc_move_time = (now() - start) / (2 * num_edits);
+
+  // the binary file writer on an image close to the 64K word limit, the
+  // image is written many times, so the timings are of the writer and
+  // the page cache rather than the disk
+  char image_asmfile[1024];
+  char image_binfile[1024];
+  snprintf(image_asmfile, sizeof(image_asmfile), "%s-image.asm", outbase);
+  snprintf(image_binfile, sizeof(image_binfile), "%s-image.lc3", outbase);
+  unsigned image_words = generate_image_program(image_asmfile);
+  tokenizer* image_tk = tk_construct(image_asmfile);
+  symbol_table* image_st = st_construct(0);
+  operation_list* image_opl = pass_one(image_tk, image_st);
+  pass_two(image_opl, image_st);
+  double image_mb = (image_size(image_opl) * WORD_SIZE) / 1e6;
+
+  unsigned num_writes = repeat * 10;
+  start = now();
+  for (unsigned r = 0; r < num_writes; r++)
+  {
+    write_bin_file_by_entry(image_binfile, image_opl);
+  }
+  double image_entry_time = (now() - start) / num_writes;
+
+  start = now();
+  for (unsigned r = 0; r < num_writes; r++)
+  {
+    write_bin_file(image_binfile, image_opl, false);
+  }
+  double image_write_time = (now() - start) / num_writes;
+
+  printf("lines: %u  entries: %u  words: %u  repeat: %u\n", lines, opl->num_entries, opl->size, repeat);
+  printf("    pass_one:       %10.3f ms\n", pass_one_time * 1e3);
+  printf("    relax:          %10.3f ms  (%u relaxed)\n", relax_time * 1e3, relaxed.num_relaxed);
+  printf("    pass_two:       %10.3f ms\n", pass_two_time * 1e3);
+  printf("    pass_two -j %-3u %10.3f ms\n", num_threads ? num_threads : wp_num_cpus(), pass_two_parallel_time * 1e3);
+  printf("    asm_inst:       %10.3f ms\n", encode_time * 1e3);
+  printf("    enc_batch:      %10.3f ms\n", batch_time * 1e3);
+  printf("    enc_batch %-4s %10.3f ms\n", enc_simd_available() ? "simd" : "n/a", batch_simd_time * 1e3);
+  printf("    write_bin_file: %10.3f ms\n", write_time * 1e3);
+  printf("    inc_construct:  %10.3f ms\n", inc_construct_time * 1e3);
+  printf("    inc_edit line:  %10.3f us\n", inc_type_time * 1e6);
+  printf("    inc_edit move:  %10.3f us\n", inc_move_time * 1e6);
+  printf("image words: %u  entries: %u  writes: %u\n", image_words, image_opl->num_entries, num_writes);
+  printf("    write_entry:    %10.3f ms  (%8.1f MB/s)\n", image_entry_time * 1e3, image_mb / image_entry_time);
+  printf("    write_bin_file: %10.3f ms  (%8.1f MB/s)\n", image_write_time * 1e3, image_mb / image_write_time);
+
+  tk_destruct(image_tk);
+  st_destruct(image_st);
+  opl_destruct(image_opl);
+  inc_destruct(eng);
+  free(source);
+  tk_destruct(tk);
+  st_destruct(st);
+  opl_destruct(opl);
+  return 0;
+}
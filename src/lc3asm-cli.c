@@ -0,0 +1,104 @@
+/** @file lc3asm-cli.c
+ * @brief LC-3 Assembler command line
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * The usage message and the batch assembly of lc3asm and lc3asm-client.
+ */
+#include "lc3asm-cli.h"
+#include "server.h"
+#include <stdlib.h>
+
+/** @brief display usage
+ *
+ * Show the command line of lc3asm, or of lc3asm-client, which takes the
+ * same arguments but does not serve or watch, and exit with status 1.
+ *
+ * @param client If true the usage of lc3asm-client is shown.
+ */
+void cli_usage(bool client)
+{
+  const char* program = client ? "lc3asm-client" : "lc3asm";
+  printf("usage: %s [-v -s -O -G -A -J -MD -j JOBS -c CACHEDIR -o OUTFILE] FILE\n", program);
+  printf("       %s [-v -s -O -G -A -J -MD -j JOBS -c CACHEDIR] FILE...\n", program);
+  if (client)
+  {
+    printf("Assemble LC-3 program given in FILE with a running lc3asm --serve server");
+  }
+  else
+  {
+    printf("       lc3asm [-v -o OUTFILE] --watch FILE...\n");
+    printf("       lc3asm [-v] --serve[=SOCKET]\n");
+    printf("Assemble LC-3 program given in FILE, or each FILE of a batch into its own FILE.lc3");
+  }
+  printf("\n");
+  printf("Arguments:\n");
+  printf("  -v            verbose output, show results of symbol table and assembly passes\n");
+  printf("  -s            streaming assembly, write code as it is read, only keeping forward references\n");
+  printf("  -O            optimize, remove instructions that do not change the program, and .FILL constants\n");
+  printf("                that another .FILL in reach already holds (not with -s)\n");
+  printf("  -G            remove the code and data the program never reaches from the start of each\n");
+  printf("                section, or references from the code it reaches (not with -s)\n");
+  printf("  -A            analyze the program, show the instructions, loops and worst case instructions\n");
+  printf("                and cycles of each routine, bound a loop with a ; @bound N comment (not with -s),\n");
+  printf("                routines start at each section and JSR target, not at labels named by a .FILL\n");
+  printf("  -J            write the errors as a JSON array, the output file with a .json extension, each\n");
+  printf("                with its file, line, column, code and message (not with -s)\n");
+  printf("  -MD           write a make dependency file, the output file with a .d extension, listing FILE\n");
+  printf("                and the files it includes (not with -s)\n");
+  printf("  -j JOBS       assemble pass two, or the files of a batch, with JOBS threads,\n");
+  printf("                0 for one per cpu (default 1)\n");
+  printf("  -c CACHEDIR   reuse the outputs of sources assembled before from CACHEDIR, or $%s,\n", CACHE_ENV);
+  printf("                and show the cache hits and misses (not with -s)\n");
+  printf("  -o OUTFILE    produce output to OUTFILE, instead of FILE.lc3\n");
+  if (!client)
+  {
+    printf("  --serve       serve assemble requests on a Unix socket, SOCKET or $%s\n", SRV_SOCKET_ENV);
+    printf("                or %s, until a client asks to shut down\n", SRV_SOCKET_DEFAULT);
+    printf("  --watch       assemble FILE..., then assemble each file again whenever it changes,\n");
+    printf("                until interrupted\n");
+  }
+  exit(1);
+}
+
+/** @brief assemble batch of files
+ *
+ * Assemble every file of a batch.  The files are assembled concurrently
+ * with JOBS threads, also when the errors are written as JSON, except in
+ * verbose or streaming mode, or with flags like optimizing or dependency
+ * files, where each file is assembled in turn, so the reports of the files
+ * are not mixed, exactly as if lc3asm was run on it by itself, and pass
+ * two of each file is assembled with JOBS threads.  An error in one file
+ * does not stop the rest of the batch.
+ *
+ * @returns int The exit status, 1 if any file had errors.
+ */
+int cli_assemble_batch(char* const* infiles, unsigned num_files, bool verbose, unsigned flags, bool stream,
+  unsigned num_threads, cache* ch)
+{
+  printf("verbose: %d\n", verbose);
+  bool serial = stream || verbose || (flags & ~LC3ASM_DIAGFILE);
+  bool ok = true;
+  for (unsigned idx = 0; idx < num_files; idx++)
+  {
+    printf("input  file <%s>\n", infiles[idx]);
+    if (stream)
+    {
+      ok = lc3asm_stream_file(infiles[idx], NULL, verbose) && ok;
+    }
+    else if (serial)
+    {
+      ok = lc3asm_file(infiles[idx], NULL, verbose, flags, num_threads, ch) && ok;
+    }
+  }
+  fflush(stdout);
+
+  if (serial)
+  {
+    return ok ? 0 : 1;
+  }
+  return lc3asm_batch(infiles, num_files, flags, num_threads, ch) ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/** @file lc3asm-client.c
+ * @brief LC-3 Assembler server client
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * A drop in replacement for lc3asm, with the same command line, that asks
+ * a running `lc3asm --serve` server to assemble the file instead of
+ * assembling it itself.  The server socket is $LC3ASM_SOCKET, or the
+ * default socket.  The verbose, streaming, optimizing, multi-threaded,
+ * batch and cached modes, and dependency files, are only done by lc3asm
+ * itself, so those, and any request when no server is running, are
+ * assembled in this process exactly as lc3asm would.
+ */
+#define _XOPEN_SOURCE 700
+#include "assembler.h"
+#include "lc3asm-cli.h"
+#include "server.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** @brief assemble remotely
+ *
+ * Ask the server to assemble a file and write the binary file from the
+ * image it sends back.  Errors are reported like lc3asm reports them.
+ *
+ * @param infile The assembly file.
+ * @param outfile The binary file, NULL for the name determined from infile.
+ *
+ * @returns bool false if the server could not be asked, so the file still
+ *   has to be assembled.
+ */
+bool remote_lc3asm(const char* infile, const char* outfile)
+{
+  // the server has its own working directory, so send it the full path
+  char path[PATH_MAX];
+  if (realpath(infile, path) == NULL)
+  {
+    return false;
+  }
+  lc3asm_result* result = srv_request(srv_socket_path(NULL), SRV_PATH, infile, path, strlen(path));
+  if (result == NULL)
+  {
+    return false;
+  }
+
+  // the warnings are reported even when the assembly is ok
+  unsigned num_errors = 0;
+  for (unsigned index = 0; index < result->num_diagnostics; index++)
+  {
+    diag_print(stderr, &result->diagnostics[index]);
+    num_errors += !diag_is_warning(result->diagnostics[index].code);
+  }
+  if (!result->ok)
+  {
+    fprintf(stderr, "Assembly failed with <%u> errors\n", num_errors);
+    exit(1);
+  }
+
+  char* binfile = outfile ? strdup(outfile) : bin_file_name(infile);
+  FILE* out = fopen(binfile, "wb");
+  if (out == NULL)
+  {
+    fprintf(stderr, "<assembler::write_bin_file> error could not open file <%s>\n", binfile);
+    exit(1);
+  }
+  bool written = fwrite(result->image, WORD_SIZE, result->image_size, out) == result->image_size;
+  written = fclose(out) == 0 && written;
+  if (!written)
+  {
+    fprintf(stderr, "<assembler::write_bin_file> error could not write file <%s>\n", binfile);
+    exit(1);
+  }
+
+  free(binfile);
+  lc3asm_result_destruct(result);
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  // parse command line arguments
+  char* infile;
+  char* outfile = NULL;
+  bool verbose = false;
+  bool stream = false;
+  unsigned flags = 0;
+  unsigned num_threads = 1;
+  const char* cache_dir = getenv(CACHE_ENV);
+  int c;
+
+  // check command line arguments/flags
+  while ((c = getopt(argc, argv, "c:j:o:svAGJM:O")) != -1)
+  {
+    switch (c)
+    {
+    case 'v':
+      verbose = true;
+      break;
+    case 's':
+      stream = true;
+      break;
+    case 'O':
+      flags |= LC3ASM_OPTIMIZE;
+      break;
+    case 'G':
+      flags |= LC3ASM_DEADCODE;
+      break;
+    case 'A':
+      flags |= LC3ASM_ANALYZE;
+      break;
+    case 'J':
+      flags |= LC3ASM_DIAGFILE;
+      break;
+    case 'M':
+      if (strcmp(optarg, "D") != 0)
+      {
+        cli_usage(true);
+      }
+      flags |= LC3ASM_DEPFILE;
+      break;
+    case 'j':
+      num_threads = atoi(optarg);
+      break;
+    case 'o':
+      outfile = optarg;
+      break;
+    case 'c':
+      cache_dir = optarg;
+      break;
+    default:
+      cli_usage(true);
+    }
+  }
+
+  // get required input file names, a batch is assembled here
+  unsigned num_files = argc - optind;
+  if (num_files == 0 || (num_files > 1 && outfile != NULL) || (stream && flags))
+  {
+    cli_usage(true);
+  }
+  cache* ch = cache_dir && cache_dir[0] && !stream ? cache_construct(cache_dir) : NULL;
+
+  int status = 0;
+  if (num_files > 1)
+  {
+    status = cli_assemble_batch(argv + optind, num_files, verbose, flags, stream, num_threads, ch);
+  }
+  else
+  {
+    infile = argv[optind];
+    printf("verbose: %d\n", verbose);
+    printf("input  file <%s>\n", infile);
+    printf("output file <%s>\n", outfile);
+    fflush(stdout);
+
+    // assemble the file on the server, or here if it is a mode only lc3asm
+    // does or there is no server
+    if (stream)
+    {
+      lc3asm_stream(infile, outfile, verbose);
+    }
+    else if (verbose || flags || num_threads != 1 || ch || !remote_lc3asm(infile, outfile))
+    {
+      lc3asm(infile, outfile, verbose, flags, num_threads, ch);
+    }
+  }
+
+  if (ch)
+  {
+    cache_display_stats(ch);
+    cache_destruct(ch);
+  }
+  return status;
+}
@@ -0,0 +1,493 @@
+/** @file lc3asm-lib.c
+ * @brief LC-3 Assembler library interface
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * An interface to embed the assembler in other programs.  The library
+ * assembles source text held in memory into the words of a binary image
+ * in memory, without reading or writing any files, and reports errors as
+ * diagnostics in the result instead of exiting.  A batch of files can also
+ * be assembled concurrently, each file into its own result and binary file.
+ * The library is built as liblc3asm.a and liblc3asm.so.
+ *
+ * The assembler modules report errors with `diag_fatal()`, so the library
+ * sets an error trap around the assembly.  An error jumps back to the trap,
+ * where everything the assembly had constructed is destructed and the
+ * error is returned as a diagnostic.  The errors that only spoil their
+ * line are recorded in a diagnostic sink instead, and the assembly goes on
+ * to find the others, so the result has every error of the source.
+ */
+#define __STDC_WANT_LIB_EXT2__ 1
+#include "lc3asm-lib.h"
+#include "assembler.h"
+#include "macro.h"
+#include "operation-list.h"
+#include "relax.h"
+#include "symbol-table.h"
+#include "tokenizer.h"
+#include "work-pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief compare symbols by address
+ *
+ * qsort() comparison of two lc3asm_symbol, by address and then by name.
+ */
+static int compare_symbols(const void* a, const void* b)
+{
+  const lc3asm_symbol* sa = (const lc3asm_symbol*)a;
+  const lc3asm_symbol* sb = (const lc3asm_symbol*)b;
+  if (sa->address != sb->address)
+  {
+    return sa->address < sb->address ? -1 : 1;
+  }
+  return strcmp(sa->symbol, sb->symbol);
+}
+
+/** @brief list symbols
+ *
+ * Copy all of the symbols in the symbol table into the result,
+ * sorted by address.
+ *
+ * @param result The result to list the symbols in.
+ * @param st The symbol table of the assembly.
+ */
+static void list_symbols(lc3asm_result* result, symbol_table* st)
+{
+  result->symbols = (lc3asm_symbol*)malloc((st->num_entries ? st->num_entries : 1) * sizeof(lc3asm_symbol));
+  result->num_symbols = 0;
+  for (unsigned index = 0; index < st->table_size; index++)
+  {
+    for (st_entry* entry = st->entries[index]; entry != NULL; entry = entry->next)
+    {
+      result->symbols[result->num_symbols].symbol = strdup(entry->symbol);
+      result->symbols[result->num_symbols].address = entry->address;
+      result->num_symbols++;
+    }
+  }
+  qsort(result->symbols, result->num_symbols, sizeof(lc3asm_symbol), compare_symbols);
+}
+
+/** @brief list files
+ *
+ * Copy the names of the files an assembly read besides its source into the
+ * result, the files the macro preprocessor included, the first file it
+ * knows is the source, and the binary files of the .INCBINs.
+ *
+ * @param result The result to list the files in.
+ * @param ctx The context of the assembly, before it is reset.
+ */
+static void list_files(lc3asm_result* result, lc3asm_context* ctx)
+{
+  unsigned num_included = ctx->mp != NULL ? ctx->mp->num_included : 1;
+  unsigned num_files = num_included - 1 + ctx->opl->num_binaries;
+  result->files = (char**)malloc((num_files ? num_files : 1) * sizeof(char*));
+  result->num_files = 0;
+  for (unsigned idx = 1; idx < num_included; idx++)
+  {
+    result->files[result->num_files++] = strdup(ctx->mp->included[idx]);
+  }
+  for (unsigned idx = 0; idx < ctx->opl->num_binaries; idx++)
+  {
+    result->files[result->num_files++] = strdup(ctx->opl->binaries[idx].name);
+  }
+}
+
+/** @brief assemble a source in memory
+ *
+ * Assemble LC-3 assembly source text into a binary image.  This does the
+ * same work as `lc3asm()` but with the source and the resulting image in
+ * memory, and it never exits.  If the source has errors the result is
+ * not ok, has no image, and has a diagnostic describing each error.
+ *
+ * @param name The name of the source, used in diagnostics.
+ * @param source The assembly source text, it does not need to be
+ *   terminated with a '\0'.
+ * @param length The length of the source text.
+ *
+ * @returns lc3asm_result* A newly allocated result, that the caller
+ *   destructs with `lc3asm_result_destruct()`.
+ */
+lc3asm_result* lc3asm_assemble(const char* name, const char* source, size_t length)
+{
+  lc3asm_context* ctx = lc3asm_context_construct();
+  lc3asm_result* result = lc3asm_context_assemble(ctx, name, source, length);
+  lc3asm_context_destruct(ctx);
+  return result;
+}
+
+/** @brief construct assembler context
+ *
+ * Construct a context with empty tables, see lc3asm-lib.h.
+ *
+ * @returns lc3asm_context* A newly allocated context, destructed with
+ *   `lc3asm_context_destruct()`.
+ */
+lc3asm_context* lc3asm_context_construct()
+{
+  lc3asm_context* ctx = (lc3asm_context*)calloc(1, sizeof(lc3asm_context));
+  ctx->st = st_construct(0);
+  ctx->opl = opl_construct();
+  diag_sink_construct(&ctx->sink, NULL);
+  return ctx;
+}
+
+/** @brief reset assembler context
+ *
+ * Clear everything an assembly left in a context, so it is ready for the
+ * next one.  The tokenizer and macro processor of the last source are
+ * destructed, and the tables and the diagnostic sink are cleared but keep
+ * their capacity, so the next assembly does not need to grow them again.
+ *
+ * @param ctx The context to reset.
+ */
+void lc3asm_context_reset(lc3asm_context* ctx)
+{
+  if (ctx->tks != NULL)
+  {
+    tokens_destruct(ctx->tks);
+    ctx->tks = NULL;
+  }
+  if (ctx->mp != NULL)
+  {
+    mac_destruct(ctx->mp);
+    ctx->mp = NULL;
+  }
+  if (ctx->tk != NULL)
+  {
+    tk_destruct(ctx->tk);
+    ctx->tk = NULL;
+  }
+  st_clear(ctx->st);
+  opl_clear(ctx->opl);
+  diag_sink_clear(&ctx->sink);
+}
+
+/** @brief destruct assembler context
+ *
+ * Free a context and everything it holds.
+ *
+ * @param ctx The context to destruct.
+ */
+void lc3asm_context_destruct(lc3asm_context* ctx)
+{
+  lc3asm_context_reset(ctx);
+  st_destruct(ctx->st);
+  opl_destruct(ctx->opl);
+  diag_sink_destruct(&ctx->sink);
+  free(ctx);
+}
+
+/** @brief assemble a source in memory with a context
+ *
+ * Assemble a source like `lc3asm_assemble()`, with the tables of a context
+ * instead of new ones.  The context is reset first, so a program that
+ * assembles many sources, like the assembler server, keeps reusing warm
+ * tables, and each thread that assembles with its own context is
+ * independent of the others.
+ *
+ * @param ctx The context to assemble with, it is only used by this thread
+ *   until the assembly returns.
+ * @param name The name of the source, used in diagnostics.
+ * @param source The assembly source text.
+ * @param length The length of the source text.
+ *
+ * @returns lc3asm_result* A newly allocated result, that the caller
+ *   destructs with `lc3asm_result_destruct()`.
+ */
+lc3asm_result* lc3asm_context_assemble(lc3asm_context* ctx, const char* name, const char* source, size_t length)
+{
+  lc3asm_result* result = (lc3asm_result*)calloc(1, sizeof(lc3asm_result));
+  if (name == NULL)
+  {
+    name = "<source>";
+  }
+  lc3asm_context_reset(ctx);
+  ctx->num_assemblies++;
+  symbol_table* st = ctx->st;
+  operation_list* opl = ctx->opl;
+
+  // what has to be destructed when an error jumps back to the trap is
+  // kept in the context, and destructed when it is reset
+  diag_sink* previous_sink = diag_set_sink(&ctx->sink);
+  diag_trap trap;
+  diag_set_trap(&trap);
+  if (setjmp(trap.jump) == 0)
+  {
+    ctx->tk = tk_construct_buffer(name, source, length);
+    ctx->mp = mac_construct(ctx->tk);
+    unsigned file = opl_add_source(opl, name, source, length);
+
+    // pass one, one line at a time so that a line being processed is
+    // freed if it has an error
+    uint16_t address = 0x0000;
+    while ((ctx->tks = mac_next_line(ctx->mp)) != NULL)
+    {
+      pass_one_line(opl, source_file(opl, file, ctx->tks), ctx->tks, st, &address);
+      tokens_destruct(ctx->tks);
+      ctx->tks = NULL;
+    }
+
+    relax(opl, st);
+    pass_two(opl, st);
+
+    if (ctx->sink.num_errors == 0)
+    {
+      result->image = (uint16_t*)malloc(image_size(opl) * sizeof(uint16_t));
+      result->image_size = write_image(opl, result->image);
+      result->ok = true;
+    }
+  }
+  diag_clear_trap(&trap);
+  diag_set_sink(previous_sink);
+
+  // the errors the assembly went on after come first, in the order of
+  // their lines, then the error that stopped it, if any, the result takes
+  // them over from the sink
+  diag_sink_sort(&ctx->sink);
+  for (unsigned index = 0; index < ctx->sink.num_diags; index++)
+  {
+    lc3asm_result_add_diagnostic(result, ctx->sink.diags[index]);
+  }
+  ctx->sink.num_diags = 0;
+  ctx->sink.num_errors = 0;
+  if (trap.diag.message != NULL)
+  {
+    lc3asm_result_add_diagnostic(result, trap.diag);
+  }
+
+  list_symbols(result, st);
+  list_files(result, ctx);
+  lc3asm_context_reset(ctx);
+  return result;
+}
+
+/** @brief add a diagnostic to a result
+ *
+ * Append a diagnostic to the diagnostics of a result, the result takes
+ * over the file and message of the diagnostic.
+ *
+ * @param result The result to add the diagnostic to.
+ * @param diag The diagnostic to add.
+ */
+void lc3asm_result_add_diagnostic(lc3asm_result* result, diagnostic diag)
+{
+  result->diagnostics =
+    (diagnostic*)realloc(result->diagnostics, (result->num_diagnostics + 1) * sizeof(diagnostic));
+  result->diagnostics[result->num_diagnostics++] = diag;
+}
+
+/** @brief read source file
+ *
+ * Read the whole of an assembly file into memory, to be assembled with
+ * `lc3asm_assemble()`.
+ *
+ * @param asmfile The name of the file to read.
+ * @param length Returns the length of the file.
+ *
+ * @returns char* The newly allocated contents of the file, freed by the
+ *   caller, or NULL if the file could not be read.
+ */
+char* lc3asm_read_source(const char* asmfile, size_t* length)
+{
+  FILE* in = fopen(asmfile, "rb");
+  if (in == NULL)
+  {
+    return NULL;
+  }
+
+  size_t capacity = 8192;
+  size_t size = 0;
+  char* source = (char*)malloc(capacity);
+  size_t got;
+  while ((got = fread(source + size, 1, capacity - size, in)) > 0)
+  {
+    size += got;
+    if (size == capacity)
+    {
+      capacity *= 2;
+      source = (char*)realloc(source, capacity);
+    }
+  }
+  fclose(in);
+
+  *length = size;
+  return source;
+}
+
+/// The files of a batch and their results, shared by the workers
+/// assembling the batch, and the contexts they assemble with.  A worker
+/// takes a free context for each file and gives it back after, so there
+/// are never more contexts than workers, and each is reused for many files.
+typedef struct batch_work
+{
+  const char* const* asmfiles;
+  const char* const* binfiles;
+  lc3asm_result** results;
+
+  pthread_mutex_t lock;
+  lc3asm_context** contexts;
+  unsigned num_contexts;
+  lc3asm_context** free_contexts;
+  unsigned num_free;
+} batch_work;
+
+/** @brief take batch context
+ *
+ * Take a free context of a batch, constructing one if they are all in use.
+ */
+static lc3asm_context* take_context(batch_work* batch)
+{
+  pthread_mutex_lock(&batch->lock);
+  lc3asm_context* ctx;
+  if (batch->num_free > 0)
+  {
+    ctx = batch->free_contexts[--batch->num_free];
+  }
+  else
+  {
+    ctx = lc3asm_context_construct();
+    batch->contexts[batch->num_contexts++] = ctx;
+  }
+  pthread_mutex_unlock(&batch->lock);
+  return ctx;
+}
+
+/** @brief give back batch context
+ *
+ * Give a context taken with `take_context()` back for the next file.
+ */
+static void give_context(batch_work* batch, lc3asm_context* ctx)
+{
+  pthread_mutex_lock(&batch->lock);
+  batch->free_contexts[batch->num_free++] = ctx;
+  pthread_mutex_unlock(&batch->lock);
+}
+
+/** @brief assemble files of a batch
+ *
+ * Work function of `lc3asm_assemble_files()`, assemble the files from
+ * begin to end and write the binary files of those that assembled.  Each
+ * file only writes its own result, so the files are independent.
+ */
+static void assemble_files(void* arg, unsigned begin, unsigned end)
+{
+  batch_work* batch = (batch_work*)arg;
+  for (unsigned idx = begin; idx < end; idx++)
+  {
+    const char* asmfile = batch->asmfiles[idx];
+    size_t length;
+    char* source = lc3asm_read_source(asmfile, &length);
+    if (source == NULL)
+    {
+      lc3asm_result* result = (lc3asm_result*)calloc(1, sizeof(lc3asm_result));
+      lc3asm_result_add_diagnostic(result,
+        diag_format(asmfile, 0, "<tokeniser::tk_construct> File Not Found: <%s>", asmfile));
+      batch->results[idx] = result;
+      continue;
+    }
+    lc3asm_context* ctx = take_context(batch);
+    lc3asm_result* result = lc3asm_context_assemble(ctx, asmfile, source, length);
+    give_context(batch, ctx);
+    free(source);
+
+    if (result->ok && batch->binfiles != NULL)
+    {
+      const char* binfile = batch->binfiles[idx];
+      FILE* out = fopen(binfile, "wb");
+      if (out == NULL)
+      {
+        result->ok = false;
+        lc3asm_result_add_diagnostic(result,
+          diag_format(asmfile, 0, "<assembler::write_bin_file> error could not open file <%s>", binfile));
+      }
+      else
+      {
+        bool written = fwrite(result->image, sizeof(uint16_t), result->image_size, out) == result->image_size;
+        written = fclose(out) == 0 && written;
+        if (!written)
+        {
+          result->ok = false;
+          lc3asm_result_add_diagnostic(result,
+            diag_format(asmfile, 0, "<assembler::write_bin_file> error could not write file <%s>", binfile));
+        }
+      }
+    }
+    batch->results[idx] = result;
+  }
+}
+
+/** @brief assemble a batch of files
+ *
+ * Assemble many files concurrently on a pool of threads, each file is read
+ * and assembled independently into its own result.  The diagnostics of
+ * each file are kept in its result, so an error in one file does not stop
+ * the others, and the caller can report them in the order of the files.
+ *
+ * @param asmfiles The names of the files to assemble.
+ * @param binfiles The names of the binary files to write, binfiles[i] is
+ *   written with the image of asmfiles[i] if it assembled.  NULL to only
+ *   return the results.
+ * @param num_files The number of files.
+ * @param num_threads The number of threads to assemble with, 0 for one per
+ *   cpu.
+ *
+ * @returns lc3asm_result** A newly allocated array of num_files results,
+ *   the caller destructs each result and frees the array.
+ */
+lc3asm_result** lc3asm_assemble_files(const char* const* asmfiles, const char* const* binfiles, unsigned num_files,
+  unsigned num_threads)
+{
+  batch_work batch;
+  batch.asmfiles = asmfiles;
+  batch.binfiles = binfiles;
+  batch.results = (lc3asm_result**)calloc(num_files ? num_files : 1, sizeof(lc3asm_result*));
+  pthread_mutex_init(&batch.lock, NULL);
+  batch.contexts = (lc3asm_context**)calloc(num_files + 1, sizeof(lc3asm_context*));
+  batch.num_contexts = 0;
+  batch.free_contexts = (lc3asm_context**)calloc(num_files + 1, sizeof(lc3asm_context*));
+  batch.num_free = 0;
+
+  // files differ a lot in size, so hand them out one at a time
+  wp_parallel_for(num_threads, num_files, 1, assemble_files, &batch);
+
+  for (unsigned idx = 0; idx < batch.num_contexts; idx++)
+  {
+    lc3asm_context_destruct(batch.contexts[idx]);
+  }
+  free(batch.contexts);
+  free(batch.free_contexts);
+  pthread_mutex_destroy(&batch.lock);
+  return batch.results;
+}
+
+/** @brief destruct result
+ *
+ * Free a result returned by `lc3asm_assemble()` and everything it holds.
+ *
+ * @param result The result to destruct.
+ */
+void lc3asm_result_destruct(lc3asm_result* result)
+{
+  free(result->image);
+  for (unsigned index = 0; index < result->num_symbols; index++)
+  {
+    free(result->symbols[index].symbol);
+  }
+  free(result->symbols);
+  for (unsigned index = 0; index < result->num_diagnostics; index++)
+  {
+    diag_destruct(&result->diagnostics[index]);
+  }
+  free(result->diagnostics);
+  for (unsigned index = 0; index < result->num_files; index++)
+  {
+    free(result->files[index]);
+  }
+  free(result->files);
+  free(result);
+}
@@ -10,19 +10,20 @@
  */
 #define _POSIX_C_SOURCE 2
 #include "assembler.h"
+#include "lc3asm-cli.h"
+#include "server.h"
+#include "watch.h"
+#include <getopt.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
-void usage()
-{
-  printf("usage: lc3asm [-v -o OUTFILE] FILE\n");
-  printf("Assemble LC-3 program given in FILE");
-  printf("\n");
-  printf("Arguments:\n");
-  printf("  -v            verbose output, show results of symbol table and assembly passes\n");
-  printf("  -o OUTFILE    produce output to OUTFILE, instead of FILE.lc3\n");
-  exit(1);
-}
+/// the long options, --serve takes an optional socket path
+static struct option long_options[] = {
+  {"serve", optional_argument, NULL, 'S'},
+  {"watch", no_argument, NULL, 'W'},
+  {NULL, 0, NULL, 0},
+};
 
 int main(int argc, char** argv)
 {
@@ -30,40 +31,126 @@ int main(int argc, char** argv)
   char* infile;
   char* outfile = NULL;
   bool verbose = false;
-  char c;
+  bool stream = false;
+  unsigned flags = 0;
+  unsigned num_threads = 1;
+  bool serve = false;
+  bool watch = false;
+  const char* socket_path = NULL;
+  const char* cache_dir = getenv(CACHE_ENV);
+  int c;
 
   // check command line arguments/flags
-  while ((c = getopt(argc, argv, "o:v")) != -1)
+  while ((c = getopt_long(argc, argv, "c:j:o:svAGJM:O", long_options, NULL)) != -1)
   {
     switch (c)
     {
+    case 'S':
+      serve = true;
+      socket_path = optarg;
+      break;
+    case 'W':
+      watch = true;
+      break;
     case 'v':
       verbose = true;
       break;
+    case 's':
+      stream = true;
+      break;
+    case 'O':
+      flags |= LC3ASM_OPTIMIZE;
+      break;
+    case 'G':
+      flags |= LC3ASM_DEADCODE;
+      break;
+    case 'A':
+      flags |= LC3ASM_ANALYZE;
+      break;
+    case 'J':
+      flags |= LC3ASM_DIAGFILE;
+      break;
+    case 'M':
+      if (strcmp(optarg, "D") != 0)
+      {
+        cli_usage(false);
+      }
+      flags |= LC3ASM_DEPFILE;
+      break;
+    case 'j':
+      num_threads = atoi(optarg);
+      break;
     case 'o':
       outfile = optarg;
       break;
+    case 'c':
+      cache_dir = optarg;
+      break;
     default:
-      usage();
+      cli_usage(false);
     }
   }
 
-  // get required input file name
-  if (optind != (argc - 1))
+  // serve requests instead of assembling a file
+  if (serve)
   {
-    usage();
+    if (optind != argc)
+    {
+      cli_usage(false);
+    }
+    srv_serve(srv_socket_path(socket_path), verbose);
+    return 0;
   }
-  else
+
+  // get required input file names, a batch of files is written to the
+  // default output file names
+  unsigned num_files = argc - optind;
+  if (num_files == 0 || (num_files > 1 && outfile != NULL) || (stream && flags))
   {
-    infile = argv[optind];
+    cli_usage(false);
   }
 
-  printf("verbose: %d\n", verbose);
-  printf("input  file <%s>\n", infile);
-  printf("output file <%s>\n", outfile);
+  // watch the files instead of assembling them once
+  if (watch)
+  {
+    if (stream || flags)
+    {
+      cli_usage(false);
+    }
+    watcher* w = watch_construct(argv + optind, num_files, outfile, verbose);
+    watch_run(w);
+    watch_destruct(w);
+    return 0;
+  }
+  cache* ch = cache_dir && cache_dir[0] && !stream ? cache_construct(cache_dir) : NULL;
 
-  // assemble the file
-  lc3asm(infile, outfile, verbose);
+  int status = 0;
+  if (num_files > 1)
+  {
+    status = cli_assemble_batch(argv + optind, num_files, verbose, flags, stream, num_threads, ch);
+  }
+  else
+  {
+    infile = argv[optind];
+    printf("verbose: %d\n", verbose);
+    printf("input  file <%s>\n", infile);
+    printf("output file <%s>\n", outfile);
 
-  return 0;
+    // assemble the file
+    if (stream)
+    {
+      lc3asm_stream(infile, outfile, verbose);
+    }
+    else
+    {
+      lc3asm(infile, outfile, verbose, flags, num_threads, ch);
+    }
+  }
+
+  if (ch)
+  {
+    cache_display_stats(ch);
+    cache_destruct(ch);
+  }
+  return status;
 }
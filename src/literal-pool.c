@@ -0,0 +1,247 @@
+/** @file literal-pool.c
+ * @brief LC-3 Assembler literal pool
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Literal pool, see literal-pool.h.  The literals are found by the address
+ * of their label, since the symbol table maps labels to addresses, and
+ * the slots of each value are kept in a list per value, so merging is one
+ * walk of the operation list.
+ */
+#define __STDC_WANT_LIB_EXT2__ 1
+#include "literal-pool.h"
+#include "assembler.h"
+#include "peephole.h"
+#include "relax.h"
+#include <stdlib.h>
+#include <string.h>
+
+/// no entry, a literal or slot that is not there
+#define NO_ENTRY ((unsigned)-1)
+
+/** @brief is literal
+ *
+ * Check if an entry is a labelled .FILL of a number, a literal if its
+ * label is only loaded from.
+ */
+static bool is_literal(operation_list* opl, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+  return hot->opc[idx] == FILL && hot->size[idx] == 1 && opl->entries[idx].label != NULL && hot->num_opr[idx] == 1 &&
+         hot->oprtype[0][idx] == NUMERIC;
+}
+
+/** @brief is data
+ *
+ * Check if an entry is data that is still in the program.
+ */
+static bool is_data(opl_hot* hot, unsigned idx)
+{
+  return hot->size[idx] > 0 && (hot->opc[idx] == FILL || hot->opc[idx] == BLKW || hot->opc[idx] == STRINGZ ||
+                                 hot->opc[idx] == INCBIN);
+}
+
+/** @brief is load
+ *
+ * Check if an operand is the label an LD or LDI loads from.
+ */
+static bool is_load(opl_hot* hot, unsigned idx, unsigned opr)
+{
+  return (hot->opc[idx] == LD || hot->opc[idx] == LDI) && hot->num_opr[idx] == 2 && opr == 1;
+}
+
+/** @brief reaches slot
+ *
+ * Check if every load of a literal can reach a slot with its 9 bit
+ * offset.
+ */
+static bool reaches(opl_hot* hot, unsigned slot, unsigned load, const unsigned* next_load)
+{
+  for (; load != NO_ENTRY; load = next_load[load])
+  {
+    if (!relax_fits(hot->address[slot] - (hot->address[load] + 1), 9))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** @brief point loads at slot
+ *
+ * Change the label of each load of a literal to the label of its slot.
+ */
+static void point_loads(operation_list* opl, unsigned slot, unsigned load, const unsigned* next_load)
+{
+  for (; load != NO_ENTRY; load = next_load[load])
+  {
+    operand* opr = opl->entries[load].opr[1];
+    free(opr->svalue);
+    free(opr->token);
+    opr->svalue = strdup(opl->entries[slot].label);
+    opr->token = strdup(opl->entries[slot].label);
+  }
+}
+
+/** @brief find literals
+ *
+ * Find the literal at each address, and the loads of each literal.  A
+ * literal whose address is taken, or that is in a run of data with a
+ * word whose address is taken, is dropped.
+ *
+ * @param opl The operation list.
+ * @param st The symbol table.
+ * @param literal Returns the index of the literal at each address, or
+ *   NO_ENTRY.
+ * @param first_load Returns the first load of each literal, or NO_ENTRY.
+ * @param next_load Returns the next load of the same literal after each
+ *   load, or NO_ENTRY.
+ */
+static void find_literals(
+  operation_list* opl, symbol_table* st, unsigned* literal, unsigned* first_load, unsigned* next_load)
+{
+  opl_hot* hot = &opl->hot;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    first_load[idx] = NO_ENTRY;
+    if (is_literal(opl, idx))
+    {
+      literal[hot->address[idx]] = idx;
+    }
+  }
+
+  // a label used by anything but a load takes the address of its word
+  uint8_t* taken = (uint8_t*)calloc(NUM_ADDRESSES, sizeof(uint8_t));
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    for (unsigned opr = 0; opr < hot->num_opr[idx] && !peep_is_removed(hot, idx); opr++)
+    {
+      st_entry* target = hot->oprtype[opr][idx] == SYMBOL ? st_lookup(st, opl->entries[idx].opr[opr]->svalue) : NULL;
+      if (target == NULL)
+      {
+        continue;
+      }
+      if (!is_load(hot, idx, opr))
+      {
+        taken[target->address] = 1;
+      }
+      else if (literal[target->address] != NO_ENTRY)
+      {
+        unsigned lit = literal[target->address];
+        next_load[idx] = first_load[lit];
+        first_load[lit] = idx;
+      }
+    }
+  }
+
+  // drop the literals of each run of data that has a taken address
+  unsigned begin = 0;
+  bool run_taken = false;
+  for (unsigned idx = 0; idx <= opl->num_entries; idx++)
+  {
+    if (idx < opl->num_entries && (is_data(hot, idx) || peep_is_removed(hot, idx)))
+    {
+      run_taken = run_taken || (is_data(hot, idx) && taken[hot->address[idx]]);
+      continue;
+    }
+    for (unsigned data = begin; run_taken && data < idx; data++)
+    {
+      if (is_literal(opl, data) && literal[hot->address[data]] == data)
+      {
+        literal[hot->address[data]] = NO_ENTRY;
+      }
+    }
+    begin = idx + 1;
+    run_taken = false;
+  }
+  free(taken);
+}
+
+/** @brief literal pool
+ *
+ * Merge each literal into an earlier literal of the same value that all
+ * of its loads reach.  Run after pass one, and the peephole optimizer,
+ * and before `relax()`, the entries and the symbol table get the
+ * addresses of the program without the merged literals.
+ *
+ * @param opl The operation list of pass one.
+ * @param st The symbol table of pass one.
+ *
+ * @returns pool_stats The literals merged and the slots they were merged
+ *   into.
+ */
+pool_stats pool_literals(operation_list* opl, symbol_table* st)
+{
+  opl_hot* hot = &opl->hot;
+  pool_stats stats;
+  memset(&stats, 0, sizeof(stats));
+  if (opl->num_entries == 0)
+  {
+    return stats;
+  }
+
+  unsigned* literal = (unsigned*)malloc(NUM_ADDRESSES * sizeof(unsigned));
+  memset(literal, 0xFF, NUM_ADDRESSES * sizeof(unsigned));
+  unsigned* first_load = (unsigned*)malloc(opl->num_entries * sizeof(unsigned));
+  unsigned* next_load = (unsigned*)malloc(opl->num_entries * sizeof(unsigned));
+  find_literals(opl, st, literal, first_load, next_load);
+
+  // the slots of each value, and whether a literal was merged into a slot
+  unsigned* first_slot = (unsigned*)malloc(NUM_ADDRESSES * sizeof(unsigned));
+  memset(first_slot, 0xFF, NUM_ADDRESSES * sizeof(unsigned));
+  unsigned* next_slot = (unsigned*)malloc(opl->num_entries * sizeof(unsigned));
+  uint8_t* shared = (uint8_t*)calloc(opl->num_entries, sizeof(uint8_t));
+  uint8_t* pinned = peep_pin_numeric_offsets(opl);
+  unsigned first_removed = opl->num_entries;
+
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    // a literal that is never loaded may be used some way the assembler
+    // can not see, it is kept as it is
+    if (!is_literal(opl, idx) || literal[hot->address[idx]] != idx || first_load[idx] == NO_ENTRY)
+    {
+      continue;
+    }
+
+    uint16_t value = hot->value[0][idx];
+    unsigned slot = first_slot[value];
+    while (slot != NO_ENTRY && !reaches(hot, slot, first_load[idx], next_load))
+    {
+      slot = next_slot[slot];
+    }
+    if (slot == NO_ENTRY || (pinned != NULL && pinned[hot->address[idx]]))
+    {
+      next_slot[idx] = first_slot[value];
+      first_slot[value] = idx;
+      continue;
+    }
+
+    point_loads(opl, slot, first_load[idx], next_load);
+    hot->size[idx] = 0;
+    opl->size--;
+    stats.num_merged++;
+    stats.num_slots += !shared[slot];
+    shared[slot] = 1;
+    if (first_removed == opl->num_entries)
+    {
+      first_removed = idx;
+    }
+  }
+
+  if (first_removed < opl->num_entries)
+  {
+    assign_addresses(opl, st, first_removed);
+  }
+
+  free(literal);
+  free(first_load);
+  free(next_load);
+  free(first_slot);
+  free(next_slot);
+  free(shared);
+  free(pinned);
+  return stats;
+}
@@ -0,0 +1,570 @@
+/** @file macro.c
+ * @brief LC-3 Assembler macro preprocessor
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Macro preprocessor, see macro.h.  The lines of an expansion are pushed on
+ * the pending stack in reverse, so they come off it in order, and a line
+ * that uses another macro is replaced on the stack by the lines of that
+ * macro before any line after it is returned.
+ */
+#define _XOPEN_SOURCE 700
+#include "macro.h"
+#include "diagnostic.h"
+#include "include-cache.h"
+#include "opcode.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/** @brief add included file
+ *
+ * Remember that a file was included, by its real path.
+ */
+static void add_included(macro_processor* mp, const char* path)
+{
+  mp->included = (char**)realloc(mp->included, (mp->num_included + 1) * sizeof(char*));
+  mp->included[mp->num_included++] = strdup(path);
+}
+
+/** @brief construct macro preprocessor
+ *
+ * Construct a macro preprocessor that reads the lines of a tokenizer.
+ *
+ * @param tk The tokenizer to read lines from, it is still destructed by
+ *   the caller, after the preprocessor.
+ *
+ * @returns macro_processor* The new preprocessor, with no macros defined.
+ */
+macro_processor* mac_construct(tokenizer* tk)
+{
+  macro_processor* mp = (macro_processor*)calloc(1, sizeof(macro_processor));
+  mp->tk = tk;
+
+  // a file that includes itself is already included, the file of the
+  // tokenizer is always the first one, even if it has no real path
+  char real[PATH_MAX];
+  add_included(mp, realpath(tk->asmfile, real) != NULL ? real : tk->asmfile);
+  return mp;
+}
+
+/** @brief destruct macro preprocessor
+ *
+ * Free the macros, and the line being preprocessed and any expanded lines
+ * that were not returned when an error stopped the assembly, and release
+ * the included files, see `ic_release()`.
+ *
+ * @param mp The preprocessor to destruct.
+ */
+void mac_destruct(macro_processor* mp)
+{
+  for (unsigned idx = 0; idx < mp->num_macros; idx++)
+  {
+    macro* m = &mp->macros[idx];
+    for (unsigned line = 0; line < m->num_lines; line++)
+    {
+      for (int tok = 0; tok < m->lines[line].num_tokens; tok++)
+      {
+        free(m->lines[line].token[tok].text);
+      }
+    }
+    for (unsigned param = 0; param < m->num_params; param++)
+    {
+      free(m->params[param]);
+    }
+    free(m->lines);
+    free(m->name);
+  }
+  for (unsigned idx = 0; idx < mp->num_pending; idx++)
+  {
+    tokens_destruct(mp->pending[idx]);
+  }
+  if (mp->line != NULL)
+  {
+    tokens_destruct(mp->line);
+  }
+  for (unsigned idx = 0; idx < mp->num_included; idx++)
+  {
+    free(mp->included[idx]);
+  }
+  free(mp->included);
+  for (unsigned idx = 0; idx < mp->num_files; idx++)
+  {
+    ic_release(mp->files[idx]);
+  }
+  free(mp->files);
+  free(mp->macros);
+  free(mp->pending);
+  free(mp->depth);
+  free(mp);
+}
+
+/** @brief lookup macro
+ *
+ * @returns macro* The macro with a name, or NULL if no macro of that name
+ *   has been defined.
+ */
+macro* mac_lookup(macro_processor* mp, const char* name)
+{
+  for (unsigned idx = 0; idx < mp->num_macros; idx++)
+  {
+    if (strcmp(mp->macros[idx].name, name) == 0)
+    {
+      return &mp->macros[idx];
+    }
+  }
+  return NULL;
+}
+
+/** @brief is directive
+ *
+ * Check if the first or second token of a line is a macro directive,
+ * .MACRO or .ENDM, in any case.
+ */
+static bool is_directive(tokens* tks, const char* directive)
+{
+  return strcasecmp(tks->token[0], directive) == 0 || (tks->num_tokens > 1 && strcasecmp(tks->token[1], directive) == 0);
+}
+
+/** @brief file of a line
+ *
+ * @returns const char* The name of the file a line is from, to report
+ *   errors on the line in.
+ */
+static const char* line_file(macro_processor* mp, tokens* tks)
+{
+  return tks->file != NULL ? tks->file : mp->tk->asmfile;
+}
+
+/** @brief next raw line
+ *
+ * Take the next line before macros are expanded, the next pending line,
+ * which is a line of an expansion or an included file, or else the next
+ * line of the tokenizer.
+ *
+ * @param mp The preprocessor.
+ * @param depth Returns how deep in expansions the line is.
+ *
+ * @returns tokens* The line, or NULL at the end of the source.
+ */
+static tokens* next_raw_line(macro_processor* mp, unsigned* depth)
+{
+  *depth = 0;
+  if (mp->num_pending > 0)
+  {
+    mp->num_pending--;
+    *depth = mp->depth[mp->num_pending];
+    return mp->pending[mp->num_pending];
+  }
+  return tk_next_line(mp->tk);
+}
+
+/** @brief push pending line
+ *
+ * Push an expanded line on the pending stack.
+ */
+static void push_pending(macro_processor* mp, tokens* tks, unsigned depth)
+{
+  if (mp->num_pending == mp->pending_capacity)
+  {
+    mp->pending_capacity = mp->pending_capacity ? 2 * mp->pending_capacity : 16;
+    mp->pending = (tokens**)realloc(mp->pending, mp->pending_capacity * sizeof(tokens*));
+    mp->depth = (unsigned*)realloc(mp->depth, mp->pending_capacity * sizeof(unsigned));
+  }
+  mp->pending[mp->num_pending] = tks;
+  mp->depth[mp->num_pending++] = depth;
+}
+
+/** @brief add a body line
+ *
+ * Keep a tokenized line as a line of the body of a macro, with the tokens
+ * that name a parameter replaced by the index of the parameter.
+ */
+static void add_body_line(macro* m, tokens* tks)
+{
+  m->lines = (mac_line*)realloc(m->lines, (m->num_lines + 1) * sizeof(mac_line));
+  mac_line* line = &m->lines[m->num_lines++];
+  line->num_tokens = tks->num_tokens;
+  for (int tok = 0; tok < tks->num_tokens; tok++)
+  {
+    mac_token* mt = &line->token[tok];
+    mt->text = NULL;
+    mt->unique = false;
+    for (mt->param = 0; mt->param < m->num_params && strcmp(m->params[mt->param], tks->token[tok]) != 0; mt->param++)
+    {
+    }
+    if (mt->param == m->num_params)
+    {
+      mt->text = strdup(tks->token[tok]);
+      mt->unique = strstr(mt->text, "\\@") != NULL;
+    }
+  }
+}
+
+/** @brief define macro
+ *
+ * Define the macro a .MACRO line starts, reading its body from the
+ * tokenizer up to the .ENDM.  A .MACRO that can not be defined, without a
+ * name or with the name of an opcode or another macro, is reported and its
+ * body is skipped, so the lines of the body are not assembled.
+ *
+ * @param mp The preprocessor.
+ * @param tks The .MACRO line, NAME and then the parameters.
+ */
+static void define_macro(macro_processor* mp, tokens* tks)
+{
+  const char* asmfile = line_file(mp, tks);
+  int first = 0;
+  if (strcasecmp(tks->token[0], ".MACRO") != 0)
+  {
+    diag_error(asmfile, tks->linenum, diag_column(tks->line, tks->token[0]), DIAG_BAD_MACRO,
+      "<macro::define_macro> Error label <%s> on .MACRO", tks->token[0]);
+    first = 1;
+  }
+  macro* m = NULL;
+  const char* name = first + 1 < tks->num_tokens ? tks->token[first + 1] : NULL;
+  if (name == NULL)
+  {
+    diag_error(asmfile, tks->linenum, 0, DIAG_BAD_MACRO, "<macro::define_macro> Error .MACRO without a name");
+  }
+  else if (is_keyword(name) || mac_lookup(mp, name) != NULL)
+  {
+    diag_error(asmfile, tks->linenum, diag_column(tks->line, name), DIAG_BAD_MACRO,
+      "<macro::define_macro> Error macro name <%s> is already an opcode or macro", name);
+  }
+  else
+  {
+    if (mp->num_macros == mp->capacity)
+    {
+      mp->capacity = mp->capacity ? 2 * mp->capacity : 8;
+      mp->macros = (macro*)realloc(mp->macros, mp->capacity * sizeof(macro));
+    }
+    m = &mp->macros[mp->num_macros++];
+    memset(m, 0, sizeof(macro));
+    m->name = strdup(name);
+    for (int tok = first + 2; tok < tks->num_tokens; tok++)
+    {
+      m->params[m->num_params++] = strdup(tks->token[tok]);
+    }
+  }
+
+  // the body is the raw lines up to the .ENDM, macros are not expanded
+  // until the macro is used, and the body must end in the same file
+  tokens* line;
+  unsigned depth;
+  while ((line = next_raw_line(mp, &depth)) != NULL && line->file == tks->file && !is_directive(line, ".ENDM"))
+  {
+    if (is_directive(line, ".MACRO"))
+    {
+      unsigned linenum = line->linenum;
+      tokens_destruct(line);
+      diag_error(asmfile, linenum, 0, DIAG_BAD_MACRO, "<macro::define_macro> Error .MACRO inside macro <%s>",
+        name != NULL ? name : "");
+      continue;
+    }
+    if (m != NULL)
+    {
+      add_body_line(m, line);
+    }
+    tokens_destruct(line);
+  }
+  if (line == NULL || line->file != tks->file)
+  {
+    // the line of another file is not part of the body, it is preprocessed
+    // as usual after the error
+    if (line != NULL)
+    {
+      push_pending(mp, line, depth);
+    }
+    diag_error(asmfile, tks->linenum, 0, DIAG_BAD_MACRO, "<macro::define_macro> Error macro <%s> has no .ENDM",
+      name != NULL ? name : "");
+    return;
+  }
+  tokens_destruct(line);
+}
+
+/** @brief find use of a macro
+ *
+ * @param mp The preprocessor.
+ * @param tks A line.
+ * @param name_pos Returns the index of the token that names the macro.
+ *
+ * @returns macro* The macro the line uses, or NULL if it is not a use of
+ *   a macro.
+ */
+static macro* find_use(macro_processor* mp, tokens* tks, int* name_pos)
+{
+  macro* m = mac_lookup(mp, tks->token[0]);
+  *name_pos = 0;
+  if (m == NULL && tks->num_tokens > 1 && !is_keyword(tks->token[0]))
+  {
+    m = mac_lookup(mp, tks->token[1]);
+    *name_pos = 1;
+  }
+  return m;
+}
+
+/** @brief replace unique markers
+ *
+ * @returns char* A new copy of a token with each \@ replaced by the
+ *   number of the use of the macro.
+ */
+static char* unique_text(const char* text, unsigned number)
+{
+  char digits[16];
+  int num_digits = snprintf(digits, sizeof(digits), "%u", number);
+  char* result = (char*)malloc(strlen(text) * num_digits + 1);
+  char* out = result;
+  while (*text)
+  {
+    if (text[0] == '\\' && text[1] == '@')
+    {
+      memcpy(out, digits, num_digits);
+      out += num_digits;
+      text += 2;
+    }
+    else
+    {
+      *out++ = *text++;
+    }
+  }
+  *out = '\0';
+  return result;
+}
+
+/** @brief expand macro
+ *
+ * Make the lines of the body of a macro for a line that uses it, and push
+ * them on the pending stack.
+ *
+ * @param mp The preprocessor.
+ * @param m The macro.
+ * @param tks The line that uses the macro.
+ * @param name_pos The index of the token that names the macro, after the
+ *   label of the line if it has one.
+ * @param depth How deep in expansions the lines of the body are.
+ */
+static void expand_macro(macro_processor* mp, macro* m, tokens* tks, int name_pos, unsigned depth)
+{
+  const char* asmfile = line_file(mp, tks);
+  unsigned column = diag_column(tks->line, tks->token[name_pos]);
+  unsigned num_args = tks->num_tokens - name_pos - 1;
+  if (num_args != m->num_params)
+  {
+    diag_error(asmfile, tks->linenum, column, DIAG_BAD_MACRO,
+      "<macro::expand_macro> Error macro <%s> takes <%u> arguments, not <%u>", m->name, m->num_params, num_args);
+    return;
+  }
+  if (depth > MACRO_MAX_DEPTH)
+  {
+    diag_error(asmfile, tks->linenum, column, DIAG_BAD_MACRO,
+      "<macro::expand_macro> Error macro <%s> is expanded more than <%d> deep", m->name, MACRO_MAX_DEPTH);
+    return;
+  }
+  const char* label = name_pos == 1 ? tks->token[0] : NULL;
+  if (label != NULL && m->num_lines == 0)
+  {
+    diag_error(asmfile, tks->linenum, diag_column(tks->line, label), DIAG_BAD_MACRO,
+      "<macro::expand_macro> Error label <%s> on macro <%s> with no lines", label, m->name);
+    return;
+  }
+  char** args = &tks->token[name_pos + 1];
+  unsigned number = ++mp->num_expansions;
+
+  for (unsigned line = m->num_lines; line-- > 0;)
+  {
+    mac_line* ml = &m->lines[line];
+    tokens* exp = (tokens*)malloc(sizeof(tokens));
+    exp->line = strdup(tks->line);
+    exp->linenum = tks->linenum;
+    exp->offset = tks->offset;
+    exp->length = tks->length;
+    exp->file = tks->file;
+    exp->num_tokens = 0;
+
+    // the label of the use goes on the first line of the body, which must
+    // not have a label of its own, else the body is expanded without it
+    if (line == 0 && label != NULL)
+    {
+      const char* first = ml->token[0].text != NULL ? ml->token[0].text : args[ml->token[0].param];
+      if ((!is_keyword(first) && mac_lookup(mp, first) == NULL) || ml->num_tokens == 5)
+      {
+        // the line is on the stack while the error is reported, so it is
+        // freed if the error stops the assembly
+        push_pending(mp, exp, depth);
+        diag_error(asmfile, tks->linenum, diag_column(tks->line, label), DIAG_BAD_MACRO,
+          "<macro::expand_macro> Error label <%s> on macro <%s> whose first line has a label", label, m->name);
+        mp->num_pending--;
+      }
+      else
+      {
+        exp->token[exp->num_tokens++] = strdup(label);
+      }
+    }
+
+    for (int tok = 0; tok < ml->num_tokens; tok++)
+    {
+      mac_token* mt = &ml->token[tok];
+      if (mt->text == NULL)
+      {
+        exp->token[exp->num_tokens++] = strdup(args[mt->param]);
+      }
+      else
+      {
+        exp->token[exp->num_tokens++] = mt->unique ? unique_text(mt->text, number) : strdup(mt->text);
+      }
+    }
+    push_pending(mp, exp, depth);
+  }
+}
+
+/** @brief path of an included file
+ *
+ * Find the path of a file named by a line of an assembly file, for
+ * .INCLUDE and .INCBIN.  A relative name is relative to the directory of
+ * the assembly file, not to the directory the assembler runs in.
+ *
+ * @param asmfile The assembly file of the line.
+ * @param name The name of the included file, without quotes.
+ * @param path Returns the path of the included file.
+ * @param size The size of the path buffer.
+ */
+void mac_include_path(const char* asmfile, const char* name, char* path, size_t size)
+{
+  const char* slash = strrchr(asmfile, '/');
+  if (name[0] == '/' || slash == NULL)
+  {
+    snprintf(path, size, "%s", name);
+  }
+  else
+  {
+    snprintf(path, size, "%.*s/%s", (int)(slash - asmfile), asmfile, name);
+  }
+}
+
+/** @brief include file
+ *
+ * Push the lines of the file an .INCLUDE names on the pending stack, from
+ * the include cache, unless the file was already included.  A relative
+ * name is found from the directory of the file of the .INCLUDE.
+ *
+ * @param mp The preprocessor.
+ * @param tks The .INCLUDE line.
+ * @param depth How deep in expansions the .INCLUDE is.
+ */
+static void include_file(macro_processor* mp, tokens* tks, unsigned depth)
+{
+  const char* asmfile = line_file(mp, tks);
+  if (strcasecmp(tks->token[0], ".INCLUDE") != 0)
+  {
+    diag_error(asmfile, tks->linenum, diag_column(tks->line, tks->token[0]), DIAG_BAD_INCLUDE,
+      "<macro::include_file> Error label <%s> on .INCLUDE", tks->token[0]);
+    return;
+  }
+  if (tks->num_tokens != 2)
+  {
+    diag_error(asmfile, tks->linenum, 0, DIAG_BAD_INCLUDE, "<macro::include_file> Error .INCLUDE needs one file name");
+    return;
+  }
+
+  // the name may be quoted, and is relative to the including file
+  char* name = tks->token[1];
+  size_t length = strlen(name);
+  if (length >= 2 && name[0] == '"' && name[length - 1] == '"')
+  {
+    name[length - 1] = '\0';
+    name++;
+  }
+  char path[PATH_MAX];
+  mac_include_path(asmfile, name, path, sizeof(path));
+
+  ic_file* file = ic_load(path);
+  if (file == NULL)
+  {
+    diag_error(asmfile, tks->linenum, diag_column(tks->line, name), DIAG_BAD_INCLUDE,
+      "<macro::include_file> Error could not read included file <%s>", path);
+    return;
+  }
+  for (unsigned idx = 0; idx < mp->num_included; idx++)
+  {
+    if (strcmp(mp->included[idx], file->path) == 0)
+    {
+      ic_release(file);
+      return;
+    }
+  }
+  add_included(mp, file->path);
+  mp->files = (ic_file**)realloc(mp->files, (mp->num_files + 1) * sizeof(ic_file*));
+  mp->files[mp->num_files++] = file;
+
+  for (unsigned line = file->num_lines; line-- > 0;)
+  {
+    push_pending(mp, ic_copy_line(file, line), depth);
+  }
+}
+
+/** @brief next preprocessed line
+ *
+ * Return the next line for pass one, like `tk_next_line()`, with the
+ * macros defined and expanded.
+ *
+ * @param mp The preprocessor.
+ *
+ * @returns tokens* The next line, destructed by the caller with
+ *   `tokens_destruct()`, or NULL at the end of the source.
+ */
+tokens* mac_next_line(macro_processor* mp)
+{
+  while (true)
+  {
+    unsigned depth;
+    tokens* tks = next_raw_line(mp, &depth);
+    if (tks == NULL)
+    {
+      return NULL;
+    }
+
+    if (is_directive(tks, ".INCLUDE"))
+    {
+      mp->line = tks;
+      include_file(mp, tks, depth);
+      mp->line = NULL;
+      tokens_destruct(tks);
+      continue;
+    }
+
+    // a body can not have a definition, so they are never expanded lines
+    if (is_directive(tks, ".MACRO"))
+    {
+      mp->line = tks;
+      define_macro(mp, tks);
+      mp->line = NULL;
+      tokens_destruct(tks);
+      continue;
+    }
+    if (is_directive(tks, ".ENDM"))
+    {
+      mp->line = tks;
+      diag_error(line_file(mp, tks), tks->linenum, 0, DIAG_BAD_MACRO,
+        "<macro::mac_next_line> Error .ENDM without .MACRO");
+      mp->line = NULL;
+      tokens_destruct(tks);
+      continue;
+    }
+
+    int name_pos;
+    macro* m = mp->num_macros > 0 ? find_use(mp, tks, &name_pos) : NULL;
+    if (m == NULL)
+    {
+      return tks;
+    }
+    mp->line = tks;
+    expand_macro(mp, m, tks, name_pos, depth + 1);
+    mp->line = NULL;
+    tokens_destruct(tks);
+  }
+}
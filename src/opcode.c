@@ -17,6 +17,7 @@
 #define __STDC_WANT_LIB_EXT2__ 1
 #include "opcode.h"
 #include "assembler.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -56,6 +57,86 @@ void opc_destruct(opcode* opc)
   free(opc);
 }
 
+/// An opcode keyword, and the opcode type, BR flags and variant that
+/// the keyword translates into.
+typedef struct opc_keyword
+{
+  const char* keyword;
+  opctype opc;
+  uint16_t flags;
+  uint16_t variant;
+} opc_keyword;
+
+/// All LC-3 opcode keywords that we recognize in the assembler.  Keywords
+/// are matched ignoring case, so `add`, `Add` and `ADD` are all the same opcode.
+#define NUM_KEYWORDS (sizeof(keywords) / sizeof(keywords[0]))
+static const opc_keyword keywords[] = {
+  {"BRn", BR, FN, 0},
+  {"BRz", BR, FZ, 0},
+  {"BRp", BR, FP, 0},
+  {"BRnz", BR, FN | FZ, 0},
+  {"BRnp", BR, FN | FP, 0},
+  {"BRzp", BR, FZ | FP, 0},
+  {"BRnzp", BR, FN | FZ | FP, 0},
+  {"ADD", ADD, 0, 0},
+  {"LD", LD, 0, 0},
+  {"ST", ST, 0, 0},
+  {"JSR", JSR, 0, 1},
+  {"JSRR", JSR, 0, 0},
+  {"AND", AND, 0, 0},
+  {"LDR", LDR, 0, 0},
+  {"STR", STR, 0, 0},
+  {"RTI", RTI, 0, 0},
+  {"NOT", NOT, 0, 0},
+  {"LDI", LDI, 0, 0},
+  {"STI", STI, 0, 0},
+  {"JMP", JMP, 0, 0},
+  {"RET", JMP, 0, 1},
+  {"RESERVED", RESERVED, 0, 0},
+  {"LEA", LEA, 0, 0},
+  {"TRAP", TRAP, 0, 0},
+  {".ORIG", ORIG, 0, 0},
+  {".END", END, 0, 0},
+  {".BLKW", BLKW, 0, 0},
+  {".FILL", FILL, 0, 0},
+  {".STRINGZ", STRINGZ, 0, 0},
+  {".INCBIN", INCBIN, 0, 0},
+  {".INCBINBE", INCBIN, 0, 1},
+};
+
+/** @brief find keyword
+ *
+ * Search the table of opcode keywords for the given token.
+ * The search folds ASCII case as it compares, so no lowercased copy
+ * of the token is made.  Keywords are all at least 2 characters long
+ * and are either letters or begin with `.`, so we reject most label
+ * and operand tokens on their first character before scanning the table.
+ *
+ * @param token The token to look up in the keyword table.
+ *
+ * @returns const opc_keyword* The matching keyword table entry, or NULL
+ *   if the token is not an opcode/pseudo opcode keyword.
+ */
+static const opc_keyword* find_keyword(const char* token)
+{
+  // fold the first character once so we only compare against keywords that
+  // could possibly match
+  char first = token[0];
+  if (first >= 'a' && first <= 'z')
+  {
+    first -= 0x20;
+  }
+
+  for (int i = 0; i < NUM_KEYWORDS; i++)
+  {
+    if (keywords[i].keyword[0] == first && match_nocase(token, keywords[i].keyword))
+    {
+      return &keywords[i];
+    }
+  }
+  return NULL;
+}
+
 /** @brief extract opcode
  *
  * In the LC-3 assembley all valid lines have to have 1 opcode or
@@ -69,168 +150,92 @@ void opc_destruct(opcode* opc)
  *   processed.
  *
  * @returns opcode* Returns the extracted opcode information as an opcode
- *   object for processing by the assembler.
+ *   object for processing by the assembler, or NULL if the line has no
+ *   opcode and the error was recorded in the diagnostic sink.
  */
 opcode* extract_opcode(tokens* tks)
 {
-  char* opcode_keyword;
-  if (is_keyword(tks->token[0]))
+  const char* token = tks->token[0];
+  const opc_keyword* keyword = find_keyword(token);
+  if (keyword == NULL && tks->num_tokens > 1)
   {
-    opcode_keyword = tks->token[0];
+    keyword = find_keyword(tks->token[1]);
+    token = tks->token[1];
   }
-  else if (is_keyword(tks->token[1]))
+
+  // opcode should be in either first or second token, if not the line is
+  // skipped, the unknown opcode is the first token unless it is a label
+  // at the start of the line
+  if (keyword == NULL)
   {
-    opcode_keyword = tks->token[1];
+    unsigned column = diag_column(tks->line, tks->token[0]);
+    if (column == 1 && tks->num_tokens > 1)
+    {
+      column = diag_column(tks->line, tks->token[1]);
+    }
+    diag_error(NULL, 0, column, DIAG_UNKNOWN_OPCODE,
+      "<opcode::extract_opcode> Error: did not find opcode token on line <%s> <%s>", tks->token[0],
+      tks->num_tokens > 1 ? tks->token[1] : "");
+    return NULL;
   }
-  // opcode should be in either first or second token,
-  // if not we just throw an error and stop
-  else
+
+  // RESERVED is a keyword so it can't be a label, but it is not an operation we can assemble
+  if (keyword->opc == RESERVED)
   {
-    fprintf(stderr, "<opcode::extract_opcode> Error: did not find opcode token on line <%s> <%s>\n", tks->token[0], tks->token[1]);
-    exit(1);
+    diag_error(NULL, 0, diag_column(tks->line, token), DIAG_UNKNOWN_OPCODE,
+      "<opcode::extract_opcode> Error: did not find token on line, token <%s>", keyword->keyword);
+    return NULL;
   }
 
   // create an opcode instance to hold the extracted opcode information
   opcode* opc = opc_construct();
+  opc->opc = keyword->opc;
+  opc->flags = keyword->flags;
+  opc->variant = keyword->variant;
 
-  // is there a better way to do this?  for now brute
-  // force it
-  if (match(opcode_keyword, "BR"))
-  {
-    opc->opc = BR;
-    opc->flags = 0x00;
-  }
-  else if (match(opcode_keyword, "BRn"))
-  {
-    opc->opc = BR;
-    opc->flags |= FN;
-  }
-  else if (match(opcode_keyword, "BRz"))
-  {
-    opc->opc = BR;
-    opc->flags |= FZ;
-  }
-  else if (match(opcode_keyword, "BRp"))
-  {
-    opc->opc = BR;
-    opc->flags |= FP;
-  }
-  else if (match(opcode_keyword, "BRnz"))
-  {
-    opc->opc = BR;
-    opc->flags |= (FN | FZ);
-  }
-  else if (match(opcode_keyword, "BRnp"))
-  {
-    opc->opc = BR;
-    opc->flags |= (FN | FP);
-  }
-  else if (match(opcode_keyword, "BRzp"))
-  {
-    opc->opc = BR;
-    opc->flags |= (FZ | FP);
-  }
-  else if (match(opcode_keyword, "BRnzp"))
-  {
-    opc->opc = BR;
-    opc->flags |= (FN | FZ | FP);
-  }
-  else if (match(opcode_keyword, "ADD"))
-  {
-    opc->opc = ADD;
-  }
-  else if (match(opcode_keyword, "LD"))
-  {
-    opc->opc = LD;
-  }
-  else if (match(opcode_keyword, "ST"))
-  {
-    opc->opc = ST;
-  }
-  else if (match(opcode_keyword, "JSR"))
-  {
-    opc->opc = JSR;
-    opc->variant = 1;
-  }
-  else if (match(opcode_keyword, "JSRR"))
-  {
-    opc->opc = JSR;
-    opc->variant = 0;
-  }
-  else if (match(opcode_keyword, "AND"))
-  {
-    opc->opc = AND;
-  }
-  else if (match(opcode_keyword, "LDR"))
-  {
-    opc->opc = LDR;
-  }
-  else if (match(opcode_keyword, "STR"))
-  {
-    opc->opc = STR;
-  }
-  else if (match(opcode_keyword, "RTI"))
-  {
-    opc->opc = RTI;
-  }
-  else if (match(opcode_keyword, "NOT"))
-  {
-    opc->opc = NOT;
-  }
-  else if (match(opcode_keyword, "LDI"))
-  {
-    opc->opc = LDI;
-  }
-  else if (match(opcode_keyword, "STI"))
-  {
-    opc->opc = STI;
-  }
-  else if (match(opcode_keyword, "JMP"))
-  {
-    opc->opc = JMP;
-    opc->variant = 0;
-  }
-  else if (match(opcode_keyword, "RET"))
-  {
-    opc->opc = JMP;
-    opc->variant = 1;
-  }
-  else if (match(opcode_keyword, "LEA"))
-  {
-    opc->opc = LEA;
-  }
-  else if (match(opcode_keyword, "TRAP"))
-  {
-    opc->opc = TRAP;
-  }
-  else if (match(opcode_keyword, ".ORIG"))
-  {
-    opc->opc = ORIG;
-  }
-  else if (match(opcode_keyword, ".END"))
-  {
-    opc->opc = END;
-  }
-  else if (match(opcode_keyword, ".BLKW"))
-  {
-    opc->opc = BLKW;
-  }
-  else if (match(opcode_keyword, ".FILL"))
-  {
-    opc->opc = FILL;
-  }
-  else if (match(opcode_keyword, ".STRINGZ"))
-  {
-    opc->opc = STRINGZ;
-  }
-  // actually the first test using is_keyword should catch, but check again
-  else
+  return opc;
+}
+
+/** @brief opcode cycles
+ *
+ * The number of clock cycles an LC-3 instruction takes through the states
+ * of the LC-3 microarchitecture state machine, the 4 states that fetch and
+ * decode it and the states that execute it, counting each memory access
+ * as a single cycle.  A BR is counted as not taken, a taken branch takes
+ * one more cycle to load the PC.
+ *
+ * @param opc The opcode of the instruction.
+ *
+ * @returns unsigned The cycles of the instruction, 0 for the pseudo
+ *   opcodes, which are not executed.
+ */
+unsigned opc_cycles(opctype opc)
+{
+  switch (opc)
   {
-    fprintf(stderr, "<opcode::extract_opcode> Error: did not find token on line, token <%s>\n", opcode_keyword);
-    exit(1);
+  case ADD:
+  case AND:
+  case NOT:
+  case BR:
+  case JMP:
+  case LEA:
+    return 5;
+  case JSR:
+    return 6;
+  case LD:
+  case LDR:
+  case ST:
+  case STR:
+  case TRAP:
+    return 7;
+  case LDI:
+  case STI:
+    return 9;
+  case RTI:
+    return 11;
+  default:
+    return 0;
   }
-
-  return opc;
 }
 
 /** @brief opcode to string
@@ -312,33 +317,26 @@ const char* opc_str(opcode* opc)
     return ".FILL";
   case STRINGZ:
     return ".STRINGZ";
+  case INCBIN:
+    if (opc->variant == 0)
+      return ".INCBIN";
+    else
+      return ".INCBINBE";
   default:
     return "UNK";
   }
 }
 
-/// All LC-3 opcode keywords that we recognize in the assembler
-#define NUM_KEYWORDS (sizeof(keywords) / sizeof(keywords[0]))
-static const char* keywords[] = {"BRn", "BRz", "BRp", "BRnz", "BRnp", "BRzp", "BRnzp", "ADD", "LD", "ST", "JSR", "JSRR", "AND", "LDR",
-  "STR", "RTI", "NOT", "LDI", "STI", "JMP", "RET", "RESERVED", "LEA", "TRAP", ".ORIG", ".END", ".BLKW", ".FILL", ".STRINGZ"};
-
 /** @brief is keyword
  *
  * Check if a token is a keyword or not.  Keywords indicate
- * an opcode or a pseudo opcode for the assembler.
+ * an opcode or a pseudo opcode for the assembler.  Keywords
+ * are recognized regardless of case.
  *
  * @param token The token to test if it is an opcode/pseudo
  *   opcode keyword.
  */
 bool is_keyword(const char* token)
 {
-  // task 3 implementation goes here
-  for (int i = 0; i < NUM_KEYWORDS; i++)
-  {
-    if (strcmp(token, keywords[i]) == 0)
-    {
-      return true;
-    }
-  }
-  return false;
+  return find_keyword(token) != NULL;
 }
@@ -124,9 +124,8 @@ operand* extract_operand(tokens* tks, int tk_pos)
 void extract_register(operand* opr)
 {
   opr->opr = REGISTER;
-  // TODO: should we be more defensive, what if this fails?  Will usually
-  // end up with register value of 0;
-  opr->value = atoi(&(opr->token[1]));
+  // is_register() has already checked the token is exactly R0-R7 / r0-r7
+  opr->value = opr->token[1] - '0';
 }
 
 /** @brief extract string operand
@@ -244,13 +243,13 @@ const char* opr_str(operand* opr)
 
 /** @brief test if token is a register operand
  *
- * Any token that starts with a "R" will be treated as a
- * register operand.
+ * Only the tokens R0 through R7 (in either case) are register
+ * operands.  Anything else that begins with an R, like a RESULT
+ * label, is not a register.
  */
 bool is_register(const char* token)
 {
-  // task 4 part 1 goes here
-  return token[0] == 'R';
+  return (token[0] | 0x20) == 'r' && (unsigned)(token[1] - '0') < 8 && token[2] == '\0';
 }
 
 /** @brief test if token is a string literal
@@ -1,5 +1,5 @@
 /** @file operation-list.c
- * @brief linked list of parsed assembly operations
+ * @brief list of parsed assembly operations
  *
  * @author Student Name
  * @note   cwid: 123456
@@ -14,22 +14,37 @@
  * calculate their offsets, and then determine the size of each operation
  * to finish the assembly process.
  *
- * Implemented as a basic linked list of opl_entry structures.  There will be one
- * opl_entry per each line in the input assembly file that contains an opcode/psedo opcode.
+ * Implemented as a growable, index addressed array.  There will be one entry
+ * per each line in the input assembly file that contains an opcode/psedo opcode.
+ * The fields pass two and the binary writer use, the opcode, address, size,
+ * operand types and values and the assembled instruction, are kept in the
+ * parallel arrays of opl_hot, one element per entry.  The cold opl_entry array
+ * holds the label, line number, source reference and parsed operands of each
+ * line.  Both grow together, an entry is the same index into all of them.
  */
 #define __STDC_WANT_LIB_EXT2__ 1
+#define _POSIX_C_SOURCE 200809L
 #include "operation-list.h"
+#include "diagnostic.h"
 #include "operand.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// The number of entries allocated when the first entry is appended,
+/// the list doubles in capacity whenever it fills up after that
+#define INITIAL_CAPACITY 64
 
 /** @brief construct operation_list
  *
  * Construct a new operation list.  We dynamically allocate
  * and return a operation_list structure and initialize
- * it.  Initially the list is empty and all pointers of the
- * linked list point to NULL.
+ * it.  Initially the list is empty and no entry or field arrays are
+ * allocated, they are allocated when the first entry is appended.
  *
  * @returns operation_list* Returns pointer to newly allocated
  *   and initialized operation list.
@@ -37,151 +52,595 @@
 operation_list* opl_construct()
 {
 
-  // allocate the operation list and initialize basic parameters
-  operation_list* opl = (operation_list*)malloc(sizeof(operation_list));
+  // allocate the operation list and initialize basic parameters, calloc
+  // leaves all of the entry and field array pointers NULL
+  operation_list* opl = (operation_list*)calloc(1, sizeof(operation_list));
 
   opl->num_entries = 0;
+  opl->capacity = 0;
   opl->size = 0;
-  opl->front = opl->back = opl->current = NULL;
+  opl->num_files = 0;
 
   return opl;
 }
 
 /** @brief destruct operation_list
  *
- * Destruct an operation list.  Deallocate all opl_entry in list
- * then deallocate the top-level object.
+ * Destruct an operation list.  Deallocate the memory held by all entries,
+ * the entry and field arrays, then deallocate the top-level object.
  *
  * @param opl A pointer to the dynamically allocated operation_list
  *   that should be destroyed.
  */
 void opl_destruct(operation_list* opl)
 {
-  // first traverse the list to deallocate all entries
-  opl_entry* current = opl_begin(opl);
-  while (current)
+  // first deallocate the memory each cold entry holds on to, and the file
+  // table names
+  opl_clear(opl);
+
+  // then the entry and hot field arrays themselves
+  free(opl->entries);
+  free(opl->hot.opc);
+  free(opl->hot.flags);
+  free(opl->hot.variant);
+  free(opl->hot.num_opr);
+  for (int opr = 0; opr < 3; opr++)
   {
+    free(opl->hot.oprtype[opr]);
+    free(opl->hot.value[opr]);
+  }
+  free(opl->hot.address);
+  free(opl->hot.size);
+  free(opl->hot.format);
+  free(opl->hot.base);
+  free(opl->hot.inst);
+
+  // and the file and binary tables
+  free(opl->files);
+  free(opl->binaries);
+
+  // once all entries are deallocated, free the operation_list itself
+  free(opl);
+}
+
+/** @brief clear operation_list
+ *
+ * Remove all entries and files from an operation list, so it can be used
+ * for another assembly.  The memory held by the entries is freed, but the
+ * entry and field arrays are kept at their current capacity, so a list
+ * that is reused does not need to grow again.
+ *
+ * @param opl A pointer to the operation list to clear.
+ */
+void opl_clear(operation_list* opl)
+{
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    opl_entry* entry = &opl->entries[idx];
+
     // deallocate the string labels that were duplicated
-    free(current->line);
-    free(current->label);
-    opc_destruct(current->opc);
+    free(entry->label);
+    opc_destruct(entry->opc);
 
     // deallocate the operands here
-    for (int idx = 0; idx < current->num_opr; idx++)
+    for (int opr = 0; opr < entry->num_opr; opr++)
+    {
+      opr_destruct(entry->opr[opr]);
+    }
+  }
+
+  for (unsigned file = 0; file < opl->num_files; file++)
+  {
+    free(opl->files[file].name);
+  }
+  for (unsigned binary = 0; binary < opl->num_binaries; binary++)
+  {
+    if (opl->binaries[binary].length > 0)
     {
-      opr_destruct(current->opr[idx]);
+      munmap((void*)opl->binaries[binary].bytes, opl->binaries[binary].length);
     }
+    free(opl->binaries[binary].name);
+  }
+
+  opl->num_entries = 0;
+  opl->size = 0;
+  opl->num_files = 0;
+  opl->num_binaries = 0;
+}
 
-    // deallocate this entry
-    free(current);
+/** @brief grow an array
+ *
+ * Reallocate one of the entry or hot field arrays to a new capacity,
+ * exiting with an error if we run out of memory.
+ *
+ * @param array The array to reallocate, may be NULL if not yet allocated.
+ * @param capacity The new number of elements the array should hold.
+ * @param elem_size The size in bytes of each element of the array.
+ *
+ * @returns void* The reallocated array.
+ */
+static void* opl_grow_array(void* array, unsigned capacity, size_t elem_size)
+{
+  array = realloc(array, capacity * elem_size);
+  if (array == NULL)
+  {
+    diag_fatal(NULL, 0, "<operation_list::opl_grow_array> error allocating <%u> entries", capacity);
+  }
+  return array;
+}
 
-    // go to next entry
-    current = opl_next(opl);
+/** @brief grow operation_list
+ *
+ * Double the capacity of the list, growing the cold entry array and all
+ * of the hot field arrays together so the same index is valid in all
+ * of them.
+ *
+ * @param opl A pointer to the operation list that is full.
+ */
+static void opl_grow(operation_list* opl)
+{
+  unsigned capacity = opl->capacity ? opl->capacity * 2 : INITIAL_CAPACITY;
+
+  opl->entries = (opl_entry*)opl_grow_array(opl->entries, capacity, sizeof(opl_entry));
+  opl->hot.opc = (uint8_t*)opl_grow_array(opl->hot.opc, capacity, sizeof(uint8_t));
+  opl->hot.flags = (uint8_t*)opl_grow_array(opl->hot.flags, capacity, sizeof(uint8_t));
+  opl->hot.variant = (uint8_t*)opl_grow_array(opl->hot.variant, capacity, sizeof(uint8_t));
+  opl->hot.num_opr = (uint8_t*)opl_grow_array(opl->hot.num_opr, capacity, sizeof(uint8_t));
+  for (int opr = 0; opr < 3; opr++)
+  {
+    opl->hot.oprtype[opr] = (uint8_t*)opl_grow_array(opl->hot.oprtype[opr], capacity, sizeof(uint8_t));
+    opl->hot.value[opr] = (uint16_t*)opl_grow_array(opl->hot.value[opr], capacity, sizeof(uint16_t));
   }
+  opl->hot.address = (uint16_t*)opl_grow_array(opl->hot.address, capacity, sizeof(uint16_t));
+  opl->hot.size = (uint16_t*)opl_grow_array(opl->hot.size, capacity, sizeof(uint16_t));
+  opl->hot.format = (uint8_t*)opl_grow_array(opl->hot.format, capacity, sizeof(uint8_t));
+  opl->hot.base = (uint16_t*)opl_grow_array(opl->hot.base, capacity, sizeof(uint16_t));
+  opl->hot.inst = (uint16_t*)opl_grow_array(opl->hot.inst, capacity, sizeof(uint16_t));
 
-  // once all entries are deallocated, free the operation_list itself
-  free(opl);
+  opl->capacity = capacity;
+}
+
+/** @brief add an assembly file
+ *
+ * Add the name of an assembly file that entries will be read from to
+ * the file table of the list.  Entries refer to the file they came from
+ * by the returned index, so that their source line can be reread from the
+ * file when needed.
+ *
+ * @param opl A pointer to the operation list to add the file to.
+ * @param asmfile The name of the assembly file.
+ *
+ * @returns unsigned The index of the file in the file table.
+ */
+unsigned opl_add_file(operation_list* opl, const char* asmfile)
+{
+  return opl_add_source(opl, asmfile, NULL, 0);
+}
+
+/** @brief add an in memory assembly source
+ *
+ * Add an assembly source that is held in memory to the file table of the
+ * list.  The source is not copied, it must stay valid as long as source
+ * lines of its entries may be needed.
+ *
+ * @param opl A pointer to the operation list to add the source to.
+ * @param name The name to report the source as in diagnostics.
+ * @param source The assembly source text, or NULL if the source is
+ *   the file called name.
+ * @param length The length of the source text.
+ *
+ * @returns unsigned The index of the source in the file table.
+ */
+unsigned opl_add_source(operation_list* opl, const char* name, const char* source, size_t length)
+{
+  // the file table doubles when it is full, so its capacity is always the
+  // next power of two, an incremental assembly adds a source per line
+  unsigned num_files = opl->num_files;
+  if ((num_files & (num_files - 1)) == 0)
+  {
+    opl->files = (opl_file*)opl_grow_array(opl->files, num_files ? 2 * num_files : 1, sizeof(opl_file));
+  }
+  opl->files[opl->num_files].name = strdup(name);
+  opl->files[opl->num_files].source = source;
+  opl->files[opl->num_files].length = length;
+  return opl->num_files++;
+}
+
+/** @brief change source of a file
+ *
+ * Point an entry of the file table at different source text held in
+ * memory, so a file slot can be reused for new source.  The source is not
+ * copied.
+ *
+ * @param opl The operation list.
+ * @param file The index of the file in the file table.
+ * @param source The new source text.
+ * @param length The length of the source text.
+ */
+void opl_set_source(operation_list* opl, unsigned file, const char* source, size_t length)
+{
+  opl->files[file].source = source;
+  opl->files[file].length = length;
+}
+
+/** @brief file name of an entry
+ *
+ * @param opl The operation list holding the entry.
+ * @param idx The index of the entry.
+ *
+ * @returns const char* The name of the file the entry was read from, or
+ *   NULL if the assembler was built with NO_SOURCE_LINES.
+ */
+const char* opl_file_name(operation_list* opl, unsigned idx)
+{
+#ifndef NO_SOURCE_LINES
+  return opl->files[opl->entries[idx].file].name;
+#else
+  return NULL;
+#endif
+}
+
+/** @brief add a binary file
+ *
+ * Map a binary file of an .INCBIN into memory and add it to the binary
+ * table of the list.  A file that is already in the table is only mapped
+ * once, for all of the .INCBINs of it.
+ *
+ * @param opl A pointer to the operation list to add the file to.
+ * @param path The path of the binary file.
+ *
+ * @returns int The index of the file in the binary table, or -1 if the
+ *   file can not be mapped.
+ */
+int opl_add_binary(operation_list* opl, const char* path)
+{
+  for (unsigned binary = 0; binary < opl->num_binaries; binary++)
+  {
+    if (strcmp(opl->binaries[binary].name, path) == 0)
+    {
+      return binary;
+    }
+  }
+
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return -1;
+  }
+
+  // an empty file can not be mapped, and has no words to write anyway
+  const uint8_t* bytes = NULL;
+  if (st.st_size > 0)
+  {
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+      close(fd);
+      return -1;
+    }
+    bytes = (const uint8_t*)map;
+  }
+  close(fd);
+
+  // the binary table grows like the file table
+  unsigned num_binaries = opl->num_binaries;
+  if ((num_binaries & (num_binaries - 1)) == 0)
+  {
+    opl->binaries =
+      (opl_binary*)opl_grow_array(opl->binaries, num_binaries ? 2 * num_binaries : 1, sizeof(opl_binary));
+  }
+  opl->binaries[num_binaries].name = strdup(path);
+  opl->binaries[num_binaries].bytes = bytes;
+  opl->binaries[num_binaries].length = st.st_size;
+  opl->num_binaries++;
+  return num_binaries;
+}
+
+/** @brief bytes of an .INCBIN entry
+ *
+ * @param opl The operation list holding the entry.
+ * @param idx The index of the .INCBIN entry.
+ *
+ * @returns const uint8_t* The bytes of the words of the entry in the
+ *   mapping of its binary file, from the offset of the entry on.
+ */
+const uint8_t* opl_binary_bytes(operation_list* opl, unsigned idx)
+{
+  opl_binary* binary = &opl->binaries[opl->entries[idx].opr[0]->value];
+  uint16_t offset = opl->hot.num_opr[idx] > 1 ? opl->hot.value[1][idx] : 0;
+  return binary->bytes + offset;
+}
+
+/** @brief word of an .INCBIN entry
+ *
+ * @param opl The operation list holding the entry.
+ * @param idx The index of the .INCBIN entry.
+ * @param word The index of the word in the entry.
+ *
+ * @returns uint16_t The word read from the binary file in the byte order
+ *   of the entry.
+ */
+uint16_t opl_binary_word(operation_list* opl, unsigned idx, unsigned word)
+{
+  const uint8_t* bytes = opl_binary_bytes(opl, idx) + word * 2;
+  return opl->hot.variant[idx] == 0 ? (uint16_t)(bytes[1] << 8) | bytes[0] : (uint16_t)(bytes[0] << 8) | bytes[1];
+}
+
+/** @brief words of an .INCBIN entry
+ *
+ * Read the words of an .INCBIN entry from its binary file, in the byte
+ * order of the entry, into host words.
+ *
+ * @param opl The operation list holding the entry.
+ * @param idx The index of the .INCBIN entry.
+ * @param words Returns the words, it must have room for the size of the
+ *   entry.
+ */
+void opl_binary_words(operation_list* opl, unsigned idx, uint16_t* words)
+{
+  for (unsigned word = 0; word < opl->hot.size[idx]; word++)
+  {
+    words[word] = opl_binary_word(opl, idx, word);
+  }
 }
 
 /** @brief append new operation entry
  *
  * Append a new entry to the list.  We will be passed in the information that
- * pass 1 can determine when adding an entry.
+ * pass 1 can determine when adding an entry.  The list grows if it is full,
+ * so pointers to entries obtained before the append may no longer be valid
+ * afterwards, always refer to entries by their index.
  *
  * @param opl A pointer to the operation list to append new operation on.
- * @param line The original whole line containing this operation we are
- *   are appending.
- * @param linenum The line number in the input file we are translating that this
- *   operation was found and processed from.
+ * @param file The index in the file table of the assembly file the operation
+ *   was read from.
+ * @param tks The tokens of the line containing this operation, we keep the
+ *   line number and the location of the line in the file, but not a copy of
+ *   the line itself.
  * @param label If the line has a label it is passed in, if not this is NULL.
  * @param opc The opcode of this entry, this is required to be present on every
  *   operation line for an LC-3 assembly file.
  * @param address The address of this operation determined by the first pass.
  *
- * @returns opl_entry* A pointer to the new entry is returned, or NULL if
- *   an error occurs on the insertion.
+ * @returns unsigned The index of the new entry in the operation list.
  */
-opl_entry* opl_append(operation_list* opl, const char* line, unsigned linenum, const char* label, opcode* opc, uint16_t address)
+unsigned opl_append(operation_list* opl, unsigned file, tokens* tks, const char* label, opcode* opc, uint16_t address)
 {
-  opl_entry* entry;
-
-  // allocate a new entry
-  entry = (opl_entry*)malloc(sizeof(opl_entry));
+  if (opl->num_entries == opl->capacity)
+  {
+    opl_grow(opl);
+  }
+  unsigned idx = opl->num_entries;
 
-  // initialize the entry with the passed in information
-  entry->line = strdup(line);
-  entry->linenum = linenum;
+  // initialize the cold entry with the passed in information
+  opl_entry* entry = &opl->entries[idx];
+#ifndef NO_SOURCE_LINES
+  entry->file = file;
+  entry->offset = tks->offset;
+  entry->length = tks->length;
+#endif
+  entry->linenum = tks->linenum;
   if (label)
     entry->label = strdup(label);
   else
     entry->label = NULL;
   entry->opc = opc;
-  entry->address = address;
   entry->num_opr = 0;
-  entry->size = 0x0;
-  entry->inst = 0x0;
-  entry->next = NULL;
 
-  // if list is empty, front and back will now both be the new entry
-  if (opl->front == NULL)
+  // and the hot fields
+  opl->hot.opc[idx] = opc->opc;
+  opl->hot.flags[idx] = opc->flags;
+  opl->hot.variant[idx] = opc->variant;
+  opl->hot.num_opr[idx] = 0;
+  for (int opr = 0; opr < 3; opr++)
   {
-    opl->front = opl->back = entry;
-  }
-  else // append to back of list
-  {
-    opl->back->next = entry;
-    opl->back = entry;
+    opl->hot.oprtype[opr][idx] = UNKOWN;
+    opl->hot.value[opr][idx] = 0x0;
   }
+  opl->hot.address[idx] = address;
+  opl->hot.size[idx] = 0x0;
+  opl->hot.format[idx] = 0x0;
+  opl->hot.base[idx] = 0x0;
+  opl->hot.inst[idx] = 0x0;
+
   opl->num_entries++;
 
-  return entry;
+  return idx;
 }
 
-/** @brief append new operand to the opl_entry
+/** @brief append new operand to an entry
  *
- * Append a new operand to the given opl_entry.  There are at most 3 operands
+ * Append a new operand to the given entry.  There are at most 3 operands
  * for each operation line in an LC-3 assembly file.  We just add the
- * operand to the end of the array of operands for this entry.
+ * operand to the end of the array of operands for this entry, and copy
+ * its type and value into the hot field arrays.
  *
- * @param entry The operation list entry that we are appending a new operand
- *   on to.
+ * @param opl The operation list holding the entry.
+ * @param idx The index of the operation list entry that we are appending a
+ *   new operand on to.
  * @param opr The operand structure instance we are adding to the operation
  *   list entry.
  */
-void opl_append_operand(opl_entry* entry, operand* opr)
+void opl_append_operand(operation_list* opl, unsigned idx, operand* opr)
 {
+  opl_entry* entry = &opl->entries[idx];
+  if (entry->num_opr == 3)
+  {
+    // the extra operand is dropped if the error is recorded in the sink
+    char line[256];
+    opl_line(opl, idx, line, sizeof(line));
+    unsigned column = diag_column(line, opr->token);
+    opr_destruct(opr);
+    diag_error(opl_file_name(opl, idx), entry->linenum, column, DIAG_TOO_MANY_OPERANDS,
+      "<operation_list::opl_append_operand> Error too many operands line: %05d: <%s>", entry->linenum, line);
+    return;
+  }
+
+  opl->hot.oprtype[entry->num_opr][idx] = opr->opr;
+  opl->hot.value[entry->num_opr][idx] = opr->value;
   entry->opr[entry->num_opr] = opr;
   entry->num_opr++;
+  opl->hot.num_opr[idx] = entry->num_opr;
+
+  // the operands changed, so the entry has to be classified for encoding again
+  opl->hot.format[idx] = 0x0;
+}
+
+/** @brief remove the last entry
+ *
+ * Remove the most recently appended entry from the list, freeing the
+ * memory the entry holds on to.  The capacity of the list is kept, so the
+ * next append reuses the removed entry's slot in all of the arrays.
+ *
+ * @param opl A pointer to the operation list to remove the last entry from.
+ */
+void opl_remove_last(operation_list* opl)
+{
+  if (opl->num_entries == 0)
+  {
+    return;
+  }
+
+  unsigned idx = --opl->num_entries;
+  opl_entry* entry = &opl->entries[idx];
+  free(entry->label);
+  opc_destruct(entry->opc);
+  for (int opr = 0; opr < entry->num_opr; opr++)
+  {
+    opr_destruct(entry->opr[opr]);
+  }
+  opl->size -= opl->hot.size[idx];
+}
+
+/** @brief splice an array
+ *
+ * Do the splice of `opl_splice()` on one of the entry or hot field arrays,
+ * moving the new elements at the end of the array down into the place of
+ * the removed ones.
+ */
+static void opl_splice_array(void* array, size_t elem_size, unsigned begin, unsigned num_removed,
+  unsigned first_new, unsigned num_entries)
+{
+  char* base = (char*)array;
+  unsigned num_new = num_entries - first_new;
+  unsigned num_kept = first_new - (begin + num_removed);
+  if (num_new == num_removed)
+  {
+    // the kept elements stay where they are
+    memcpy(base + begin * elem_size, base + first_new * elem_size, num_new * elem_size);
+    return;
+  }
+  if (num_new == 0)
+  {
+    memmove(base + begin * elem_size, base + (begin + num_removed) * elem_size, num_kept * elem_size);
+    return;
+  }
+
+  // the new elements are copied out of the way first, the kept elements
+  // after the removed ones move to make room for them
+  char stack[1024];
+  size_t new_size = num_new * elem_size;
+  char* moved = new_size <= sizeof(stack) ? stack : (char*)malloc(new_size);
+  memcpy(moved, base + first_new * elem_size, new_size);
+  memmove(base + (begin + num_new) * elem_size, base + (begin + num_removed) * elem_size, num_kept * elem_size);
+  memcpy(base + begin * elem_size, moved, new_size);
+  if (moved != stack)
+  {
+    free(moved);
+  }
+}
+
+/** @brief splice entries
+ *
+ * Replace a range of entries with the entries that were appended after
+ * first_new.  The entries from begin to begin + num_removed are freed, and
+ * the appended entries from first_new to the end of the list take their
+ * place, the entries in between move to follow them.  This is how entries
+ * are inserted in the middle of the list, they are appended as usual and
+ * then spliced into place.  The size of the list is adjusted, but the
+ * addresses of the entries are left for the caller to fix.
+ *
+ * @param opl The operation list.
+ * @param begin The index of the first entry to remove.
+ * @param num_removed The number of entries to remove.
+ * @param first_new The index of the first appended entry, at or after
+ *   begin + num_removed.
+ */
+void opl_splice(operation_list* opl, unsigned begin, unsigned num_removed, unsigned first_new)
+{
+  for (unsigned idx = begin; idx < begin + num_removed; idx++)
+  {
+    opl_entry* entry = &opl->entries[idx];
+    free(entry->label);
+    opc_destruct(entry->opc);
+    for (int opr = 0; opr < entry->num_opr; opr++)
+    {
+      opr_destruct(entry->opr[opr]);
+    }
+    opl->size -= opl->hot.size[idx];
+  }
+
+  opl_hot* hot = &opl->hot;
+  unsigned n = opl->num_entries;
+  opl_splice_array(opl->entries, sizeof(opl_entry), begin, num_removed, first_new, n);
+  opl_splice_array(hot->opc, sizeof(uint8_t), begin, num_removed, first_new, n);
+  opl_splice_array(hot->flags, sizeof(uint8_t), begin, num_removed, first_new, n);
+  opl_splice_array(hot->variant, sizeof(uint8_t), begin, num_removed, first_new, n);
+  opl_splice_array(hot->num_opr, sizeof(uint8_t), begin, num_removed, first_new, n);
+  for (int opr = 0; opr < 3; opr++)
+  {
+    opl_splice_array(hot->oprtype[opr], sizeof(uint8_t), begin, num_removed, first_new, n);
+    opl_splice_array(hot->value[opr], sizeof(uint16_t), begin, num_removed, first_new, n);
+  }
+  opl_splice_array(hot->address, sizeof(uint16_t), begin, num_removed, first_new, n);
+  opl_splice_array(hot->size, sizeof(uint16_t), begin, num_removed, first_new, n);
+  opl_splice_array(hot->format, sizeof(uint8_t), begin, num_removed, first_new, n);
+  opl_splice_array(hot->base, sizeof(uint16_t), begin, num_removed, first_new, n);
+  opl_splice_array(hot->inst, sizeof(uint16_t), begin, num_removed, first_new, n);
+  opl->num_entries -= num_removed;
 }
 
 /** @brief begin iteration
  *
- * Set the iteration of list back to the beginning of the list.
+ * Start an iteration at the beginning of the list.  The iteration index is
+ * kept by the caller, not in the list, so any number of threads can
+ * iterate over the same list at the same time.
  *
- * @param opl A pointer to the operation list to reset iteration for.
+ * @param opl A pointer to the operation list to iterate over.
+ * @param cursor The iteration index, set to the index of the first entry.
  *
- * @returns opl_entry* Returns pointer to the first operation list entry.
+ * @returns opl_entry* Returns pointer to the first operation list entry,
+ *   or NULL if the list is empty.
  */
-opl_entry* opl_begin(operation_list* opl)
+opl_entry* opl_begin(operation_list* opl, unsigned* cursor)
 {
-  opl->current = opl->front;
-  return opl->current;
+  *cursor = 0;
+  return opl->num_entries ? &opl->entries[0] : NULL;
 }
 
 /** @brief next iteration
  *
- * Return current entry when iterating the list and move pointer up to
- * next entry.
+ * Move the iteration index up to the next entry and return it.
  *
  * @param opl A pointer to the operation list to iterate next item for.
+ * @param cursor The iteration index of an iteration started with
+ *   `opl_begin()`, moved to the index of the next entry.
  *
  * @returns opl_entry* Returns a pointer to the next operation list
- *   entry in the current iteration.
+ *   entry in the current iteration, or NULL at the end of the list.
  */
-opl_entry* opl_next(operation_list* opl)
+opl_entry* opl_next(operation_list* opl, unsigned* cursor)
 {
-  opl->current = opl->current->next;
-  return opl->current;
+  if (*cursor < opl->num_entries)
+  {
+    (*cursor)++;
+  }
+  return *cursor < opl->num_entries ? &opl->entries[*cursor] : NULL;
 }
 
 /** @brief display operation_list
@@ -193,11 +652,27 @@ opl_entry* opl_next(operation_list* opl)
  */
 void opl_display(operation_list* opl)
 {
-  printf("%-20s%-10s%-40s %-4s: %-4s %16s\n", "LABEL", "OPCODE", "OPERANDS", "ADDR", "INST", "BINARY");
-  printf("--------------------------------------------------------------------------------------------------\n");
-  opl_entry* current = opl_begin(opl);
-  while (current)
+  opl_fdisplay(stdout, opl);
+}
+
+/** @brief display operation_list to a file
+ *
+ * Display contents of a operation_list like `opl_display()`, but on the
+ * given file, for example to keep the listing in the output cache.
+ *
+ * @param out The file to display the operation list on.
+ * @param opl A pointer to the operation_list to display.
+ */
+void opl_fdisplay(FILE* out, operation_list* opl)
+{
+  fprintf(out, "%-20s%-10s%-40s %-4s: %-4s %16s\n", "LABEL", "OPCODE", "OPERANDS", "ADDR", "INST", "BINARY");
+  fprintf(out, "--------------------------------------------------------------------------------------------------\n");
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
   {
+    opl_entry* current = &opl->entries[idx];
+    uint16_t address = opl->hot.address[idx];
+    uint16_t inst = opl->hot.inst[idx];
+
     // determine string for label to display
     const char* label;
     if (current->label)
@@ -208,42 +683,114 @@ void opl_display(operation_list* opl)
     // create a string of the operands to display
     char oprbuf[100];
     oprbuf[0] = '\0';
-    for (int idx = 0; idx < current->num_opr; idx++)
+    for (int opr = 0; opr < current->num_opr; opr++)
     {
-      strcat(oprbuf, opr_str(current->opr[idx]));
-      if (idx < current->num_opr - 1)
+      strcat(oprbuf, opr_str(current->opr[opr]));
+      if (opr < current->num_opr - 1)
       {
         strcat(oprbuf, ", ");
       }
     }
 
-    printf("%-20s%-10s%-40s %04X: %04X %016b\n", label, opc_str(current->opc), oprbuf, current->address, current->inst, current->inst);
+    // an entry of no words was removed by the peephole optimizer, the
+    // literal pool or dead code elimination, it keeps its line in the
+    // listing but has no machine word
+    if (opl->hot.size[idx] == 0 && opl->hot.opc[idx] != ORIG && opl->hot.opc[idx] != END)
+    {
+      fprintf(out, "%-20s%-10s%-40s %04X: %-4s %16s\n", label, opc_str(current->opc), oprbuf, address, "----",
+        "removed");
+      continue;
+    }
+    fprintf(out, "%-20s%-10s%-40s %04X: %04X %016b\n", label, opc_str(current->opc), oprbuf, address, inst, inst);
 
     // BLKW and STRINGZ pseudo ops actually will assemble to multiple address words, handle their output specially here
-    if (current->opc->opc == BLKW)
+    if (opl->hot.opc[idx] == BLKW)
     {
       char* empty = ".";
       uint16_t i = 0x0000;
-      uint16_t address = current->address + 1;
-      for (int idx = 1; idx < current->size; idx++)
+      address++;
+      for (int word = 1; word < opl->hot.size[idx]; word++)
       {
-        printf("%-20s%-10s%-40s %04X: %04X %016b\n", "", empty, empty, address, i, i);
+        fprintf(out, "%-20s%-10s%-40s %04X: %04X %016b\n", "", empty, empty, address, i, i);
         address++;
       }
     }
-    if (current->opc->opc == STRINGZ)
+    if (opl->hot.opc[idx] == STRINGZ)
     {
       char* empty = ".";
       uint16_t i = 0x0000;
-      uint16_t address = current->address + 1;
-      for (int idx = 1; idx < current->size; idx++)
+      address++;
+      for (int word = 1; word < opl->hot.size[idx]; word++)
       {
-        i = (uint16_t)current->opr[0]->svalue[idx];
-        printf("%-20s%-10s%-40s %04X: %04X %016b\n", "", empty, empty, address, i, i);
+        i = (uint16_t)current->opr[0]->svalue[word];
+        fprintf(out, "%-20s%-10s%-40s %04X: %04X %016b\n", "", empty, empty, address, i, i);
         address++;
       }
     }
+    if (opl->hot.opc[idx] == INCBIN && opl->hot.size[idx] > 1)
+    {
+      char* empty = ".";
+      uint16_t* words = (uint16_t*)malloc(opl->hot.size[idx] * sizeof(uint16_t));
+      opl_binary_words(opl, idx, words);
+      address++;
+      for (int word = 1; word < opl->hot.size[idx]; word++)
+      {
+        fprintf(out, "%-20s%-10s%-40s %04X: %04X %016b\n", "", empty, empty, address, words[word], words[word]);
+        address++;
+      }
+      free(words);
+    }
+  }
+}
+
+/** @brief source line of an entry
+ *
+ * Read the original source line of an entry back from its assembly file,
+ * or from memory for a source that was assembled from memory.
+ * Entries do not keep a copy of their line, it is only loaded when a
+ * diagnostic or listing needs it.  If the assembler was built with
+ * NO_SOURCE_LINES, or the file can no longer be read, the line is empty.
+ *
+ * @param opl The operation list holding the entry.
+ * @param idx The index of the entry whose line we want.
+ * @param buffer A buffer to read the line into.
+ * @param size The size of the buffer, longer lines are truncated.
+ *
+ * @returns const char* The buffer holding the line, without its newline.
+ */
+const char* opl_line(operation_list* opl, unsigned idx, char* buffer, size_t size)
+{
+  buffer[0] = '\0';
+
+#ifndef NO_SOURCE_LINES
+  opl_entry* entry = &opl->entries[idx];
+  size_t length = entry->length < size - 1 ? entry->length : size - 1;
+
+  // sources assembled from memory are read back from memory
+  opl_file* file = &opl->files[entry->file];
+  if (file->source != NULL)
+  {
+    if (entry->offset >= 0 && (size_t)entry->offset + length <= file->length)
+    {
+      memcpy(buffer, file->source + entry->offset, length);
+      buffer[length] = '\0';
+    }
+    return buffer;
+  }
+
+  FILE* in = fopen(file->name, "r");
+  if (in == NULL)
+  {
+    return buffer;
+  }
 
-    current = opl_next(opl);
+  if (fseek(in, entry->offset, SEEK_SET) == 0)
+  {
+    length = fread(buffer, 1, length, in);
+    buffer[length] = '\0';
   }
+  fclose(in);
+#endif
+
+  return buffer;
 }
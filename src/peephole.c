@@ -0,0 +1,304 @@
+/** @file peephole.c
+ * @brief LC-3 Assembler peephole optimizer
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Peephole optimizer, see peephole.h.  Each pass walks the operation list
+ * once, keeping the previous instruction that falls into the current one,
+ * so every rule only looks at an instruction and its neighbours.  The
+ * addresses are only assigned again after a pass, from the first removed
+ * instruction on, so the branch-next rule sees the addresses from before
+ * the pass, and finds the branches that a pass made into branches to the
+ * next instruction in the pass after it.
+ */
+#include "peephole.h"
+#include "assembler.h"
+#include "relax.h"
+#include <stdlib.h>
+#include <string.h>
+
+/// no previous instruction falls into the current one
+#define NO_ENTRY ((unsigned)-1)
+
+/// the names of the rules, in the order of peep_rule
+static const char* rule_names[PEEP_NUM_RULES] = {"branch-next", "set-cc", "dead-clear"};
+
+/** @brief rule name
+ *
+ * @returns const char* The name of a peephole rule, used to report it.
+ */
+const char* peep_rule_name(peep_rule rule)
+{
+  return rule_names[rule];
+}
+
+/** @brief is removed
+ *
+ * Check if the peephole optimizer, the literal pool or dead code
+ * elimination removed an entry.  Every entry but .ORIG and .END has words,
+ * so one of no words was removed, or is a .BLKW of none that is the same
+ * as removed.
+ */
+bool peep_is_removed(opl_hot* hot, unsigned idx)
+{
+  return hot->size[idx] == 0 && hot->opc[idx] != ORIG && hot->opc[idx] != END;
+}
+
+/** @brief is instruction
+ *
+ * Check if an entry is an LC-3 instruction that is still in the program,
+ * not a pseudo op.
+ */
+static bool is_instruction(opl_hot* hot, unsigned idx)
+{
+  return hot->opc[idx] < ORIG && hot->size[idx] == 1;
+}
+
+/** @brief register operand
+ *
+ * @returns int The register of an operand, or -1 if the entry does not
+ *   have the operand or it is not a register.  Entries with the wrong
+ *   operands are left for pass two to report.
+ */
+static int reg_operand(opl_hot* hot, unsigned idx, unsigned opr)
+{
+  return opr < hot->num_opr[idx] && hot->oprtype[opr][idx] == REGISTER ? hot->value[opr][idx] : -1;
+}
+
+/** @brief clears register
+ *
+ * @returns int The register an AND Rx, Ry, #0 clears, or -1 if the entry
+ *   is not a clear.
+ */
+static int clears(opl_hot* hot, unsigned idx)
+{
+  if (hot->opc[idx] != AND || hot->num_opr[idx] != 3 || hot->oprtype[2][idx] != NUMERIC || hot->value[2][idx] != 0)
+  {
+    return -1;
+  }
+  return reg_operand(hot, idx, 0);
+}
+
+/** @brief sets condition codes
+ *
+ * @returns int The register an instruction writes and sets the condition
+ *   codes from, or -1 if it does not set them.  LEA is left out, since the
+ *   LC-3 revisions disagree on whether it sets the condition codes.
+ */
+static int sets_cc(opl_hot* hot, unsigned idx)
+{
+  switch (hot->opc[idx])
+  {
+  case ADD:
+  case AND:
+  case NOT:
+  case LD:
+  case LDI:
+  case LDR:
+    return reg_operand(hot, idx, 0);
+  default:
+    return -1;
+  }
+}
+
+/** @brief reads register
+ *
+ * Check if one of the instructions that set the condition codes reads a
+ * register.  A clear does not depend on its source register, so it does
+ * not read it.
+ */
+static bool reads(opl_hot* hot, unsigned idx, int reg)
+{
+  switch (hot->opc[idx])
+  {
+  case ADD:
+  case AND:
+    return clears(hot, idx) < 0 && (reg_operand(hot, idx, 1) == reg || reg_operand(hot, idx, 2) == reg);
+  case NOT:
+  case LDR:
+    return reg_operand(hot, idx, 1) == reg;
+  default:
+    return false;
+  }
+}
+
+/** @brief next instruction
+ *
+ * @returns unsigned The index of the instruction the program falls into
+ *   after an entry, skipping removed instructions, or NO_ENTRY if the next
+ *   entry is a pseudo op.
+ */
+static unsigned next_instruction(operation_list* opl, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+  for (idx++; idx < opl->num_entries && peep_is_removed(hot, idx); idx++)
+  {
+  }
+  return idx < opl->num_entries && is_instruction(hot, idx) ? idx : NO_ENTRY;
+}
+
+/** @brief pin numeric offsets
+ *
+ * Mark the addresses between each operation with a numeric PC offset and
+ * its target, removing any of them would move the target of the offset.
+ * The literal pool pins the same addresses.
+ *
+ * @returns uint8_t* A flag for each address, nonzero if it is pinned, or
+ *   NULL if the program has no numeric offsets, freed by the caller.
+ */
+uint8_t* peep_pin_numeric_offsets(operation_list* opl)
+{
+  opl_hot* hot = &opl->hot;
+  uint8_t* pinned = NULL;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    unsigned opr = hot->num_opr[idx] - 1;
+    if (!is_instruction(hot, idx) || hot->num_opr[idx] == 0 || hot->oprtype[opr][idx] != NUMERIC ||
+        relax_offset_bits(hot, idx, opr) == 0)
+    {
+      continue;
+    }
+    if (pinned == NULL)
+    {
+      pinned = (uint8_t*)calloc(NUM_ADDRESSES, sizeof(uint8_t));
+    }
+
+    // a forward offset pins the words after the operation up to its
+    // target, a backward one the words from its target up to the operation
+    int16_t offset = (int16_t)hot->value[opr][idx];
+    uint16_t first = offset >= 0 ? hot->address[idx] + 1 : hot->address[idx] + 1 + offset;
+    unsigned count = offset >= 0 ? offset + 1 : -offset;
+    for (unsigned word = 0; word < count; word++)
+    {
+      pinned[(uint16_t)(first + word)] = 1;
+    }
+  }
+  return pinned;
+}
+
+/** @brief match rule
+ *
+ * Find the rule, if any, that removes an instruction.
+ *
+ * @param opl The operation list.
+ * @param st The symbol table.
+ * @param idx The index of the instruction.
+ * @param prev The index of the instruction that falls into it, or
+ *   NO_ENTRY.
+ * @param labelled true if the instruction, or a removed instruction right
+ *   before it, has a label, so it can be reached by a branch.
+ *
+ * @returns int The rule that removes the instruction, or -1 if it stays.
+ */
+static int match_rule(operation_list* opl, symbol_table* st, unsigned idx, unsigned prev, bool labelled)
+{
+  opl_hot* hot = &opl->hot;
+  switch (hot->opc[idx])
+  {
+  case BR:
+    // a branch to the next instruction, by label or by an offset of 0
+    if (hot->num_opr[idx] == 1 && hot->oprtype[0][idx] == SYMBOL)
+    {
+      st_entry* target = st_lookup(st, opl->entries[idx].opr[0]->svalue);
+      return target != NULL && target->address == (uint16_t)(hot->address[idx] + 1) ? PEEP_BRANCH_NEXT : -1;
+    }
+    return hot->num_opr[idx] == 1 && hot->oprtype[0][idx] == NUMERIC && hot->value[0][idx] == 0 ? PEEP_BRANCH_NEXT
+                                                                                                   : -1;
+  case ADD:
+    // ADD Rx, Rx, #0 only sets the condition codes from Rx, which the
+    // instruction before it already did when it wrote Rx
+    if (!labelled && prev != NO_ENTRY && hot->num_opr[idx] == 3 && hot->oprtype[2][idx] == NUMERIC &&
+        hot->value[2][idx] == 0 && reg_operand(hot, idx, 0) >= 0 &&
+        reg_operand(hot, idx, 0) == reg_operand(hot, idx, 1) && sets_cc(hot, prev) == reg_operand(hot, idx, 0))
+    {
+      return PEEP_SET_CC;
+    }
+    return -1;
+  case AND:
+  {
+    // a clear that the next instruction overwrites, along with the
+    // condition codes, before anything can read it
+    int reg = clears(hot, idx);
+    unsigned next = reg >= 0 ? next_instruction(opl, idx) : NO_ENTRY;
+    if (next != NO_ENTRY && sets_cc(hot, next) == reg && !reads(hot, next, reg))
+    {
+      return PEEP_DEAD_CLEAR;
+    }
+    return -1;
+  }
+  default:
+    return -1;
+  }
+}
+
+/** @brief peephole optimizer
+ *
+ * Remove the instructions the peephole rules find, until a pass removes
+ * nothing.  Run after pass one and before `relax()`, the entries and the
+ * symbol table get the addresses of the optimized program, and pass two
+ * then assembles the remaining entries as usual.
+ *
+ * @param opl The operation list of pass one.
+ * @param st The symbol table of pass one.
+ *
+ * @returns peep_stats The instructions removed and cycles saved by each
+ *   rule, and the passes it took.
+ */
+peep_stats peephole(operation_list* opl, symbol_table* st)
+{
+  opl_hot* hot = &opl->hot;
+  peep_stats stats;
+  memset(&stats, 0, sizeof(stats));
+  unsigned first_removed;
+  do
+  {
+    stats.num_passes++;
+    first_removed = opl->num_entries;
+    uint8_t* pinned = peep_pin_numeric_offsets(opl);
+    unsigned prev = NO_ENTRY;
+    bool labelled = false;
+    for (unsigned idx = 0; idx < opl->num_entries; idx++)
+    {
+      // the label of a removed instruction is on the entry after it
+      labelled = labelled || opl->entries[idx].label != NULL;
+      if (peep_is_removed(hot, idx))
+      {
+        continue;
+      }
+      // nothing falls through a pseudo op into the code after it
+      if (!is_instruction(hot, idx))
+      {
+        prev = NO_ENTRY;
+        labelled = false;
+        continue;
+      }
+
+      int rule = match_rule(opl, st, idx, prev, labelled);
+      if (rule < 0 || (pinned != NULL && pinned[hot->address[idx]]))
+      {
+        prev = idx;
+        labelled = false;
+        continue;
+      }
+      hot->size[idx] = 0;
+      opl->size--;
+      stats.num_removed[rule]++;
+      stats.cycles_saved[rule] += opc_cycles(hot->opc[idx]) + (hot->opc[idx] == BR && hot->flags[idx] == 0x7);
+      if (first_removed == opl->num_entries)
+      {
+        first_removed = idx;
+      }
+    }
+    free(pinned);
+
+    if (first_removed < opl->num_entries)
+    {
+      assign_addresses(opl, st, first_removed);
+    }
+  } while (first_removed < opl->num_entries);
+
+  return stats;
+}
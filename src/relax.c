@@ -0,0 +1,377 @@
+/** @file relax.c
+ * @brief LC-3 Assembler branch relaxation
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Branch relaxation, see relax.h.  The first pass over the operation list
+ * looks up the label of every PC relative SYMBOL operand, so a program
+ * with nothing to relax costs one pass of symbol lookups.  After a pass
+ * that grew operations, the addresses are only assigned again from the
+ * first grown operation on, and only the labels that really moved are
+ * updated in the symbol table.  Every relaxed operation is reported as a
+ * warning, and a section that grew into the next section as an error.
+ */
+#include "relax.h"
+#include "assembler.h"
+#include "diagnostic.h"
+#include <stdlib.h>
+
+/// the register a relaxed branch or JSR loads the address of its label
+/// into, JSR already uses it for the return address
+#define RELAX_REG 7
+
+/// the word of an unconditional branch over the literal after it
+#define BR_OVER_LITERAL ((BR << 12) | (0x7 << 9) | 0x1)
+
+/** @brief PC offset bits
+ *
+ * Find the bits of the offset of a PC relative operand.
+ *
+ * @param hot The hot fields of the operation list.
+ * @param idx The index of the entry.
+ * @param opr The index of the operand of the entry.
+ *
+ * @returns unsigned The number of bits of the offset the operand is
+ *   encoded into, or 0 if the operand is not a PC relative offset.
+ */
+unsigned relax_offset_bits(opl_hot* hot, unsigned idx, unsigned opr)
+{
+  switch (hot->opc[idx])
+  {
+  case BR:
+    return hot->num_opr[idx] == 1 && opr == 0 ? 9 : 0;
+  case JSR:
+    // only JSR has an offset, JSRR has a base register
+    return hot->variant[idx] == 1 && hot->num_opr[idx] == 1 && opr == 0 ? 11 : 0;
+  case LD:
+  case LDI:
+  case LEA:
+  case ST:
+  case STI:
+    return hot->num_opr[idx] == 2 && opr == 1 ? 9 : 0;
+  default:
+    return 0;
+  }
+}
+
+/** @brief offset fits
+ *
+ * Check if an offset can be encoded as a signed number of the given bits.
+ *
+ * @param offset The offset, a 16 bit two's complement number.
+ * @param bits The number of bits of the encoded offset.
+ *
+ * @returns bool true if the offset is in range.
+ */
+bool relax_fits(uint16_t offset, unsigned bits)
+{
+  int16_t value = (int16_t)offset;
+  return value >= -(1 << (bits - 1)) && value < (1 << (bits - 1));
+}
+
+/** @brief is relaxed
+ *
+ * Check if an entry was relaxed.  Instructions are one word, so any
+ * instruction with more words is a relaxed sequence.
+ */
+bool relax_is_relaxed(opl_hot* hot, unsigned idx)
+{
+  return hot->size[idx] > 1 && hot->opc[idx] < ORIG;
+}
+
+/** @brief relaxed size
+ *
+ * The number of words an entry becomes when it is relaxed.
+ *
+ * @returns uint16_t The size of the relaxed sequence, or 0 if the entry
+ *   can not be relaxed.
+ */
+static uint16_t relaxed_size(opl_hot* hot, unsigned idx)
+{
+  switch (hot->opc[idx])
+  {
+  case BR:
+    return hot->flags[idx] == 0x7 ? 3 : 4;
+  case JSR:
+  case LDI:
+    return 4;
+  case LD:
+  case LEA:
+  case ST:
+    return 3;
+  default:
+    return 0;
+  }
+}
+
+/** @brief needs relaxing
+ *
+ * Check if an entry is out of range of its label and can be relaxed.
+ *
+ * @param opl The operation list.
+ * @param st The symbol table.
+ * @param idx The index of the entry.
+ *
+ * @returns uint16_t The size the entry has to grow to, or 0 if it reaches
+ *   its label, was already relaxed, or can not be relaxed.
+ */
+uint16_t relax_needed(operation_list* opl, symbol_table* st, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+
+  // the PC relative operand is the last one, and relaxed entries already
+  // reach their labels
+  unsigned opr = hot->num_opr[idx] - 1;
+  if (hot->size[idx] != 1 || hot->num_opr[idx] == 0 || hot->oprtype[opr][idx] != SYMBOL)
+  {
+    return 0;
+  }
+  unsigned bits = relax_offset_bits(hot, idx, opr);
+  st_entry* entry = bits ? st_lookup(st, opl->entries[idx].opr[opr]->svalue) : NULL;
+  if (entry == NULL || relax_fits(entry->address - (hot->address[idx] + 1), bits))
+  {
+    return 0;
+  }
+  return relaxed_size(hot, idx);
+}
+
+/** @brief report relaxed operation
+ *
+ * Warn that an operation was rewritten into a longer sequence, at the
+ * label it could not reach.  A relaxed branch is the one that changes more
+ * than its size, it overwrites R7 and the condition codes.
+ */
+static void report_relaxed(operation_list* opl, unsigned idx)
+{
+  opl_hot* hot = &opl->hot;
+  opl_entry* entry = &opl->entries[idx];
+  unsigned opr = hot->num_opr[idx] - 1;
+  char line[256];
+  unsigned column = diag_column(opl_line(opl, idx, line, sizeof(line)), entry->opr[opr]->token);
+  diag_warning(opl_file_name(opl, idx), entry->linenum, column, DIAG_RELAXED,
+    "<relax::relax> Warning offset to symbol <%s> does not fit in %u bits, <%s> relaxed into %u words%s",
+    entry->opr[opr]->svalue, relax_offset_bits(hot, idx, opr), opc_str(entry->opc), hot->size[idx],
+    hot->opc[idx] == BR ? " that overwrite R7 and the condition codes" : "");
+}
+
+/// A section of the program, the words from its .ORIG up to the next one,
+/// and if relaxation grew it.
+typedef struct relax_section
+{
+  unsigned orig;
+  uint32_t begin;
+  uint32_t end;
+  bool grown;
+} relax_section;
+
+/** @brief check grown sections
+ *
+ * Report every section that relaxation grew over the address of another
+ * section, the words of both would be loaded at the same addresses.  The
+ * sections of a program are few, so each grown section is checked against
+ * all of the others.
+ *
+ * @param opl The relaxed operation list.
+ */
+static void check_sections(operation_list* opl)
+{
+  opl_hot* hot = &opl->hot;
+  unsigned num_sections = 0;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    num_sections += hot->opc[idx] == ORIG;
+  }
+  relax_section* sections = (relax_section*)calloc(num_sections + 1, sizeof(relax_section));
+
+  // the end of a section is not wrapped, so a section grown past the end
+  // of memory still covers the addresses after it
+  unsigned section = 0;
+  uint32_t address = 0;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    if (hot->opc[idx] == ORIG)
+    {
+      sections[section].orig = idx;
+      sections[section].begin = address = hot->address[idx];
+      section++;
+    }
+    address += hot->size[idx];
+    if (section > 0)
+    {
+      sections[section - 1].end = address;
+      sections[section - 1].grown |= relax_is_relaxed(hot, idx);
+    }
+  }
+
+  for (unsigned grown = 0; grown < num_sections; grown++)
+  {
+    for (unsigned other = 0; sections[grown].grown && other < num_sections; other++)
+    {
+      if (other != grown && sections[other].begin > sections[grown].begin &&
+          sections[other].begin < sections[grown].end)
+      {
+        unsigned orig = sections[grown].orig;
+        diag_error(opl_file_name(opl, orig), opl->entries[orig].linenum, 0, DIAG_SECTION_OVERLAP,
+          "<relax::relax> Error section at <x%04X> relaxed to end at <x%04X>, over the section at <x%04X>",
+          sections[grown].begin, sections[grown].end - 1, sections[other].begin);
+      }
+    }
+  }
+  free(sections);
+}
+
+/** @brief relax out of range offsets
+ *
+ * Rewrite the PC relative operations whose labels are out of reach of
+ * their offsets, until the addresses of the program converge.  Run after
+ * pass one, the entries get their final addresses and sizes and the
+ * symbol table its final addresses, and pass two then assembles the
+ * relaxed entries as usual.  Labels that are not defined are left for
+ * pass two to report.  Each relaxed operation is reported as a warning,
+ * and a section that grew over the start of another one as an error.
+ *
+ * @param opl The operation list of pass one.
+ * @param st The symbol table of pass one.
+ *
+ * @returns relax_stats How many operations were relaxed, the words that
+ *   added, and the passes it took.
+ */
+relax_stats relax(operation_list* opl, symbol_table* st)
+{
+  opl_hot* hot = &opl->hot;
+  relax_stats stats = {0, 0, 0};
+  unsigned first_grown;
+  do
+  {
+    stats.num_passes++;
+    first_grown = opl->num_entries;
+    for (unsigned idx = 0; idx < opl->num_entries; idx++)
+    {
+      uint16_t size = relax_needed(opl, st, idx);
+      if (size == 0)
+      {
+        continue;
+      }
+      hot->size[idx] = size;
+      opl->size += size - 1;
+      report_relaxed(opl, idx);
+      stats.num_relaxed++;
+      stats.words_added += size - 1;
+      if (first_grown == opl->num_entries)
+      {
+        first_grown = idx;
+      }
+    }
+
+    if (first_grown < opl->num_entries)
+    {
+      assign_addresses(opl, st, first_grown);
+    }
+  } while (first_grown < opl->num_entries);
+
+  if (stats.num_relaxed > 0)
+  {
+    check_sections(opl);
+  }
+  return stats;
+}
+
+/** @brief undo relaxation
+ *
+ * Put every relaxed entry back to a single instruction, and give all of
+ * the entries and labels their addresses from before relaxation.  An
+ * assembly that is kept and edited, like the incremental engine, undoes
+ * its relaxation before it relaxes again, so the program is relaxed
+ * exactly as a full assembly of the same source would be.
+ *
+ * @param opl The operation list.
+ * @param st The symbol table.
+ *
+ * @returns unsigned The number of entries that had been relaxed.
+ */
+unsigned relax_reset(operation_list* opl, symbol_table* st)
+{
+  opl_hot* hot = &opl->hot;
+  unsigned num_reset = 0;
+  unsigned first_reset = opl->num_entries;
+  for (unsigned idx = 0; idx < opl->num_entries; idx++)
+  {
+    if (relax_is_relaxed(hot, idx))
+    {
+      opl->size -= hot->size[idx] - 1;
+      hot->size[idx] = 1;
+      num_reset++;
+      if (first_reset == opl->num_entries)
+      {
+        first_reset = idx;
+      }
+    }
+  }
+  if (num_reset > 0)
+  {
+    assign_addresses(opl, st, first_reset);
+  }
+  return num_reset;
+}
+
+/** @brief relaxed words
+ *
+ * Make the machine words of a relaxed entry, once pass two has resolved
+ * the offset of its label.
+ *
+ * @param opl The assembled operation list.
+ * @param idx The index of a relaxed entry.
+ * @param words Returns the words of the relaxed sequence, it must have
+ *   room for RELAX_MAX_WORDS words.
+ *
+ * @returns unsigned The number of words, the size of the entry.
+ */
+unsigned relax_words(operation_list* opl, unsigned idx, uint16_t* words)
+{
+  opl_hot* hot = &opl->hot;
+  unsigned opr = hot->num_opr[idx] - 1;
+  uint16_t target = hot->address[idx] + 1 + hot->value[opr][idx];
+  uint16_t reg = hot->value[0][idx];
+  unsigned num_words = 0;
+
+  switch (hot->opc[idx])
+  {
+  case BR:
+    // a conditional branch skips the jump when its condition is false
+    if (hot->flags[idx] != 0x7)
+    {
+      words[num_words++] = (BR << 12) | ((~hot->flags[idx] & 0x7) << 9) | 0x3;
+    }
+    words[num_words++] = (LD << 12) | (RELAX_REG << 9) | 0x1;
+    words[num_words++] = (JMP << 12) | (RELAX_REG << 6);
+    break;
+  case JSR:
+    // the subroutine returns to the branch over the literal
+    words[num_words++] = (LD << 12) | (RELAX_REG << 9) | 0x2;
+    words[num_words++] = (JSR << 12) | (RELAX_REG << 6);
+    words[num_words++] = BR_OVER_LITERAL;
+    break;
+  case LD:
+  case ST:
+    // load or store indirectly through the address of the label
+    words[num_words++] = ((hot->opc[idx] == LD ? LDI : STI) << 12) | (reg << 9) | 0x1;
+    words[num_words++] = BR_OVER_LITERAL;
+    break;
+  case LEA:
+    words[num_words++] = (LD << 12) | (reg << 9) | 0x1;
+    words[num_words++] = BR_OVER_LITERAL;
+    break;
+  case LDI:
+    words[num_words++] = (LDI << 12) | (reg << 9) | 0x2;
+    words[num_words++] = (LDR << 12) | (reg << 9) | (reg << 6);
+    words[num_words++] = BR_OVER_LITERAL;
+    break;
+  default:
+    break;
+  }
+  words[num_words++] = target;
+  return num_words;
+}
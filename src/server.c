@@ -0,0 +1,515 @@
+/** @file server.c
+ * @brief LC-3 Assembler server
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * An assembler server that listens on a local Unix socket, and the client
+ * side of its protocol, see server.h for the request and response frames.
+ * The server answers requests one at a time with a single assembler
+ * context, whose tables are cleared and reused for every request, so after
+ * the first few requests assembling does not allocate any new tables.
+ */
+#define _POSIX_C_SOURCE 200809L
+#define __STDC_WANT_LIB_EXT2__ 1
+#include "server.h"
+#include "diagnostic.h"
+#include "include-cache.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/// largest name or body of a request the server accepts
+#define SRV_MAX_LENGTH (64U << 20)
+
+/// A growable buffer a response frame is built in, so that the whole
+/// frame is sent with as few writes as possible.
+typedef struct srv_buffer
+{
+  char* data;
+  size_t size;
+  size_t capacity;
+} srv_buffer;
+
+/** @brief append to buffer
+ *
+ * Append bytes to the end of the buffer, doubling its capacity as needed.
+ *
+ * @param buf The buffer to append to.
+ * @param data The bytes to append.
+ * @param size The number of bytes to append.
+ */
+static void buf_append(srv_buffer* buf, const void* data, size_t size)
+{
+  if (buf->size + size > buf->capacity)
+  {
+    size_t capacity = buf->capacity ? buf->capacity : 256;
+    while (buf->size + size > capacity)
+    {
+      capacity *= 2;
+    }
+    buf->data = (char*)realloc(buf->data, capacity);
+    buf->capacity = capacity;
+  }
+  memcpy(buf->data + buf->size, data, size);
+  buf->size += size;
+}
+
+/** @brief append word to buffer
+ *
+ * Append a uint32 field of a frame to the buffer.
+ */
+static void buf_append_u32(srv_buffer* buf, uint32_t value)
+{
+  buf_append(buf, &value, sizeof(value));
+}
+
+/** @brief append string to buffer
+ *
+ * Append a uint32 length and then the bytes of a string to the buffer,
+ * a NULL string is sent with the length SRV_NO_FILE and no bytes.
+ */
+static void buf_append_string(srv_buffer* buf, const char* string)
+{
+  if (string == NULL)
+  {
+    buf_append_u32(buf, SRV_NO_FILE);
+    return;
+  }
+  uint32_t length = strlen(string);
+  buf_append_u32(buf, length);
+  buf_append(buf, string, length);
+}
+
+/** @brief read all
+ *
+ * Read exactly size bytes from a socket, retrying short reads.
+ *
+ * @returns bool true if all of the bytes were read, false if the
+ *   connection was closed or failed first.
+ */
+static bool read_all(int fd, void* data, size_t size)
+{
+  char* next = (char*)data;
+  while (size > 0)
+  {
+    ssize_t got = read(fd, next, size);
+    if (got < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got <= 0)
+    {
+      return false;
+    }
+    next += got;
+    size -= got;
+  }
+  return true;
+}
+
+/** @brief write all
+ *
+ * Write exactly size bytes to a socket, retrying short writes.  A peer that
+ * has gone away is reported as a failure instead of raising SIGPIPE.
+ *
+ * @returns bool true if all of the bytes were written.
+ */
+static bool write_all(int fd, const void* data, size_t size)
+{
+  const char* next = (const char*)data;
+  while (size > 0)
+  {
+    ssize_t put = send(fd, next, size, MSG_NOSIGNAL);
+    if (put < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (put <= 0)
+    {
+      return false;
+    }
+    next += put;
+    size -= put;
+  }
+  return true;
+}
+
+/** @brief read string
+ *
+ * Read a string of the given length from a socket.
+ *
+ * @returns char* A newly allocated '\0' terminated string, or NULL if it
+ *   could not be read.
+ */
+static char* read_string(int fd, uint32_t length)
+{
+  if (length > SRV_MAX_LENGTH)
+  {
+    return NULL;
+  }
+  char* string = (char*)malloc(length + 1);
+  if (!read_all(fd, string, length))
+  {
+    free(string);
+    return NULL;
+  }
+  string[length] = '\0';
+  return string;
+}
+
+/** @brief socket path
+ *
+ * Determine the socket the server listens on, the given path if there is
+ * one, else the path in the LC3ASM_SOCKET environment variable, else the
+ * default socket.
+ *
+ * @param socket_path The socket path asked for on the command line, or NULL.
+ *
+ * @returns const char* The socket path to use.
+ */
+const char* srv_socket_path(const char* socket_path)
+{
+  if (socket_path != NULL && socket_path[0] != '\0')
+  {
+    return socket_path;
+  }
+  const char* env = getenv(SRV_SOCKET_ENV);
+  if (env != NULL && env[0] != '\0')
+  {
+    return env;
+  }
+  return SRV_SOCKET_DEFAULT;
+}
+
+/** @brief socket address
+ *
+ * Fill in the Unix socket address of a socket path.
+ *
+ * @returns bool false if the path is too long for a socket address.
+ */
+static bool socket_address(const char* socket_path, struct sockaddr_un* address)
+{
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (strlen(socket_path) >= sizeof(address->sun_path))
+  {
+    return false;
+  }
+  strcpy(address->sun_path, socket_path);
+  return true;
+}
+
+/** @brief remove stale socket
+ *
+ * Remove the socket a server that did not shut down cleanly left at a
+ * path.  A socket that still accepts connections belongs to a running
+ * server, and a path that is not a socket is not ours to remove, so both
+ * are left alone, and binding to the path then fails.
+ *
+ * @returns bool false if a server is listening on the socket.
+ */
+static bool remove_stale_socket(const char* socket_path, const struct sockaddr_un* address)
+{
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd >= 0 && connect(fd, (const struct sockaddr*)address, sizeof(*address)) == 0)
+  {
+    close(fd);
+    return false;
+  }
+  if (fd >= 0)
+  {
+    close(fd);
+  }
+
+  struct stat info;
+  if (lstat(socket_path, &info) == 0 && S_ISSOCK(info.st_mode))
+  {
+    unlink(socket_path);
+  }
+  return true;
+}
+
+/** @brief send response
+ *
+ * Build the response frame for an assembly result and send it.
+ *
+ * @returns bool true if the whole response was sent.
+ */
+static bool send_response(int fd, lc3asm_result* result)
+{
+  srv_buffer buf = {NULL, 0, 0};
+  buf_append_u32(&buf, SRV_RESPONSE_MAGIC);
+  buf_append_u32(&buf, result->ok);
+  buf_append_u32(&buf, result->image_size);
+  buf_append_u32(&buf, result->num_symbols);
+  buf_append_u32(&buf, result->num_diagnostics);
+  if (result->image_size > 0)
+  {
+    buf_append(&buf, result->image, result->image_size * sizeof(uint16_t));
+  }
+  for (unsigned index = 0; index < result->num_symbols; index++)
+  {
+    buf_append_u32(&buf, result->symbols[index].address);
+    buf_append_string(&buf, result->symbols[index].symbol);
+  }
+  for (unsigned index = 0; index < result->num_diagnostics; index++)
+  {
+    diagnostic* diag = &result->diagnostics[index];
+    buf_append_u32(&buf, diag->line);
+    buf_append_u32(&buf, diag->column);
+    buf_append_u32(&buf, diag->code);
+    buf_append_string(&buf, diag->file);
+    buf_append_string(&buf, diag->message);
+  }
+
+  bool sent = write_all(fd, buf.data, buf.size);
+  free(buf.data);
+  return sent;
+}
+
+/** @brief serve request
+ *
+ * Read one request from a connection, assemble it with the warm tables and
+ * send back the response.
+ *
+ * @param fd The connection to the client.
+ * @param ctx The assembler context reused for every request.
+ * @param verbose If true log the request on standard output.
+ * @param shutdown Set to true if the client asked the server to stop.
+ *
+ * @returns bool true if another request can be read from the connection.
+ */
+static bool serve_request(int fd, lc3asm_context* ctx, bool verbose, bool* shutdown)
+{
+  uint32_t header[4];
+  if (!read_all(fd, header, sizeof(header)) || header[0] != SRV_REQUEST_MAGIC)
+  {
+    return false;
+  }
+  char* name = read_string(fd, header[2]);
+  char* body = name ? read_string(fd, header[3]) : NULL;
+  if (body == NULL)
+  {
+    free(name);
+    return false;
+  }
+
+  lc3asm_result* result = NULL;
+  switch (header[1])
+  {
+  case SRV_PATH:
+  {
+    size_t length;
+    char* source = lc3asm_read_source(body, &length);
+    if (source != NULL)
+    {
+      result = lc3asm_context_assemble(ctx, name, source, length);
+      free(source);
+    }
+    else
+    {
+      result = (lc3asm_result*)calloc(1, sizeof(lc3asm_result));
+      lc3asm_result_add_diagnostic(result, diag_format(name, 0, "<server::srv_serve> File Not Found: <%s>", name));
+    }
+    break;
+  }
+  case SRV_SOURCE:
+    result = lc3asm_context_assemble(ctx, name, body, header[3]);
+    break;
+  case SRV_SHUTDOWN:
+    result = (lc3asm_result*)calloc(1, sizeof(lc3asm_result));
+    result->ok = true;
+    *shutdown = true;
+    break;
+  default:
+    free(name);
+    free(body);
+    return false;
+  }
+
+  if (verbose)
+  {
+    printf("request %u <%s> %s\n", header[1], name, result->ok ? "ok" : "error");
+    fflush(stdout);
+  }
+
+  bool sent = send_response(fd, result);
+  lc3asm_result_destruct(result);
+  free(name);
+  free(body);
+  return sent && !*shutdown;
+}
+
+/** @brief serve assemble requests
+ *
+ * Listen on a Unix socket and answer assemble requests until a client
+ * sends a SRV_SHUTDOWN request.  Connections are served one at a time,
+ * each for as many requests as the client sends on it.  A stale socket
+ * left at the path by a server that did not shut down cleanly is replaced,
+ * but a server that is still listening on the path is an error.  The
+ * include cache, see include-cache.h, is cleared at shutdown.
+ *
+ * @param socket_path The path of the socket to listen on.
+ * @param verbose If true log each request on standard output.
+ */
+void srv_serve(const char* socket_path, bool verbose)
+{
+  struct sockaddr_un address;
+  if (!socket_address(socket_path, &address))
+  {
+    diag_fatal(NULL, 0, "<server::srv_serve> socket path too long <%s>", socket_path);
+  }
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0)
+  {
+    diag_fatal(NULL, 0, "<server::srv_serve> could not create socket: %s", strerror(errno));
+  }
+  if (!remove_stale_socket(socket_path, &address))
+  {
+    close(listener);
+    diag_fatal(NULL, 0, "<server::srv_serve> a server is already listening on <%s>", socket_path);
+  }
+  if (bind(listener, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listener, 16) < 0)
+  {
+    close(listener);
+    diag_fatal(NULL, 0, "<server::srv_serve> could not listen on <%s>: %s", socket_path, strerror(errno));
+  }
+  if (verbose)
+  {
+    printf("listening on <%s>\n", socket_path);
+    fflush(stdout);
+  }
+
+  lc3asm_context* ctx = lc3asm_context_construct();
+  bool shutdown = false;
+  while (!shutdown)
+  {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0)
+    {
+      continue;
+    }
+    while (serve_request(fd, ctx, verbose, &shutdown))
+    {
+    }
+    close(fd);
+  }
+
+  lc3asm_context_destruct(ctx);
+  ic_clear();
+  close(listener);
+  unlink(socket_path);
+}
+
+/** @brief read response
+ *
+ * Read a response frame from the server into a new result.
+ *
+ * @returns lc3asm_result* The result, or NULL if the response could not
+ *   be read.
+ */
+static lc3asm_result* read_response(int fd)
+{
+  uint32_t header[5];
+  if (!read_all(fd, header, sizeof(header)) || header[0] != SRV_RESPONSE_MAGIC)
+  {
+    return NULL;
+  }
+
+  lc3asm_result* result = (lc3asm_result*)calloc(1, sizeof(lc3asm_result));
+  result->ok = header[1];
+  bool complete = true;
+  if (header[2] > 0)
+  {
+    result->image = (uint16_t*)malloc(header[2] * sizeof(uint16_t));
+    result->image_size = header[2];
+    complete = read_all(fd, result->image, header[2] * sizeof(uint16_t));
+  }
+
+  result->symbols = (lc3asm_symbol*)calloc(header[3] ? header[3] : 1, sizeof(lc3asm_symbol));
+  for (unsigned index = 0; complete && index < header[3]; index++)
+  {
+    uint32_t field[2];
+    complete = read_all(fd, field, sizeof(field)) && (result->symbols[index].symbol = read_string(fd, field[1]));
+    result->symbols[index].address = field[0];
+    result->num_symbols += complete;
+  }
+
+  for (unsigned index = 0; complete && index < header[4]; index++)
+  {
+    uint32_t field[4];
+    diagnostic diag = {NULL, 0, NULL};
+    complete = read_all(fd, field, sizeof(field));
+    if (complete && field[3] != SRV_NO_FILE)
+    {
+      complete = (diag.file = read_string(fd, field[3])) != NULL;
+    }
+    uint32_t length;
+    complete = complete && read_all(fd, &length, sizeof(length)) && (diag.message = read_string(fd, length));
+    diag.line = field[0];
+    diag.column = field[1];
+    diag.code = field[2] < DIAG_NUM_CODES ? (diag_code)field[2] : DIAG_FATAL;
+    lc3asm_result_add_diagnostic(result, diag);
+  }
+
+  if (!complete)
+  {
+    lc3asm_result_destruct(result);
+    return NULL;
+  }
+  return result;
+}
+
+/** @brief send request
+ *
+ * Connect to an assembler server and send it one request.
+ *
+ * @param socket_path The socket the server listens on.
+ * @param kind The kind of the request.
+ * @param name The name of the source, used in diagnostics.
+ * @param body The path of the file for a SRV_PATH request, or the source
+ *   text for a SRV_SOURCE request.
+ * @param length The length of the body.
+ *
+ * @returns lc3asm_result* The result the server sent back, destructed by the
+ *   caller with `lc3asm_result_destruct()`, or NULL if there is no server
+ *   listening or the request failed, so the caller can assemble itself.
+ */
+lc3asm_result* srv_request(const char* socket_path, srv_request_kind kind, const char* name, const char* body,
+  size_t length)
+{
+  struct sockaddr_un address;
+  if (!socket_address(socket_path, &address))
+  {
+    return NULL;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return NULL;
+  }
+  if (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  name = name ? name : "";
+  body = body ? body : "";
+  uint32_t header[4] = {SRV_REQUEST_MAGIC, kind, (uint32_t)strlen(name), (uint32_t)length};
+  lc3asm_result* result = NULL;
+  if (write_all(fd, header, sizeof(header)) && write_all(fd, name, header[2]) && write_all(fd, body, length))
+  {
+    result = read_response(fd);
+  }
+  close(fd);
+  return result;
+}
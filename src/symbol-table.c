@@ -18,6 +18,7 @@
 #define __STDC_WANT_LIB_EXT2__ 1
 #include "symbol-table.h"
 #include "assembler.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -73,9 +74,29 @@ symbol_table* st_construct(unsigned table_size)
  */
 void st_destruct(symbol_table* st)
 {
-  // first deallocate and return all symbol table entries by traversing
+  // first deallocate and return all symbol table entries
+  st_clear(st);
+
+  // once all entries are deallocated, can deallocate the entries array
+  free(st->entries);
+
+  // once all entries are deallocated and the entries array is free,
+  // free the symbol_table itself
+  free(st);
+}
+
+/** @brief clear symbol_table
+ *
+ * Remove all symbols from a symbol table, so it can be used for another
+ * assembly.  The hash table itself is kept.
+ *
+ * @param st A pointer to the symbol_table to clear.
+ */
+void st_clear(symbol_table* st)
+{
+  // deallocate and return all symbol table entries by traversing
   // the collision linked lists
-  for (int i = 0; i < st->table_size; i++)
+  for (int i = 0; i < st->table_size && st->num_entries > 0; i++)
   {
     st_entry* entry = st->entries[i];
     while (entry != NULL)
@@ -88,15 +109,11 @@ void st_destruct(symbol_table* st)
 
       // and free the entry itself
       free(current);
+      st->num_entries--;
     }
+    st->entries[i] = NULL;
   }
-
-  // once all entries are deallocated, can deallocate the entries array
-  free(st->entries);
-
-  // once all entries are deallocated and the entries array is free,
-  // free the symbol_table itself
-  free(st);
+  st->num_entries = 0;
 }
 
 /** @brief insert new symbol/address pair
@@ -109,8 +126,9 @@ void st_destruct(symbol_table* st)
  *   symbol table.
  * @param address The address uint16_t associated with the symbol.
  *
- * @returns st_entry* A pointer to the new entry is returned, or NULL if
- *   an error occurs on the insertion.
+ * @returns st_entry* A pointer to the new entry is returned.  A duplicate
+ *   symbol is an error, if it is recorded in the diagnostic sink the first
+ *   entry of the symbol is returned and keeps its address.
  */
 st_entry* st_insert(symbol_table* st, const char* symbol, uint16_t address)
 {
@@ -121,16 +139,16 @@ st_entry* st_insert(symbol_table* st, const char* symbol, uint16_t address)
   entry = st_lookup(st, symbol);
   if (entry != NULL)
   {
-    fprintf(stderr, "<symbol_table::insert> duplicate insertion attempted on symbol <%s> address <%d>\n", symbol, address);
-    exit(1);
+    diag_error(NULL, 0, 0, DIAG_DUPLICATE_LABEL,
+      "<symbol_table::insert> duplicate insertion attempted on symbol <%s> address <%d>", symbol, address);
+    return entry;
   }
 
   // otherwise safe to insert into table
   entry = (st_entry*)malloc(sizeof(st_entry));
   if (entry == NULL || (entry->symbol = strdup(symbol)) == NULL)
   {
-    fprintf(stderr, "<symbol_table::insert> error allocating new st_entry or symbol\n");
-    exit(1);
+    diag_fatal(NULL, 0, "<symbol_table::insert> error allocating new st_entry or symbol");
   }
 
   entry->address = address;
@@ -173,6 +191,33 @@ st_entry* st_lookup(symbol_table* st, const char* symbol)
   return NULL;
 }
 
+/** @brief remove symbol/address pair
+ *
+ * Remove a symbol from the symbol_table, for example when the line that
+ * defined a label is edited away.  Nothing happens if the symbol is not in
+ * the table.
+ *
+ * @param st A pointer to the symbol table to remove the symbol from.
+ * @param symbol The symbol to remove.
+ */
+void st_remove(symbol_table* st, const char* symbol)
+{
+  st_entry** link = &st->entries[st_hash(st, symbol)];
+  while (*link != NULL)
+  {
+    st_entry* entry = *link;
+    if (match(entry->symbol, symbol))
+    {
+      *link = entry->next;
+      free(entry->symbol);
+      free(entry);
+      st->num_entries--;
+      return;
+    }
+    link = &entry->next;
+  }
+}
+
 /** @brief display symbol_table
  *
  * Display contents of a symbol_table on stdout. Useful after pass 1 to generate
@@ -182,8 +227,21 @@ st_entry* st_lookup(symbol_table* st, const char* symbol)
  */
 void st_display(symbol_table* st)
 {
-  printf("Symbol             ADDRESS (indx)\n");
-  printf("---------------------------------\n");
+  st_fdisplay(stdout, st);
+}
+
+/** @brief display symbol_table to a file
+ *
+ * Display contents of a symbol_table like `st_display()`, but on the given
+ * file, for example to keep the report in the output cache.
+ *
+ * @param out The file to display the symbol table on.
+ * @param st A pointer to the symbol table to display.
+ */
+void st_fdisplay(FILE* out, symbol_table* st)
+{
+  fprintf(out, "Symbol             ADDRESS (indx)\n");
+  fprintf(out, "---------------------------------\n");
 
   char* padding = "....................";
 
@@ -192,7 +250,7 @@ void st_display(symbol_table* st)
     st_entry* entry = st->entries[index];
     while (entry != NULL)
     {
-      printf("%s%s0x%04X (%04d)\n", entry->symbol, padding + strlen(entry->symbol), entry->address, index);
+      fprintf(out, "%s%s0x%04X (%04d)\n", entry->symbol, padding + strlen(entry->symbol), entry->address, index);
       entry = entry->next;
     }
   }
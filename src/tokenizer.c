@@ -15,8 +15,10 @@
  * The assembler is responsible for interpreting the tokens found on each line,
  * and other tasks.
  */
+#define _POSIX_C_SOURCE 200809L
 #define __STDC_WANT_LIB_EXT2__ 1
 #include "tokenizer.h"
+#include "diagnostic.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,8 +50,41 @@ tokenizer* tk_construct(const char* asmfile)
   tk->in = fopen(asmfile, "r");
   if (tk->in == NULL)
   {
-    fprintf(stderr, "<tokeniser::tk_construct> File Not Found: <%s>\n", asmfile);
-    exit(1);
+    diag_fatal(NULL, 0, "<tokeniser::tk_construct> File Not Found: <%s>", asmfile);
+  }
+
+  return tk;
+}
+
+/** @brief construct tokenizer of an in memory source
+ *
+ * Construct a new tokenizer that tokenizes assembly source text held
+ * in memory instead of a file.  The source is read through a memory
+ * stream, so no file is opened, and the offsets of the lines are
+ * offsets into the source text.  The source is not copied, it must stay
+ * valid until the tokenizer is destructed.
+ *
+ * @param name The name to report the source as.
+ * @param source The assembly source text.
+ * @param length The length of the source text.
+ *
+ * @returns tokenizer* Returns pointer to newly allocated
+ *   and initialized tokenizer ready to read and tokenize lines.
+ */
+tokenizer* tk_construct_buffer(const char* name, const char* source, size_t length)
+{
+  tokenizer* tk = (tokenizer*)malloc(sizeof(tokenizer));
+
+  tk->asmfile = strdup(name);
+  tk->linenum = 1;
+
+  // the stream is only read from, so it never writes to the source
+  tk->in = fmemopen((void*)source, length, "r");
+  if (tk->in == NULL)
+  {
+    free(tk->asmfile);
+    free(tk);
+    diag_fatal(name, 0, "<tokeniser::tk_construct_buffer> could not read source: <%s>", name);
   }
 
   return tk;
@@ -113,25 +148,29 @@ void tokens_destruct(tokens* tks)
 tokens* tk_next_line(tokenizer* tk)
 {
   char buffer[4096];
+  char line[4096];
   tokens* tks = NULL;
   char* token;
+  char* cursor;
   bool done = false;
 
-  // if we are at end of file then the input is done
-  if (feof(tk->in))
-  {
-    return NULL;
-  }
-
   // we have to get lines until we find a line that is not blank or a
   // comment.
+  long offset;
   while (!done)
   {
-    // get the next line of input
-    fgets(buffer, sizeof(buffer), tk->in);
+    // get the next line of input, remembering where it starts in the file
+    offset = ftell(tk->in);
+    if (fgets(buffer, sizeof(buffer), tk->in) == NULL)
+    {
+      return NULL;
+    }
+
+    // keep a copy of the whole line, tokenizing modifies the buffer
+    strcpy(line, buffer);
 
     // attempt to tokenize line elements, separate by whitespace and commas
-    token = strtokquote(buffer, " \n\t,");
+    token = strtokquote_r(buffer, " \n\t,", &cursor);
 
     // if line was empty we get a NULL token, or if first character is ;
     // then line only has a comments.  In both cases continue to next line
@@ -147,14 +186,17 @@ tokens* tk_next_line(tokenizer* tk)
 
   // We are tokenizing a line, create a tokens object to return and fill it with tokens
   tks = (tokens*)malloc(sizeof(tokens));
-  tks->line = strdup(buffer);
+  tks->line = strdup(line);
   tks->linenum = tk->linenum;
+  tks->offset = offset;
+  tks->length = strcspn(line, "\r\n");
+  tks->file = NULL;
   tks->token[0] = strdup(token);
   tks->num_tokens = 1;
 
   // extract remaining tokens from buffer, passing NULL to
   // strtok continues tokenization where left off in buffer
-  while ((token = strtokquote(NULL, " \n\t,")) != NULL)
+  while ((token = strtokquote_r(NULL, " \n\t,", &cursor)) != NULL)
   {
     // throw away rest of line when we encounter comment
     if ((token == NULL) || (token[0] == ';'))
@@ -192,16 +234,32 @@ tokens* tk_next_line(tokenizer* tk)
  */
 char* strtokquote(char* input, char* delimit)
 {
-  // notice that token is statically allocated, it persists on subsequent calls
-  // to strtokquote
-  static char* token = NULL;
-  char* start = NULL;
+  // notice that the cursor is statically allocated, it persists on
+  // subsequent calls to strtokquote, one per thread so files can be
+  // tokenized concurrently
+  static _Thread_local char* cursor = NULL;
+  return strtokquote_r(input, delimit, &cursor);
+}
 
-  // initial call, set token to of beginning string
-  if (input != NULL)
-  {
-    token = input;
-  }
+/** @brief reentrant tokenizer that keeps "string literal" as a single token
+ *
+ * The same as `strtokquote()`, like `strtok_r()` the caller keeps the
+ * location of the last token found, so the tokenizer has no hidden state
+ * and any number of buffers can be tokenized at the same time.
+ *
+ * @param input The input buffer to tokenize, or NULL to continue on from
+ *   the last token found.
+ * @param delimit A character array of delimiters.
+ * @param save The location of the last token found, set by the call that
+ *   starts tokenizing a buffer and used by the calls that continue it.
+ *
+ * @returns char* Returns the next token found, or NULL when no more tokens can be found
+ *   in the original buffer.
+ */
+char* strtokquote_r(char* input, char* delimit, char** save)
+{
+  char* token = input != NULL ? input : *save;
+  char* start = NULL;
 
   // skip over any delimiters at beginning
   while ((strchr(delimit, *token) != NULL) && (*token != '\0'))
@@ -212,6 +270,7 @@ char* strtokquote(char* input, char* delimit)
   // when we find that token is at \0 we are done tokenizing
   if (*token == '\0')
   {
+    *save = token;
     return NULL;
   }
 
@@ -251,5 +310,6 @@ char* strtokquote(char* input, char* delimit)
     token++;
   }
 
+  *save = token;
   return start;
 }
\ No newline at end of file
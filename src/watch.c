@@ -0,0 +1,544 @@
+/** @file watch.c
+ * @brief LC-3 Assembler watch mode
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * Watch mode, see watch.h.  The process sleeps in poll() on the inotify
+ * descriptor between builds, so a watch that is waiting for an edit uses no
+ * cpu at all.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "watch.h"
+#include "assembler.h"
+#include "diagnostic.h"
+#include "include-cache.h"
+#include "lc3asm-lib.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+
+/// the changes to a directory that change a watched file in it, the file
+/// closed after writing it, or a new file renamed over it
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+/// set by the signal handler to end `watch_run()`
+static volatile sig_atomic_t watch_stopped = 0;
+
+/** @brief stop watching
+ *
+ * Signal handler for SIGINT and SIGTERM.
+ */
+static void watch_stop(int signum)
+{
+  (void)signum;
+  watch_stopped = 1;
+}
+
+/** @brief current time in milliseconds
+ *
+ * @returns double The monotonic clock time in milliseconds.
+ */
+static double now_ms()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/** @brief split lines
+ *
+ * Find where each line of a text starts.  The line starts are followed by
+ * the length of the text, so line i is from starts[i] to starts[i + 1].
+ *
+ * @returns unsigned The number of lines, a last line does not need a
+ *   newline.
+ */
+static unsigned split_lines(const char* text, size_t length, size_t** starts)
+{
+  unsigned num_lines = 0;
+  unsigned capacity = 64;
+  *starts = (size_t*)malloc(capacity * sizeof(size_t));
+  size_t pos = 0;
+  while (pos < length)
+  {
+    if (num_lines + 1 == capacity)
+    {
+      capacity *= 2;
+      *starts = (size_t*)realloc(*starts, capacity * sizeof(size_t));
+    }
+    (*starts)[num_lines++] = pos;
+    const char* newline = (const char*)memchr(text + pos, '\n', length - pos);
+    pos = newline != NULL ? (size_t)(newline - text) + 1 : length;
+  }
+  (*starts)[num_lines] = length;
+  return num_lines;
+}
+
+/** @brief same line
+ *
+ * Check if a line of the old text and a line of the new text are the same.
+ */
+static bool same_line(const char* old, const size_t* old_starts, unsigned old_line, const char* text,
+  const size_t* starts, unsigned line)
+{
+  size_t length = starts[line + 1] - starts[line];
+  return old_starts[old_line + 1] - old_starts[old_line] == length &&
+         memcmp(old + old_starts[old_line], text + starts[line], length) == 0;
+}
+
+/** @brief edit changed lines
+ *
+ * Compare the new text of a file with the text of its last build, and
+ * edit only the lines between the first and last lines that differ in its
+ * incremental assembly.
+ */
+static void edit_changed_lines(watch_file* wf, const char* text, size_t length)
+{
+  size_t* old_starts;
+  size_t* starts;
+  unsigned old_lines = split_lines(wf->source, wf->length, &old_starts);
+  unsigned num_lines = split_lines(text, length, &starts);
+
+  // the lines before the first difference and after the last one are the
+  // same in both texts
+  unsigned prefix = 0;
+  while (prefix < old_lines && prefix < num_lines && same_line(wf->source, old_starts, prefix, text, starts, prefix))
+  {
+    prefix++;
+  }
+  unsigned suffix = 0;
+  while (suffix < old_lines - prefix && suffix < num_lines - prefix &&
+         same_line(wf->source, old_starts, old_lines - 1 - suffix, text, starts, num_lines - 1 - suffix))
+  {
+    suffix++;
+  }
+
+  size_t begin = starts[prefix];
+  size_t end = starts[num_lines - suffix];
+  inc_edit(wf->eng, prefix, old_lines - prefix - suffix, text + begin, end - begin);
+  free(old_starts);
+  free(starts);
+}
+
+/** @brief watch directory
+ *
+ * Watch the directory of a file, an editor that saves by renaming a new
+ * file over the old one would end a watch of the file itself.  A directory
+ * that is already watched gives the same watch again.
+ *
+ * @param w The watcher.
+ * @param path The path of the file.
+ * @param name Returns the name of the file in its directory, a pointer
+ *   into path.
+ *
+ * @returns int The watch descriptor of the directory, or -1 if it can not
+ *   be watched.
+ */
+static int watch_directory(watcher* w, const char* path, const char** name)
+{
+  const char* slash = strrchr(path, '/');
+  char dir[PATH_MAX];
+  if (slash == NULL)
+  {
+    strcpy(dir, ".");
+    *name = path;
+  }
+  else
+  {
+    snprintf(dir, sizeof(dir), "%.*s", slash == path ? 1 : (int)(slash - path), path);
+    *name = slash + 1;
+  }
+  return inotify_add_watch(w->fd, dir, WATCH_EVENTS);
+}
+
+/** @brief forget included files
+ *
+ * Free the files a watched file included.  Their directory watches are
+ * left, a directory may also have a watched file in it, and a change in a
+ * directory nothing needs any more is ignored.
+ */
+static void clear_deps(watch_file* wf)
+{
+  for (unsigned idx = 0; idx < wf->num_deps; idx++)
+  {
+    free(wf->deps[idx].path);
+  }
+  free(wf->deps);
+  wf->deps = NULL;
+  wf->num_deps = 0;
+}
+
+/** @brief watch included files
+ *
+ * Watch the files the last full assembly of a file read, instead of the
+ * ones it read before.
+ */
+static void watch_deps(watcher* w, watch_file* wf, lc3asm_result* result)
+{
+  clear_deps(wf);
+  wf->deps = (watch_dep*)calloc(result->num_files ? result->num_files : 1, sizeof(watch_dep));
+  for (unsigned idx = 0; idx < result->num_files; idx++)
+  {
+    watch_dep* dep = &wf->deps[wf->num_deps];
+    dep->path = strdup(result->files[idx]);
+    dep->wd = watch_directory(w, dep->path, &dep->name);
+    if (dep->wd < 0)
+    {
+      fprintf(stderr, "<watch::watch_deps> could not watch included file <%s>: %s\n", dep->path, strerror(errno));
+      free(dep->path);
+      continue;
+    }
+    wf->num_deps++;
+  }
+}
+
+/** @brief write binary file
+ *
+ * Write the image of a build to the binary file of a watched file.
+ */
+static void write_binary(watch_file* wf, const uint16_t* image, size_t size)
+{
+  FILE* out = fopen(wf->binfile, "wb");
+  if (out == NULL || fwrite(image, WORD_SIZE, size, out) != size)
+  {
+    fprintf(stderr, "<watch::build_file> error could not write file <%s>\n", wf->binfile);
+  }
+  if (out != NULL)
+  {
+    fclose(out);
+  }
+}
+
+/** @brief build file incrementally
+ *
+ * Edit the changed lines of a file in its incremental assembly, or start
+ * one, and write its binary file if it has no errors.
+ */
+static void build_incremental(watcher* w, watch_file* wf, const char* text, size_t length, double start)
+{
+  if (wf->eng == NULL)
+  {
+    wf->eng = inc_construct(wf->asmfile, text, length);
+  }
+  else
+  {
+    edit_changed_lines(wf, text, length);
+  }
+
+  inc_engine* eng = wf->eng;
+  if (eng->num_errors > 0)
+  {
+    const diagnostic** diags = (const diagnostic**)malloc(eng->num_errors * sizeof(diagnostic*));
+    unsigned num_diags = inc_diagnostics(eng, diags, eng->num_errors);
+    for (unsigned idx = 0; idx < num_diags; idx++)
+    {
+      diag_print(stderr, diags[idx]);
+    }
+    free(diags);
+    printf("%s: %u errors, <%s> not written\n", wf->asmfile, eng->num_errors, wf->binfile);
+    return;
+  }
+
+  uint16_t* image = (uint16_t*)malloc(image_size(eng->opl) * sizeof(uint16_t));
+  size_t size = inc_image(eng, image);
+  write_binary(wf, image, size);
+  free(image);
+
+  if (w->verbose)
+  {
+    st_display(eng->st);
+    opl_display(eng->opl);
+    display_bin_file(wf->binfile);
+  }
+  printf("%s: assembled <%s>, %u lines parsed, %u entries encoded, %.3f ms\n", wf->asmfile, wf->binfile,
+    eng->num_parsed, eng->num_encoded, now_ms() - start);
+}
+
+/** @brief build file in full
+ *
+ * Assemble a file that the incremental engine can not, with the macro
+ * preprocessor, and watch the files it included.  Its errors and warnings
+ * are reported like lc3asm reports them, and its binary file is written if
+ * it has no errors.
+ */
+static void build_full(watcher* w, watch_file* wf, const char* text, size_t length, double start)
+{
+  if (wf->eng != NULL)
+  {
+    inc_destruct(wf->eng);
+    wf->eng = NULL;
+  }
+  lc3asm_result* result = lc3asm_context_assemble(w->ctx, wf->asmfile, text, length);
+  watch_deps(w, wf, result);
+
+  unsigned num_errors = 0;
+  for (unsigned idx = 0; idx < result->num_diagnostics; idx++)
+  {
+    diag_print(stderr, &result->diagnostics[idx]);
+    num_errors += !diag_is_warning(result->diagnostics[idx].code);
+  }
+  if (!result->ok)
+  {
+    printf("%s: %u errors, <%s> not written\n", wf->asmfile, num_errors, wf->binfile);
+    lc3asm_result_destruct(result);
+    return;
+  }
+
+  write_binary(wf, result->image, result->image_size);
+  if (w->verbose)
+  {
+    display_bin_file(wf->binfile);
+  }
+  printf("%s: assembled <%s>, %u files included, %.3f ms\n", wf->asmfile, wf->binfile, wf->num_deps,
+    now_ms() - start);
+  lc3asm_result_destruct(result);
+}
+
+/** @brief build file
+ *
+ * Assemble a file if its text changed since its last build.  The binary
+ * file is written when the file has no errors, else the errors are
+ * reported on standard error and the last binary file is kept.  A file
+ * that is assembled in full is also built when only a file it included
+ * changed, so it is built again even if its own text is the same.
+ *
+ * @param w The watcher.
+ * @param wf The file to build.
+ *
+ * @returns bool true if the file was assembled, false if it could not be
+ *   read or had not really changed.
+ */
+static bool build_file(watcher* w, watch_file* wf)
+{
+  wf->changed = false;
+  size_t length;
+  char* text = lc3asm_read_source(wf->asmfile, &length);
+  if (text == NULL)
+  {
+    // the editor may be replacing the file, the new file is reported when
+    // it is renamed into place
+    return false;
+  }
+  if (wf->eng != NULL && length == wf->length && memcmp(text, wf->source, length) == 0)
+  {
+    free(text);
+    return false;
+  }
+
+  double start = now_ms();
+  if (inc_supported(text, length))
+  {
+    clear_deps(wf);
+    build_incremental(w, wf, text, length, start);
+  }
+  else
+  {
+    build_full(w, wf, text, length, start);
+  }
+  free(wf->source);
+  wf->source = text;
+  wf->length = length;
+  w->num_builds++;
+  fflush(stdout);
+  return true;
+}
+
+/** @brief construct watcher
+ *
+ * Assemble the files, and start watching them for changes.
+ *
+ * @param asmfiles The names of the assembly files to watch.
+ * @param num_files The number of files.
+ * @param outfile The binary file of a single file, or NULL to write each
+ *   file to its default binary file.
+ * @param verbose If true show the symbol table, listing and binary file of
+ *   every build.
+ *
+ * @returns watcher* The new watcher, destructed with `watch_destruct()`.
+ */
+watcher* watch_construct(char* const* asmfiles, unsigned num_files, const char* outfile, bool verbose)
+{
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0)
+  {
+    diag_fatal(NULL, 0, "<watch::watch_construct> could not start inotify: %s", strerror(errno));
+  }
+
+  watcher* w = (watcher*)calloc(1, sizeof(watcher));
+  w->fd = fd;
+  w->files = (watch_file*)calloc(num_files, sizeof(watch_file));
+  w->num_files = num_files;
+  w->verbose = verbose;
+  w->ctx = lc3asm_context_construct();
+
+  for (unsigned idx = 0; idx < num_files; idx++)
+  {
+    watch_file* wf = &w->files[idx];
+    wf->asmfile = strdup(asmfiles[idx]);
+    wf->binfile = outfile != NULL && num_files == 1 ? strdup(outfile) : bin_file_name(asmfiles[idx]);
+    wf->wd = watch_directory(w, wf->asmfile, &wf->name);
+    if (wf->wd < 0)
+    {
+      diag_fatal(NULL, 0, "<watch::watch_construct> could not watch the directory of <%s>: %s", wf->asmfile,
+        strerror(errno));
+    }
+
+    if (!build_file(w, wf))
+    {
+      fprintf(stderr, "<watch::watch_construct> could not read file <%s>, waiting for it\n", wf->asmfile);
+    }
+  }
+  return w;
+}
+
+/** @brief destruct watcher
+ *
+ * Stop watching, and free the files and their assemblies, and the include
+ * cache, see include-cache.h.
+ *
+ * @param w The watcher to destruct.
+ */
+void watch_destruct(watcher* w)
+{
+  for (unsigned idx = 0; idx < w->num_files; idx++)
+  {
+    watch_file* wf = &w->files[idx];
+    if (wf->eng != NULL)
+    {
+      inc_destruct(wf->eng);
+    }
+    clear_deps(wf);
+    free(wf->source);
+    free(wf->asmfile);
+    free(wf->binfile);
+  }
+  close(w->fd);
+  lc3asm_context_destruct(w->ctx);
+  ic_clear();
+  free(w->files);
+  free(w);
+}
+
+/** @brief watched file changed
+ *
+ * Check if an inotify event is about a watched file, or a file it
+ * included.
+ */
+static bool file_changed(watch_file* wf, struct inotify_event* event)
+{
+  if (wf->wd == event->wd && strcmp(wf->name, event->name) == 0)
+  {
+    return true;
+  }
+  for (unsigned idx = 0; idx < wf->num_deps; idx++)
+  {
+    if (wf->deps[idx].wd == event->wd && strcmp(wf->deps[idx].name, event->name) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** @brief read changes
+ *
+ * Read the pending inotify events and mark the watched files they are
+ * about, or that included the files they are about, as changed.
+ *
+ * @returns bool true if any watched file changed.
+ */
+static bool read_changes(watcher* w)
+{
+  bool changed = false;
+  _Alignas(struct inotify_event) char events[4096];
+  ssize_t got;
+  while ((got = read(w->fd, events, sizeof(events))) > 0)
+  {
+    for (char* next = events; next < events + got;)
+    {
+      struct inotify_event* event = (struct inotify_event*)next;
+      for (unsigned idx = 0; idx < w->num_files && event->len > 0; idx++)
+      {
+        watch_file* wf = &w->files[idx];
+        if (file_changed(wf, event))
+        {
+          wf->changed = true;
+          changed = true;
+        }
+      }
+      next += sizeof(struct inotify_event) + event->len;
+    }
+  }
+  return changed;
+}
+
+/** @brief wait for changes
+ *
+ * Wait for a watched file to change, then wait until the files have been
+ * quiet for WATCH_DEBOUNCE_MS so a burst of writes is built once, and
+ * assemble the files that changed.
+ *
+ * @param w The watcher.
+ * @param timeout_ms How long to wait for a first change, -1 to wait until
+ *   one comes or a signal interrupts the wait.
+ *
+ * @returns unsigned The number of files assembled, 0 if the wait timed out
+ *   or was interrupted, or the changed files had the same text.
+ */
+unsigned watch_wait(watcher* w, int timeout_ms)
+{
+  struct pollfd pfd = {w->fd, POLLIN, 0};
+  if (poll(&pfd, 1, timeout_ms) <= 0 || !read_changes(w))
+  {
+    return 0;
+  }
+  while (poll(&pfd, 1, WATCH_DEBOUNCE_MS) > 0)
+  {
+    read_changes(w);
+  }
+
+  unsigned num_built = 0;
+  for (unsigned idx = 0; idx < w->num_files; idx++)
+  {
+    if (w->files[idx].changed && build_file(w, &w->files[idx]))
+    {
+      num_built++;
+    }
+  }
+  return num_built;
+}
+
+/** @brief watch until stopped
+ *
+ * Build the files as they change, until the process gets SIGINT or
+ * SIGTERM.
+ *
+ * @param w The watcher.
+ */
+void watch_run(watcher* w)
+{
+  // no SA_RESTART, so a signal interrupts the poll() that is waiting
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = watch_stop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  printf("watching %u files, ^C to stop\n", w->num_files);
+  fflush(stdout);
+  while (!watch_stopped)
+  {
+    watch_wait(w, -1);
+  }
+  printf("stopped watching after %u builds\n", w->num_builds);
+}
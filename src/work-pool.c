@@ -0,0 +1,188 @@
+/** @file work-pool.c
+ * @brief work stealing pool of threads for parallel loops
+ *
+ * @author Student Name
+ * @note   cwid: 123456
+ * @date   Spring 2025
+ * @note   ide:  gcc 13.3.0 / GNU Make 4.3 / VSCode 1.99
+ *
+ * A small pool of worker threads to run the iterations of a loop
+ * in parallel.  The range of loop indexes is cut into chunks, and
+ * each worker is initially given an equal share of the chunks.  Workers
+ * claim chunks from their own share, and when their share is used up they
+ * steal unclaimed chunks from the shares of the other workers, so a worker
+ * that gets a slow share does not hold up the whole loop.  Every index
+ * in the range is processed exactly once.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "work-pool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/// The share of chunks owned by one worker.  Chunks next up to end are
+/// unclaimed, and a chunk is claimed by atomically incrementing next, so
+/// the owner and any thieves never claim the same chunk twice.
+typedef struct wp_share
+{
+  atomic_uint next;
+  unsigned end;
+} wp_share;
+
+/// The state of one parallel loop shared by all of its workers.
+typedef struct wp_loop
+{
+  unsigned num_workers;
+  unsigned count;
+  unsigned chunk_size;
+  wp_work work;
+  void* arg;
+  wp_share* shares;
+} wp_loop;
+
+/// A worker is told which loop it is working on and which share is its own.
+typedef struct wp_worker
+{
+  wp_loop* loop;
+  unsigned id;
+  pthread_t thread;
+} wp_worker;
+
+/** @brief run the chunks of a share
+ *
+ * Claim and process chunks from a share until none are left.
+ *
+ * @param loop The loop the share belongs to.
+ * @param share The share to claim chunks from.
+ */
+static void wp_drain(wp_loop* loop, wp_share* share)
+{
+  unsigned chunk;
+  while ((chunk = atomic_fetch_add(&share->next, 1)) < share->end)
+  {
+    unsigned begin = chunk * loop->chunk_size;
+    unsigned end = begin + loop->chunk_size;
+    if (end > loop->count)
+    {
+      end = loop->count;
+    }
+    loop->work(loop->arg, begin, end);
+  }
+}
+
+/** @brief worker thread
+ *
+ * A worker first drains its own share of chunks, then visits the shares
+ * of the other workers in turn and steals whatever chunks remain there.
+ *
+ * @param arg The wp_worker describing this worker.
+ *
+ * @returns void* Always NULL.
+ */
+static void* wp_run(void* arg)
+{
+  wp_worker* worker = (wp_worker*)arg;
+  wp_loop* loop = worker->loop;
+
+  for (unsigned n = 0; n < loop->num_workers; n++)
+  {
+    wp_drain(loop, &loop->shares[(worker->id + n) % loop->num_workers]);
+  }
+  return NULL;
+}
+
+/** @brief parallel for loop
+ *
+ * Run work over all indexes 0 to count-1 using up to num_threads threads.
+ * The calling thread acts as one of the workers, so a single thread, or a
+ * loop with only one chunk, runs entirely on the caller without starting
+ * any threads.  This function returns when every index has been processed.
+ *
+ * @param num_threads The number of threads to use, 0 means use one per cpu.
+ * @param count The number of loop indexes to process.
+ * @param chunk_size The number of consecutive indexes given to the work
+ *   function at a time.
+ * @param work The function to call for each chunk of indexes.
+ * @param arg A user argument passed through to the work function.
+ */
+void wp_parallel_for(unsigned num_threads, unsigned count, unsigned chunk_size, wp_work work, void* arg)
+{
+  if (count == 0)
+  {
+    return;
+  }
+  if (chunk_size == 0)
+  {
+    chunk_size = 1;
+  }
+  if (num_threads == 0)
+  {
+    num_threads = wp_num_cpus();
+  }
+
+  // no more workers than there are chunks to give them
+  unsigned num_chunks = (count + chunk_size - 1) / chunk_size;
+  if (num_threads > num_chunks)
+  {
+    num_threads = num_chunks;
+  }
+  if (num_threads <= 1)
+  {
+    work(arg, 0, count);
+    return;
+  }
+
+  // divide the chunks up into equal shares, the first shares get one
+  // extra chunk when they don't divide evenly
+  wp_loop loop = {num_threads, count, chunk_size, work, arg, NULL};
+  loop.shares = (wp_share*)malloc(num_threads * sizeof(wp_share));
+  wp_worker* workers = (wp_worker*)malloc(num_threads * sizeof(wp_worker));
+  if (loop.shares == NULL || workers == NULL)
+  {
+    fprintf(stderr, "<work_pool::wp_parallel_for> error allocating <%u> workers\n", num_threads);
+    exit(1);
+  }
+
+  unsigned start = 0;
+  for (unsigned id = 0; id < num_threads; id++)
+  {
+    unsigned share_size = num_chunks / num_threads + (id < num_chunks % num_threads ? 1 : 0);
+    atomic_init(&loop.shares[id].next, start);
+    loop.shares[id].end = start + share_size;
+    start += share_size;
+
+    workers[id].loop = &loop;
+    workers[id].id = id;
+  }
+
+  // worker 0 is the calling thread, if a thread can't be started its
+  // share is simply stolen by the workers that did start
+  bool* started = (bool*)calloc(num_threads, sizeof(bool));
+  for (unsigned id = 1; id < num_threads; id++)
+  {
+    started[id] = pthread_create(&workers[id].thread, NULL, wp_run, &workers[id]) == 0;
+  }
+  wp_run(&workers[0]);
+  for (unsigned id = 1; id < num_threads; id++)
+  {
+    if (started[id])
+    {
+      pthread_join(workers[id].thread, NULL);
+    }
+  }
+
+  free(started);
+  free(workers);
+  free(loop.shares);
+}
+
+/** @brief number of cpus
+ *
+ * @returns unsigned The number of online processors, at least 1.
+ */
+unsigned wp_num_cpus()
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus > 0 ? (unsigned)cpus : 1;
+}